@@ -30,8 +30,28 @@
 
 #if defined(__cplusplus)
 
+#include "lemma/qsat/aligned_allocator.h"
+#include "lemma/qsat/arena_allocator.h"
 #include "lemma/qsat/basic_channel.h"
 #include "lemma/qsat/channel_base.h"
+#include "lemma/qsat/channel_expression.h"
+#include "lemma/qsat/channel_group.h"
+#include "lemma/qsat/channel_io.h"
+#include "lemma/qsat/channel_slice.h"
+#include "lemma/qsat/chunked_sequence.h"
+#include "lemma/qsat/compressed_sequence.h"
+#include "lemma/qsat/fir.h"
+#include "lemma/qsat/generated_channel.h"
+#include "lemma/qsat/indexed_channel.h"
+#include "lemma/qsat/intrusive_sequence.h"
+#include "lemma/qsat/irregular_channel.h"
+#include "lemma/qsat/live_channel.h"
+#include "lemma/qsat/mapped_sequence.h"
+#include "lemma/qsat/parallel.h"
+#include "lemma/qsat/pool_allocator.h"
+#include "lemma/qsat/resample.h"
+#include "lemma/qsat/ring_channel.h"
+#include "lemma/qsat/run_length_sequence.h"
 
 #endif
 
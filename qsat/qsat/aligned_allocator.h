@@ -0,0 +1,323 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_ALIGNED_ALLOCATOR_H
+#define LEMMA_QSAT_ALIGNED_ALLOCATOR_H
+
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+
+#include <new>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdlib>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+/** \file
+ *  \brief Implementation of aligned_allocator, an allocator for cache line
+ *    aligned and huge page backed channel buffers
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \internal Alignment of every aligned_allocator block. One cache line,
+ *  which is also the width of an AVX-512 register.
+ */
+static const std::size_t cache_line_size = 64;
+
+/** \internal Size and alignment of a transparent huge page */
+static const std::size_t huge_page_size = 2*1024*1024;
+
+/** \internal Blocks of at least this many bytes are mapped on huge pages */
+static const std::size_t huge_page_threshold = huge_page_size;
+
+/** \internal Nodes representable in the mbind node mask */
+static const int numa_max_nodes = 1024;
+
+/** \internal The NUMA node installed by the innermost scoped_numa_node of
+ *  this thread, -1 for none
+ */
+inline int & current_numa_node(void)
+{
+  static thread_local int node = -1;
+  return node;
+}
+
+/** \brief Bind [\e addr, \e addr + \e length) to NUMA node \e node
+ *  \internal Kernels without NUMA support have nothing to bind to and are
+ *  not an error.
+ */
+inline void bind_numa_node(void *addr, std::size_t length, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  if(node >= numa_max_nodes) {
+    ::munmap(addr,length);
+    throw std::invalid_argument("aligned_allocator: invalid NUMA node");
+  }
+
+  const int mpol_bind = 2;
+  const std::size_t bits = sizeof(unsigned long)*CHAR_BIT;
+
+  unsigned long mask[numa_max_nodes/(sizeof(unsigned long)*CHAR_BIT)] = {0};
+  mask[node/bits] = 1UL << (node%bits);
+
+  // the kernel reads one bit fewer than maxnode
+  if(::syscall(SYS_mbind,addr,length,mpol_bind,mask,
+    (unsigned long)(numa_max_nodes+1),0u) != 0 && errno != ENOSYS)
+  {
+    int err = errno;
+    ::munmap(addr,length);
+    throw std::system_error(err,std::system_category(),
+      "aligned_allocator: mbind");
+  }
+#else
+  (void)addr;
+  (void)length;
+  (void)node;
+#endif
+}
+
+/** \brief Map \e bytes of anonymous memory on huge page boundaries
+ *  \internal The mapping is over-allocated by one huge page and trimmed so
+ *  that it starts on a huge page boundary, which transparent huge pages
+ *  require.
+ */
+inline void * map_huge(std::size_t bytes, int node)
+{
+#if defined(MAP_ANONYMOUS)
+  const int anonymous = MAP_ANONYMOUS;
+#else
+  const int anonymous = MAP_ANON;
+#endif
+
+  std::size_t length = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+  if(length < bytes || length + huge_page_size < length)
+    throw std::bad_alloc();
+
+  void *addr = ::mmap(0,length+huge_page_size,PROT_READ | PROT_WRITE,
+    MAP_PRIVATE | anonymous,-1,0);
+  if(addr == MAP_FAILED)
+    throw std::bad_alloc();
+
+  char *raw = static_cast<char *>(addr);
+  char *first = reinterpret_cast<char *>(
+    (reinterpret_cast<std::size_t>(raw) + huge_page_size - 1)
+      & ~(huge_page_size - 1));
+
+  if(first != raw)
+    ::munmap(raw,first-raw);
+
+  std::size_t tail = huge_page_size - (first-raw);
+  if(tail)
+    ::munmap(first+length,tail);
+
+#if defined(MADV_HUGEPAGE)
+  // only a hint, kernels without THP support reject it harmlessly
+  ::madvise(first,length,MADV_HUGEPAGE);
+#endif
+
+  if(node >= 0)
+    bind_numa_node(first,length,node);
+
+  return first;
+}
+
+/** \internal Release memory obtained from map_huge(\e bytes) */
+inline void unmap_huge(void *p, std::size_t bytes)
+{
+  ::munmap(p,(bytes + huge_page_size - 1) & ~(huge_page_size - 1));
+}
+
+}
+
+/** \brief Install a NUMA node for the large aligned_allocator buffers of
+ *    the current thread
+ *
+ *  \par Discussion
+ *  While a scoped_numa_node exists, aligned_allocator objects constructed
+ *  by the same thread bind the huge page mappings they create to
+ *  <em>node</em>. The previously installed node is reinstated on
+ *  destruction. Binding is ignored on systems without NUMA support.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double,std::vector,aligned_allocator>
+ *    aligned_channel;
+ *
+ *  scoped_numa_node bind(1);
+ *  aligned_channel ch(first,last);
+ *  \endcode
+ */
+class scoped_numa_node :private b::noncopyable {
+  public:
+    /** \brief Constructor
+     *  \param node The NUMA node, -1 for no binding
+     *  \throws <CODE>std::invalid_argument</CODE> if <em>node</em> is out
+     *    of range
+     */
+    explicit scoped_numa_node(int node) :prev(detail::current_numa_node())
+    {
+      if(node < -1 || node >= detail::numa_max_nodes)
+        throw std::invalid_argument("scoped_numa_node: invalid node");
+
+      detail::current_numa_node() = node;
+    }
+
+    /** \brief Destructor
+     *
+     *  Reinstate the previous node
+     */
+    ~scoped_numa_node(void) {
+      detail::current_numa_node() = prev;
+    }
+
+  private:
+    int prev;
+};
+
+/** \brief Allocator returning cache line aligned memory, backed by
+ *    transparent huge pages for large blocks
+ *  \tparam T The value type, aligned to at most 64 bytes
+ *
+ *  \par Discussion
+ *  Every block is aligned to 64 bytes so that vector loads of channel
+ *  samples never split a cache line. Blocks of 2MiB or more are mapped
+ *  with mmap on a huge page boundary and advised to use transparent huge
+ *  pages, which reduces TLB misses when scanning large channels. If a NUMA
+ *  node was installed with scoped_numa_node when the allocator was
+ *  constructed, those mappings are bound to that node.
+ *
+ *  A basic_channel instantiated with aligned_allocator uses it for its
+ *  samples and for the container and reference count. All
+ *  aligned_allocator objects compare equal. Memory allocated by one may be
+ *  freed by any other.
+ */
+template<typename T>
+class aligned_allocator {
+  public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+      typedef aligned_allocator<U> other;
+    };
+
+    /** \brief Default Constructor
+     *
+     *  Use the NUMA node installed for this thread, if any
+     */
+    aligned_allocator(void) :_node(detail::current_numa_node()) {}
+
+    /** \brief Bind large blocks to NUMA node <em>n</em>, -1 for none */
+    explicit aligned_allocator(int n) :_node(n) {}
+
+    /** \brief Rebinding Copy Constructor */
+    template<typename U>
+    aligned_allocator(const aligned_allocator<U> &rhs) :_node(rhs.node()) {}
+
+    /** \brief Allocate storage for <em>n</em> objects
+     *  \throws <CODE>std::bad_alloc</CODE> if memory cannot be obtained
+     *  \throws <CODE>std::invalid_argument</CODE> if the NUMA node is out
+     *    of range
+     *  \throws <CODE>std::system_error</CODE> if the memory cannot be bound
+     *    to the NUMA node
+     */
+    T * allocate(std::size_t n) {
+      BOOST_STATIC_ASSERT(alignof(T) <= detail::cache_line_size);
+
+      if(n > max_size())
+        throw std::bad_alloc();
+
+      std::size_t bytes = n*sizeof(T);
+      if(bytes >= detail::huge_page_threshold)
+        return static_cast<T *>(detail::map_huge(bytes,_node));
+
+      void *p = 0;
+      if(::posix_memalign(&p,detail::cache_line_size,bytes ? bytes : 1))
+        throw std::bad_alloc();
+
+      return static_cast<T *>(p);
+    }
+
+    void deallocate(T *p, std::size_t n) {
+      std::size_t bytes = n*sizeof(T);
+      if(bytes >= detail::huge_page_threshold)
+        detail::unmap_huge(p,bytes);
+      else
+        std::free(p);
+    }
+
+    std::size_t max_size(void) const {
+      return std::numeric_limits<std::size_t>::max()/sizeof(T);
+    }
+
+    /** \brief Obtain the NUMA node large blocks are bound to, -1 for none */
+    int node(void) const {
+      return _node;
+    }
+
+  private:
+    int _node;
+};
+
+template<typename T, typename U>
+inline bool operator==(const aligned_allocator<T> &,
+  const aligned_allocator<U> &)
+{
+  return true;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const aligned_allocator<T> &,
+  const aligned_allocator<U> &)
+{
+  return false;
+}
+
+}
+}
+
+#endif
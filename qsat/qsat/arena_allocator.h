@@ -0,0 +1,390 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_ARENA_ALLOCATOR_H
+#define LEMMA_QSAT_ARENA_ALLOCATOR_H
+
+#include <boost/noncopyable.hpp>
+
+#include <new>
+#include <limits>
+#include <cstddef>
+
+/** \file
+ *  \brief Implementation of monotonic_arena and arena_allocator, a
+ *    bump-pointer allocator for short-lived channels
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \internal The size of the first chunk of a monotonic_arena by default */
+static const std::size_t arena_chunk_size = 64*1024;
+
+}
+
+/** \brief Region of memory handed out by bumping a pointer and reclaimed
+ *    all at once
+ *
+ *  \par Discussion
+ *  Memory is obtained from operator new in chunks. Each new chunk is twice
+ *  the size of the previous one so that the number of chunks grows
+ *  logarithmically with the total allocated. deallocate() reclaims memory
+ *  only if it was the most recent allocation, otherwise the memory is
+ *  reclaimed by reset() or release().
+ *
+ *  reset() makes the whole arena available again. If the previous batch
+ *  needed more than one chunk, the chunks are replaced by a single chunk of
+ *  their combined size so that a steady workload reaches a point where it
+ *  never calls operator new.
+ *
+ *  A monotonic_arena is not thread safe. Each thread should use its own.
+ */
+class monotonic_arena :private b::noncopyable {
+  public:
+    /** \brief Constructor
+     *  \param chunk The size of the first chunk in bytes, allocated on the
+     *    first call to allocate()
+     */
+    explicit monotonic_arena(std::size_t chunk = detail::arena_chunk_size);
+
+    /** \brief Destructor
+     *
+     *  Releases all memory. Nothing allocated from the arena may be used
+     *  afterwards.
+     */
+    ~monotonic_arena(void);
+
+    /** \brief Allocate <em>bytes</em> aligned to <em>align</em>
+     *  \param bytes The number of bytes
+     *  \param align The alignment, a power of two
+     *  \return A pointer to the memory
+     *  \throws <CODE>std::bad_alloc</CODE> if a new chunk cannot be obtained
+     *    or its size cannot be represented
+     */
+    void * allocate(std::size_t bytes, std::size_t align);
+
+    /** \brief Return memory obtained from allocate()
+     *
+     *  The memory is reused immediately only if it was the most recent
+     *  allocation.
+     */
+    void deallocate(void *p, std::size_t bytes);
+
+    /** \brief Make all memory of the arena available again
+     *  \pre Nothing allocated from the arena is in use
+     */
+    void reset(void);
+
+    /** \brief Return all chunks to operator new
+     *  \pre Nothing allocated from the arena is in use
+     */
+    void release(void);
+
+    /** \brief Obtain the number of bytes of all chunks */
+    std::size_t capacity(void) const {
+      return total;
+    }
+
+    /** \brief Obtain the number of bytes handed out since the last reset,
+     *    including alignment padding and unused chunk tails
+     */
+    std::size_t used(void) const;
+
+  private:
+    struct chunk {
+      chunk *next;
+      std::size_t size;
+    };
+
+    chunk *head;
+    char *cur;
+    char *last;
+    std::size_t next_size;
+    std::size_t total;
+
+    void add_chunk(std::size_t min_bytes);
+
+    static char * data(chunk *c) {
+      return reinterpret_cast<char *>(c) + header_size();
+    }
+
+    static std::size_t header_size(void) {
+      return (sizeof(chunk) + alignof(std::max_align_t) - 1)
+        & ~(alignof(std::max_align_t) - 1);
+    }
+};
+
+namespace detail {
+
+/** \internal The arena installed by the innermost scoped_arena of this
+ *  thread
+ */
+inline monotonic_arena *& current_arena(void)
+{
+  static thread_local monotonic_arena *arena = 0;
+  return arena;
+}
+
+}
+
+/** \brief Install a monotonic_arena for the allocations of a processing
+ *    batch
+ *
+ *  \par Discussion
+ *  While a scoped_arena exists, arena_allocator objects constructed by the
+ *  same thread allocate from its arena. On destruction the previously
+ *  installed arena, if any, is reinstated and the arena is reset, so every
+ *  channel allocated in the scope must have been destroyed by then.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double,std::vector,arena_allocator>
+ *    temp_channel;
+ *
+ *  monotonic_arena arena;
+ *  for(each batch) {
+ *    scoped_arena scope(arena);
+ *    temp_channel tmp(first,last);
+ *    ...
+ *  }
+ *  \endcode
+ */
+class scoped_arena :private b::noncopyable {
+  public:
+    /** \brief Constructor
+     *  \param a The arena to install for this thread
+     */
+    explicit scoped_arena(monotonic_arena &a) :arena(&a),
+      prev(detail::current_arena())
+    {
+      detail::current_arena() = arena;
+    }
+
+    /** \brief Destructor
+     *
+     *  Reinstate the previous arena and reset this one
+     */
+    ~scoped_arena(void) {
+      detail::current_arena() = prev;
+      arena->reset();
+    }
+
+  private:
+    monotonic_arena *arena;
+    monotonic_arena *prev;
+};
+
+/** \brief Allocator drawing from the monotonic_arena of the innermost
+ *    scoped_arena
+ *  \tparam T The value type
+ *
+ *  \par Discussion
+ *  An arena_allocator binds to the arena installed for the constructing
+ *  thread and keeps using it for its lifetime, including in copies and
+ *  rebound copies. A basic_channel instantiated with arena_allocator
+ *  therefore places its container, and the reference count shared between
+ *  channel copies, in the arena. Deallocation is essentially free.
+ *
+ *  If no arena is installed, memory comes from operator new as with
+ *  <code>std::allocator</code>.
+ *
+ *  arena_allocator is meant for temporaries that live within a processing
+ *  batch on one thread. Growing a channel after the batch's scoped_arena is
+ *  gone, or from a thread other than the one that owns the arena, is
+ *  undefined.
+ */
+template<typename T>
+class arena_allocator {
+  public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+      typedef arena_allocator<U> other;
+    };
+
+    /** \brief Default Constructor
+     *
+     *  Bind to the arena installed for this thread, if any
+     */
+    arena_allocator(void) :arena(detail::current_arena()) {}
+
+    /** \brief Bind to <em>a</em> explicitly */
+    explicit arena_allocator(monotonic_arena &a) :arena(&a) {}
+
+    /** \brief Rebinding Copy Constructor */
+    template<typename U>
+    arena_allocator(const arena_allocator<U> &rhs) :arena(rhs.resource()) {}
+
+    T * allocate(std::size_t n) {
+      if(n > std::numeric_limits<std::size_t>::max()/sizeof(T))
+        throw std::bad_alloc();
+
+      if(!arena)
+        return static_cast<T *>(::operator new(n*sizeof(T)));
+
+      return static_cast<T *>(arena->allocate(n*sizeof(T),alignof(T)));
+    }
+
+    void deallocate(T *p, std::size_t n) {
+      if(!arena)
+        ::operator delete(p);
+      else
+        arena->deallocate(p,n*sizeof(T));
+    }
+
+    /** \brief Obtain the arena, null if memory comes from operator new */
+    monotonic_arena * resource(void) const {
+      return arena;
+    }
+
+  private:
+    monotonic_arena *arena;
+};
+
+template<typename T, typename U>
+inline bool operator==(const arena_allocator<T> &lhs,
+  const arena_allocator<U> &rhs)
+{
+  return lhs.resource() == rhs.resource();
+}
+
+template<typename T, typename U>
+inline bool operator!=(const arena_allocator<T> &lhs,
+  const arena_allocator<U> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+
+
+inline monotonic_arena::monotonic_arena(std::size_t chunk) :head(0), cur(0),
+  last(0), next_size(chunk ? chunk : detail::arena_chunk_size), total(0)
+{
+}
+
+inline monotonic_arena::~monotonic_arena(void)
+{
+  release();
+}
+
+inline void * monotonic_arena::allocate(std::size_t bytes, std::size_t align)
+{
+  if(bytes > std::numeric_limits<std::size_t>::max() - align)
+    throw std::bad_alloc();
+
+  std::size_t pad = (align - reinterpret_cast<std::size_t>(cur)) & (align-1);
+  std::size_t room = cur ? std::size_t(last-cur) : 0;
+  if(!cur || room < pad || room-pad < bytes) {
+    add_chunk(bytes+align);
+    pad = (align - reinterpret_cast<std::size_t>(cur)) & (align-1);
+  }
+
+  void *result = cur+pad;
+  cur += pad+bytes;
+  return result;
+}
+
+inline void monotonic_arena::deallocate(void *p, std::size_t bytes)
+{
+  if(static_cast<char *>(p)+bytes == cur)
+    cur = static_cast<char *>(p);
+}
+
+inline void monotonic_arena::reset(void)
+{
+  if(!head)
+    return;
+
+  if(head->next) {
+    next_size = total;
+    release();
+    add_chunk(0);
+  }
+  else
+    cur = data(head);
+}
+
+inline void monotonic_arena::release(void)
+{
+  while(head) {
+    chunk *next = head->next;
+    ::operator delete(head);
+    head = next;
+  }
+
+  cur = last = 0;
+  total = 0;
+}
+
+inline std::size_t monotonic_arena::used(void) const
+{
+  std::size_t result = 0;
+  for(chunk *c = head; c; c = c->next)
+    result += c->size - header_size();
+
+  // only the newest chunk has room left
+  return head ? result - std::size_t(last-cur) : 0;
+}
+
+inline void monotonic_arena::add_chunk(std::size_t min_bytes)
+{
+  const std::size_t max = std::numeric_limits<std::size_t>::max();
+  if(min_bytes > max - header_size())
+    throw std::bad_alloc();
+
+  // double the chunk size until it fits, or take exactly what is needed
+  // once doubling would overflow
+  std::size_t size = next_size;
+  while(size < min_bytes+header_size())
+    size = (size > max/2 ? min_bytes+header_size() : size*2);
+
+  chunk *c = static_cast<chunk *>(::operator new(size));
+  c->next = head;
+  c->size = size;
+  head = c;
+
+  cur = data(c);
+  last = reinterpret_cast<char *>(c) + size;
+  total += size;
+  next_size = (size > std::numeric_limits<std::size_t>::max()/2 ? size : size*2);
+}
+
+}
+}
+
+#endif
@@ -35,11 +35,17 @@
 
 #include <boost/ref.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
 #include <boost/type_traits/is_const.hpp>
 #include <boost/type_traits/add_const.hpp>
+#include <boost/type_traits/remove_const.hpp>
 
 #include <vector>
 #include <iterator>
+#include <utility>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 /** \file
  *  \brief Implementation of basic_channel modeling Channel concept
@@ -73,7 +79,386 @@ class has_reserve_capability {
     typedef mpl::bool_<sizeof(test<T>(0)) == sizeof(char)> type;
 };
 
+/** \brief Capacity to give a container of <em>size</em> elements that
+ *    must hold <em>n</em> more
+ *  \internal Grows at least geometrically so that repeated appends are
+ *  amortized constant per element.
+ */
+template<typename SizeT>
+inline SizeT grown_capacity(SizeT size, SizeT n)
+{
+  return size+n > 2*size ? size+n : 2*size;
+}
+
+/** \brief Reference counted pointer to a Container used as the shared
+ *    representation of basic_channel
+ *  \internal A default constructed or moved-from pointer holds nothing and
+ *    reads as an empty container. It allocates one on first modification so
+ *    that moving a basic_channel never allocates.
+ */
+template<typename C>
+class shared_sequence_ptr {
+  public:
+    shared_sequence_ptr(void) {}
+
+    shared_sequence_ptr(b::shared_ptr<C> &&seq) noexcept
+      :sequence(std::move(seq)) {}
+
+    shared_sequence_ptr(const shared_sequence_ptr &rhs) = default;
+
+    shared_sequence_ptr(shared_sequence_ptr &&rhs) noexcept
+      :sequence(std::move(rhs.sequence)) {}
+
+    shared_sequence_ptr & operator=(const shared_sequence_ptr &rhs) = default;
+
+    shared_sequence_ptr & operator=(shared_sequence_ptr &&rhs) noexcept {
+      sequence = std::move(rhs.sequence);
+      return *this;
+    }
+
+    C & operator*(void) {
+      return *get();
+    }
+
+    const C & operator*(void) const {
+      return sequence ? *sequence : empty();
+    }
+
+    C * operator->(void) {
+      return get();
+    }
+
+    const C * operator->(void) const {
+      return &**this;
+    }
+
+    bool unique(void) const {
+      return !sequence || sequence.unique();
+    }
+
+    void swap(shared_sequence_ptr &rhs) noexcept {
+      sequence.swap(rhs.sequence);
+    }
+
+    bool operator==(const shared_sequence_ptr &rhs) const {
+      return sequence == rhs.sequence;
+    }
+
+  private:
+    b::shared_ptr<C> sequence;
+
+    C * get(void) {
+      if(!sequence)
+        sequence = b::allocate_shared<C>(typename C::allocator_type());
+      return sequence.get();
+    }
+
+    static const C & empty(void) {
+      static const C seq;
+      return seq;
+    }
+};
+
+/** \brief Storage policy for the shared representation of basic_channel
+ *  \internal
+ *
+ *  <em>pointer</em> must model a reference counted pointer to a
+ *  <em>Container</em> providing <code>unique()</code>, <code>swap()</code>,
+ *  and equality comparison. Moving a pointer must not throw and must leave
+ *  the source referring to an empty container. <em>make</em> constructs a
+ *  new, unshared container from the given constructor arguments. The
+ *  default places the container and its reference count in a single
+ *  allocation obtained from the container's allocator. Containers that carry
+ *  their own reference count specialize this template.
+ */
+template<typename Container>
+struct sequence_storage {
+  typedef shared_sequence_ptr<Container> pointer;
+
+  template<typename... Args>
+  static pointer make(Args &&...args) {
+    return b::allocate_shared<Container>(
+      typename Container::allocator_type(),std::forward<Args>(args)...);
+  }
+};
+
+/** \brief Number of consecutive elements that writing through a mutable
+ *    Iterator detaches from shared storage at once
+ *  \internal 0 if the copy-on-write check of basic_channel::begin() already
+ *  detached all of the storage. Iterators of containers that detach lazily
+ *  on element access, eg chunked_sequence, specialize this template so that
+ *  the storage can be detached before it is written by several threads.
+ */
+template<typename Iterator>
+struct detach_stride {
+  static const std::size_t value = 0;
+};
+
+/** \brief How a subchannel locates its interval within a channel
+ *  \internal
+ *
+ *  basic_subchannel records <em>offset</em> of its first element once, when
+ *  bound, and obtains times from it with <em>time</em>. Offsets are relative
+ *  to begin() by default. Iterators of Containers that are not random
+ *  access survive insertion and erasure before them, so for these the
+ *  offset is recorded along with <em>revision</em>, which changes whenever
+ *  elements may have moved, and recomputed only when it differs. Channels
+ *  whose begin() moves without invalidating iterators, eg
+ *  basic_ring_channel, specialize this template so that the recorded
+ *  offset remains meaningful.
+ *
+ *  \par
+ *  The primary template also holds the mapping from a sample index to its
+ *  time shared by basic_channel and the channels that compute their
+ *  samples, eg basic_generated_channel.
+ */
+template<typename ChannelT>
+struct channel_position {
+  static typename ChannelT::size_type
+  offset(const ChannelT &ch, typename ChannelT::const_iterator pos) {
+    return std::distance(ch.begin(),pos);
+  }
+
+  static typename ChannelT::time_type
+  time(const ChannelT &ch, typename ChannelT::size_type off) {
+    return time(ch.epoch(),ch.frequency(),off);
+  }
+
+  /** \internal The time of sample \e off of a channel starting at \e epoch
+   *  with frequency \e freq
+   */
+  static typename ChannelT::time_type
+  time(const typename ChannelT::time_type &epoch,
+    const typename ChannelT::frequency_type &freq,
+    typename ChannelT::size_type off)
+  {
+    return epoch + double(off) / freq;
+  }
+
+  /** \internal Only used for Containers that are not random access */
+  static std::size_t revision(const ChannelT &ch) {
+    return ch._revision;
+  }
+};
+
+/** \brief Machine epsilon of the arithmetic used for times
+ *  \internal That of TimeT if it is a floating point type, otherwise that
+ *  of double.
+ */
+template<typename TimeT,
+  bool Float = std::numeric_limits<TimeT>::is_specialized &&
+    !std::numeric_limits<TimeT>::is_integer>
+struct time_epsilon {
+  static double get(void) {
+    return std::numeric_limits<double>::epsilon();
+  }
+};
+
+template<typename TimeT>
+struct time_epsilon<TimeT,true> {
+  static double get(void) {
+    double eps = std::numeric_limits<TimeT>::epsilon();
+    return eps > std::numeric_limits<double>::epsilon() ?
+      eps : std::numeric_limits<double>::epsilon();
+  }
+};
+
+/** \brief Map a time onto a sample index
+ *  \internal
+ *
+ *  Returns the index of the first sample whose time is not earlier than
+ *  \e t, clamped to [0,\e size]. Times within a few units of rounding of
+ *  a sample are taken to be that sample so that <tt>index_at(time_at(n))
+ *  == n</tt> despite rounding. The tolerance is that of computing
+ *  <tt>(t - start) * freq</tt>, so it scales with the magnitude of the
+ *  times rather than with the index.
+ */
+template<typename SizeT, typename TimeT, typename FrequencyT>
+inline SizeT time_index(const TimeT &start, const FrequencyT &freq,
+  const TimeT &t, SizeT size)
+{
+  double x = (t - start) * freq;
+  if(!(x > 0))
+    return 0;
+
+  double scale = (std::fabs(scalar_value<TimeT>::get(t)) +
+    std::fabs(scalar_value<TimeT>::get(start))) *
+      std::fabs(scalar_value<FrequencyT>::get(freq));
+
+  double tol = 4*time_epsilon<TimeT>::get()*(std::max(1.0,x) + scale);
+
+  double near = std::floor(x + 0.5);
+  double idx = std::fabs(x - near) <= tol ? near : std::ceil(x);
+
+  return idx >= double(size) ? size : SizeT(idx);
+}
+
+
+}
+
+template<typename ExprT>
+class channel_expression;
+
+/** \brief Detached interval of a channel's underlying representation
+ *
+ *  \par Discussion
+ *  A write lease is obtained from basic_channel::lease() or
+ *  basic_subchannel::lease(). Obtaining the lease performs the copy-on-write
+ *  check of the channel's underlying representation exactly once. Element
+ *  access through the lease is then a plain dereference of the underlying
+ *  container iterator and never triggers another sharing check or copy. This
+ *  makes the lease the preferred means of mutating all (or most) of the
+ *  samples of a channel in a tight loop.
+ *
+ *  \par
+ *  The lease is invalidated by any operation that would invalidate the
+ *  iterators of the leased channel. In addition, a copy of the leased channel
+ *  made while the lease is still in use shares the representation that the
+ *  lease writes into. ie the leased channel should not be copied or assigned
+ *  from until the lease is no longer in use.
+ *  \code
+ *  typedef basic_channel<float,float,float> channel_type;
+ *
+ *  channel_type channel; // assume filled with values
+ *  channel_type::lease_type samples = channel.lease(); // copy occurs here
+ *
+ *  for(std::size_t i=0; i<samples.size(); ++i)
+ *    samples[i] = samples[i]*gain + offset; // no sharing checks
+ *  \endcode
+ */
+template<typename ChannelT>
+class basic_write_lease {
+  public:
+    /** lvalue of ChannelT::value_type
+     *  (const-ness dependent on ChannelT)
+     */
+    typedef typename mpl::if_<
+      b::is_const<ChannelT>,
+      typename ChannelT::const_reference,
+      typename ChannelT::reference>::type reference;
+
+    /** iterator type pointing to ChannelT::value_type
+     *  (const-ness dependent on ChannelT)
+     */
+    typedef typename mpl::if_<
+      b::is_const<ChannelT>,
+      typename ChannelT::const_iterator,
+      typename ChannelT::iterator>::type iterator;
+
+    /** unsigned integral type */
+    typedef typename ChannelT::size_type size_type;
+    /** signed integral type */
+    typedef typename ChannelT::difference_type difference_type;
+    /** MagnitudeT */
+    typedef typename ChannelT::value_type value_type;
+
+    /** \brief Constructor
+     *
+     *  Lease the interval [\e first, \e last)
+     *
+     *  \param first,last Detached interval of the leased channel
+     *
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    basic_write_lease(iterator first, iterator last);
+
+    /** \brief Obtain iterator to the leased interval beginning
+     *  \return iterator to MagnitudeT
+     */
+    iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past the leased interval end
+     *  \return iterator to MagnitudeT
+     */
+    iterator end(void) const;
+
+    /** \brief Obtain the number of elements contained in the leased interval
+     *  \return leased interval size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain whether or not the leased interval contains any values
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Obtain a reference to the value stored at leased location
+     *    <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     */
+    reference operator[](size_type n) const;
+
+    /** \brief Obtain the element at the beginning of the leased interval
+     *  \return element reference
+     */
+    reference front(void) const;
+
+    /** \brief Obtain the last element of the leased interval
+     *  \return element reference
+     */
+    reference back(void) const;
 
+  private:
+    iterator lease_first;
+    iterator lease_last;
+    size_type lease_size;
+};
+
+template<typename ChannelT>
+inline basic_write_lease<ChannelT>::basic_write_lease(iterator first,
+  iterator last) :lease_first(first), lease_last(last),
+    lease_size(std::distance(first,last))
+{
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::iterator
+basic_write_lease<ChannelT>::begin(void) const
+{
+  return lease_first;
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::iterator
+basic_write_lease<ChannelT>::end(void) const
+{
+  return lease_last;
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::size_type
+basic_write_lease<ChannelT>::size(void) const
+{
+  return lease_size;
+}
+
+template<typename ChannelT>
+inline bool basic_write_lease<ChannelT>::empty(void) const
+{
+  return lease_size == 0;
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::reference
+basic_write_lease<ChannelT>::operator[](size_type n) const
+{
+  return lease_first[n];
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::reference
+basic_write_lease<ChannelT>::front(void) const
+{
+  return *lease_first;
+}
+
+template<typename ChannelT>
+inline typename basic_write_lease<ChannelT>::reference
+basic_write_lease<ChannelT>::back(void) const
+{
+  iterator last = lease_last;
+  return *--last;
 }
 
 /** \brief Reference into a basic_channel interval
@@ -163,7 +548,9 @@ class basic_subchannel {
     /** Subchannel type */
     typedef basic_subchannel<
       typename b::add_const<ChannelT>::type> const_subchannel_type;
-    
+    /** Write lease type over the subchannel interval */
+    typedef basic_write_lease<ChannelT> lease_type;
+
     /** MagnitudeT */
     typedef typename ChannelT::magnitude_type magnitude_type;
     /** FrequencyT */
@@ -182,6 +569,20 @@ class basic_subchannel {
      */
     explicit basic_subchannel(ChannelT &ch, iterator first, iterator last);
 
+    /** \brief Constructor
+     *
+     *  Bind to \e ch with interval [\e first, \e last) where the offset
+     *  of \e first in \e ch is already known
+     *
+     *  \param ch Parent channel
+     *  \param first,last Interval over \e ch to bind to
+     *  \param offset <code>std::distance(ch.begin(),first)</code>
+     *
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    basic_subchannel(ChannelT &ch, iterator first, iterator last,
+      size_type offset);
+
     /** \brief Copy Constructor
      *
      *  \param rhs rvalue of type basic_channel
@@ -277,11 +678,39 @@ class basic_subchannel {
     const frequency_type & frequency(void) const;
 
     /** \brief Obtain the current sample epoch
+     *
+     *  \par Discussion
+     *  For random access Containers the offset of the subchannel into its
+     *  channel is recorded when the interval is bound so this is constant
+     *  time. Other Containers, eg std::list, keep iterators valid across
+     *  insertion and erasure, so their recorded offset is recomputed, in
+     *  time linear in offset(), the first time it is needed after elements
+     *  are inserted into or erased from the channel. Otherwise this is also
+     *  constant time.
      *
      *  \return The current sample epoch
      */
     time_type epoch(void) const;
 
+    /** \brief Obtain the offset of the subchannel into its channel
+     *  \return <code>std::distance(channel().begin(),begin())</code>, at the
+     *    time the interval was bound for random access Containers
+     */
+    size_type offset(void) const;
+
+    /** \brief Obtain the index of the sample at a given time
+     *  \param t A time
+     *  \return The index of the first sample in the subchannel whose time is
+     *    not earlier than \e t or size() if there is none
+     */
+    size_type index_at(const time_type &t) const;
+
+    /** \brief Obtain the time of a given sample
+     *  \param n A sample index
+     *  \return The time of the sample at location \e n
+     */
+    time_type time_at(size_type n) const;
+
     /** \brief Obtain a refrence to the channel that this subchannel is an
      *  interval over
      *  \return Channel reference
@@ -302,7 +731,27 @@ class basic_subchannel {
      *  \return A subset of this subchannel.
      */
     subchannel_type subchannel(iterator first, iterator last) const;
-    
+
+    /** \brief Obtain the subset of this subchannel within a time interval
+     *
+     *  \param t0,t1 The time interval [\e t0, \e t1)
+     *  \return A subchannel over [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>) of this subchannel
+     */
+    subchannel_type subchannel(const time_type &t0,
+      const time_type &t1) const;
+
+    /** \brief Obtain a write lease over the subchannel interval
+     *
+     *  \par Discussion
+     *  The parent channel was already detached when this mutable subchannel
+     *  was obtained so no additional sharing check is performed. The returned
+     *  lease has the same validity as the subchannel itself.
+     *
+     *  \return A lease over [begin(),end())
+     */
+    lease_type lease(void) const;
+
     /** \brief Compare two subchannels for equality
      *  \return this->channel() == rhs.channel() && this->begin() == rhs.begin()
      *    && this->end() == rhs.end()
@@ -315,20 +764,43 @@ class basic_subchannel {
     bool operator!=(const basic_subchannel &rhs) const;
     
   private:
+    typedef typename std::iterator_traits<iterator>::iterator_category
+      iterator_category;
+
     iterator sub_first;
     iterator sub_last;
+    mutable size_type sub_offset;
+    mutable std::size_t sub_revision;
     b::reference_wrapper<ChannelT> base;
+
+    size_type offset_of(iterator pos) const;
+    size_type current_offset(std::random_access_iterator_tag) const;
+    size_type current_offset(std::input_iterator_tag) const;
+    std::size_t channel_revision(std::random_access_iterator_tag) const;
+    std::size_t channel_revision(std::input_iterator_tag) const;
 };
 
 template<typename ChannelT>
 inline basic_subchannel<ChannelT>::basic_subchannel(ChannelT &ch,
-  iterator first, iterator last) :sub_first(first), sub_last(last), base(ch)
+  iterator first, iterator last) :sub_first(first), sub_last(last),
+    sub_offset(0), sub_revision(0), base(ch)
+{
+  sub_offset = offset_of(first);
+  sub_revision = channel_revision(iterator_category());
+}
+
+template<typename ChannelT>
+inline basic_subchannel<ChannelT>::basic_subchannel(ChannelT &ch,
+  iterator first, iterator last, size_type offset) :sub_first(first),
+    sub_last(last), sub_offset(offset), sub_revision(0), base(ch)
 {
+  sub_revision = channel_revision(iterator_category());
 }
 
 template<typename ChannelT>
 inline basic_subchannel<ChannelT>::basic_subchannel(const basic_subchannel &rhs)
-  :sub_first(rhs.sub_first), sub_last(rhs.sub_last), base(rhs.base)
+  :sub_first(rhs.sub_first), sub_last(rhs.sub_last),
+    sub_offset(rhs.sub_offset), sub_revision(rhs.sub_revision), base(rhs.base)
 {
 }
 
@@ -344,6 +816,8 @@ basic_subchannel<ChannelT>::operator=(const basic_subchannel &rhs)
   if(this != &rhs) {
     sub_first = rhs.sub_first;
     sub_last = rhs.sub_last;
+    sub_offset = rhs.sub_offset;
+    sub_revision = rhs.sub_revision;
     base = rhs.base;
   }
   
@@ -379,6 +853,8 @@ template<typename ChannelT>
 inline typename basic_subchannel<ChannelT>::iterator
 basic_subchannel<ChannelT>::begin(iterator pos)
 {
+  sub_offset = offset_of(pos);
+  sub_revision = channel_revision(iterator_category());
   return (sub_first = pos);
 }
 
@@ -456,12 +932,32 @@ template<typename ChannelT>
 inline typename basic_subchannel<ChannelT>::time_type
 basic_subchannel<ChannelT>::epoch(void) const
 {
+  return time_at(0);
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::size_type
+basic_subchannel<ChannelT>::offset(void) const
+{
+  return current_offset(iterator_category());
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::size_type
+basic_subchannel<ChannelT>::index_at(const time_type &t) const
+{
+  return detail::time_index(epoch(),frequency(),t,size());
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::time_type
+basic_subchannel<ChannelT>::time_at(size_type n) const
+{
+  typedef typename b::remove_const<ChannelT>::type plain_channel_type;
   typedef typename b::add_const<ChannelT>::type const_channel_type;
-  const_channel_type &c_base = static_cast<const_channel_type&>(base);
 
-  return c_base.epoch() +
-    double(std::distance(c_base.begin(),
-      typename const_channel_type::const_iterator(sub_first))) / frequency();
+  return detail::channel_position<plain_channel_type>::time(
+    static_cast<const_channel_type&>(base),offset()+n);
 }
 
 template<typename ChannelT>
@@ -475,7 +971,33 @@ template<typename ChannelT>
 inline typename basic_subchannel<ChannelT>::subchannel_type
 basic_subchannel<ChannelT>::subchannel(iterator first, iterator last) const
 {
-  return static_cast<ChannelT>(base).subchannel(first,last);
+  return static_cast<ChannelT&>(base).subchannel(first,last);
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::subchannel_type
+basic_subchannel<ChannelT>::subchannel(const time_type &t0,
+  const time_type &t1) const
+{
+  size_type first = index_at(t0);
+  size_type last = index_at(t1);
+  if(last < first)
+    last = first;
+
+  iterator sfirst = sub_first;
+  std::advance(sfirst,first);
+  iterator slast = sfirst;
+  std::advance(slast,last-first);
+
+  return subchannel_type(static_cast<ChannelT&>(base),sfirst,slast,
+    offset()+first);
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::lease_type
+basic_subchannel<ChannelT>::lease(void) const
+{
+  return lease_type(sub_first,sub_last);
 }
 
 template<typename ChannelT>
@@ -492,6 +1014,63 @@ inline bool basic_subchannel<ChannelT>::operator!=(const basic_subchannel &rhs)
   return !(*this == rhs);
 }
 
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::size_type
+basic_subchannel<ChannelT>::offset_of(iterator pos) const
+{
+  // read through the const interface so a shared channel is not detached
+  typedef typename b::remove_const<ChannelT>::type plain_channel_type;
+  typedef typename b::add_const<ChannelT>::type const_channel_type;
+
+  return detail::channel_position<plain_channel_type>::offset(
+    static_cast<const_channel_type&>(base),
+    typename const_channel_type::const_iterator(pos));
+}
+
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::size_type
+basic_subchannel<ChannelT>::current_offset(
+  std::random_access_iterator_tag) const
+{
+  return sub_offset;
+}
+
+/** \internal Iterators of other Containers survive insertion before the
+ *  subchannel, which would leave a recorded offset stale, so it is
+ *  recomputed once whenever the channel revision has changed.
+ */
+template<typename ChannelT>
+inline typename basic_subchannel<ChannelT>::size_type
+basic_subchannel<ChannelT>::current_offset(std::input_iterator_tag) const
+{
+  std::size_t rev = channel_revision(iterator_category());
+  if(rev != sub_revision) {
+    sub_offset = offset_of(sub_first);
+    sub_revision = rev;
+  }
+
+  return sub_offset;
+}
+
+template<typename ChannelT>
+inline std::size_t
+basic_subchannel<ChannelT>::channel_revision(
+  std::random_access_iterator_tag) const
+{
+  return 0;
+}
+
+template<typename ChannelT>
+inline std::size_t
+basic_subchannel<ChannelT>::channel_revision(std::input_iterator_tag) const
+{
+  typedef typename b::remove_const<ChannelT>::type plain_channel_type;
+  typedef typename b::add_const<ChannelT>::type const_channel_type;
+
+  return detail::channel_position<plain_channel_type>::revision(
+    static_cast<const_channel_type&>(base));
+}
+
 /** \brief Core signal container
  *  \tparam MagnitudeT The signal magnitude type
  *  \tparam FrequencyT The signal frequency type
@@ -502,6 +1081,17 @@ inline bool basic_subchannel<ChannelT>::operator!=(const basic_subchannel &rhs)
  *  A basic_channel is the base object used to encapsulate signal data. It is
  *  basically a STL random-access sequence with an extra sampling interval
  *  and start time member.
+ *
+ *  \par Thread safety
+ *  Copies of a basic_channel share the underlying container until one of
+ *  them is modified. The shared container is only ever read through const
+ *  members, and the reference count is maintained atomically, so distinct
+ *  basic_channel objects that share storage may be read, written, and
+ *  destroyed concurrently from different threads. As with the standard
+ *  containers, a single basic_channel object may not be copied or read in
+ *  one thread while it is being modified in another. Use
+ *  basic_live_channel when one thread must append samples while others
+ *  observe them.
  */
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container = std::vector,
@@ -548,6 +1138,8 @@ class basic_channel {
     typedef basic_subchannel<basic_channel> subchannel_type;
     /** Subchannel type representing const interval of basic_channel */
     typedef basic_subchannel<const basic_channel> const_subchannel_type;
+    /** Write lease type representing detached interval of basic_channel */
+    typedef basic_write_lease<basic_channel> lease_type;
     
     /** \brief Default Constructor
      *  \param tp A <code>std::pair<FrequencyT,TimeT></code> where
@@ -619,11 +1211,55 @@ class basic_channel {
       const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
       const TimeT &start=detail::value_cast<TimeT>::construct(0));
 
+    /** \brief Adopting Constructor
+     *
+     *  Construct a channel that takes ownership of the samples of
+     *  <em>seq</em> without copying them. This is the means of constructing
+     *  a channel over a container that cannot be constructed from the
+     *  other constructor arguments, eg a mapped_sequence bound to a file.
+     *
+     *  \param seq The container whose contents are moved into the channel
+     *  \param freq A value of <code>basic_channel::frequency_type</code>
+     *    representing the sample frequency. Default is
+     *    <code>basic_channel::frequency_type(1)</code>.
+     *  \param start A value of <code>basic_channel::time_type</code>
+     *    representing the time sampling started. Default is
+     *    <code>basic_channel::time_type(0)</code>.
+     *
+     *  \post size() == the size of <em>seq</em> before the call
+     */
+    explicit basic_channel(container_type &&seq,
+      const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
+      const TimeT &start=detail::value_cast<TimeT>::construct(0));
+
     /** \brief Copy Constructor
      *
      *  \param rhs rvalue of type basic_channel
      */
     basic_channel(const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &rhs);
+
+    /** \brief Move Constructor
+     *
+     *  Take the samples of <em>rhs</em> without copying them, touching
+     *  their reference count or allocating. <em>rhs</em> obtains new
+     *  storage the next time it is modified.
+     *
+     *  \param rhs rvalue of type basic_channel
+     *  \throws Nothing
+     *  \post <em>rhs</em> is empty
+     */
+    basic_channel(basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &&rhs) noexcept;
+
+    /** \brief Expression Constructor
+     *
+     *  Construct a channel holding the samples of <em>expr</em>, computed in
+     *  a single pass, with the frequency and epoch of <em>expr</em>.
+     *
+     *  \param expr A channel_expression, eg <code>a + b * 2.0f</code>
+     *  \post size() == <em>expr</em>.size()
+     */
+    template<typename ExprT>
+    basic_channel(const channel_expression<ExprT> &expr);
     
     /** \brief Destructor
      */
@@ -635,6 +1271,30 @@ class basic_channel {
      */
     basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &
     operator=(const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &rhs);
+
+    /** \brief Move Assignment Operator
+     *  \param rhs rvalue of type basic_channel, which receives the previous
+     *    contents of this channel
+     *  \return <code>*this</code>
+     */
+    basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &
+    operator=(basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &&rhs);
+
+    /** \brief Expression Assignment Operator
+     *  \param expr A channel_expression, eg <code>a + b * 2.0f</code>
+     *  \return <code>*this</code>
+     *  \post size() == <em>expr</em>.size()
+     *
+     *  \par Discussion
+     *  The samples of <em>expr</em> are computed in a single pass and
+     *  written directly into the underlying sequence. If the sequence is not
+     *  shared and already has the right size, it is overwritten in place so
+     *  that <code>a = a * 2.0f</code> allocates nothing. The frequency and
+     *  epoch are taken from <em>expr</em>.
+     */
+    template<typename ExprT>
+    basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &
+    operator=(const channel_expression<ExprT> &expr);
     
     /** \brief Range Assignment Operator
      *  \param first,last <code>InputIterator</code> range pointing to objects
@@ -807,6 +1467,60 @@ class basic_channel {
      */
     void push_back(const MagnitudeT &val);
 
+    /** \brief Add a new element at the end of the sequence
+     *  \param val The value of the new element, which is moved from if the
+     *    sequence is not shared
+     */
+    void push_back(MagnitudeT &&val);
+
+    /** \brief Add a new element constructed from <em>args</em> at the end
+     *    of the sequence
+     *  \param args Constructor arguments of MagnitudeT
+     */
+    template<typename... Args>
+    void emplace_back(Args &&...args);
+
+    /** \brief Add the elements of <code>[first,last)</code> at the end of
+     *    the sequence
+     *
+     *  \par Discussion
+     *  A shared sequence is copied once, with room for the new elements
+     *  and geometric spare capacity, regardless of the number of elements
+     *  appended. The elements are then inserted in bulk. Appending k
+     *  elements is therefore O(k) for an unshared sequence and O(size()+k)
+     *  for a shared one, unlike k calls to push_back().
+     *
+     *  \param first,last An <code>InputIterator</code> range pointing to
+     *    objects convertable to MagnitudeT, not referring to this channel
+     */
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    /** \brief Add the elements of <em>range</em> at the end of the sequence
+     *
+     *  As append(InputIterator,InputIterator) with
+     *  <code>std::begin(range)</code> and <code>std::end(range)</code>, eg
+     *  for an array or a block held in a <code>std::vector</code>.
+     *
+     *  \param range A range of objects convertable to MagnitudeT, not
+     *    referring to this channel
+     */
+    template<typename Range>
+    void append(const Range &range);
+
+    /** \brief Add <em>n</em> elements obtained from successive calls of
+     *    <code>gen()</code> at the end of the sequence
+     *
+     *  A shared sequence is copied at most once, as with append(). If
+     *  <em>gen</em> throws, the elements generated so far remain.
+     *
+     *  \param n The number of elements to add
+     *  \param gen A function object returning values convertable to
+     *    MagnitudeT
+     */
+    template<typename Generator>
+    void append_n(size_type n, Generator gen);
+
     /** \brief Remove the last element of the sequence
      */
     void pop_back(void);
@@ -819,6 +1533,25 @@ class basic_channel {
      */
     iterator insert(iterator position, const MagnitudeT &val);
 
+    /** \brief Insert a new element into the sequence before <em>position</em>
+     *  \param position An iterator pointing to the location the element should
+     *    be inserted before
+     *  \param val The value of the new element, which is moved from if the
+     *    sequence is not shared
+     *  \return An iterator pointing to the new element
+     */
+    iterator insert(iterator position, MagnitudeT &&val);
+
+    /** \brief Insert a new element constructed from <em>args</em> into the
+     *    sequence before <em>position</em>
+     *  \param position An iterator pointing to the location the element should
+     *    be inserted before
+     *  \param args Constructor arguments of MagnitudeT
+     *  \return An iterator pointing to the new element
+     */
+    template<typename... Args>
+    iterator emplace(iterator position, Args &&...args);
+
     /** \brief Insert <em>n</em> elements into the sequence before <em>position</em>
      *  \param position An iterator pointing to the location the elements should
      *    be inserted before
@@ -917,26 +1650,104 @@ class basic_channel {
     /** \brief Obtain a constant subset of this channel
      *
      *  \par Discussion
-     *  The lifetime of the channel is not bound to the returned
-     *  subchannel. Make sure that the channel bound to the subchannel has
-     *  a longer lifetime than the subchannel to be used.
+     *  The lifetime of the channel is not bound to the returned
+     *  subchannel. Make sure that the channel bound to the subchannel has
+     *  a longer lifetime than the subchannel to be used.
+     *
+     *  \return A constant subset into this channel.
+     */
+    const_subchannel_type subchannel(const_iterator first,
+      const_iterator last) const;
+
+    /** \brief Obtain a mutable subset of this channel within a time
+     *    interval
+     *
+     *  \par Discussion
+     *  As with subchannel(iterator,iterator), obtaining a mutable subset will
+     *  cause a copy operation of this channel's underlying bound
+     *  representation if it is shared.
+     *
+     *  \param t0,t1 The time interval [\e t0, \e t1)
+     *  \return A mutable subset over [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>)
+     */
+    subchannel_type subchannel(const time_type &t0, const time_type &t1);
+
+    /** \brief Obtain a constant subset of this channel within a time
+     *    interval
+     *
+     *  \param t0,t1 The time interval [\e t0, \e t1)
+     *  \return A constant subset over [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>)
+     */
+    const_subchannel_type subchannel(const time_type &t0,
+      const time_type &t1) const;
+
+    /** \brief Obtain the index of the sample at a given time
+     *
+     *  \par Discussion
+     *  Computed from the epoch and frequency in constant time. Times within
+     *  a small relative tolerance of a sample time map to that sample.
+     *
+     *  \param t A time
+     *  \return The index of the first sample whose time is not earlier than
+     *    \e t or size() if there is none
+     */
+    size_type index_at(const time_type &t) const;
+
+    /** \brief Obtain the time of a given sample
+     *  \param n A sample index
+     *  \return <code>epoch() + n/frequency()</code>
+     */
+    time_type time_at(size_type n) const;
+
+    /** \brief Obtain a write lease over the entire channel
+     *
+     *  \par Discussion
+     *  The underlying representation is detached exactly once, here, rather
+     *  than on every mutable element access. See basic_write_lease for the
+     *  lifetime requirements of the returned lease.
      *
-     *  \return A constant subset into this channel.
+     *  \return A lease over [begin(),end())
      */
-    const_subchannel_type subchannel(const_iterator first,
-      const_iterator last) const;
+    lease_type lease(void);
 
   private:
     FrequencyT _sample_frequency;
     TimeT _time_start;
     
-    b::shared_ptr<container_type> sequence;
+    typedef detail::sequence_storage<container_type> storage;
+    typedef typename storage::pointer storage_pointer;
+
+    storage_pointer sequence;
+
+    // changed by every modification that may move elements relative to
+    // begin(), see detail::channel_position
+    std::size_t _revision;
+
+    friend struct detail::channel_position<basic_channel>;
+
+    const container_type & const_sequence(void) const;
+
+    void reserve_impl(size_type sz, mpl::false_);
+    void reserve_impl(size_type sz, mpl::true_);
 
     void resize_impl(size_type sz, const MagnitudeT &mag, mpl::false_);
     void resize_impl(size_type sz, const MagnitudeT &mag, mpl::true_);
 
     void push_back_impl(const MagnitudeT &val, mpl::false_);
     void push_back_impl(const MagnitudeT &val, mpl::true_);
+
+    void detach_append(size_type n, mpl::false_);
+    void detach_append(size_type n, mpl::true_);
+
+    template<typename InputIterator>
+    void append_impl(InputIterator first, InputIterator last,
+      std::input_iterator_tag);
+
+    template<typename ForwardIterator>
+    void append_impl(ForwardIterator first, ForwardIterator last,
+      std::forward_iterator_tag);
     
     iterator insert_impl(iterator position, const MagnitudeT &val, mpl::false_);
     iterator insert_impl(iterator position, const MagnitudeT &val, mpl::true_);
@@ -976,14 +1787,15 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T> class Allocator>
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   basic_channel(const std::pair<FrequencyT,TimeT> &tp) :_sample_frequency(tp.first),
-  _time_start(tp.second), sequence(new container_type()) {}
+  _time_start(tp.second), sequence(storage::make()), _revision(0) {}
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::basic_channel(size_type n,
   const MagnitudeT &value, const FrequencyT &freq, const TimeT &start)
-    :_sample_frequency(freq), _time_start(start), sequence(new container_type(n,value)) {}
+    :_sample_frequency(freq), _time_start(start), sequence(storage::make(n,value)),
+    _revision(0) {}
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
@@ -991,19 +1803,50 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 template<typename InputIterator>
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::basic_channel(InputIterator first,
   InputIterator last, const FrequencyT &freq, const TimeT &start)
-    :_sample_frequency(freq), _time_start(start), sequence(new container_type(first,last)) {}
+    :_sample_frequency(freq), _time_start(start), sequence(storage::make(first,last)),
+    _revision(0) {}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::basic_channel(container_type &&seq,
+  const FrequencyT &freq, const TimeT &start)
+    :_sample_frequency(freq), _time_start(start), sequence(storage::make(std::move(seq))),
+    _revision(0) {}
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   basic_channel(const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &rhs)
-    :_sample_frequency(rhs._sample_frequency), _time_start(rhs._time_start), sequence(rhs.sequence) {}
+    :_sample_frequency(rhs._sample_frequency), _time_start(rhs._time_start), sequence(rhs.sequence),
+    _revision(0) {}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  basic_channel(basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &&rhs) noexcept
+    :_sample_frequency(rhs._sample_frequency), _time_start(rhs._time_start),
+    sequence(std::move(rhs.sequence)), _revision(0) {}
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::~basic_channel(void) {}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename ExprT>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  basic_channel(const channel_expression<ExprT> &expr)
+    :_sample_frequency(expr.derived().frequency()),
+    _time_start(expr.derived().epoch()),
+    sequence(storage::make(expr.derived().size())), _revision(0)
+{
+  expr.evaluate(sequence->begin());
+}
     
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
@@ -1011,6 +1854,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> & basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   operator=(const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &rhs)
 {
+  ++_revision;
   if(&rhs != this) {
     _sample_frequency = rhs._sample_frequency;
     _time_start = rhs._time_start;
@@ -1020,6 +1864,45 @@ inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> & basic_ch
   return *this;
 }
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> & basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  operator=(basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &&rhs)
+{
+  swap(rhs);
+  return *this;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename ExprT>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  operator=(const channel_expression<ExprT> &expr)
+{
+  ++_revision;
+  const ExprT &e = expr.derived();
+
+  // the expression may refer to this channel so evaluate before updating
+  FrequencyT freq = e.frequency();
+  TimeT start = e.epoch();
+
+  if(sequence.unique() && sequence->size() == e.size())
+    e.evaluate(sequence->begin());
+  else {
+    storage_pointer tmp(storage::make(e.size()));
+    e.evaluate(tmp->begin());
+    sequence.swap(tmp);
+  }
+
+  _sample_frequency = freq;
+  _time_start = start;
+
+  return *this;
+}
+
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
@@ -1027,10 +1910,11 @@ template<typename InputIterator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::assign(InputIterator first,
   InputIterator last)
 {
+  ++_revision;
   if(sequence.unique())
     sequence->assign(first,last);
   else
-    sequence.reset(new container_type(first,last));
+    sequence = storage::make(first,last);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1040,13 +1924,14 @@ template<typename InputIterator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::assign(InputIterator first,
   InputIterator last, const FrequencyT &freq, const TimeT &start)
 {
+  ++_revision;
   _sample_frequency = freq;
   _time_start = start;
 
   if(sequence.unique())
     sequence->assign(first,last);
   else
-    sequence.reset(new container_type(first,last));
+    sequence = storage::make(first,last);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1055,10 +1940,11 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::assign(size_type n,
   const MagnitudeT &val)
 {
+  ++_revision;
   if(sequence.unique())
     sequence->assign(n,val);
   else
-    sequence.reset(new container_type(n,val));
+    sequence = storage::make(n,val);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1067,13 +1953,14 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::assign(size_type n,
   const MagnitudeT &val, const FrequencyT &freq, const TimeT &start)
 {
+  ++_revision;
   _sample_frequency = freq;
   _time_start = start;
 
   if(sequence.unique())
     sequence->assign(n,val);
   else
-    sequence.reset(new container_type(n,val));
+    sequence = storage::make(n,val);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1083,7 +1970,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::begin(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
   
   return sequence->begin();
 }
@@ -1094,7 +1981,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::begin(void) const
 {
-  return sequence->begin();
+  return const_sequence().begin();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1104,7 +1991,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::end(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
   
   return sequence->end();
 }
@@ -1115,7 +2002,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::end(void) const
 {
-  return sequence->end();
+  return const_sequence().end();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1125,7 +2012,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::rbegin(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
   
   return sequence->rbegin();
 }
@@ -1136,7 +2023,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reverse_iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::rbegin(void) const
 {
-  return sequence->rbegin();
+  return const_sequence().rbegin();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1146,7 +2033,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::rend(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
   
   return sequence->rend();
 }
@@ -1157,7 +2044,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reverse_iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::rend(void) const
 {
-  return sequence->rend();
+  return const_sequence().rend();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1184,6 +2071,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::resize(size_type sz,
   const MagnitudeT &mag)
 {
+  ++_revision;
   if(sequence.unique())
     sequence->resize(sz,mag);
   else
@@ -1217,12 +2105,8 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::rese
 
   if(sequence.unique())
     sequence->reserve(sz);
-  else {
-    b::shared_ptr<container_type> tmp(new container_type());
-    tmp->reserve(sz);
-    tmp->assign(sequence->begin(),sequence->end());
-    sequence.swap(tmp);
-  }
+  else
+    reserve_impl(sz,typename detail::has_reserve_capability<container_type>::type());
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1232,7 +2116,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::operator[](size_type n)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
 
   return sequence->operator[](n);
 }
@@ -1243,7 +2127,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reference
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::operator[](size_type n) const
 {
-  return sequence->operator[](n);
+  return const_sequence().operator[](n);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1252,7 +2136,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reference
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::at(size_type n) const
 {
-  return sequence->at(n);
+  return const_sequence().at(n);
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1262,7 +2146,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::at(size_type n)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
 
   return sequence->at(n);
 }
@@ -1274,7 +2158,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::front(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
 
   return sequence->front();
 }
@@ -1285,7 +2169,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reference
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::front(void) const
 {
-  return sequence->front();
+  return const_sequence().front();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1295,7 +2179,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::back(void)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
 
   return sequence->back();
 }
@@ -1306,7 +2190,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_reference
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::back(void) const
 {
-  return sequence->back();
+  return const_sequence().back();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1321,6 +2205,62 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::push
       typename detail::has_reserve_capability<container_type>::type());
 }
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::push_back(MagnitudeT &&val)
+{
+  if(sequence.unique())
+    sequence->push_back(std::move(val));
+  else
+    push_back_impl(val,
+      typename detail::has_reserve_capability<container_type>::type());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename... Args>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::emplace_back(Args &&...args)
+{
+  push_back(MagnitudeT(std::forward<Args>(args)...));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename InputIterator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::append(InputIterator first,
+  InputIterator last)
+{
+  append_impl(first,last,
+    typename std::iterator_traits<InputIterator>::iterator_category());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename Range>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::append(const Range &range)
+{
+  append(std::begin(range),std::end(range));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename Generator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::append_n(size_type n,
+  Generator gen)
+{
+  if(!sequence.unique())
+    detach_append(n,
+      typename detail::has_reserve_capability<container_type>::type());
+
+  for(; n; --n)
+    sequence->push_back(gen());
+}
+
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
@@ -1329,7 +2269,7 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::pop_
   if(sequence.unique())
     sequence->pop_back();
   else {
-    b::shared_ptr<container_type> tmp(new container_type(*sequence));
+    storage_pointer tmp(storage::make(*sequence));
     tmp->pop_back();
     sequence.swap(tmp);
   }
@@ -1341,6 +2281,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::insert(iterator position, const MagnitudeT &val)
 {
+  ++_revision;
   if(sequence.unique())
     return sequence->insert(position,val);
   
@@ -1348,12 +2289,37 @@ basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::insert(iterator
     typename detail::has_reserve_capability<container_type>::type());
 }
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterator
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::insert(iterator position, MagnitudeT &&val)
+{
+  ++_revision;
+  if(sequence.unique())
+    return sequence->insert(position,std::move(val));
+
+  return insert_impl(position,val,
+    typename detail::has_reserve_capability<container_type>::type());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename... Args>
+inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterator
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::emplace(iterator position, Args &&...args)
+{
+  return insert(position,MagnitudeT(std::forward<Args>(args)...));
+}
+
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::insert(iterator position,
   size_type n, const MagnitudeT &val)
 {
+  ++_revision;
   if(sequence.unique())
     sequence->insert(position,n,val);
   else
@@ -1368,6 +2334,7 @@ template <class InputIterator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::insert(iterator position,
   InputIterator first, InputIterator last)
 {
+  ++_revision;
   range_insert_thunk(position,first,last,b::is_integral<InputIterator>());
 }
 
@@ -1377,6 +2344,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::erase(iterator position)
 {
+  ++_revision;
   if(sequence.unique())
     return sequence->erase(position);
 
@@ -1390,6 +2358,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterator
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::erase(iterator first, iterator last)
 {
+  ++_revision;
   if(sequence.unique())
     return sequence->erase(first,last);
 
@@ -1406,6 +2375,8 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   std::swap(_sample_frequency,rhs._sample_frequency);
   std::swap(_time_start,rhs._time_start);
   sequence.swap(rhs.sequence);
+  ++_revision;
+  ++rhs._revision;
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1413,10 +2384,11 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T> class Allocator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::clear(void)
 {
+  ++_revision;
   if(sequence.unique())
     sequence->clear();
   else
-    sequence.reset(new container_type());
+    sequence = storage::make();
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -1494,7 +2466,7 @@ basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   subchannel(iterator first, iterator last)
 {
   if(!sequence.unique())
-    sequence.reset(new container_type(*sequence));
+    sequence = storage::make(*sequence);
   
   return subchannel_type(*this,first,last);
 }
@@ -1509,6 +2481,82 @@ basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   return const_subchannel_type(*this,first,last);
 }
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<
+  MagnitudeT,FrequencyT,TimeT,Container,Allocator>::subchannel_type
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  subchannel(const time_type &t0, const time_type &t1)
+{
+  size_type first = index_at(t0);
+  size_type last = index_at(t1);
+  if(last < first)
+    last = first;
+
+  iterator sfirst = begin();
+  std::advance(sfirst,first);
+  iterator slast = sfirst;
+  std::advance(slast,last-first);
+
+  return subchannel_type(*this,sfirst,slast,first);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_subchannel_type
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  subchannel(const time_type &t0, const time_type &t1) const
+{
+  size_type first = index_at(t0);
+  size_type last = index_at(t1);
+  if(last < first)
+    last = first;
+
+  const_iterator sfirst = begin();
+  std::advance(sfirst,first);
+  const_iterator slast = sfirst;
+  std::advance(slast,last-first);
+
+  return const_subchannel_type(*this,sfirst,slast,first);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<
+  MagnitudeT,FrequencyT,TimeT,Container,Allocator>::size_type
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  index_at(const time_type &t) const
+{
+  return detail::time_index(_time_start,_sample_frequency,t,size());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<
+  MagnitudeT,FrequencyT,TimeT,Container,Allocator>::time_type
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  time_at(size_type n) const
+{
+  return detail::channel_position<basic_channel>::time(_time_start,
+    _sample_frequency,n);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::lease_type
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::lease(void)
+{
+  if(!sequence.unique())
+    sequence = storage::make(*sequence);
+
+  return lease_type(sequence->begin(),sequence->end());
+}
+
 
 
 
@@ -1526,13 +2574,45 @@ inline void swap(basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>
 
 
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline const typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::container_type &
+basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::const_sequence(void) const
+{
+  return *sequence;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  reserve_impl(size_type sz, mpl::false_)
+{
+  storage_pointer tmp(storage::make(*sequence));
+  tmp->reserve(sz);
+  sequence.swap(tmp);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  reserve_impl(size_type sz, mpl::true_)
+{
+  storage_pointer tmp(storage::make());
+  tmp->reserve(sz);
+  tmp->assign(const_sequence().begin(),const_sequence().end());
+  sequence.swap(tmp);
+}
+
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   resize_impl(size_type sz, const MagnitudeT &mag, mpl::false_)
 {
-  b::shared_ptr<container_type> tmp(new container_type(*sequence));
+  storage_pointer tmp(storage::make(*sequence));
   tmp->resize(sz,mag);
   sequence.swap(tmp);
 }
@@ -1543,9 +2623,9 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   resize_impl(size_type sz, const MagnitudeT &mag, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
+  storage_pointer tmp(storage::make());
   tmp->reserve(sequence->size()+sz);
-  tmp->assign(sequence->begin(),sequence->end());
+  tmp->assign(const_sequence().begin(),const_sequence().end());
   tmp->resize(sz,mag);
   sequence.swap(tmp);
 }
@@ -1556,7 +2636,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   push_back_impl(const MagnitudeT &val, mpl::false_)
 {
-  b::shared_ptr<container_type> tmp(new container_type(*sequence));
+  storage_pointer tmp(storage::make(*sequence));
   tmp->push_back(val);
   sequence.swap(tmp);
 }
@@ -1567,13 +2647,61 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   push_back_impl(const MagnitudeT &val, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
-  tmp->reserve(sequence->size()+1);
-  tmp->assign(sequence->begin(),sequence->end());
+  storage_pointer tmp(storage::make());
+  tmp->reserve(detail::grown_capacity(sequence->size(),size_type(1)));
+  tmp->assign(const_sequence().begin(),const_sequence().end());
   tmp->push_back(val);
   sequence.swap(tmp);
 }
 
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  detach_append(size_type, mpl::false_)
+{
+  sequence = storage::make(*sequence);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  detach_append(size_type n, mpl::true_)
+{
+  reserve_impl(detail::grown_capacity(sequence->size(),n),mpl::true_());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename InputIterator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  append_impl(InputIterator first, InputIterator last, std::input_iterator_tag)
+{
+  // the number of elements is unknown, leave growth to the container
+  if(!sequence.unique())
+    detach_append(0,
+      typename detail::has_reserve_capability<container_type>::type());
+
+  sequence->insert(sequence->end(),first,last);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename ForwardIterator>
+inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
+  append_impl(ForwardIterator first, ForwardIterator last,
+    std::forward_iterator_tag)
+{
+  if(!sequence.unique())
+    detach_append(std::distance(first,last),
+      typename detail::has_reserve_capability<container_type>::type());
+
+  sequence->insert(sequence->end(),first,last);
+}
+
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
   template<typename T, typename A> class Container,
   template<typename T> class Allocator>
@@ -1581,18 +2709,14 @@ typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::iterato
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   insert_impl(iterator position, const MagnitudeT &val, mpl::false_)
 {
-  b::shared_ptr<container_type> tmp(new container_type(sequence->begin(),position));
-
-  iterator res = tmp->end();
-  reverse_iterator rfirst = sequence->rbegin();
-  while(rfirst.base() != position)
-    res = tmp->insert(res,*rfirst++);
-
-  if(position != sequence->end())
-    res = tmp->insert(res,*position);
-  
-  res = tmp->insert(res,val);
+  size_type len = std::distance(sequence->begin(),position);
+  storage_pointer tmp(storage::make(sequence->begin(),position));
+  tmp->insert(tmp->end(),val);
+  tmp->insert(tmp->end(),position,sequence->end());
   sequence.swap(tmp);
+
+  iterator res = sequence->begin();
+  std::advance(res,len);
   return res;
 }
 
@@ -1603,7 +2727,7 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   insert_impl(iterator position, const MagnitudeT &val, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
+  storage_pointer tmp(storage::make());
   tmp->reserve(sequence->size()+1);
   tmp->assign(sequence->begin(),position);
   iterator res = tmp->insert(tmp->end(),val);
@@ -1618,7 +2742,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   fill_insert_impl(iterator position, size_type n, const MagnitudeT &val, mpl::false_)
 {
-  b::shared_ptr<container_type> tmp(new container_type(sequence->begin(),position));
+  storage_pointer tmp(storage::make(sequence->begin(),position));
   tmp->insert(tmp->end(),n,val);
   tmp->insert(tmp->end(),position,sequence->end());
   sequence.swap(tmp);
@@ -1630,7 +2754,7 @@ template<typename MagnitudeT, typename FrequencyT, typename TimeT,
 inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   fill_insert_impl(iterator position, size_type n, const MagnitudeT &val, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
+  storage_pointer tmp(storage::make());
   tmp->reserve(sequence->size()+n);
   tmp->assign(sequence->begin(),position);
   tmp->insert(tmp->end(),n,val);
@@ -1649,7 +2773,7 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   if(sequence.unique())
     sequence->insert(position,first,last);
   else {
-    b::shared_ptr<container_type> tmp(new container_type(sequence->begin(),position));
+    storage_pointer tmp(storage::make(sequence->begin(),position));
     tmp->insert(tmp->end(),first,last);
     tmp->insert(tmp->end(),position,sequence->end());
     sequence.swap(tmp);
@@ -1667,15 +2791,15 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   if(sequence.unique())
     sequence->insert(position,first,last);
   else {
-    b::shared_ptr<container_type> tmp(new container_type());
+    // the number of new elements is unknown, push_back grows geometrically
+    storage_pointer tmp(storage::make());
     tmp->reserve(sequence->size());
     tmp->assign(sequence->begin(),position);
-    size_type extra = std::distance(position,sequence->end());
-    while(first != last) {
-      tmp->reserve(sequence->size()+extra+1);
+    while(first != last)
       tmp->push_back(*first++);
-    }
+
     tmp->insert(tmp->end(),position,sequence->end());
+    sequence.swap(tmp);
   }
 }
 
@@ -1690,11 +2814,12 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   if(sequence.unique())
     sequence->insert(position,first,last);
   else {
-    b::shared_ptr<container_type> tmp(new container_type());
+    storage_pointer tmp(storage::make());
     tmp->reserve(sequence->size()+std::distance(first,last));
     tmp->assign(sequence->begin(),position);
     tmp->insert(tmp->end(),first,last);
     tmp->insert(tmp->end(),position,sequence->end());
+    sequence.swap(tmp);
   }
 }
 
@@ -1707,7 +2832,7 @@ basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   erase_impl(iterator position, mpl::false_)
 {
   size_type len = std::distance(sequence->begin(),position);
-  b::shared_ptr<container_type> tmp(new container_type(sequence->begin(),position));
+  storage_pointer tmp(storage::make(sequence->begin(),position));
   tmp->insert(tmp->end(),++position,sequence->end());
   sequence.swap(tmp);
   iterator res = sequence->begin();
@@ -1722,12 +2847,15 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   erase_impl(iterator position, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
+  size_type len = std::distance(sequence->begin(),position);
+  storage_pointer tmp(storage::make());
   tmp->reserve(sequence->size()-1);
   tmp->assign(sequence->begin(),position);
-  iterator res = tmp->insert(tmp->end(),*(++position));
-  tmp->assign(position,sequence->end());
+  tmp->insert(tmp->end(),++position,sequence->end());
   sequence.swap(tmp);
+
+  iterator res = sequence->begin();
+  std::advance(res,len);
   return res;
 }
 
@@ -1738,14 +2866,13 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   erase_impl(iterator first, iterator last, mpl::false_)
 {
-  b::shared_ptr<container_type> tmp(new container_type(sequence->begin(),first));
-  
-  iterator res = tmp->end();
-  reverse_iterator rfirst = sequence->rbegin();
-  while(rfirst.base() != last)
-    res = tmp->insert(res,*rfirst++);
-
+  size_type len = std::distance(sequence->begin(),first);
+  storage_pointer tmp(storage::make(sequence->begin(),first));
+  tmp->insert(tmp->end(),last,sequence->end());
   sequence.swap(tmp);
+
+  iterator res = sequence->begin();
+  std::advance(res,len);
   return res;
 }
 
@@ -1756,16 +2883,15 @@ inline typename basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
   erase_impl(iterator first, iterator last, mpl::true_)
 {
-  b::shared_ptr<container_type> tmp(new container_type());
+  size_type len = std::distance(sequence->begin(),first);
+  storage_pointer tmp(storage::make());
   tmp->reserve(sequence->size()-std::distance(first,last));
   tmp->assign(sequence->begin(),first);
-  
-  iterator res = tmp->end();
-  reverse_iterator rfirst = sequence->rbegin();
-  while(rfirst.base() != last)
-    res = tmp->insert(res,*rfirst++);
-
+  tmp->insert(tmp->end(),last,sequence->end());
   sequence.swap(tmp);
+
+  iterator res = sequence->begin();
+  std::advance(res,len);
   return res;
 }
 
@@ -1777,8 +2903,8 @@ inline void basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator>::
 range_insert_thunk(iterator position, InputIterator first, InputIterator last,
   mpl::true_)
 {
-  fill_insert(position,static_cast<size_type>(first),
-    static_cast<const value_type &>(last));
+  insert(position,static_cast<size_type>(first),
+    static_cast<MagnitudeT>(last));
 }
 
 template<typename MagnitudeT, typename FrequencyT, typename TimeT,
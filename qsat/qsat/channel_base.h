@@ -30,6 +30,7 @@
 
 #include "basic_channel.h"
 #include "detail/value_cast.h"
+#include "detail/contiguous.h"
 #include "detail/channel_base_detail.h"
 
 #include <boost/variant.hpp>
@@ -51,7 +52,24 @@
 #include <boost/mpl/eval_if.hpp>
 #include <boost/mpl/transform.hpp>
 
+#include <boost/mpl/for_each.hpp>
+#include <boost/mpl/size.hpp>
+#include <boost/mpl/contains.hpp>
+#include <boost/static_assert.hpp>
+
+#include <boost/numeric/conversion/cast.hpp>
+
 #include <boost/type_traits/is_same.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/add_pointer.hpp>
+#include <boost/type_traits/remove_reference.hpp>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <limits>
+#include <cstddef>
 
 namespace lemma {
 namespace qsat {
@@ -60,6 +78,420 @@ namespace b = boost;
 namespace bf = boost::fusion;
 namespace mpl = boost::mpl;
 
+namespace detail {
+namespace channel_base {
+
+/** \brief Make the internal channel type of a precision
+ *  \internal Metafunction class applied over InternalPrecisionSequence so
+ *    that every internal channel uses the Container and Allocator of the
+ *    channel_base.
+ */
+template<typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+struct make_container_channel {
+  template<typename P>
+  struct apply {
+    typedef basic_channel<P,FrequencyT,TimeT,Container,Allocator> type;
+  };
+};
+
+template<typename ChannelT>
+inline void reserve_samples(ChannelT &ch, typename ChannelT::size_type n,
+  mpl::true_)
+{
+  ch.reserve(n);
+}
+
+template<typename ChannelT>
+inline void reserve_samples(ChannelT &, typename ChannelT::size_type,
+  mpl::false_)
+{
+}
+
+/** \brief Reserve storage in a channel whose Container supports it
+ *  \internal Containers such as std::list have nothing to reserve.
+ */
+template<typename ChannelT>
+inline void reserve_samples(ChannelT &ch, typename ChannelT::size_type n)
+{
+  reserve_samples(ch,n,typename has_reserve_capability<
+    typename ChannelT::container_type>::type());
+}
+
+/** \brief Determine if \e val is represented exactly by P
+ *  \internal NaN is representable by any floating point P.
+ */
+template<typename P, typename S>
+inline bool lossless(const S &val)
+{
+  if(val != val)
+    return !std::numeric_limits<P>::is_integer;
+
+  try {
+    return S(b::numeric_cast<P>(val)) == val;
+  }
+  catch(const b::numeric::bad_numeric_cast &) {
+    return false;
+  }
+}
+
+/** \brief Find the first precision at or after \e start representing
+ *    \e val exactly
+ *  \internal Called by mpl::for_each over InternalPrecisionSequence.
+ *    <em>found</em> is left unchanged if there is none.
+ */
+template<typename MagnitudeT>
+struct narrowest_precision {
+  narrowest_precision(const MagnitudeT &v, std::size_t first,
+    std::size_t &result) :val(&v), start(first), index(0), found(&result) {}
+
+  template<typename P>
+  void operator()(P *) {
+    if(*found == std::size_t(-1) && index >= start && lossless<P>(*val))
+      *found = index;
+
+    ++index;
+  }
+
+  const MagnitudeT *val;
+  std::size_t start;
+  std::size_t index;
+  std::size_t *found;
+};
+
+/** \brief Determine if every sample of a channel is represented exactly
+ *    by P
+ *  \internal
+ */
+template<typename P>
+struct all_lossless_visitor :public boost::static_visitor<bool> {
+  template<typename ChannelT>
+  bool operator()(const ChannelT &ch) const {
+    for(typename ChannelT::const_iterator cur = ch.begin(); cur != ch.end();
+      ++cur)
+    {
+      if(!lossless<P>(*cur))
+        return false;
+    }
+
+    return true;
+  }
+};
+
+/** \brief Construct a channel of another precision from the samples,
+ *    frequency, and epoch of a channel
+ *  \internal
+ */
+template<typename ChannelT>
+struct convert_visitor :public boost::static_visitor<ChannelT> {
+  template<typename SourceT>
+  ChannelT operator()(const SourceT &src) const {
+    ChannelT result(std::make_pair(src.frequency(),src.epoch()));
+    reserve_samples(result,src.size());
+    for(typename SourceT::const_iterator cur = src.begin(); cur != src.end();
+      ++cur)
+    {
+      result.push_back(
+        static_cast<typename ChannelT::magnitude_type>(*cur));
+    }
+
+    return result;
+  }
+};
+
+/** \brief Append a value converted to the precision of the channel
+ *  \internal
+ */
+template<typename MagnitudeT>
+struct converting_push_back_visitor :public boost::static_visitor<> {
+  explicit converting_push_back_visitor(const MagnitudeT &v) :val(&v) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.push_back(
+      b::numeric_cast<typename ChannelT::magnitude_type>(*val));
+  }
+
+  const MagnitudeT *val;
+};
+
+/** \brief Replace the samples of a channel with a range converted to the
+ *    precision of the channel
+ *  \internal
+ */
+template<typename MagnitudeT, typename InputIterator>
+struct converting_assign_visitor :public boost::static_visitor<> {
+  converting_assign_visitor(InputIterator f, InputIterator l) :first(f),
+    last(l) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.clear();
+    for(InputIterator cur = first; cur != last; ++cur) {
+      ch.push_back(b::numeric_cast<typename ChannelT::magnitude_type>(
+        MagnitudeT(*cur)));
+    }
+  }
+
+  InputIterator first;
+  InputIterator last;
+};
+
+/** \brief Replace the samples of a channel with copies of a value converted
+ *    to the precision of the channel
+ *  \internal
+ */
+template<typename MagnitudeT, typename SizeT>
+struct converting_fill_visitor :public boost::static_visitor<> {
+  converting_fill_visitor(SizeT count, const MagnitudeT &v) :n(count),
+    val(&v) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.assign(n,b::numeric_cast<typename ChannelT::magnitude_type>(*val));
+  }
+
+  SizeT n;
+  const MagnitudeT *val;
+};
+
+/** \brief Resize a channel, appending a value converted to the precision of
+ *    the channel
+ *  \internal
+ */
+template<typename MagnitudeT, typename SizeT>
+struct converting_resize_visitor :public boost::static_visitor<> {
+  converting_resize_visitor(SizeT count, const MagnitudeT &v) :n(count),
+    val(&v) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.resize(n,b::numeric_cast<typename ChannelT::magnitude_type>(*val));
+  }
+
+  SizeT n;
+  const MagnitudeT *val;
+};
+
+/** \brief Reserve storage in a channel
+ *  \internal
+ */
+template<typename SizeT>
+struct reserve_visitor :public boost::static_visitor<> {
+  explicit reserve_visitor(SizeT count) :n(count) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    reserve_samples(ch,n);
+  }
+
+  SizeT n;
+};
+
+/** \brief Remove the last sample of a channel
+ *  \internal
+ */
+struct pop_back_visitor :public boost::static_visitor<> {
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.pop_back();
+  }
+};
+
+/** \brief Set the sample frequency and epoch of a channel
+ *  \internal
+ */
+template<typename FrequencyT, typename TimeT>
+struct timebase_visitor :public boost::static_visitor<> {
+  timebase_visitor(const FrequencyT &f, const TimeT &t) :freq(&f),
+    start(&t) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    ch.frequency(*freq);
+    ch.epoch(*start);
+  }
+
+  const FrequencyT *freq;
+  const TimeT *start;
+};
+
+/** \brief Smallest precision index at which every sample of a channel is
+ *    represented exactly
+ *  \internal Called by mpl::for_each over InternalPrecisionSequence.
+ */
+template<typename VariantT>
+struct shrink_precision {
+  shrink_precision(const VariantT &v, std::size_t &result) :var(&v),
+    index(0), found(&result) {}
+
+  template<typename P>
+  void operator()(P *) {
+    if(*found == std::size_t(-1) && index <= std::size_t(var->which()) &&
+      boost::apply_visitor(all_lossless_visitor<P>(),*var))
+    {
+      *found = index;
+    }
+
+    ++index;
+  }
+
+  const VariantT *var;
+  std::size_t index;
+  std::size_t *found;
+};
+
+/** \brief Convert a channel variant to the precision at \e target
+ *  \internal Called by mpl::for_each over the channel types of the variant.
+ */
+template<typename VariantT>
+struct convert_precision {
+  convert_precision(VariantT &v, std::size_t t) :var(&v), target(t),
+    index(0) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT *) {
+    if(index++ == target && std::size_t(var->which()) != target) {
+      ChannelT converted =
+        boost::apply_visitor(convert_visitor<ChannelT>(),*var);
+      *var = std::move(converted);
+    }
+  }
+
+  VariantT *var;
+  std::size_t target;
+  std::size_t index;
+};
+
+/** \internal Samples per callback of for_each_block() by default */
+static const std::size_t default_block_size = 4096;
+
+/** \brief Hand the whole range of a channel to a function
+ *  \internal Contiguous channels are passed as pointers, others as their
+ *    own iterators.
+ */
+template<typename Function>
+struct const_span_visitor :public boost::static_visitor<> {
+  explicit const_span_visitor(Function &func) :f(&func) {}
+
+  template<typename ChannelT>
+  void operator()(const ChannelT &ch) const {
+    visit(ch,typename is_contiguous_channel<ChannelT>::type());
+  }
+
+  template<typename ChannelT>
+  void visit(const ChannelT &ch, mpl::true_) const {
+    typedef const typename ChannelT::magnitude_type * pointer;
+
+    pointer first = ch.empty() ? pointer(0) : &*ch.begin();
+    (*f)(first,first+ch.size());
+  }
+
+  template<typename ChannelT>
+  void visit(const ChannelT &ch, mpl::false_) const {
+    (*f)(ch.begin(),ch.end());
+  }
+
+  Function *f;
+};
+
+/** \brief Hand the whole mutable range of a channel to a function
+ *  \internal Obtaining begin() performs the copy-on-write check once.
+ */
+template<typename Function>
+struct span_visitor :public boost::static_visitor<> {
+  explicit span_visitor(Function &func) :f(&func) {}
+
+  template<typename ChannelT>
+  void operator()(ChannelT &ch) const {
+    visit(ch,typename is_contiguous_channel<ChannelT>::type());
+  }
+
+  template<typename ChannelT>
+  void visit(ChannelT &ch, mpl::true_) const {
+    typedef typename ChannelT::magnitude_type * pointer;
+
+    pointer first = ch.empty() ? pointer(0) : &*ch.begin();
+    (*f)(first,first+ch.size());
+  }
+
+  template<typename ChannelT>
+  void visit(ChannelT &ch, mpl::false_) const {
+    typename ChannelT::iterator first = ch.begin();
+    (*f)(first,ch.end());
+  }
+
+  Function *f;
+};
+
+/** \brief Hand a channel to a function in contiguous blocks
+ *  \internal Samples of non contiguous channels are copied into a buffer
+ *    of one block so that the function always receives pointers.
+ */
+template<typename Function>
+struct block_visitor :public boost::static_visitor<> {
+  block_visitor(Function &func, std::size_t n) :f(&func), block(n) {}
+
+  template<typename ChannelT>
+  void operator()(const ChannelT &ch) const {
+    visit(ch,typename is_contiguous_channel<ChannelT>::type());
+  }
+
+  template<typename ChannelT>
+  void visit(const ChannelT &ch, mpl::true_) const {
+    if(ch.empty())
+      return;
+
+    const typename ChannelT::magnitude_type *first = &*ch.begin();
+    std::size_t n = ch.size();
+    for(std::size_t off=0; off<n; off += block)
+      (*f)(first+off,first+std::min(off+block,n));
+  }
+
+  template<typename ChannelT>
+  void visit(const ChannelT &ch, mpl::false_) const {
+    std::vector<typename ChannelT::magnitude_type> buf(block);
+
+    typename ChannelT::const_iterator cur = ch.begin();
+    while(cur != ch.end()) {
+      std::size_t k = 0;
+      for(; k<block && cur != ch.end(); ++k, ++cur)
+        buf[k] = *cur;
+
+      (*f)(&buf[0],&buf[0]+k);
+    }
+  }
+
+  Function *f;
+  std::size_t block;
+};
+
+/** \brief Copy the samples of a channel, converted to T
+ *  \internal
+ */
+template<typename T>
+struct copy_visitor :public boost::static_visitor<T *> {
+  explicit copy_visitor(T *dst) :out(dst) {}
+
+  template<typename ChannelT>
+  T * operator()(const ChannelT &ch) const {
+    T *dst = out;
+    for(typename ChannelT::const_iterator cur = ch.begin(); cur != ch.end();
+      ++cur, ++dst)
+    {
+      *dst = static_cast<T>(*cur);
+    }
+
+    return dst;
+  }
+
+  T *out;
+};
+
+}
+}
+
 namespace cbdetail = detail::channel_base;
 
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -69,7 +501,8 @@ template <typename MagnitudeT, typename FrequencyT, typename TimeT,
 class channel_base {
   private:
     typedef typename mpl::transform<InternalPrecisionSequence,
-      cbdetail::make_basic_channel<FrequencyT,TimeT> >::type channel_types;
+      cbdetail::make_container_channel<FrequencyT,TimeT,Container,
+        Allocator> >::type channel_types;
   
     typedef typename boost::make_variant_over<channel_types>::type variant_type;
 
@@ -193,7 +626,11 @@ class channel_base {
       const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
       const TimeT &start=detail::value_cast<TimeT>::construct(0));
 
-    /** \brief Copy Constructor
+    /** \brief Converting Copy Constructor
+     *
+     *  The samples of <em>rhs</em> keep their internal precision if it is
+     *  one of InternalPrecisionSequence and are converted to the first
+     *  precision of InternalPrecisionSequence otherwise.
      *
      *  \param rhs rvalue of type channel_base
      */
@@ -201,11 +638,73 @@ class channel_base {
       template<typename _T, typename _A> class C,
       template<typename _T> class A>
     channel_base(const channel_base<M,F,T,I,C,A> &rhs);
+
+    /** \brief Copy Constructor
+     *
+     *  \param rhs rvalue of type channel_base
+     */
+    channel_base(const channel_base &rhs);
+
+    /** \brief Move Constructor
+     *
+     *  \param rhs rvalue of type channel_base whose samples are taken
+     *    without copying
+     */
+    channel_base(channel_base &&rhs);
+
+    /** \brief Adopting Constructor
+     *
+     *  Construct a channel that takes ownership of <em>ch</em> as its
+     *  internal channel without copying its samples. The internal precision
+     *  is <em>P</em>.
+     *
+     *  \param ch A basic_channel whose magnitude_type is one of
+     *    InternalPrecisionSequence
+     */
+    template<typename P>
+    explicit channel_base(
+      basic_channel<P,FrequencyT,TimeT,Container,Allocator> &&ch);
+
+    /** \brief Adopting Constructor
+     *
+     *  Construct a channel that takes ownership of the samples of
+     *  <em>seq</em> without copying them, eg a freshly decoded
+     *  <code>std::vector<short></code>. The internal precision is
+     *  <em>P</em>.
+     *
+     *  \param seq A container of one of InternalPrecisionSequence whose
+     *    contents are moved into the channel
+     *  \param freq A value of <code>basic_channel::frequency_type</code>
+     *    representing the sample frequency. Default is
+     *    <code>basic_channel::frequency_type(1)</code>.
+     *  \param start A value of <code>basic_channel::time_type</code>
+     *    representing the time sampling started. Default is
+     *    <code>basic_channel::time_type(0)</code>.
+     *
+     *  \post size() == the size of <em>seq</em> before the call
+     */
+    template<typename P>
+    explicit channel_base(Container<P,Allocator<P> > &&seq,
+      const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
+      const TimeT &start=detail::value_cast<TimeT>::construct(0));
     
     /** \brief Destructor
      */
     ~channel_base(void);
 
+    /** \brief Assignment Operator
+     *  \param rhs rvalue of type channel_base
+     *  \return <code>*this</code>
+     */
+    channel_base & operator=(const channel_base &rhs);
+
+    /** \brief Move Assignment Operator
+     *  \param rhs rvalue of type channel_base whose samples are taken
+     *    without copying
+     *  \return <code>*this</code>
+     */
+    channel_base & operator=(channel_base &&rhs);
+
     /** \brief Assignment Operator
      *  \param rhs rvalue of type basic_channel
      *  \return <code>*this</code>
@@ -390,43 +889,6 @@ class channel_base {
      */
     void pop_back(void);
 
-    /** \brief Insert a new element into the sequence before <em>position</em>
-     *  \param position An iterator pointing to the location the element should
-     *    be inserted before
-     *  \param val The value of the new element
-     *  \return An iterator pointing to the new element
-     */
-    iterator insert(iterator position, const MagnitudeT &val);
-
-    /** \brief Insert <em>n</em> elements into the sequence before <em>position</em>
-     *  \param position An iterator pointing to the location the elements should
-     *    be inserted before
-     *  \param n The number of elements to insert
-     *  \param val The value of the new elements
-     */
-    void insert(iterator position, size_type n, const MagnitudeT &val);
-
-    /** \brief Insert elements in the range of <code>[first,last)</code>
-     *    into the sequence before <em>position</em>
-     *  \param position An iterator pointing to the location the elements should
-     *    be inserted before
-     *  \param first,last An <code>InputIterator</code> pointing to objects
-     *    convertable to MagnitudeT
-     */
-    template <class InputIterator>
-    void insert(iterator position, InputIterator first, InputIterator last);
-
-    /** \brief Erase the element at <em>position</em>
-     *  \param position An iterator pointing to the element to erase
-     *  \return An iterator to the element immediately after <em>position</em>
-     */
-    iterator erase(iterator position);
-    
-    /** \brief Erase elements in the range of <code>[first,last)</code>
-     *  \param first,last An iterator range in the sequence
-     */
-    iterator erase(iterator first, iterator last);
-
     /** \brief Efficiently swap another basic_channel object with this
      *  \param rhs a reference
      */
@@ -487,36 +949,161 @@ class channel_base {
      */
     const time_type & epoch(void) const;
 
+    /** \brief Obtain the internal precision currently in use
+     *
+     *  \return The position of the precision within
+     *    InternalPrecisionSequence
+     */
+    std::size_t precision(void) const;
+
+    /** \brief Enable or disable adaptive storage precision
+     *
+     *  \par Discussion
+     *  When enabled, values added with push_back() are checked against the
+     *  current internal precision. A value that is not represented exactly
+     *  promotes the samples to the first later precision in
+     *  InternalPrecisionSequence that represents it, so the sequence should
+     *  list precisions from narrowest to widest, eg
+     *  <code>mpl::vector<short,float,double></code>. Promotion converts all
+     *  samples once and never narrows. Values that no precision represents
+     *  exactly promote to the last, widest, precision.
+     *
+     *  Values stored with assign() and resize() are checked in the same
+     *  way. Values stored through references or the pointers passed by
+     *  visit_span() are converted to the current precision without
+     *  promotion and may be narrowed. Add such values with push_back(), or
+     *  construct the channel in a precision wide enough to hold them.
+     *
+     *  \param enable Whether precision is adaptive
+     *  \return The previous setting
+     */
+    bool adaptive_precision(bool enable);
+
+    /** \brief Determine if storage precision is adaptive
+     *  \return The current setting
+     */
+    bool adaptive_precision(void) const;
+
+    /** \brief Convert to the narrowest precision representing every sample
+     *    exactly
+     *
+     *  \par Discussion
+     *  Only precisions before the current one in InternalPrecisionSequence
+     *  are considered. Useful after loading data, eg 16 bit ADC codes read
+     *  as <code>double</code>, into an adaptive channel.
+     */
+    void shrink_precision(void);
+
+    /** \brief Call a function once with all samples in their internal
+     *    precision
+     *
+     *  \par Discussion
+     *  The internal precision is dispatched once rather than for every
+     *  sample as with element access. <em>f</em> is called as
+     *  <code>f(first,last)</code>. For channels whose Container is
+     *  contiguous, eg <code>std::vector</code>, <em>first</em> and
+     *  <em>last</em> are <code>const P *</code> where P is the internal
+     *  precision, otherwise they are const iterators of the internal
+     *  channel. <em>f</em> must therefore accept every precision of
+     *  InternalPrecisionSequence, eg with a template function call
+     *  operator.
+     *
+     *  \code
+     *  struct sum_type {
+     *    double sum;
+     *
+     *    template<typename Iterator>
+     *    void operator()(Iterator first, Iterator last) {
+     *      for(; first != last; ++first)
+     *        sum += *first;
+     *    }
+     *  };
+     *
+     *  sum_type s = {0};
+     *  channel.visit_span(s);
+     *  \endcode
+     *
+     *  \param f The function object, which is not copied
+     */
+    template<typename Function>
+    void visit_span(Function &&f) const;
+
+    /** \brief Call a function once with all samples in their internal
+     *    precision for modification
+     *
+     *  As visit_span(Function&&) const with mutable pointers or iterators.
+     *  The copy-on-write check of the internal channel is performed once.
+     *
+     *  \param f The function object, which is not copied
+     */
+    template<typename Function>
+    void visit_span(Function &&f);
+
+    /** \brief Call a function with successive contiguous blocks of samples
+     *    in their internal precision
+     *
+     *  \par Discussion
+     *  <em>f</em> is called as <code>f(first,last)</code> with
+     *  <code>const P *</code> pointers to at most <em>block</em> samples at
+     *  a time, in order, where P is the internal precision. Samples of a
+     *  channel whose Container is not contiguous are copied into a buffer
+     *  of <em>block</em> samples first. The internal precision is
+     *  dispatched once for all blocks.
+     *
+     *  \param f The function object, which is not copied
+     *  \param block The maximum number of samples per call
+     */
+    template<typename Function>
+    void for_each_block(Function &&f,
+      size_type block = cbdetail::default_block_size) const;
+
+    /** \brief Copy all samples, converted to T, to <em>out</em>
+     *
+     *  \param out Destination of at least size() elements
+     *  \return <em>out</em> + size()
+     */
+    template<typename T>
+    T * copy_to(T *out) const;
+
   private:
-    template<typename M, typename F, typename T, typename I,
-      template<typename _T, typename _A> class C,
-      template<typename _T> class A>
-    struct adapted_copy :public boost::static_visitor<> {
-      adapted_copy(const channel_base<M,F,T,I,C,A> &cb) :other(b::cref(cb)) {}
-      
-      void operator()(basic_channel<M,FrequencyT,TimeT,Container,Allocator> &self)
-      {
-        self.assign(other.get().begin(),other.get().end());
-        self.frequency(b::numeric_cast<FrequencyT>(other.frequency()));
-        self.epoch(b::numeric_cast<FrequencyT>(other.epoch()));
-      }
-      
-      template<typename SelfM>
-      void operator()(const basic_channel<SelfM,FrequencyT,TimeT,Container,Allocator> &self)
-      {
-        typedef typename mpl::find<InternalPrecisionSequence,M>::type iter;
-
-        if(boost::is_same<typename mpl::deref<iter>::type,T>::value)
-          self.channel_variant = basic_channel<M,FrequencyT,TimeT,Container,Allocator>();
-        else
-          self.channel_variant = default_channel_type();
-        
+    /** \brief Build the variant from the samples of another channel_base
+     *  \internal Called by visit_span() of the source with its samples in
+     *    their internal precision P. The samples keep P if it is one of
+     *    InternalPrecisionSequence and are converted to the default
+     *    precision otherwise. The channel is constructed once and moved
+     *    into the variant.
+     */
+    struct adapted_copy {
+      adapted_copy(variant_type &v, const FrequencyT &f, const TimeT &t)
+        :var(&v), freq(f), start(t) {}
+
+      template<typename Iterator>
+      void operator()(Iterator first, Iterator last) const {
+        typedef typename std::iterator_traits<Iterator>::value_type P;
+        typedef typename mpl::if_<
+          mpl::contains<InternalPrecisionSequence,P>,
+          basic_channel<P,FrequencyT,TimeT,Container,Allocator>,
+          default_channel_type>::type channel_type;
+
+        channel_type ch(first,last,freq,start);
+        *var = std::move(ch);
       }
-      
-      b::reference_wrapper<const channel_base<M,F,T,I,C,A> > other;
+
+      variant_type *var;
+      FrequencyT freq;
+      TimeT start;
     };
-  
+
     variant_type channel_variant;
+    bool adaptive;
+
+    void promote(const MagnitudeT &val);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
 };
 
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -524,7 +1111,7 @@ template <typename MagnitudeT, typename FrequencyT, typename TimeT,
   class Container, template<typename T> class Allocator>
 inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
   channel_base(const std::pair<FrequencyT,TimeT> &tp)
-    :channel_variant(default_channel_type(tp))
+    :channel_variant(default_channel_type(tp)), adaptive(false)
 {
 }
 
@@ -533,7 +1120,8 @@ template <typename MagnitudeT, typename FrequencyT, typename TimeT,
   class Container, template<typename T> class Allocator>
 inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
   channel_base(size_type n, const MagnitudeT &value, const FrequencyT &freq,
-  const TimeT &start) :channel_variant(default_channel_type(n,value,freq,start))
+  const TimeT &start) :channel_variant(default_channel_type(n,value,freq,start)),
+    adaptive(false)
 {
 }
 
@@ -543,6 +1131,7 @@ template <typename MagnitudeT, typename FrequencyT, typename TimeT,
 template<typename T>
 inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
   channel_base(size_type n, const T &value, const FrequencyT &freq, const TimeT &start)
+    :adaptive(false)
 {
   // if T is one of the InternalPrecisionSequence types, then construct the
   // variant directly, otherwise numeric_cast to MagnitudeT
@@ -567,8 +1156,53 @@ template<typename M, typename F, typename T, typename I,
   template<typename _T> class A>
 inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
   channel_base(const channel_base<M,F,T,I,C,A> &rhs)
+    :adaptive(rhs.adaptive_precision())
 {
-  boost::apply_visitor(adapted_copy<M,F,T,I,C,A>(rhs),channel_variant);
+  rhs.visit_span(adapted_copy(channel_variant,
+    b::numeric_cast<FrequencyT>(rhs.frequency()),
+    b::numeric_cast<TimeT>(rhs.epoch())));
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+  channel_base(const channel_base &rhs)
+    :channel_variant(rhs.channel_variant), adaptive(rhs.adaptive)
+{
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+  channel_base(channel_base &&rhs)
+    :channel_variant(std::move(rhs.channel_variant)), adaptive(rhs.adaptive)
+{
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename P>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+  channel_base(basic_channel<P,FrequencyT,TimeT,Container,Allocator> &&ch)
+    :channel_variant(std::move(ch)), adaptive(false)
+{
+  BOOST_STATIC_ASSERT((mpl::contains<InternalPrecisionSequence,P>::value));
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename P>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+  channel_base(Container<P,Allocator<P> > &&seq, const FrequencyT &freq,
+    const TimeT &start)
+    :channel_variant(basic_channel<P,FrequencyT,TimeT,Container,Allocator>(
+      std::move(seq),freq,start)), adaptive(false)
+{
+  BOOST_STATIC_ASSERT((mpl::contains<InternalPrecisionSequence,P>::value));
 }
 
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
@@ -579,13 +1213,85 @@ inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Contai
 {
 }
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator> &
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    operator=(const channel_base &rhs)
+{
+  channel_variant = rhs.channel_variant;
+  adaptive = rhs.adaptive;
+  return *this;
+}
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator> &
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    operator=(channel_base &&rhs)
+{
+  channel_variant = std::move(rhs.channel_variant);
+  adaptive = rhs.adaptive;
+  return *this;
+}
 
 
 
 
 
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename InputIterator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign(InputIterator first, InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename InputIterator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign(InputIterator first, InputIterator last, const FrequencyT &freq,
+      const TimeT &start)
+{
+  assign(first,last);
+  boost::apply_visitor(
+    cbdetail::timebase_visitor<FrequencyT,TimeT>(freq,start),channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign(size_type n, const MagnitudeT &val)
+{
+  promote(val);
+  boost::apply_visitor(
+    cbdetail::converting_fill_visitor<MagnitudeT,size_type>(n,val),
+    channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign(size_type n, const MagnitudeT &val, const FrequencyT &freq,
+      const TimeT &start)
+{
+  assign(n,val);
+  boost::apply_visitor(
+    cbdetail::timebase_visitor<FrequencyT,TimeT>(freq,start),channel_variant);
+}
 
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
   typename InternalPrecisionSequence, template<typename T, typename A>
@@ -598,7 +1304,20 @@ inline typename channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequen
     cbdetail::size_visitor<size_type>(),channel_variant);
 }
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    resize(size_type sz, const MagnitudeT &mag)
+{
+  if(sz > size())
+    promote(mag);
 
+  boost::apply_visitor(
+    cbdetail::converting_resize_visitor<MagnitudeT,size_type>(sz,mag),
+    channel_variant);
+}
 
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
   typename InternalPrecisionSequence, template<typename T, typename A>
@@ -610,6 +1329,18 @@ inline bool channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,C
 }
 
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    reserve(size_type n)
+{
+  boost::apply_visitor(cbdetail::reserve_visitor<size_type>(n),
+    channel_variant);
+}
+
+
 template <typename MagnitudeT, typename FrequencyT, typename TimeT,
   typename InternalPrecisionSequence, template<typename T, typename A>
   class Container, template<typename T> class Allocator>
@@ -658,6 +1389,189 @@ inline const typename channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecision
     cbdetail::epoch_visitor<time_type>(),channel_variant);
 }
 
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    push_back(const MagnitudeT &val)
+{
+  promote(val);
+  boost::apply_visitor(
+    cbdetail::converting_push_back_visitor<MagnitudeT>(val),channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    pop_back(void)
+{
+  boost::apply_visitor(cbdetail::pop_back_visitor(),channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline std::size_t
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    precision(void) const
+{
+  return channel_variant.which();
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline bool
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    adaptive_precision(bool enable)
+{
+  bool old = adaptive;
+  adaptive = enable;
+  return old;
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline bool
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    adaptive_precision(void) const
+{
+  return adaptive;
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    shrink_precision(void)
+{
+  std::size_t target = std::size_t(-1);
+  mpl::for_each<InternalPrecisionSequence,b::add_pointer<mpl::_1> >(
+    cbdetail::shrink_precision<variant_type>(channel_variant,target));
+
+  if(target != std::size_t(-1)) {
+    mpl::for_each<typename variant_type::types,b::add_pointer<mpl::_1> >(
+      cbdetail::convert_precision<variant_type>(channel_variant,target));
+  }
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename Function>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    visit_span(Function &&f) const
+{
+  boost::apply_visitor(
+    cbdetail::const_span_visitor<typename b::remove_reference<Function>::type>(f),
+    channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename Function>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    visit_span(Function &&f)
+{
+  boost::apply_visitor(
+    cbdetail::span_visitor<typename b::remove_reference<Function>::type>(f),
+    channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename Function>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    for_each_block(Function &&f, size_type block) const
+{
+  if(!block)
+    block = cbdetail::default_block_size;
+
+  boost::apply_visitor(
+    cbdetail::block_visitor<typename b::remove_reference<Function>::type>(f,block),
+    channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename T>
+inline T *
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    copy_to(T *out) const
+{
+  return boost::apply_visitor(cbdetail::copy_visitor<T>(out),channel_variant);
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    promote(const MagnitudeT &val)
+{
+  if(!adaptive)
+    return;
+
+  std::size_t target = std::size_t(-1);
+  mpl::for_each<InternalPrecisionSequence,b::add_pointer<mpl::_1> >(
+    cbdetail::narrowest_precision<MagnitudeT>(val,channel_variant.which(),
+      target));
+
+  // nothing represents val exactly, the widest precision comes closest
+  if(target == std::size_t(-1))
+    target = mpl::size<InternalPrecisionSequence>::value - 1;
+
+  if(target > std::size_t(channel_variant.which())) {
+    mpl::for_each<typename variant_type::types,b::add_pointer<mpl::_1> >(
+      cbdetail::convert_precision<variant_type>(channel_variant,target));
+  }
+}
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename InputIterator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign_thunk(InputIterator first, InputIterator last, mpl::true_)
+{
+  assign(static_cast<size_type>(first),static_cast<MagnitudeT>(last));
+}
+
+/** \internal An adaptive channel checks every value as push_back() does. A
+ *  range that is only traversed once cannot be scanned ahead of storing it.
+ */
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+template<typename InputIterator>
+inline void
+  channel_base<MagnitudeT,FrequencyT,TimeT,InternalPrecisionSequence,Container,Allocator>::
+    assign_thunk(InputIterator first, InputIterator last, mpl::false_)
+{
+  if(adaptive) {
+    clear();
+    for(; first != last; ++first)
+      push_back(MagnitudeT(*first));
+  }
+  else {
+    boost::apply_visitor(
+      cbdetail::converting_assign_visitor<MagnitudeT,InputIterator>(first,
+        last),channel_variant);
+  }
+}
+
 
 }
 }
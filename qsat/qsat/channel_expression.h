@@ -0,0 +1,628 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_CHANNEL_EXPRESSION_H
+#define LEMMA_QSAT_CHANNEL_EXPRESSION_H
+
+#include "basic_channel.h"
+
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/and.hpp>
+#include <boost/mpl/or.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <iterator>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+/** \file
+ *  \brief Lazy elementwise arithmetic over channels
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+template <typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+class channel_base;
+
+/** \brief Base of all channel expressions
+ *  \tparam ExprT The derived expression type
+ *
+ *  \par Discussion
+ *  Arithmetic operators over channels do not compute anything. They return a
+ *  lightweight expression object recording the operands and operations.
+ *  The samples are computed in a single pass, one output sample at a time,
+ *  when the expression is assigned into a basic_channel or iterated over.
+ *  No intermediate channel is ever constructed so an expression of any
+ *  size reads each operand once and writes the result once.
+ *
+ *  \code
+ *  basic_channel<float,double,double> a, b, c;
+ *  ...
+ *  basic_channel<float,double,double> d = a + b * 2.0f - c;
+ *  \endcode
+ *
+ *  An expression holds references to its channel operands. It must not
+ *  outlive them and the operands must not be resized while it exists.
+ *  Expressions are meant to be consumed in the statement that creates them.
+ */
+template<typename ExprT>
+class channel_expression {
+  public:
+    /** \brief Obtain the derived expression */
+    const ExprT & derived(void) const {
+      return static_cast<const ExprT &>(*this);
+    }
+
+    /** \brief Write every sample of the expression starting at \e out
+     *  \param out An OutputIterator to at least size() elements
+     *  \internal If both \e out and every operand are random access, the
+     *    samples are computed with an index loop the compiler can vectorize.
+     */
+    template<typename OutputIterator>
+    void evaluate(OutputIterator out) const;
+};
+
+namespace detail {
+
+/** \internal Channel types usable as expression operands */
+template<typename T>
+struct is_channel_operand :mpl::false_ {};
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+struct is_channel_operand<
+  basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> >
+    :mpl::true_ {};
+
+template<typename ChannelT>
+struct is_channel_operand<basic_subchannel<ChannelT> > :mpl::true_ {};
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  typename InternalPrecisionSequence, template<typename T, typename A>
+  class Container, template<typename T> class Allocator>
+struct is_channel_operand<qsat::channel_base<MagnitudeT,FrequencyT,TimeT,
+  InternalPrecisionSequence,Container,Allocator> > :mpl::true_ {};
+
+/** \internal Expressions, which also includes every channel operand */
+template<typename T>
+struct is_expression_operand :mpl::or_<
+  is_channel_operand<T>,
+  b::is_base_of<channel_expression<T>,T> > {};
+
+/** \internal Arithmetic types used as a constant operand */
+template<typename T>
+struct is_scalar_operand :b::is_arithmetic<T> {};
+
+/** \internal An operand of a binary operator, at least one of which must be
+ *  an expression
+ */
+template<typename L, typename R>
+struct is_binary_operands :mpl::and_<
+  mpl::or_<is_expression_operand<L>,is_scalar_operand<L> >,
+  mpl::or_<is_expression_operand<R>,is_scalar_operand<R> >,
+  mpl::or_<is_expression_operand<L>,is_expression_operand<R> > > {};
+
+/** \internal Compile-time tag for random access evaluation */
+template<typename Iterator>
+struct is_random_access_iterator :b::is_convertible<
+  typename std::iterator_traits<Iterator>::iterator_category,
+  std::random_access_iterator_tag> {};
+
+
+
+/** \brief Leaf expression referring to a channel
+ *  \internal
+ */
+template<typename ChannelT>
+class channel_terminal :public channel_expression<channel_terminal<ChannelT> > {
+  public:
+    typedef decltype(std::declval<const ChannelT &>().begin()) iterator;
+    typedef typename b::remove_const<
+      typename std::iterator_traits<iterator>::value_type>::type value_type;
+    typedef typename ChannelT::size_type size_type;
+    typedef typename ChannelT::frequency_type frequency_type;
+    typedef typename ChannelT::time_type time_type;
+
+    typedef mpl::true_ has_timebase;
+    typedef is_random_access_iterator<iterator> random_access;
+
+    /** \internal Position within the channel during evaluation */
+    class cursor {
+      public:
+        explicit cursor(iterator pos) :_pos(pos) {}
+
+        value_type operator*(void) const {
+          return *_pos;
+        }
+
+        value_type operator[](std::ptrdiff_t n) const {
+          return _pos[n];
+        }
+
+        void operator++(void) {
+          ++_pos;
+        }
+
+      private:
+        iterator _pos;
+    };
+
+    explicit channel_terminal(const ChannelT &ch) :_ch(&ch) {}
+
+    cursor make_cursor(void) const {
+      return cursor(_ch->begin());
+    }
+
+    size_type size(void) const {
+      return _ch->size();
+    }
+
+    frequency_type frequency(void) const {
+      return _ch->frequency();
+    }
+
+    time_type epoch(void) const {
+      return _ch->epoch();
+    }
+
+  private:
+    const ChannelT *_ch;
+};
+
+/** \brief Leaf holding a constant operand
+ *  \internal Has no timebase of its own and matches any channel.
+ */
+template<typename T>
+class scalar_terminal {
+  public:
+    typedef T value_type;
+
+    typedef mpl::false_ has_timebase;
+    typedef mpl::true_ random_access;
+
+    class cursor {
+      public:
+        explicit cursor(const T &val) :_val(val) {}
+
+        value_type operator*(void) const {
+          return _val;
+        }
+
+        value_type operator[](std::ptrdiff_t) const {
+          return _val;
+        }
+
+        void operator++(void) {}
+
+      private:
+        T _val;
+    };
+
+    explicit scalar_terminal(const T &val) :_val(val) {}
+
+    cursor make_cursor(void) const {
+      return cursor(_val);
+    }
+
+  private:
+    T _val;
+};
+
+/** \internal Map an operator argument to the node stored in an expression */
+template<typename T, typename Enable = void>
+struct operand_traits {
+  typedef scalar_terminal<T> type;
+
+  static type make(const T &val) {
+    return type(val);
+  }
+};
+
+template<typename T>
+struct operand_traits<T,
+  typename b::enable_if<is_channel_operand<T> >::type>
+{
+  typedef channel_terminal<T> type;
+
+  static type make(const T &ch) {
+    return type(ch);
+  }
+};
+
+template<typename T>
+struct operand_traits<T,
+  typename b::enable_if<b::is_base_of<channel_expression<T>,T> >::type>
+{
+  typedef T type;
+
+  static const type & make(const T &expr) {
+    return expr;
+  }
+};
+
+struct plus_op {
+  template<typename A, typename B>
+  static auto apply(const A &a, const B &b) -> decltype(a+b) {
+    return a+b;
+  }
+};
+
+struct minus_op {
+  template<typename A, typename B>
+  static auto apply(const A &a, const B &b) -> decltype(a-b) {
+    return a-b;
+  }
+};
+
+struct multiplies_op {
+  template<typename A, typename B>
+  static auto apply(const A &a, const B &b) -> decltype(a*b) {
+    return a*b;
+  }
+};
+
+struct divides_op {
+  template<typename A, typename B>
+  static auto apply(const A &a, const B &b) -> decltype(a/b) {
+    return a/b;
+  }
+};
+
+struct negate_op {
+  template<typename A>
+  static auto apply(const A &a) -> decltype(-a) {
+    return -a;
+  }
+};
+
+/** \brief Elementwise binary operation
+ *  \internal The timebase of the expression is that of the left operand
+ *    unless it is a constant.
+ */
+template<typename L, typename R, typename Op>
+class binary_expression
+  :public channel_expression<binary_expression<L,R,Op> >
+{
+  private:
+    typedef typename mpl::if_<typename L::has_timebase,L,R>::type
+      timebase_type;
+
+  public:
+    typedef typename b::remove_const<decltype(Op::apply(
+      std::declval<typename L::value_type>(),
+      std::declval<typename R::value_type>()))>::type value_type;
+    typedef typename timebase_type::size_type size_type;
+    typedef typename timebase_type::frequency_type frequency_type;
+    typedef typename timebase_type::time_type time_type;
+
+    typedef mpl::true_ has_timebase;
+    typedef mpl::and_<typename L::random_access,
+      typename R::random_access> random_access;
+
+    class cursor {
+      public:
+        cursor(const typename L::cursor &lhs, const typename R::cursor &rhs)
+          :_lhs(lhs), _rhs(rhs) {}
+
+        value_type operator*(void) const {
+          return Op::apply(*_lhs,*_rhs);
+        }
+
+        value_type operator[](std::ptrdiff_t n) const {
+          return Op::apply(_lhs[n],_rhs[n]);
+        }
+
+        void operator++(void) {
+          ++_lhs;
+          ++_rhs;
+        }
+
+      private:
+        typename L::cursor _lhs;
+        typename R::cursor _rhs;
+    };
+
+    binary_expression(const L &lhs, const R &rhs) :_lhs(lhs), _rhs(rhs) {
+      check_timebase(typename L::has_timebase(),typename R::has_timebase());
+    }
+
+    cursor make_cursor(void) const {
+      return cursor(_lhs.make_cursor(),_rhs.make_cursor());
+    }
+
+    size_type size(void) const {
+      return timebase().size();
+    }
+
+    frequency_type frequency(void) const {
+      return timebase().frequency();
+    }
+
+    time_type epoch(void) const {
+      return timebase().epoch();
+    }
+
+  private:
+    L _lhs;
+    R _rhs;
+
+    const timebase_type & timebase(void) const {
+      return select_timebase(typename L::has_timebase());
+    }
+
+    const L & select_timebase(mpl::true_) const {
+      return _lhs;
+    }
+
+    const R & select_timebase(mpl::false_) const {
+      return _rhs;
+    }
+
+    void check_timebase(mpl::true_, mpl::true_) const;
+
+    void check_timebase(mpl::true_, mpl::false_) const {}
+
+    void check_timebase(mpl::false_, mpl::true_) const {}
+};
+
+template<typename L, typename R, typename Op>
+inline void binary_expression<L,R,Op>::check_timebase(mpl::true_, mpl::true_)
+  const
+{
+  if(!(_lhs.frequency() == _rhs.frequency()))
+    throw std::invalid_argument("channel expression: frequency mismatch");
+
+  if(!(_lhs.epoch() == _rhs.epoch()))
+    throw std::invalid_argument("channel expression: epoch mismatch");
+
+  if(_lhs.size() != _rhs.size())
+    throw std::invalid_argument("channel expression: size mismatch");
+}
+
+/** \brief Elementwise unary operation
+ *  \internal
+ */
+template<typename E, typename Op>
+class unary_expression :public channel_expression<unary_expression<E,Op> > {
+  public:
+    typedef typename b::remove_const<decltype(Op::apply(
+      std::declval<typename E::value_type>()))>::type value_type;
+    typedef typename E::size_type size_type;
+    typedef typename E::frequency_type frequency_type;
+    typedef typename E::time_type time_type;
+
+    typedef mpl::true_ has_timebase;
+    typedef typename E::random_access random_access;
+
+    class cursor {
+      public:
+        explicit cursor(const typename E::cursor &arg) :_arg(arg) {}
+
+        value_type operator*(void) const {
+          return Op::apply(*_arg);
+        }
+
+        value_type operator[](std::ptrdiff_t n) const {
+          return Op::apply(_arg[n]);
+        }
+
+        void operator++(void) {
+          ++_arg;
+        }
+
+      private:
+        typename E::cursor _arg;
+    };
+
+    explicit unary_expression(const E &arg) :_arg(arg) {}
+
+    cursor make_cursor(void) const {
+      return cursor(_arg.make_cursor());
+    }
+
+    size_type size(void) const {
+      return _arg.size();
+    }
+
+    frequency_type frequency(void) const {
+      return _arg.frequency();
+    }
+
+    time_type epoch(void) const {
+      return _arg.epoch();
+    }
+
+  private:
+    E _arg;
+};
+
+/** \brief Forward iterator over the samples of an expression
+ *  \internal
+ */
+template<typename ExprT>
+class expression_iterator :public b::iterator_facade<
+  expression_iterator<ExprT>,
+  const typename ExprT::value_type,
+  b::forward_traversal_tag,
+  typename ExprT::value_type>
+{
+  public:
+    expression_iterator(const typename ExprT::cursor &cur, std::size_t pos)
+      :_cur(cur), _pos(pos) {}
+
+  private:
+    friend class b::iterator_core_access;
+
+    typename ExprT::cursor _cur;
+    std::size_t _pos;
+
+    typename ExprT::value_type dereference(void) const {
+      return *_cur;
+    }
+
+    bool equal(const expression_iterator &rhs) const {
+      return _pos == rhs._pos;
+    }
+
+    void increment(void) {
+      ++_cur;
+      ++_pos;
+    }
+};
+
+template<typename ExprT, typename OutputIterator>
+inline void evaluate_expression(const ExprT &expr, OutputIterator out,
+  mpl::true_)
+{
+  typename ExprT::cursor cur = expr.make_cursor();
+
+  std::ptrdiff_t n = expr.size();
+  for(std::ptrdiff_t i=0; i<n; ++i)
+    out[i] = cur[i];
+}
+
+template<typename ExprT, typename OutputIterator>
+inline void evaluate_expression(const ExprT &expr, OutputIterator out,
+  mpl::false_)
+{
+  typename ExprT::cursor cur = expr.make_cursor();
+
+  for(std::size_t n = expr.size(); n; --n, ++out, ++cur)
+    *out = *cur;
+}
+
+}
+
+
+
+template<typename ExprT>
+template<typename OutputIterator>
+inline void channel_expression<ExprT>::evaluate(OutputIterator out) const
+{
+  detail::evaluate_expression(derived(),out,
+    mpl::bool_<ExprT::random_access::value &&
+      detail::is_random_access_iterator<OutputIterator>::value>());
+}
+
+/** \brief Obtain an iterator to the first sample of an expression
+ *  \param expr The expression
+ *  \return A forward iterator whose dereference computes the sample
+ *
+ *  \par Discussion
+ *  Allows an expression to be consumed by any algorithm taking a range, eg
+ *  <code>sub.assign(begin(expr),end(expr))</code> for a subchannel.
+ */
+template<typename ExprT>
+inline detail::expression_iterator<ExprT>
+begin(const channel_expression<ExprT> &expr)
+{
+  return detail::expression_iterator<ExprT>(
+    expr.derived().make_cursor(),0);
+}
+
+/** \brief Obtain an iterator to one past the last sample of an expression
+ *  \param expr The expression
+ *  \return A forward iterator comparing equal to the end of \e expr
+ */
+template<typename ExprT>
+inline detail::expression_iterator<ExprT>
+end(const channel_expression<ExprT> &expr)
+{
+  return detail::expression_iterator<ExprT>(
+    expr.derived().make_cursor(),expr.derived().size());
+}
+
+#define LEMMA_QSAT_CHANNEL_BINARY_OPERATOR(OP,FUNC)                         \
+template<typename L, typename R>                                            \
+inline typename b::enable_if<detail::is_binary_operands<L,R>,               \
+  detail::binary_expression<typename detail::operand_traits<L>::type,       \
+    typename detail::operand_traits<R>::type,detail::FUNC> >::type          \
+OP(const L &lhs, const R &rhs)                                              \
+{                                                                           \
+  return detail::binary_expression<                                         \
+    typename detail::operand_traits<L>::type,                               \
+    typename detail::operand_traits<R>::type,detail::FUNC>(                 \
+      detail::operand_traits<L>::make(lhs),                                 \
+      detail::operand_traits<R>::make(rhs));                                \
+}
+
+/** \brief Elementwise sum of channels, expressions, or constants
+ *  \throws <CODE>std::invalid_argument</CODE> if two channel operands differ
+ *    in frequency, epoch, or size
+ */
+LEMMA_QSAT_CHANNEL_BINARY_OPERATOR(operator+,plus_op)
+
+/** \brief Elementwise difference of channels, expressions, or constants
+ *  \throws <CODE>std::invalid_argument</CODE> if two channel operands differ
+ *    in frequency, epoch, or size
+ */
+LEMMA_QSAT_CHANNEL_BINARY_OPERATOR(operator-,minus_op)
+
+/** \brief Elementwise product of channels, expressions, or constants
+ *  \throws <CODE>std::invalid_argument</CODE> if two channel operands differ
+ *    in frequency, epoch, or size
+ */
+LEMMA_QSAT_CHANNEL_BINARY_OPERATOR(operator*,multiplies_op)
+
+/** \brief Elementwise quotient of channels, expressions, or constants
+ *  \throws <CODE>std::invalid_argument</CODE> if two channel operands differ
+ *    in frequency, epoch, or size
+ */
+LEMMA_QSAT_CHANNEL_BINARY_OPERATOR(operator/,divides_op)
+
+#undef LEMMA_QSAT_CHANNEL_BINARY_OPERATOR
+
+/** \brief Elementwise negation of a channel or expression */
+template<typename E>
+inline typename b::enable_if<detail::is_expression_operand<E>,
+  detail::unary_expression<typename detail::operand_traits<E>::type,
+    detail::negate_op> >::type
+operator-(const E &arg)
+{
+  return detail::unary_expression<typename detail::operand_traits<E>::type,
+    detail::negate_op>(detail::operand_traits<E>::make(arg));
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,1022 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_CHANNEL_GROUP_H
+#define LEMMA_QSAT_CHANNEL_GROUP_H
+
+#include "basic_channel.h"
+#include "detail/value_cast.h"
+
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <memory>
+#include <vector>
+#include <deque>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <cassert>
+
+/** \file
+ *  \brief Implementation of basic_channel_group, a set of channels sharing
+ *    one timebase stored planar in a single allocation
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \brief Random access iterator with a fixed distance between elements
+ *  \internal Used to traverse a row of a basic_channel_group, ie the samples
+ *  of every channel at one instant.
+ */
+template<typename T>
+class strided_iterator :public b::iterator_facade<strided_iterator<T>,
+  T, std::random_access_iterator_tag>
+{
+  public:
+    typedef std::ptrdiff_t difference_type;
+
+    strided_iterator(void) :ptr(0), stride(0) {}
+
+    strided_iterator(T *p, difference_type s) :ptr(p), stride(s) {}
+
+    template<typename U>
+    strided_iterator(const strided_iterator<U> &rhs,
+      typename std::enable_if<std::is_convertible<U*,T*>::value>::type* = 0)
+        :ptr(rhs.ptr), stride(rhs.stride) {}
+
+  private:
+    friend class b::iterator_core_access;
+    template<typename U> friend class strided_iterator;
+
+    T & dereference(void) const {
+      return *ptr;
+    }
+
+    template<typename U>
+    bool equal(const strided_iterator<U> &rhs) const {
+      return ptr == rhs.ptr;
+    }
+
+    void increment(void) {
+      ptr += stride;
+    }
+
+    void decrement(void) {
+      ptr -= stride;
+    }
+
+    void advance(difference_type n) {
+      ptr += n*stride;
+    }
+
+    template<typename U>
+    difference_type distance_to(const strided_iterator<U> &rhs) const {
+      return (rhs.ptr - ptr)/stride;
+    }
+
+    T *ptr;
+    difference_type stride;
+};
+
+/** \brief The samples of every channel of a group at one instant
+ *  \internal
+ */
+template<typename T>
+class strided_range {
+  public:
+    typedef T value_type;
+    typedef T & reference;
+    typedef std::size_t size_type;
+    typedef strided_iterator<T> iterator;
+
+    strided_range(T *p, size_type n, std::ptrdiff_t s)
+      :ptr(p), count(n), stride(s) {}
+
+    iterator begin(void) const {
+      return iterator(ptr,stride);
+    }
+
+    iterator end(void) const {
+      return iterator(ptr+count*stride,stride);
+    }
+
+    size_type size(void) const {
+      return count;
+    }
+
+    reference operator[](size_type n) const {
+      return ptr[n*stride];
+    }
+
+  private:
+    T *ptr;
+    size_type count;
+    std::ptrdiff_t stride;
+};
+
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+class basic_channel_group;
+
+/** \brief One channel of a basic_channel_group
+ *  \tparam GroupT The basic_channel_group type
+ *
+ *  Model of std::sequence without insertion or erasure, with Channel
+ *  additions
+ *
+ *  \par Discussion
+ *  The samples of a group channel are contiguous and owned by the group.
+ *  Group channels are obtained by reference from the group and live as long
+ *  as the group does, so subchannels may be bound to them exactly as to a
+ *  basic_channel. Iterators and references are invalidated by any operation
+ *  on the group that changes its capacity.
+ */
+template<typename GroupT>
+class basic_group_channel {
+  public:
+    /** lvalue of MagnitudeT */
+    typedef typename GroupT::magnitude_type & reference;
+    /** const lvalue of MagnitudeT */
+    typedef const typename GroupT::magnitude_type & const_reference;
+    /** iterator type pointing to MagnitudeT */
+    typedef typename GroupT::magnitude_type * iterator;
+    /** iterator type pointing to const MagnitudeT */
+    typedef const typename GroupT::magnitude_type * const_iterator;
+    /** unsigned integral type */
+    typedef typename GroupT::size_type size_type;
+    /** signed integral type */
+    typedef typename GroupT::difference_type difference_type;
+    /** MagnitudeT */
+    typedef typename GroupT::magnitude_type value_type;
+    /** type modeling pointer to MagnitudeT */
+    typedef typename GroupT::magnitude_type * pointer;
+    /** type modeling pointer to const MagnitudeT */
+    typedef const typename GroupT::magnitude_type * const_pointer;
+    /** reverse_iterator type pointing to MagnitudeT */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type pointing to const MagnitudeT */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** MagnitudeT */
+    typedef typename GroupT::magnitude_type magnitude_type;
+    /** FrequencyT */
+    typedef typename GroupT::frequency_type frequency_type;
+    /** TimeT */
+    typedef typename GroupT::time_type time_type;
+
+    /** Subchannel type */
+    typedef basic_subchannel<basic_group_channel> subchannel_type;
+    /** Subchannel type */
+    typedef basic_subchannel<const basic_group_channel> const_subchannel_type;
+
+    /** Obtain iterator to the first sample */
+    iterator begin(void) {
+      return group->data(idx);
+    }
+
+    /** Obtain iterator to the first sample */
+    const_iterator begin(void) const {
+      return group->data(idx);
+    }
+
+    /** Obtain iterator to one past the last sample */
+    iterator end(void) {
+      return group->data(idx)+group->size();
+    }
+
+    /** Obtain iterator to one past the last sample */
+    const_iterator end(void) const {
+      return group->data(idx)+group->size();
+    }
+
+    /** Obtain reverse_iterator to the last sample */
+    reverse_iterator rbegin(void) {
+      return reverse_iterator(end());
+    }
+
+    /** Obtain reverse_iterator to the last sample */
+    const_reverse_iterator rbegin(void) const {
+      return const_reverse_iterator(end());
+    }
+
+    /** Obtain reverse_iterator to one before the first sample */
+    reverse_iterator rend(void) {
+      return reverse_iterator(begin());
+    }
+
+    /** Obtain reverse_iterator to one before the first sample */
+    const_reverse_iterator rend(void) const {
+      return const_reverse_iterator(begin());
+    }
+
+    /** Obtain the number of samples, the same for every channel */
+    size_type size(void) const {
+      return group->size();
+    }
+
+    /** Obtain whether or not the channel contains any samples */
+    bool empty(void) const {
+      return group->empty();
+    }
+
+    /** Obtain a reference to the sample at location <EM>n</EM> */
+    reference operator[](size_type n) {
+      return group->data(idx)[n];
+    }
+
+    /** Obtain a reference to the sample at location <EM>n</EM> */
+    const_reference operator[](size_type n) const {
+      return group->data(idx)[n];
+    }
+
+    /** Obtain the first sample */
+    reference front(void) {
+      return *begin();
+    }
+
+    /** Obtain the first sample */
+    const_reference front(void) const {
+      return *begin();
+    }
+
+    /** Obtain the last sample */
+    reference back(void) {
+      return *(end()-1);
+    }
+
+    /** Obtain the last sample */
+    const_reference back(void) const {
+      return *(end()-1);
+    }
+
+    /** Obtain the location of this channel in its group */
+    size_type index(void) const {
+      return idx;
+    }
+
+    /** Obtain the sample frequency of the group */
+    const frequency_type & frequency(void) const {
+      return group->frequency();
+    }
+
+    /** Obtain the sample epoch of the group */
+    const time_type & epoch(void) const {
+      return group->epoch();
+    }
+
+    /** Obtain a mutable subset of this channel */
+    subchannel_type subchannel(iterator first, iterator last) {
+      return subchannel_type(*this,first,last,first-begin());
+    }
+
+    /** Obtain a constant subset of this channel */
+    const_subchannel_type subchannel(const_iterator first,
+      const_iterator last) const
+    {
+      return const_subchannel_type(*this,first,last,first-begin());
+    }
+
+    /** Compare the samples of two channels */
+    bool operator==(const basic_group_channel &rhs) const {
+      return size() == rhs.size() && std::equal(begin(),end(),rhs.begin());
+    }
+
+    /** Compare the samples of two channels */
+    bool operator!=(const basic_group_channel &rhs) const {
+      return !(*this == rhs);
+    }
+
+  private:
+    template<typename M, typename F, typename T,
+      template<typename U> class A> friend class basic_channel_group;
+
+    basic_group_channel(GroupT *g, size_type i) :group(g), idx(i) {}
+
+    GroupT *group;
+    size_type idx;
+};
+
+/** \brief A set of channels sharing one timebase stored planar in a single
+ *    allocation
+ *  \tparam MagnitudeT The signal magnitude type, must be trivially copyable
+ *  \tparam FrequencyT The signal frequency type
+ *  \tparam TimeT The type used to represent the channels time quantum
+ *  \tparam Allocator The allocator used for the sample storage
+ *
+ *  \par Discussion
+ *  Recordings from many sensors sampled together share a frequency, an
+ *  epoch, and a length. basic_channel_group stores the samples of all of
+ *  its channels() channels structure-of-arrays in one allocation: channel
+ *  \e i occupies <code>[data(i),data(i)+size())</code>, each channel begins
+ *  on a 64 byte boundary, and consecutive channels are stride() samples
+ *  apart. There is a single frequency and epoch for the group.
+ *
+ *  Each channel is a basic_group_channel, obtained by reference with
+ *  operator[], that models the Channel interface so subchannels may be
+ *  bound to it. The samples of every channel at one instant, a row, are
+ *  accessed with row() and appended with push_back().
+ *
+ *  Unlike basic_channel, a group is not copy on write. Copies are deep.
+ *
+ *  \code
+ *  typedef basic_channel_group<float,float,float> group_type;
+ *
+ *  group_type group(64,0,1000.0f);
+ *  group.push_back(first,first+64); // one sample for every channel
+ *  float x = group[3][0];
+ *  group_type::row_type r = group.row(0);
+ *  \endcode
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator = std::allocator>
+class basic_channel_group {
+  public:
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** MagnitudeT */
+    typedef MagnitudeT value_type;
+    /** MagnitudeT */
+    typedef MagnitudeT magnitude_type;
+    /** FrequencyT */
+    typedef FrequencyT frequency_type;
+    /** TimeT */
+    typedef TimeT time_type;
+    /** Allocator<MagnitudeT> */
+    typedef Allocator<MagnitudeT> allocator_type;
+
+    /** One channel of the group */
+    typedef basic_group_channel<basic_channel_group> channel_type;
+    /** The samples of every channel at one instant */
+    typedef detail::strided_range<MagnitudeT> row_type;
+    /** The samples of every channel at one instant */
+    typedef detail::strided_range<const MagnitudeT> const_row_type;
+
+    /** Alignment in bytes of the first sample of every channel */
+    static const size_type alignment = 64;
+
+    /** \brief Constructor
+     *
+     *  \param nchannels The number of channels
+     *  \param n The initial number of samples in each channel
+     *  \param freq A value of <code>frequency_type</code> representing the
+     *    sample frequency. Default is <code>frequency_type(1)</code>.
+     *  \param start A value of <code>time_type</code> representing the time
+     *    sampling started. Default is <code>time_type(0)</code>.
+     *  \param val The value of the initial samples
+     */
+    explicit basic_channel_group(size_type nchannels, size_type n=0,
+      const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
+      const TimeT &start=detail::value_cast<TimeT>::construct(0),
+      const MagnitudeT &val=MagnitudeT());
+
+    /** \brief Copy Constructor
+     *  \param rhs The group to copy
+     */
+    basic_channel_group(const basic_channel_group &rhs);
+
+    /** \brief Move Constructor
+     *  \param rhs The group to move from. rhs has no samples afterwards.
+     */
+    basic_channel_group(basic_channel_group &&rhs);
+
+    /** \brief Destructor
+     */
+    ~basic_channel_group(void);
+
+    /** \brief Assignment Operator
+     *  \param rhs The group to copy
+     */
+    basic_channel_group & operator=(basic_channel_group rhs);
+
+    /** \brief Obtain the number of channels
+     *  \return The number of channels
+     */
+    size_type channels(void) const;
+
+    /** \brief Obtain the number of samples in each channel
+     *  \return The number of samples in each channel
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain whether or not the channels contain any samples
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Obtain the number of samples each channel can hold without
+     *    reallocation
+     *  \return The capacity of each channel
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain the distance in samples between consecutive channels
+     *  \return <CODE>data(i+1) - data(i)</CODE>
+     */
+    size_type stride(void) const;
+
+    /** \brief Obtain the samples of a channel
+     *  \param i The channel location
+     *  \return Pointer to the first sample of channel \e i
+     */
+    MagnitudeT * data(size_type i);
+
+    /** \brief Obtain the samples of a channel
+     *  \param i The channel location
+     *  \return Pointer to the first sample of channel \e i
+     */
+    const MagnitudeT * data(size_type i) const;
+
+    /** \brief Obtain a channel
+     *  \param i The channel location
+     *  \return Reference to channel \e i, valid for the life of the group
+     *    unless an assignment or swap() leaves it with \e i or fewer
+     *    channels
+     */
+    channel_type & operator[](size_type i);
+
+    /** \brief Obtain a channel
+     *  \param i The channel location
+     *  \return Reference to channel \e i, valid for the life of the group
+     *    unless an assignment or swap() leaves it with \e i or fewer
+     *    channels
+     */
+    const channel_type & operator[](size_type i) const;
+
+    /** \brief Obtain a channel with bounds checking
+     *  \param i The channel location
+     *  \return Reference to channel \e i
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>i >= channels()</CODE>
+     */
+    channel_type & at(size_type i);
+
+    /** \brief Obtain a channel with bounds checking
+     *  \param i The channel location
+     *  \return Reference to channel \e i
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>i >= channels()</CODE>
+     */
+    const channel_type & at(size_type i) const;
+
+    /** \brief Obtain the samples of every channel at one instant
+     *  \param n The sample location
+     *  \return The row of samples, channel 0 first
+     */
+    row_type row(size_type n);
+
+    /** \brief Obtain the samples of every channel at one instant
+     *  \param n The sample location
+     *  \return The row of samples, channel 0 first
+     */
+    const_row_type row(size_type n) const;
+
+    /** \brief Append one sample to every channel
+     *  \param first,last <code>InputIterator</code> range of channels()
+     *    values convertable to MagnitudeT, channel 0 first
+     *  \throws <CODE>std::invalid_argument</CODE> if the range does not
+     *    contain exactly channels() values
+     *
+     *  \par Discussion
+     *  Capacity grows geometrically so appending rows is amortized constant
+     *  time per channel.
+     */
+    template<typename InputIterator>
+    void push_back(InputIterator first, InputIterator last);
+
+    /** \brief Remove the last sample of every channel
+     */
+    void pop_back(void);
+
+    /** \brief Change the number of samples in each channel
+     *  \param n The new number of samples
+     *  \param val The value of appended samples
+     */
+    void resize(size_type n, const MagnitudeT &val=MagnitudeT());
+
+    /** \brief Ensure each channel can hold \e n samples without reallocation
+     *  \param n The minimum capacity
+     */
+    void reserve(size_type n);
+
+    /** \brief Remove every sample, keeping the channels
+     */
+    void clear(void);
+
+    /** \brief Swap the contents of two groups
+     *  \param rhs The group to swap with
+     *  \pre The allocators compare equal unless the allocator_type
+     *    propagates on container swap, in which case they are exchanged
+     */
+    void swap(basic_channel_group &rhs);
+
+    /** \brief Set new sample frequency and return the old value
+     *  \param freq The new sample frequency
+     *  \return The previous sample frequency
+     */
+    frequency_type frequency(const FrequencyT &freq);
+
+    /** \brief Obtain the sample frequency of every channel
+     *  \return The sample frequency
+     */
+    const frequency_type & frequency(void) const;
+
+    /** \brief Set new sample epoch and return the old value
+     *  \param start The time sampling started
+     *  \return The previous sample epoch
+     */
+    time_type epoch(const TimeT &start);
+
+    /** \brief Obtain the sample epoch of every channel
+     *  \return The sample epoch
+     */
+    const time_type & epoch(void) const;
+
+    /** \brief Copy one channel into a basic_channel
+     *  \param i The channel location
+     *  \return A basic_channel holding the samples, frequency, and epoch of
+     *    channel \e i
+     */
+    basic_channel<MagnitudeT,FrequencyT,TimeT,std::vector,Allocator>
+    extract(size_type i) const;
+
+  private:
+    static_assert(std::is_trivially_copyable<MagnitudeT>::value,
+      "basic_channel_group requires a trivially copyable MagnitudeT");
+
+    typedef std::allocator_traits<allocator_type> alloc_traits;
+
+    FrequencyT _sample_frequency;
+    TimeT _time_start;
+
+    allocator_type alloc;
+    // allocation as returned by the allocator and its length in samples
+    MagnitudeT *block;
+    size_type block_len;
+    // first sample of channel 0, aligned
+    MagnitudeT *base;
+
+    size_type _size;
+    size_type _capacity;
+    size_type _stride;
+
+    // a deque so that growing or shrinking never moves the other views
+    std::deque<channel_type> views;
+
+    static size_type stride_for(size_type n);
+
+    void reallocate(size_type n);
+    void deallocate(void);
+    void make_views(size_type nchannels);
+    void swap_storage(basic_channel_group &rhs);
+};
+
+
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_channel_group(size_type nchannels, size_type n,
+    const FrequencyT &freq, const TimeT &start, const MagnitudeT &val)
+      :_sample_frequency(freq), _time_start(start), block(0), block_len(0),
+        base(0), _size(0), _capacity(0), _stride(0)
+{
+  make_views(nchannels);
+  resize(n,val);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_channel_group(const basic_channel_group &rhs)
+    :_sample_frequency(rhs._sample_frequency), _time_start(rhs._time_start),
+      alloc(alloc_traits::select_on_container_copy_construction(rhs.alloc)),
+      block(0), block_len(0), base(0), _size(0), _capacity(0), _stride(0)
+{
+  make_views(rhs.channels());
+  reallocate(rhs._size);
+
+  for(size_type i=0; i<channels(); ++i)
+    std::copy(rhs.data(i),rhs.data(i)+rhs._size,data(i));
+
+  _size = rhs._size;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_channel_group(basic_channel_group &&rhs)
+    :_sample_frequency(rhs._sample_frequency), _time_start(rhs._time_start),
+      alloc(rhs.alloc), block(rhs.block), block_len(rhs.block_len),
+      base(rhs.base), _size(rhs._size), _capacity(rhs._capacity),
+      _stride(rhs._stride)
+{
+  make_views(rhs.channels());
+
+  rhs.block = 0;
+  rhs.block_len = 0;
+  rhs.base = 0;
+  rhs._size = 0;
+  rhs._capacity = 0;
+  rhs._stride = 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  ~basic_channel_group(void)
+{
+  deallocate();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator> &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  operator=(basic_channel_group rhs)
+{
+  // rhs is a temporary, so the allocators go along with the storage they
+  // allocated
+  using std::swap;
+
+  swap(alloc,rhs.alloc);
+  swap_storage(rhs);
+  return *this;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  channels(void) const
+{
+  return views.size();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size(void) const
+{
+  return _size;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline bool basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  empty(void) const
+{
+  return _size == 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  capacity(void) const
+{
+  return _capacity;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::stride(void) const
+{
+  return _stride;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline MagnitudeT *
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::data(size_type i)
+{
+  return base+i*_stride;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const MagnitudeT *
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  data(size_type i) const
+{
+  return base+i*_stride;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::channel_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  operator[](size_type i)
+{
+  return views[i];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::channel_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  operator[](size_type i) const
+{
+  return views[i];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::channel_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::at(size_type i)
+{
+  if(i >= channels())
+    throw std::out_of_range("basic_channel_group::at");
+
+  return views[i];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::channel_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  at(size_type i) const
+{
+  if(i >= channels())
+    throw std::out_of_range("basic_channel_group::at");
+
+  return views[i];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::row_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::row(size_type n)
+{
+  return row_type(base+n,channels(),_stride);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::const_row_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  row(size_type n) const
+{
+  return const_row_type(base+n,channels(),_stride);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+template<typename InputIterator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  push_back(InputIterator first, InputIterator last)
+{
+  if(_size == _capacity)
+    reallocate(_capacity ? 2*_capacity : 8);
+
+  MagnitudeT *dst = base+_size;
+  size_type i = 0;
+  for(; first != last && i < channels(); ++first, ++i)
+    dst[i*_stride] = *first;
+
+  if(first != last || i != channels())
+    throw std::invalid_argument(
+      "basic_channel_group::push_back: row length does not match channels()");
+
+  ++_size;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  pop_back(void)
+{
+  --_size;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  resize(size_type n, const MagnitudeT &val)
+{
+  if(n > _capacity)
+    reallocate(std::max(n,2*_capacity));
+
+  if(n > _size) {
+    for(size_type i=0; i<channels(); ++i)
+      std::fill(data(i)+_size,data(i)+n,val);
+  }
+
+  _size = n;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  reserve(size_type n)
+{
+  if(n > _capacity)
+    reallocate(n);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  clear(void)
+{
+  _size = 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  swap(basic_channel_group &rhs)
+{
+  using std::swap;
+
+  if(alloc_traits::propagate_on_container_swap::value)
+    swap(alloc,rhs.alloc);
+  else
+    assert(alloc == rhs.alloc);
+
+  swap_storage(rhs);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  swap_storage(basic_channel_group &rhs)
+{
+  using std::swap;
+
+  swap(_sample_frequency,rhs._sample_frequency);
+  swap(_time_start,rhs._time_start);
+  swap(block,rhs.block);
+  swap(block_len,rhs.block_len);
+  swap(base,rhs.base);
+  swap(_size,rhs._size);
+  swap(_capacity,rhs._capacity);
+  swap(_stride,rhs._stride);
+
+  size_type nchannels = channels();
+  make_views(rhs.channels());
+  rhs.make_views(nchannels);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  frequency(const FrequencyT &freq)
+{
+  FrequencyT prev(_sample_frequency);
+  _sample_frequency = freq;
+  return prev;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  frequency(void) const
+{
+  return _sample_frequency;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  epoch(const TimeT &start)
+{
+  TimeT prev(_time_start);
+  _time_start = start;
+  return prev;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type &
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::epoch(void) const
+{
+  return _time_start;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,std::vector,Allocator>
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  extract(size_type i) const
+{
+  return basic_channel<MagnitudeT,FrequencyT,TimeT,std::vector,Allocator>(
+    data(i),data(i)+_size,_sample_frequency,_time_start);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  stride_for(size_type n)
+{
+  // round each channel up to the fewest samples spanning a whole number
+  // of aligned blocks, alignment/gcd(alignment,sizeof(MagnitudeT))
+  size_type a = alignment;
+  size_type b = sizeof(MagnitudeT);
+  while(b) {
+    size_type r = a % b;
+    a = b;
+    b = r;
+  }
+
+  const size_type unit = alignment/a;
+
+  return ((n+unit-1)/unit)*unit;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  reallocate(size_type n)
+{
+  size_type nstride = stride_for(n);
+  size_type len = nstride*channels() + alignment/sizeof(MagnitudeT) + 1;
+
+  MagnitudeT *nblock = alloc_traits::allocate(alloc,len);
+
+  void *ptr = nblock;
+  std::size_t space = len*sizeof(MagnitudeT);
+  MagnitudeT *nbase = static_cast<MagnitudeT*>(
+    std::align(alignment,nstride*channels()*sizeof(MagnitudeT),ptr,space));
+
+  for(size_type i=0; i<channels(); ++i)
+    std::copy(data(i),data(i)+_size,nbase+i*nstride);
+
+  deallocate();
+
+  block = nblock;
+  block_len = len;
+  base = nbase;
+  _capacity = nstride;
+  _stride = nstride;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  deallocate(void)
+{
+  if(block)
+    alloc_traits::deallocate(alloc,block,block_len);
+
+  block = 0;
+  block_len = 0;
+  base = 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_channel_group<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  make_views(size_type nchannels)
+{
+  // existing views stay where they are so references to them remain valid
+  while(views.size() > nchannels)
+    views.pop_back();
+
+  while(views.size() < nchannels)
+    views.push_back(channel_type(this,views.size()));
+}
+
+}
+}
+
+
+#endif
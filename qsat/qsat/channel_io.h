@@ -0,0 +1,485 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_CHANNEL_IO_H
+#define LEMMA_QSAT_CHANNEL_IO_H
+
+#include "basic_channel.h"
+#include "intrusive_sequence.h"
+#include "mapped_sequence.h"
+#include "detail/value_cast.h"
+#include "detail/contiguous.h"
+
+#include <boost/mpl/bool.hpp>
+#include <boost/predef/other/endian.h>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/** \file
+ *  \brief Reading and writing channels in the native qsat binary channel
+ *    file format
+ *
+ *  \par File format
+ *  A channel file is a fixed 64 byte header followed by the raw samples.
+ *  All header fields and samples are stored little-endian.
+ *  <pre>
+ *  offset  size  field
+ *       0     8  magic "QSATCHN\0"
+ *       8     2  format version (1)
+ *      10     2  header size (64)
+ *      12     1  sample type code, see detail::sample_type_code
+ *      13     1  sample size in bytes
+ *      14     2  alignment in bytes of the sample data offset, a power
+ *                of two dividing the byte offset of the first sample
+ *      16     8  sample count
+ *      24     8  sample frequency (IEEE 754 double)
+ *      32     8  epoch (IEEE 754 double)
+ *      40     8  byte offset of the first sample
+ *      48    16  reserved, zero
+ *  </pre>
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+/** \brief Decoded header of a channel file
+ */
+struct channel_file_header {
+  /** Sample type code, see detail::sample_type_code */
+  unsigned int type_code;
+  /** Sample size in bytes */
+  unsigned int sample_size;
+  /** Alignment of the sample data offset in bytes */
+  unsigned int alignment;
+  /** Number of samples */
+  std::uint64_t count;
+  /** Sample frequency */
+  double frequency;
+  /** Epoch */
+  double epoch;
+  /** Byte offset of the first sample */
+  std::uint64_t data_offset;
+};
+
+namespace detail {
+
+/** \brief File type code of a sample type
+ *  \internal Only fixed width arithmetic types have a code.
+ */
+template<typename T>
+struct sample_type_code;
+
+template<> struct sample_type_code<std::int8_t> { static const unsigned int value = 1; };
+template<> struct sample_type_code<std::uint8_t> { static const unsigned int value = 2; };
+template<> struct sample_type_code<std::int16_t> { static const unsigned int value = 3; };
+template<> struct sample_type_code<std::uint16_t> { static const unsigned int value = 4; };
+template<> struct sample_type_code<std::int32_t> { static const unsigned int value = 5; };
+template<> struct sample_type_code<std::uint32_t> { static const unsigned int value = 6; };
+template<> struct sample_type_code<std::int64_t> { static const unsigned int value = 7; };
+template<> struct sample_type_code<std::uint64_t> { static const unsigned int value = 8; };
+template<> struct sample_type_code<float> { static const unsigned int value = 9; };
+template<> struct sample_type_code<double> { static const unsigned int value = 10; };
+
+static const char channel_file_magic[8] = {'Q','S','A','T','C','H','N','\0'};
+static const unsigned int channel_file_version = 1;
+static const std::size_t channel_file_header_size = 64;
+
+inline void store_le(char *dst, std::uint64_t val, std::size_t n)
+{
+  for(std::size_t i=0; i<n; ++i, val >>= 8)
+    dst[i] = char(val & 0xff);
+}
+
+inline std::uint64_t load_le(const char *src, std::size_t n)
+{
+  std::uint64_t val = 0;
+  for(std::size_t i=n; i>0; --i)
+    val = (val << 8) | std::uint64_t(static_cast<unsigned char>(src[i-1]));
+
+  return val;
+}
+
+inline void encode_header(char *buf, const channel_file_header &hdr)
+{
+  std::uint64_t freq;
+  std::uint64_t start;
+  std::memcpy(&freq,&hdr.frequency,sizeof(freq));
+  std::memcpy(&start,&hdr.epoch,sizeof(start));
+
+  std::memset(buf,0,channel_file_header_size);
+  std::memcpy(buf,channel_file_magic,sizeof(channel_file_magic));
+  store_le(buf+8,channel_file_version,2);
+  store_le(buf+10,channel_file_header_size,2);
+  store_le(buf+12,hdr.type_code,1);
+  store_le(buf+13,hdr.sample_size,1);
+  store_le(buf+14,hdr.alignment,2);
+  store_le(buf+16,hdr.count,8);
+  store_le(buf+24,freq,8);
+  store_le(buf+32,start,8);
+  store_le(buf+40,hdr.data_offset,8);
+}
+
+inline channel_file_header decode_header(const char *buf)
+{
+  if(std::memcmp(buf,channel_file_magic,sizeof(channel_file_magic)) != 0)
+    throw std::runtime_error("channel_io: not a channel file");
+
+  if(load_le(buf+8,2) != channel_file_version)
+    throw std::runtime_error("channel_io: unsupported format version");
+
+  if(load_le(buf+10,2) != channel_file_header_size)
+    throw std::runtime_error("channel_io: invalid header size");
+
+  channel_file_header hdr;
+  hdr.type_code = load_le(buf+12,1);
+  hdr.sample_size = load_le(buf+13,1);
+  hdr.alignment = load_le(buf+14,2);
+  hdr.count = load_le(buf+16,8);
+
+  std::uint64_t freq = load_le(buf+24,8);
+  std::uint64_t start = load_le(buf+32,8);
+  std::memcpy(&hdr.frequency,&freq,sizeof(freq));
+  std::memcpy(&hdr.epoch,&start,sizeof(start));
+
+  // the samples are mapped at data_offset, so it must honor a sane alignment
+  if(hdr.alignment == 0 || (hdr.alignment & (hdr.alignment-1)) != 0)
+    throw std::runtime_error("channel_io: invalid alignment");
+
+  hdr.data_offset = load_le(buf+40,8);
+  if(hdr.data_offset < channel_file_header_size ||
+    hdr.data_offset % hdr.alignment != 0)
+  {
+    throw std::runtime_error("channel_io: invalid data offset");
+  }
+
+  return hdr;
+}
+
+template<typename T>
+inline void check_sample_type(const channel_file_header &hdr)
+{
+  if(hdr.type_code != sample_type_code<T>::value ||
+    hdr.sample_size != sizeof(T))
+  {
+    throw std::runtime_error("channel_io: sample type mismatch");
+  }
+
+  if(hdr.alignment % std::alignment_of<T>::value != 0)
+    throw std::runtime_error("channel_io: misaligned samples");
+}
+
+/** \internal Reverse the byte order of each sample in place. Only used on
+ *  big-endian hosts.
+ */
+template<typename T>
+inline void swap_bytes(T *first, T *last)
+{
+  for(; first != last; ++first) {
+    char *bytes = reinterpret_cast<char*>(first);
+    std::reverse(bytes,bytes+sizeof(T));
+  }
+}
+
+inline void write_fully(int fd, struct iovec *iov, int iovcnt)
+{
+  while(iovcnt) {
+    ssize_t res = ::writev(fd,iov,iovcnt);
+    if(res < 0) {
+      if(errno == EINTR)
+        continue;
+
+      throw std::system_error(errno,std::system_category(),
+        "channel_io: writev");
+    }
+
+    // advance past a partial write
+    std::size_t len = res;
+    while(iovcnt && len >= iov->iov_len) {
+      len -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+
+    if(iovcnt) {
+      iov->iov_base = static_cast<char*>(iov->iov_base)+len;
+      iov->iov_len -= len;
+    }
+  }
+}
+
+/** \internal Create a new file next to \e path for writing
+ *  \param tmp Set to the name of the created file
+ *  \return The open descriptor
+ */
+inline int open_temporary(const std::string &path, std::string &tmp)
+{
+  static std::atomic<unsigned long> counter(0);
+
+  for(;;) {
+    tmp = path + ".tmp." + std::to_string(long(::getpid())) + "." +
+      std::to_string(counter++);
+
+    int fd = ::open(tmp.c_str(),O_WRONLY | O_CREAT | O_EXCL,0666);
+    if(fd >= 0)
+      return fd;
+
+    if(errno != EEXIST)
+      throw std::system_error(errno,std::system_category(),
+        "channel_io: open " + tmp);
+  }
+}
+
+template<typename T>
+inline void write_samples(const std::string &path, channel_file_header hdr,
+  const T *samples)
+{
+  char buf[channel_file_header_size];
+  encode_header(buf,hdr);
+
+  // the samples may be mapped from path itself, eg a channel from
+  // load_channel(), so path is replaced only once they are written
+  std::string tmp;
+  int fd = open_temporary(path,tmp);
+
+  struct iovec iov[2];
+  iov[0].iov_base = buf;
+  iov[0].iov_len = sizeof(buf);
+  iov[1].iov_base = const_cast<T*>(samples);
+  iov[1].iov_len = hdr.count*sizeof(T);
+
+  try {
+    write_fully(fd,iov,hdr.count ? 2 : 1);
+  }
+  catch(...) {
+    ::close(fd);
+    ::unlink(tmp.c_str());
+    throw;
+  }
+
+  if(::close(fd) < 0) {
+    int err = errno;
+    ::unlink(tmp.c_str());
+    throw std::system_error(err,std::system_category(),
+      "channel_io: close " + tmp);
+  }
+
+  if(std::rename(tmp.c_str(),path.c_str()) < 0) {
+    int err = errno;
+    ::unlink(tmp.c_str());
+    throw std::system_error(err,std::system_category(),
+      "channel_io: rename " + path);
+  }
+}
+
+template<typename ChannelT>
+inline void write_channel_impl(const std::string &path, const ChannelT &ch,
+  const channel_file_header &hdr, mpl::false_)
+{
+  typedef typename ChannelT::magnitude_type magnitude_type;
+
+  std::vector<magnitude_type> buf(ch.begin(),ch.end());
+#if !BOOST_ENDIAN_LITTLE_BYTE
+  swap_bytes(buf.data(),buf.data()+buf.size());
+#endif
+  write_samples(path,hdr,buf.data());
+}
+
+template<typename ChannelT>
+inline void write_channel_impl(const std::string &path, const ChannelT &ch,
+  const channel_file_header &hdr, mpl::true_)
+{
+  typedef typename ChannelT::magnitude_type magnitude_type;
+
+#if BOOST_ENDIAN_LITTLE_BYTE
+  write_samples(path,hdr,ch.empty() ? (const magnitude_type*)0 : &*ch.begin());
+#else
+  write_channel_impl(path,ch,hdr,mpl::false_());
+#endif
+}
+
+}
+
+/** \brief Read the header of a channel file
+ *  \param path The file name
+ *  \return The decoded header
+ *  \throws <CODE>std::system_error</CODE> if the file cannot be read
+ *  \throws <CODE>std::runtime_error</CODE> if the file is not a channel file
+ *    or its alignment or data offset are invalid
+ */
+inline channel_file_header read_channel_header(const std::string &path)
+{
+  char buf[detail::channel_file_header_size];
+
+  int fd = ::open(path.c_str(),O_RDONLY);
+  if(fd < 0)
+    throw std::system_error(errno,std::system_category(),
+      "channel_io: open " + path);
+
+  ssize_t res = ::pread(fd,buf,sizeof(buf),0);
+  int err = errno;
+  ::close(fd);
+
+  if(res < 0)
+    throw std::system_error(err,std::system_category(),
+      "channel_io: read " + path);
+
+  if(std::size_t(res) != sizeof(buf))
+    throw std::runtime_error("channel_io: truncated header");
+
+  return detail::decode_header(buf);
+}
+
+/** \brief Write a channel to a file
+ *  \tparam ChannelT A Channel type, eg basic_channel or channel_base, whose
+ *    magnitude_type is a fixed width arithmetic type
+ *  \param path The file name. An existing file is replaced.
+ *  \param ch The channel to write
+ *  \throws <CODE>std::system_error</CODE> if the file cannot be written
+ *
+ *  \par Discussion
+ *  The header and samples are written with a single vectored write. On
+ *  little-endian hosts, the samples of a basic_channel whose Container
+ *  stores them contiguously are written directly from the channel. Other
+ *  channels are first copied into a contiguous buffer.
+ *
+ *  \par
+ *  The file is written under a temporary name in the same directory and
+ *  renamed over \e path, so an existing file is replaced atomically and a
+ *  channel loaded from \e path with load_channel() may be written back to
+ *  it.
+ */
+template<typename ChannelT>
+inline void write_channel(const std::string &path, const ChannelT &ch)
+{
+  typedef typename ChannelT::magnitude_type magnitude_type;
+
+  channel_file_header hdr;
+  hdr.type_code = detail::sample_type_code<magnitude_type>::value;
+  hdr.sample_size = sizeof(magnitude_type);
+  hdr.alignment = detail::channel_file_header_size;
+  hdr.count = ch.size();
+  hdr.frequency = detail::scalar_value<
+    typename ChannelT::frequency_type>::get(ch.frequency());
+  hdr.epoch = detail::scalar_value<
+    typename ChannelT::time_type>::get(ch.epoch());
+  hdr.data_offset = detail::channel_file_header_size;
+
+  detail::write_channel_impl(path,ch,hdr,
+    typename detail::is_contiguous_channel<ChannelT>::type());
+}
+
+/** \brief Load a channel file without copying the samples
+ *  \tparam MagnitudeT The sample type stored in the file
+ *  \tparam FrequencyT The signal frequency type
+ *  \tparam TimeT The type used to represent the channels time quantum
+ *  \param path The file name
+ *  \return A channel whose samples alias the mapped file
+ *  \throws <CODE>std::system_error</CODE> if the file cannot be mapped
+ *  \throws <CODE>std::runtime_error</CODE> if the file is not a channel file
+ *    of suitably aligned MagnitudeT samples
+ *  \throws <CODE>std::invalid_argument</CODE> if the file is truncated, ie
+ *    shorter than the sample count in its header
+ *
+ *  \par Discussion
+ *  Only the header is read. The samples are mapped read only (see
+ *  mapped_sequence) and paged in by the operating system as they are
+ *  accessed. Modifying the returned channel never modifies the file.
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT>
+inline basic_channel<MagnitudeT,FrequencyT,TimeT,mapped_sequence>
+load_channel(const std::string &path)
+{
+  typedef basic_channel<MagnitudeT,FrequencyT,TimeT,mapped_sequence>
+    channel_type;
+  typedef typename channel_type::container_type container_type;
+
+  channel_file_header hdr = read_channel_header(path);
+  detail::check_sample_type<MagnitudeT>(hdr);
+
+  container_type seq(path,container_type::read_only,hdr.data_offset,
+    hdr.count);
+#if !BOOST_ENDIAN_LITTLE_BYTE
+  detail::swap_bytes(seq.begin(),seq.end());
+#endif
+
+  return channel_type(std::move(seq),
+    detail::value_cast<FrequencyT>::construct(hdr.frequency),
+    detail::value_cast<TimeT>::construct(hdr.epoch));
+}
+
+/** \brief Read a channel file into a channel of any type
+ *  \tparam ChannelT A Channel type constructible from an iterator range,
+ *    frequency and epoch
+ *  \param path The file name
+ *  \return A channel holding a copy of the samples in the file
+ *  \throws <CODE>std::system_error</CODE> if the file cannot be read
+ *  \throws <CODE>std::runtime_error</CODE> if the file is not a channel file
+ *    of suitably aligned ChannelT::magnitude_type samples
+ *  \throws <CODE>std::invalid_argument</CODE> if the file is truncated, ie
+ *    shorter than the sample count in its header
+ */
+template<typename ChannelT>
+inline ChannelT read_channel(const std::string &path)
+{
+  typedef typename ChannelT::magnitude_type magnitude_type;
+  typedef typename ChannelT::frequency_type frequency_type;
+  typedef typename ChannelT::time_type time_type;
+
+  basic_channel<magnitude_type,double,double,mapped_sequence> mapped =
+    load_channel<magnitude_type,double,double>(path);
+
+  const basic_channel<magnitude_type,double,double,mapped_sequence> &src =
+    mapped;
+
+  return ChannelT(src.begin(),src.end(),
+    detail::value_cast<frequency_type>::construct(src.frequency()),
+    detail::value_cast<time_type>::construct(src.epoch()));
+}
+
+}
+}
+
+
+#endif
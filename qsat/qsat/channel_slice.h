@@ -0,0 +1,467 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_CHANNEL_SLICE_H
+#define LEMMA_QSAT_CHANNEL_SLICE_H
+
+#include "basic_channel.h"
+#include "channel_expression.h"
+
+#include <boost/mpl/bool.hpp>
+
+#include <iterator>
+#include <stdexcept>
+#include <cstddef>
+
+/** \file
+ *  \brief Implementation of basic_channel_slice, a read-only window into a
+ *    channel that shares ownership of its samples
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+/** \brief Read-only window of a channel that keeps the samples alive
+ *  \tparam ChannelT A basic_channel
+ *
+ *  \par Discussion
+ *  A basic_channel_slice holds a copy of its channel, which shares the
+ *  underlying sequence, together with the offset and length of the window.
+ *  Unlike basic_subchannel it therefore remains valid after the channel it
+ *  was taken from is modified or destroyed: modifying that channel detaches
+ *  it from the shared sequence, leaving the slice looking at the samples as
+ *  they were when the slice was taken. No samples are copied to create,
+ *  copy, or narrow a slice.
+ *
+ *  A slice is itself a channel with the frequency of its channel and the
+ *  epoch of its first sample, so it can be passed to algorithms such as
+ *  resample() or used in channel expressions. to_channel() promotes it to
+ *  an independent channel, copying only if the slice is a proper part of
+ *  the channel.
+ *
+ *  Slices may be handed to other threads provided the reference count of
+ *  the Container is thread safe, which it is for all but
+ *  local_intrusive_sequence.
+ *
+ *  \code
+ *  basic_channel<float,double,double> ch(first,last,48000.0);
+ *  basic_channel_slice<basic_channel<float,double,double> > window =
+ *    time_slice(ch,1.0,2.0);
+ *
+ *  ch.clear(); // window is unaffected
+ *  \endcode
+ */
+template<typename ChannelT>
+class basic_channel_slice {
+  public:
+    /** const lvalue of ChannelT::value_type */
+    typedef typename ChannelT::const_reference reference;
+    /** const lvalue of ChannelT::value_type */
+    typedef typename ChannelT::const_reference const_reference;
+    /** iterator type pointing to const ChannelT::value_type */
+    typedef typename ChannelT::const_iterator iterator;
+    /** iterator type pointing to const ChannelT::value_type */
+    typedef typename ChannelT::const_iterator const_iterator;
+    /** reverse_iterator type pointing to const ChannelT::value_type */
+    typedef typename ChannelT::const_reverse_iterator reverse_iterator;
+    /** reverse_iterator type pointing to const ChannelT::value_type */
+    typedef typename ChannelT::const_reverse_iterator const_reverse_iterator;
+    /** type modeling pointer to const ChannelT::value_type */
+    typedef typename ChannelT::const_pointer pointer;
+    /** type modeling pointer to const ChannelT::value_type */
+    typedef typename ChannelT::const_pointer const_pointer;
+    /** unsigned integral type */
+    typedef typename ChannelT::size_type size_type;
+    /** signed integral type */
+    typedef typename ChannelT::difference_type difference_type;
+    /** MagnitudeT */
+    typedef typename ChannelT::value_type value_type;
+
+    /** Underlying channel type, used for making new channels */
+    typedef ChannelT channel_type;
+    /** Slice type */
+    typedef basic_channel_slice slice_type;
+
+    /** MagnitudeT */
+    typedef typename ChannelT::magnitude_type magnitude_type;
+    /** FrequencyT */
+    typedef typename ChannelT::frequency_type frequency_type;
+    /** TimeT */
+    typedef typename ChannelT::time_type time_type;
+
+    /** \brief Default Constructor
+     *
+     *  An empty slice of a default constructed channel
+     */
+    basic_channel_slice(void);
+
+    /** \brief Constructor
+     *
+     *  Share all samples of <em>ch</em>
+     *
+     *  \param ch The channel
+     *  \post size() == <em>ch</em>.size()
+     */
+    explicit basic_channel_slice(const ChannelT &ch);
+
+    /** \brief Constructor
+     *
+     *  Share the samples [<em>pos</em>, <em>pos</em> + <em>n</em>) of
+     *  <em>ch</em>, clipped to the end of <em>ch</em>
+     *
+     *  \param ch The channel
+     *  \param pos The offset of the first sample
+     *  \param n The number of samples
+     *  \throws <CODE>std::out_of_range</CODE> if <em>pos</em> >
+     *    <em>ch</em>.size()
+     */
+    basic_channel_slice(const ChannelT &ch, size_type pos, size_type n);
+
+    /** \brief Copy Constructor
+     *
+     *  \param rhs rvalue of type basic_channel_slice
+     */
+    basic_channel_slice(const basic_channel_slice &rhs);
+
+    /** \brief Assignment Operator
+     *  \param rhs rvalue of type basic_channel_slice
+     *  \return <code>*this</code>
+     */
+    basic_channel_slice & operator=(const basic_channel_slice &rhs);
+
+    /** \brief Obtain iterator to slice beginning */
+    const_iterator begin(void) const {
+      return sub_first;
+    }
+
+    /** \brief Obtain iterator to slice end */
+    const_iterator end(void) const {
+      return sub_last;
+    }
+
+    /** \brief Obtain reverse iterator to slice end */
+    const_reverse_iterator rbegin(void) const {
+      return const_reverse_iterator(sub_last);
+    }
+
+    /** \brief Obtain reverse iterator to slice beginning */
+    const_reverse_iterator rend(void) const {
+      return const_reverse_iterator(sub_first);
+    }
+
+    /** \brief Obtain the number of samples */
+    size_type size(void) const {
+      return length;
+    }
+
+    /** \brief Determine if the slice has no samples */
+    bool empty(void) const {
+      return !length;
+    }
+
+    /** \brief Obtain the sample at location <em>n</em> */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain the sample at location <em>n</em>
+     *  \throws <CODE>std::out_of_range</CODE> if <em>n</em> >= size()
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the first sample */
+    const_reference front(void) const {
+      return *sub_first;
+    }
+
+    /** \brief Obtain the last sample */
+    const_reference back(void) const;
+
+    /** \brief Obtain the sample frequency */
+    const frequency_type & frequency(void) const {
+      return base.frequency();
+    }
+
+    /** \brief Obtain the time of the first sample of the slice */
+    time_type epoch(void) const {
+      return time_at(0);
+    }
+
+    /** \brief Obtain the offset of the first sample in channel() */
+    size_type offset(void) const {
+      return sub_offset;
+    }
+
+    /** \brief Obtain the index of the first sample at or after <em>t</em>,
+     *    clamped to [0,size()]
+     */
+    size_type index_at(const time_type &t) const;
+
+    /** \brief Obtain the time of sample <em>n</em> */
+    time_type time_at(size_type n) const;
+
+    /** \brief Obtain the channel whose samples are shared
+     *
+     *  This is the channel as it was when the slice was taken
+     */
+    const channel_type & channel(void) const {
+      return base;
+    }
+
+    /** \brief Obtain a narrower slice of the same samples
+     *
+     *  \param pos The offset of the first sample relative to this slice
+     *  \param n The number of samples, clipped to the end of this slice
+     *  \throws <CODE>std::out_of_range</CODE> if <em>pos</em> > size()
+     */
+    basic_channel_slice slice(size_type pos, size_type n) const;
+
+    /** \brief Obtain a narrower slice of the same samples by time
+     *
+     *  \return A slice over [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>) of this slice
+     */
+    basic_channel_slice time_slice(const time_type &t0,
+      const time_type &t1) const;
+
+    /** \brief Promote the slice to an independent channel
+     *
+     *  \return A channel with the samples, frequency and epoch of the
+     *    slice. If the slice covers all of channel(), the samples are
+     *    shared rather than copied.
+     */
+    channel_type to_channel(void) const;
+
+  private:
+    ChannelT base;
+    size_type sub_offset;
+    size_type length;
+    const_iterator sub_first;
+    const_iterator sub_last;
+
+    void bind(void);
+};
+
+/** \brief Share the samples [<em>pos</em>, <em>pos</em> + <em>n</em>) of
+ *    <em>ch</em>
+ *
+ *  \param ch The channel
+ *  \param pos The offset of the first sample
+ *  \param n The number of samples, clipped to the end of <em>ch</em>
+ *  \throws <CODE>std::out_of_range</CODE> if <em>pos</em> >
+ *    <em>ch</em>.size()
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline basic_channel_slice<
+  basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> >
+slice(const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &ch,
+  std::size_t pos, std::size_t n)
+{
+  return basic_channel_slice<
+    basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> >(ch,pos,n);
+}
+
+/** \brief Share the samples of <em>ch</em> in [<em>t0</em>, <em>t1</em>)
+ *
+ *  \return A slice over [<code>ch.index_at(t0)</code>,
+ *    <code>ch.index_at(t1)</code>)
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline basic_channel_slice<
+  basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> >
+time_slice(
+  const basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> &ch,
+  const TimeT &t0, const TimeT &t1)
+{
+  return basic_channel_slice<
+    basic_channel<MagnitudeT,FrequencyT,TimeT,Container,Allocator> >(ch)
+      .time_slice(t0,t1);
+}
+
+namespace detail {
+
+template<typename ChannelT>
+struct is_channel_operand<basic_channel_slice<ChannelT> > :mpl::true_ {};
+
+}
+
+
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>::basic_channel_slice(void)
+  :sub_offset(0), length(0)
+{
+  bind();
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>::basic_channel_slice(const ChannelT &ch)
+  :base(ch), sub_offset(0), length(ch.size())
+{
+  bind();
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>::basic_channel_slice(const ChannelT &ch,
+  size_type pos, size_type n) :base(ch), sub_offset(pos), length(n)
+{
+  size_type sz = ch.size();
+  if(pos > sz)
+    throw std::out_of_range("basic_channel_slice: offset out of range");
+
+  if(length > sz-pos)
+    length = sz-pos;
+
+  bind();
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>::basic_channel_slice(
+  const basic_channel_slice &rhs) :base(rhs.base),
+    sub_offset(rhs.sub_offset), length(rhs.length), sub_first(rhs.sub_first),
+    sub_last(rhs.sub_last)
+{
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT> &
+basic_channel_slice<ChannelT>::operator=(const basic_channel_slice &rhs)
+{
+  if(this != &rhs) {
+    base = rhs.base;
+    sub_offset = rhs.sub_offset;
+    length = rhs.length;
+    sub_first = rhs.sub_first;
+    sub_last = rhs.sub_last;
+  }
+
+  return *this;
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::const_reference
+basic_channel_slice<ChannelT>::operator[](size_type n) const
+{
+  const_iterator pos = sub_first;
+  std::advance(pos,n);
+  return *pos;
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::const_reference
+basic_channel_slice<ChannelT>::at(size_type n) const
+{
+  if(n >= length)
+    throw std::out_of_range("basic_channel_slice: index out of range");
+
+  return (*this)[n];
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::const_reference
+basic_channel_slice<ChannelT>::back(void) const
+{
+  const_iterator pos = sub_last;
+  return *--pos;
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::size_type
+basic_channel_slice<ChannelT>::index_at(const time_type &t) const
+{
+  return detail::time_index(epoch(),frequency(),t,size());
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::time_type
+basic_channel_slice<ChannelT>::time_at(size_type n) const
+{
+  return detail::channel_position<ChannelT>::time(base,sub_offset+n);
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>
+basic_channel_slice<ChannelT>::slice(size_type pos, size_type n) const
+{
+  if(pos > length)
+    throw std::out_of_range("basic_channel_slice: offset out of range");
+
+  if(n > length-pos)
+    n = length-pos;
+
+  basic_channel_slice result(*this);
+  result.sub_offset += pos;
+  result.length = n;
+  std::advance(result.sub_first,pos);
+  result.sub_last = result.sub_first;
+  std::advance(result.sub_last,n);
+  return result;
+}
+
+template<typename ChannelT>
+inline basic_channel_slice<ChannelT>
+basic_channel_slice<ChannelT>::time_slice(const time_type &t0,
+  const time_type &t1) const
+{
+  size_type first = index_at(t0);
+  size_type last = index_at(t1);
+  if(last < first)
+    last = first;
+
+  return slice(first,last-first);
+}
+
+template<typename ChannelT>
+inline typename basic_channel_slice<ChannelT>::channel_type
+basic_channel_slice<ChannelT>::to_channel(void) const
+{
+  if(!sub_offset && length == base.size())
+    return base;
+
+  return channel_type(sub_first,sub_last,frequency(),epoch());
+}
+
+template<typename ChannelT>
+inline void basic_channel_slice<ChannelT>::bind(void)
+{
+  // const access never detaches base from the shared sequence
+  const ChannelT &ch = base;
+  sub_first = ch.begin();
+  std::advance(sub_first,sub_offset);
+  sub_last = sub_first;
+  std::advance(sub_last,length);
+}
+
+}
+}
+
+#endif
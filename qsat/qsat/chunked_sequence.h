@@ -0,0 +1,957 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_CHUNKED_SEQUENCE_H
+#define LEMMA_QSAT_CHUNKED_SEQUENCE_H
+
+#include "basic_channel.h"
+
+#include <boost/mpl/bool.hpp>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_convertible.hpp>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+
+/** \file
+ *  \brief Implementation of chunked_sequence, a persistent random-access
+ *    sequence suitable as the Container of basic_channel
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+/** \brief Number of elements stored in each chunk of a chunked_sequence
+ *  \internal Chunks are sized to occupy (approximately) 64KiB.
+ */
+template<typename T>
+struct chunk_length {
+  /** chunk size in bytes */
+  static const std::size_t bytes = 65536;
+  /** elements per chunk */
+  static const std::size_t value = (sizeof(T) < bytes ? bytes/sizeof(T) : 1);
+};
+
+/** \brief Random access iterator into a chunked_sequence
+ *  \internal Dereferencing through a mutable SequenceT detaches only the
+ *    chunk holding the element.
+ */
+template<typename SequenceT, typename ValueT>
+class chunked_iterator :public b::iterator_facade<
+  chunked_iterator<SequenceT,ValueT>,ValueT,std::random_access_iterator_tag>
+{
+  private:
+    struct enabler {};
+
+  public:
+    chunked_iterator(void) :seq(0), idx(0) {}
+
+    chunked_iterator(SequenceT *s, std::size_t n) :seq(s), idx(n) {}
+
+    template<typename OtherSequenceT, typename OtherValueT>
+    chunked_iterator(const chunked_iterator<OtherSequenceT,OtherValueT> &rhs,
+      typename b::enable_if<
+        b::is_convertible<OtherSequenceT*,SequenceT*>,enabler>::type = enabler())
+          :seq(rhs.seq), idx(rhs.idx) {}
+
+  private:
+    friend class b::iterator_core_access;
+    template<typename, typename> friend class chunked_iterator;
+
+    ValueT & dereference(void) const {
+      return (*seq)[idx];
+    }
+
+    template<typename OtherSequenceT, typename OtherValueT>
+    bool equal(const chunked_iterator<OtherSequenceT,OtherValueT> &rhs) const {
+      return idx == rhs.idx;
+    }
+
+    void increment(void) {
+      ++idx;
+    }
+
+    void decrement(void) {
+      --idx;
+    }
+
+    void advance(std::ptrdiff_t n) {
+      idx += n;
+    }
+
+    template<typename OtherSequenceT, typename OtherValueT>
+    std::ptrdiff_t distance_to(
+      const chunked_iterator<OtherSequenceT,OtherValueT> &rhs) const
+    {
+      return std::ptrdiff_t(rhs.idx) - std::ptrdiff_t(idx);
+    }
+
+    SequenceT *seq;
+    std::size_t idx;
+};
+
+}
+
+/** \brief Persistent random-access sequence of fixed size, reference counted
+ *    chunks
+ *  \tparam T The element type
+ *  \tparam A The allocator used for element storage
+ *
+ *  Model of std::sequence with optional members
+ *
+ *  \par Discussion
+ *  Elements are stored in chunks of detail::chunk_length<T>::value elements
+ *  (64KiB) that are shared between copies of the sequence. Copying a
+ *  chunked_sequence only copies the small chunk index. A mutating operation
+ *  copies only those chunks that it writes into and that are shared with
+ *  another sequence. As the Container of a basic_channel, this reduces the
+ *  cost of detaching a shared channel on write from the size of the channel
+ *  to the size of the chunk index plus the chunks actually written to.
+ *  \code
+ *  typedef basic_channel<float,float,float,chunked_sequence> channel_type;
+ *
+ *  channel_type channel; // assume filled with 2GB of values
+ *  channel_type snapshot = channel;
+ *  channel[42] = 0; // copies the chunk index and the 64KiB chunk of channel[42]
+ *  \endcode
+ *
+ *  \par
+ *  Obtaining a mutable iterator does not by itself copy any chunks. Instead,
+ *  the chunk of an element is checked (and copied if shared) each time an
+ *  element is dereferenced through a mutable iterator or reference.
+ *  Consequently, insertion and erasure before the end of the sequence copy
+ *  all shared chunks after the affected position.
+ */
+template<typename T, typename A = std::allocator<T> >
+class chunked_sequence {
+  public:
+    /** Chunk storage type */
+    typedef std::vector<T,A> chunk_type;
+
+    /** lvalue of T */
+    typedef typename chunk_type::reference reference;
+    /** const lvalue of T */
+    typedef typename chunk_type::const_reference const_reference;
+    /** iterator type pointing to T */
+    typedef detail::chunked_iterator<chunked_sequence,T> iterator;
+    /** iterator type pointing to const T */
+    typedef detail::chunked_iterator<const chunked_sequence,const T>
+      const_iterator;
+    /** unsigned integral type */
+    typedef typename chunk_type::size_type size_type;
+    /** signed integral type */
+    typedef typename chunk_type::difference_type difference_type;
+    /** T */
+    typedef typename chunk_type::value_type value_type;
+    /** Allocator */
+    typedef typename chunk_type::allocator_type allocator_type;
+    /** type modeling pointer to T */
+    typedef typename chunk_type::pointer pointer;
+    /** type modeling pointer to const T */
+    typedef typename chunk_type::const_pointer const_pointer;
+    /** reverse_iterator type pointing to T */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type pointing to const T */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** Number of elements stored in each chunk */
+    static const size_type chunk_length = detail::chunk_length<T>::value;
+
+    /** \brief Default Constructor
+     *  \param alloc The allocator used for element storage
+     */
+    explicit chunked_sequence(const allocator_type &alloc = allocator_type());
+
+    /** \brief Fill Constructor
+     *  \param n The number of copies of \e value to make
+     *  \param value The value to copy
+     *  \param alloc The allocator used for element storage
+     *  \post size() == \e n
+     */
+    explicit chunked_sequence(size_type n, const T &value = T(),
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Constructor
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \param alloc The allocator used for element storage
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    chunked_sequence(InputIterator first, InputIterator last,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Copy Constructor
+     *
+     *  Shares all chunks of \e rhs
+     *
+     *  \param rhs rvalue of type chunked_sequence
+     */
+    chunked_sequence(const chunked_sequence &rhs);
+
+    /** \brief Assignment Operator
+     *
+     *  Shares all chunks of \e rhs
+     *
+     *  \param rhs rvalue of type chunked_sequence
+     *  \return <code>*this</code>
+     */
+    chunked_sequence & operator=(const chunked_sequence &rhs);
+
+    /** \brief Range Assignment Operator
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \post size() = <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /** \brief Fill Assignment Operator
+     *  \param n The number of <em>val</em> object to assign to this sequence
+     *  \param val The value of the objects that are assigned to this
+     *  \post size() = <em>n</em>
+     */
+    void assign(size_type n, const T &val);
+
+    /** \brief Obtain the allocator used for element storage
+     *  \return A copy of the allocator
+     */
+    allocator_type get_allocator(void) const;
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to T
+     */
+    iterator begin(void);
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to const T
+     */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to T
+     */
+    iterator end(void);
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to const T
+     */
+    const_iterator end(void) const;
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rbegin(void);
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rbegin(void) const;
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rend(void);
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rend(void) const;
+
+    /** \brief Obtain the number of elements contained in the sequence
+     *  \return sequence size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain the maximum number of elements able to be stored by
+     *    this sequence
+     *  \return sequence maximum size
+     */
+    size_type max_size(void) const;
+
+    /** \brief Resize the sequence
+     *  \param sz The new sequence size
+     *  \param val The value of the new objects copied to the end of the
+     *    sequence if <em>sz</em> > <CODE>size()</CODE>
+     */
+    void resize(size_type sz, const T &val = T());
+
+    /** \brief Obtain the total number of elements that this sequence can hold
+     *    without reallocating the chunk index
+     *
+     *  Elements never move when a new chunk is allocated.
+     *
+     *  \return sequence storage capacity
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain whether or not the sequence contains any values
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Ensure that the chunk index can describe <EM>n</EM> elements
+     *    without reallocation occuring
+     *
+     *  Chunks themselves are allocated as they are needed.
+     *
+     *  \param n the new capacity
+     */
+    void reserve(size_type n);
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *
+     *  The chunk containing <EM>n</EM> is copied if it is shared.
+     *
+     *  \param n The element location
+     *  \return element reference
+     */
+    reference operator[](size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    reference at(size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element reference
+     */
+    reference front(void);
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element const_reference
+     */
+    const_reference front(void) const;
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element reference
+     */
+    reference back(void);
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element const_reference
+     */
+    const_reference back(void) const;
+
+    /** \brief Add a new element at the end of the sequence
+     *  \param val The value of the new element
+     */
+    void push_back(const T &val);
+
+    /** \brief Remove the last element of the sequence
+     */
+    void pop_back(void);
+
+    /** \brief Insert a new element into the sequence before <em>position</em>
+     *  \param position An iterator pointing to the location the element should
+     *    be inserted before
+     *  \param val The value of the new element
+     *  \return An iterator pointing to the new element
+     */
+    iterator insert(iterator position, const T &val);
+
+    /** \brief Insert <em>n</em> elements into the sequence before <em>position</em>
+     *  \param position An iterator pointing to the location the elements should
+     *    be inserted before
+     *  \param n The number of elements to insert
+     *  \param val The value of the new elements
+     */
+    void insert(iterator position, size_type n, const T &val);
+
+    /** \brief Insert elements in the range of <code>[first,last)</code>
+     *    into the sequence before <em>position</em>
+     *  \param position An iterator pointing to the location the elements should
+     *    be inserted before
+     *  \param first,last An <code>InputIterator</code> pointing to objects
+     *    convertable to T
+     */
+    template<typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last);
+
+    /** \brief Erase the element at <em>position</em>
+     *  \param position An iterator pointing to the element to erase
+     *  \return An iterator to the element immediately after <em>position</em>
+     */
+    iterator erase(iterator position);
+
+    /** \brief Erase elements in the range of <code>[first,last)</code>
+     *  \param first,last An iterator range in the sequence
+     *  \return An iterator to the element immediately after the erased range
+     */
+    iterator erase(iterator first, iterator last);
+
+    /** \brief Efficiently swap another chunked_sequence object with this
+     *  \param rhs a reference
+     */
+    void swap(chunked_sequence &rhs);
+
+    /** \brief Remove all elements of the sequence
+     */
+    void clear(void);
+
+    /** \brief Obtain the number of chunks currently referenced by this
+     *    sequence
+     *  \return <code>ceil(size()/chunk_length)</code>
+     */
+    size_type chunk_count(void) const;
+
+    /** \brief Determine whether chunk \e n is shared with another sequence
+     *  \param n The chunk index
+     *  \return true if a write into chunk \e n would cause it to be copied
+     */
+    bool chunk_shared(size_type n) const;
+
+    /** \brief Object equality comparison
+     *
+     *  Chunks shared between both sequences are not compared element-wise.
+     *
+     *  \param rhs a const_reference
+     *  \return <code>[this->begin(),this->end()) == [rhs.begin(),rhs.end())</code>
+     */
+    bool operator==(const chunked_sequence &rhs) const;
+
+    /** \brief Object inequality comparison
+     *  \param rhs a const_reference
+     *  \return !(*this == rhs)
+     */
+    bool operator!=(const chunked_sequence &rhs) const;
+
+  private:
+    typedef b::shared_ptr<chunk_type> chunk_pointer;
+    typedef std::vector<chunk_pointer> index_type;
+
+    allocator_type alloc;
+    index_type chunks;
+    size_type count;
+
+    chunk_type & detach_chunk(size_type n);
+
+    chunk_pointer make_chunk(void) const;
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::false_);
+};
+
+template<typename T, typename A>
+const typename chunked_sequence<T,A>::size_type
+  chunked_sequence<T,A>::chunk_length;
+
+namespace detail {
+
+/** \brief Mutable iterators detach the chunk of each element they write
+ *  \internal
+ */
+template<typename T, typename A>
+struct detach_stride<chunked_iterator<chunked_sequence<T,A>,T> > {
+  static const std::size_t value = chunked_sequence<T,A>::chunk_length;
+};
+
+}
+
+template<typename T, typename A>
+inline chunked_sequence<T,A>::chunked_sequence(const allocator_type &a)
+  :alloc(a), count(0)
+{
+}
+
+template<typename T, typename A>
+inline chunked_sequence<T,A>::chunked_sequence(size_type n, const T &value,
+  const allocator_type &a) :alloc(a), count(0)
+{
+  assign(n,value);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline chunked_sequence<T,A>::chunked_sequence(InputIterator first,
+  InputIterator last, const allocator_type &a) :alloc(a), count(0)
+{
+  assign(first,last);
+}
+
+template<typename T, typename A>
+inline chunked_sequence<T,A>::chunked_sequence(const chunked_sequence &rhs)
+  :alloc(rhs.alloc), chunks(rhs.chunks), count(rhs.count)
+{
+}
+
+template<typename T, typename A>
+inline chunked_sequence<T,A> &
+chunked_sequence<T,A>::operator=(const chunked_sequence &rhs)
+{
+  if(this != &rhs) {
+    chunks = rhs.chunks;
+    count = rhs.count;
+  }
+
+  return *this;
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::assign(InputIterator first,
+  InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::assign(size_type n, const T &val)
+{
+  clear();
+  resize(n,val);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::allocator_type
+chunked_sequence<T,A>::get_allocator(void) const
+{
+  return alloc;
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::iterator
+chunked_sequence<T,A>::begin(void)
+{
+  return iterator(this,0);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_iterator
+chunked_sequence<T,A>::begin(void) const
+{
+  return const_iterator(this,0);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::iterator
+chunked_sequence<T,A>::end(void)
+{
+  return iterator(this,count);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_iterator
+chunked_sequence<T,A>::end(void) const
+{
+  return const_iterator(this,count);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reverse_iterator
+chunked_sequence<T,A>::rbegin(void)
+{
+  return reverse_iterator(end());
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reverse_iterator
+chunked_sequence<T,A>::rbegin(void) const
+{
+  return const_reverse_iterator(end());
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reverse_iterator
+chunked_sequence<T,A>::rend(void)
+{
+  return reverse_iterator(begin());
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reverse_iterator
+chunked_sequence<T,A>::rend(void) const
+{
+  return const_reverse_iterator(begin());
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::size_type
+chunked_sequence<T,A>::size(void) const
+{
+  return count;
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::size_type
+chunked_sequence<T,A>::max_size(void) const
+{
+  return chunks.max_size() < size_type(-1)/chunk_length ?
+    chunks.max_size()*chunk_length : size_type(-1);
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::resize(size_type sz, const T &val)
+{
+  if(sz < count) {
+    size_type nchunks = (sz+chunk_length-1)/chunk_length;
+    chunks.resize(nchunks);
+    if(sz % chunk_length)
+      detach_chunk(nchunks-1).resize(sz % chunk_length);
+    count = sz;
+  }
+  else {
+    while(count < sz)
+      push_back(val);
+  }
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::size_type
+chunked_sequence<T,A>::capacity(void) const
+{
+  return chunks.capacity()*chunk_length;
+}
+
+template<typename T, typename A>
+inline bool chunked_sequence<T,A>::empty(void) const
+{
+  return count == 0;
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::reserve(size_type n)
+{
+  chunks.reserve((n+chunk_length-1)/chunk_length);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reference
+chunked_sequence<T,A>::operator[](size_type n)
+{
+  return detach_chunk(n/chunk_length)[n%chunk_length];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reference
+chunked_sequence<T,A>::operator[](size_type n) const
+{
+  return (*chunks[n/chunk_length])[n%chunk_length];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reference
+chunked_sequence<T,A>::at(size_type n)
+{
+  if(n >= count)
+    throw std::out_of_range("chunked_sequence::at");
+
+  return (*this)[n];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reference
+chunked_sequence<T,A>::at(size_type n) const
+{
+  if(n >= count)
+    throw std::out_of_range("chunked_sequence::at");
+
+  return (*this)[n];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reference
+chunked_sequence<T,A>::front(void)
+{
+  return (*this)[0];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reference
+chunked_sequence<T,A>::front(void) const
+{
+  return (*this)[0];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::reference
+chunked_sequence<T,A>::back(void)
+{
+  return (*this)[count-1];
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::const_reference
+chunked_sequence<T,A>::back(void) const
+{
+  return (*this)[count-1];
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::push_back(const T &val)
+{
+  if(count % chunk_length == 0) {
+    chunk_pointer tmp = make_chunk();
+    tmp->push_back(val);
+    chunks.push_back(tmp);
+  }
+  else
+    detach_chunk(chunks.size()-1).push_back(val);
+
+  ++count;
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::pop_back(void)
+{
+  if(count % chunk_length == 1 || chunk_length == 1)
+    chunks.pop_back();
+  else
+    detach_chunk(chunks.size()-1).pop_back();
+
+  --count;
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::iterator
+chunked_sequence<T,A>::insert(iterator position, const T &val)
+{
+  difference_type off = position-begin();
+  push_back(val);
+  std::rotate(begin()+off,end()-1,end());
+  return begin()+off;
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::insert(iterator position, size_type n,
+  const T &val)
+{
+  difference_type off = position-begin();
+  size_type len = count;
+  resize(count+n,val);
+  std::rotate(begin()+off,begin()+len,end());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::insert(iterator position,
+  InputIterator first, InputIterator last)
+{
+  insert_thunk(position,first,last,
+    typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::iterator
+chunked_sequence<T,A>::erase(iterator position)
+{
+  return erase(position,position+1);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::iterator
+chunked_sequence<T,A>::erase(iterator first, iterator last)
+{
+  difference_type off = first-begin();
+  if(first != last) {
+    if(last != end())
+      std::copy(last,end(),first);
+
+    resize(count-(last-first));
+  }
+
+  return begin()+off;
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::swap(chunked_sequence &rhs)
+{
+  std::swap(alloc,rhs.alloc);
+  chunks.swap(rhs.chunks);
+  std::swap(count,rhs.count);
+}
+
+template<typename T, typename A>
+inline void chunked_sequence<T,A>::clear(void)
+{
+  chunks.clear();
+  count = 0;
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::size_type
+chunked_sequence<T,A>::chunk_count(void) const
+{
+  return chunks.size();
+}
+
+template<typename T, typename A>
+inline bool chunked_sequence<T,A>::chunk_shared(size_type n) const
+{
+  return !chunks[n].unique();
+}
+
+template<typename T, typename A>
+inline bool chunked_sequence<T,A>::operator==(const chunked_sequence &rhs) const
+{
+  if(count != rhs.count)
+    return false;
+
+  for(size_type i=0; i<chunks.size(); ++i) {
+    if(chunks[i] != rhs.chunks[i] && *chunks[i] != *rhs.chunks[i])
+      return false;
+  }
+
+  return true;
+}
+
+template<typename T, typename A>
+inline bool chunked_sequence<T,A>::operator!=(const chunked_sequence &rhs) const
+{
+  return !(*this == rhs);
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::chunk_type &
+chunked_sequence<T,A>::detach_chunk(size_type n)
+{
+  chunk_pointer &chunk = chunks[n];
+  if(!chunk.unique()) {
+    chunk_pointer tmp = make_chunk();
+    tmp->assign(chunk->begin(),chunk->end());
+    chunk.swap(tmp);
+  }
+
+  return *chunk;
+}
+
+template<typename T, typename A>
+inline typename chunked_sequence<T,A>::chunk_pointer
+chunked_sequence<T,A>::make_chunk(void) const
+{
+  chunk_pointer tmp(new chunk_type(alloc));
+  tmp->reserve(chunk_length);
+  return tmp;
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::true_)
+{
+  assign(static_cast<size_type>(first),static_cast<T>(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::false_)
+{
+  clear();
+  while(first != last)
+    push_back(*first++);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::true_)
+{
+  insert(position,static_cast<size_type>(first),static_cast<T>(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void chunked_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::false_)
+{
+  difference_type off = position-begin();
+  size_type len = count;
+  while(first != last)
+    push_back(*first++);
+  std::rotate(begin()+off,begin()+len,end());
+}
+
+/** \brief Free function to efficiently swap two chunked_sequence objects
+ *  \param lhs,rhs to chunked_sequence references
+ */
+template<typename T, typename A>
+inline void swap(chunked_sequence<T,A> &lhs, chunked_sequence<T,A> &rhs)
+{
+  lhs.swap(rhs);
+}
+
+namespace detail {
+
+/** \brief Copying a chunked_sequence is inexpensive
+ *  \internal basic_channel prefers reserving a new container and copying
+ *    elements into it when detaching a shared representation for containers
+ *    with reserve capability. For chunked_sequence, copy constructing and
+ *    mutating the copy only copies the chunks actually written to, so select
+ *    that path instead.
+ */
+template<typename T, typename A>
+class has_reserve_capability<chunked_sequence<T,A> > {
+  public:
+    /** Prefer the copy then mutate path */
+    typedef mpl::false_ type;
+};
+
+}
+
+}
+}
+
+
+#endif
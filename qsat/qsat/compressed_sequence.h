@@ -0,0 +1,1078 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_COMPRESSED_SEQUENCE_H
+#define LEMMA_QSAT_COMPRESSED_SEQUENCE_H
+
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/static_assert.hpp>
+
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+
+/** \file
+ *  \brief Implementation of compressed_sequence, a sequence stored in a
+ *    compressed bit stream
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+/** \internal Number of leading zero bits of a nonzero \e x */
+inline unsigned int leading_zeros(std::uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_clzll(x);
+#else
+  unsigned int n = 0;
+  for(std::uint64_t bit = std::uint64_t(1) << 63; !(x & bit); bit >>= 1)
+    ++n;
+  return n;
+#endif
+}
+
+/** \internal Number of trailing zero bits of a nonzero \e x */
+inline unsigned int trailing_zeros(std::uint64_t x)
+{
+#if defined(__GNUC__)
+  return __builtin_ctzll(x);
+#else
+  unsigned int n = 0;
+  for(; !(x & 1); x >>= 1)
+    ++n;
+  return n;
+#endif
+}
+
+/** \internal Append the low \e n bits, 1 <= \e n <= 64, of \e val */
+template<typename WordVector>
+inline void write_bits(WordVector &words, std::size_t &bit_size,
+  std::uint64_t val, unsigned int n)
+{
+  if(n < 64)
+    val &= (std::uint64_t(1) << n) - 1;
+
+  std::size_t off = bit_size % 64;
+  if(!off)
+    words.push_back(val);
+  else {
+    words.back() |= val << off;
+    if(off + n > 64)
+      words.push_back(val >> (64 - off));
+  }
+
+  bit_size += n;
+}
+
+/** \internal Read \e n bits, 1 <= \e n <= 64, at \e bit and advance it */
+inline std::uint64_t read_bits(const std::uint64_t *words, std::size_t &bit,
+  unsigned int n)
+{
+  std::size_t word = bit / 64;
+  std::size_t off = bit % 64;
+
+  std::uint64_t val = words[word] >> off;
+  if(off + n > 64)
+    val |= words[word+1] << (64 - off);
+
+  if(n < 64)
+    val &= (std::uint64_t(1) << n) - 1;
+
+  bit += n;
+  return val;
+}
+
+/** \brief XOR encoding of floating point values
+ *  \internal
+ *  Each value is XORed with its predecessor. An identical value costs one
+ *  bit. Otherwise the meaningful bits of the XOR are stored, reusing the
+ *  leading and trailing zero counts of the previous XOR when they fit, as
+ *  in Pelkonen et al, "Gorilla: A Fast, Scalable, In-Memory Time Series
+ *  Database".
+ */
+template<typename T, typename UIntT>
+struct xor_codec {
+  BOOST_STATIC_ASSERT(sizeof(T) == sizeof(UIntT) &&
+    (sizeof(T) == 4 || sizeof(T) == 8));
+
+  static const unsigned int bits = sizeof(T)*8;
+  static const unsigned int count_bits = (bits == 64 ? 6 : 5);
+
+  struct state {
+    UIntT prev;
+    unsigned int leading;
+    unsigned int trailing;
+  };
+
+  static UIntT to_bits(const T &val) {
+    UIntT r;
+    std::memcpy(&r,&val,sizeof(T));
+    return r;
+  }
+
+  static T from_bits(UIntT val) {
+    T r;
+    std::memcpy(&r,&val,sizeof(T));
+    return r;
+  }
+
+  template<typename WordVector>
+  static void encode_first(WordVector &words, std::size_t &bit_size,
+    state &s, const T &val)
+  {
+    s.prev = to_bits(val);
+    s.leading = bits;
+    s.trailing = 0;
+    write_bits(words,bit_size,s.prev,bits);
+  }
+
+  template<typename WordVector>
+  static void encode(WordVector &words, std::size_t &bit_size, state &s,
+    const T &val)
+  {
+    UIntT cur = to_bits(val);
+    UIntT x = cur ^ s.prev;
+    s.prev = cur;
+
+    if(!x) {
+      write_bits(words,bit_size,0,1);
+      return;
+    }
+
+    unsigned int leading = leading_zeros(x) - (64 - bits);
+    unsigned int trailing = trailing_zeros(x);
+
+    if(s.leading + s.trailing < bits && leading >= s.leading &&
+      trailing >= s.trailing)
+    {
+      // control bits 1,0 then the bits within the previous window
+      write_bits(words,bit_size,1,2);
+      write_bits(words,bit_size,x >> s.trailing,
+        bits - s.leading - s.trailing);
+      return;
+    }
+
+    if(leading >= (1u << count_bits))
+      leading = (1u << count_bits) - 1;
+
+    unsigned int len = bits - leading - trailing;
+
+    // control bits 1,1 then the new window
+    write_bits(words,bit_size,3,2);
+    write_bits(words,bit_size,leading,count_bits);
+    write_bits(words,bit_size,len-1,count_bits);
+    write_bits(words,bit_size,x >> trailing,len);
+
+    s.leading = leading;
+    s.trailing = trailing;
+  }
+
+  static T decode_first(const std::uint64_t *words, std::size_t &bit,
+    state &s)
+  {
+    s.prev = UIntT(read_bits(words,bit,bits));
+    s.leading = bits;
+    s.trailing = 0;
+    return from_bits(s.prev);
+  }
+
+  static T decode(const std::uint64_t *words, std::size_t &bit, state &s) {
+    if(read_bits(words,bit,1)) {
+      if(read_bits(words,bit,1)) {
+        s.leading = unsigned(read_bits(words,bit,count_bits));
+        unsigned int len = unsigned(read_bits(words,bit,count_bits)) + 1;
+        s.trailing = bits - s.leading - len;
+      }
+
+      unsigned int len = bits - s.leading - s.trailing;
+      s.prev ^= UIntT(read_bits(words,bit,len)) << s.trailing;
+    }
+
+    return from_bits(s.prev);
+  }
+};
+
+/** \brief Delta-of-delta encoding of integral values
+ *  \internal
+ *  The difference between consecutive deltas is zigzag encoded into one of
+ *  five variable length buckets. A constant slope costs one bit per value.
+ *  Arithmetic is modulo 2^64 so that any value of T round trips.
+ */
+template<typename T>
+struct delta_codec {
+  BOOST_STATIC_ASSERT(sizeof(T) <= 8);
+
+  static const unsigned int bits = sizeof(T)*8;
+
+  struct state {
+    std::uint64_t prev;
+    std::uint64_t delta;
+  };
+
+  template<typename WordVector>
+  static void encode_first(WordVector &words, std::size_t &bit_size,
+    state &s, const T &val)
+  {
+    s.prev = std::uint64_t(val);
+    s.delta = 0;
+    write_bits(words,bit_size,s.prev,bits);
+  }
+
+  template<typename WordVector>
+  static void encode(WordVector &words, std::size_t &bit_size, state &s,
+    const T &val)
+  {
+    std::uint64_t cur = std::uint64_t(val);
+    std::uint64_t delta = cur - s.prev;
+    std::uint64_t dod = delta - s.delta;
+    s.prev = cur;
+    s.delta = delta;
+
+    // zigzag so that small negative values are small
+    std::uint64_t z = (dod << 1) ^ (0 - (dod >> 63));
+
+    if(!z)
+      write_bits(words,bit_size,0,1);
+    else if(z < (std::uint64_t(1) << 7)) {
+      write_bits(words,bit_size,1,2);
+      write_bits(words,bit_size,z,7);
+    }
+    else if(z < (std::uint64_t(1) << 12)) {
+      write_bits(words,bit_size,3,3);
+      write_bits(words,bit_size,z,12);
+    }
+    else if(z < (std::uint64_t(1) << 20)) {
+      write_bits(words,bit_size,7,4);
+      write_bits(words,bit_size,z,20);
+    }
+    else {
+      write_bits(words,bit_size,15,4);
+      write_bits(words,bit_size,z,64);
+    }
+  }
+
+  static T decode_first(const std::uint64_t *words, std::size_t &bit,
+    state &s)
+  {
+    s.prev = read_bits(words,bit,bits);
+    s.delta = 0;
+    return T(s.prev);
+  }
+
+  static T decode(const std::uint64_t *words, std::size_t &bit, state &s) {
+    std::uint64_t z = 0;
+    if(read_bits(words,bit,1)) {
+      if(!read_bits(words,bit,1))
+        z = read_bits(words,bit,7);
+      else if(!read_bits(words,bit,1))
+        z = read_bits(words,bit,12);
+      else if(!read_bits(words,bit,1))
+        z = read_bits(words,bit,20);
+      else
+        z = read_bits(words,bit,64);
+    }
+
+    std::uint64_t dod = (z >> 1) ^ (0 - (z & 1));
+    s.delta += dod;
+    s.prev += s.delta;
+    return T(s.prev);
+  }
+};
+
+/** \brief Bytewise encoding of wide floating point values
+ *  \internal
+ *  Floating point types that are neither 32 nor 64 bits, such as the x87
+ *  long double, are stored whole in 64 bit chunks. A value bytewise
+ *  identical to its predecessor costs one bit.
+ */
+template<typename T>
+struct raw_codec {
+  static const unsigned int chunks = (sizeof(T) + 7)/8;
+
+  struct state {
+    std::uint64_t prev[chunks];
+  };
+
+  static void to_chunks(const T &val, std::uint64_t *c) {
+    std::memset(c,0,chunks*sizeof(std::uint64_t));
+    std::memcpy(c,&val,sizeof(T));
+  }
+
+  static T from_chunks(const std::uint64_t *c) {
+    T r;
+    std::memcpy(&r,c,sizeof(T));
+    return r;
+  }
+
+  template<typename WordVector>
+  static void encode_first(WordVector &words, std::size_t &bit_size,
+    state &s, const T &val)
+  {
+    to_chunks(val,s.prev);
+    for(unsigned int i=0; i<chunks; ++i)
+      write_bits(words,bit_size,s.prev[i],64);
+  }
+
+  template<typename WordVector>
+  static void encode(WordVector &words, std::size_t &bit_size, state &s,
+    const T &val)
+  {
+    std::uint64_t cur[chunks];
+    to_chunks(val,cur);
+    if(std::memcmp(cur,s.prev,sizeof(cur)) == 0) {
+      write_bits(words,bit_size,0,1);
+      return;
+    }
+
+    write_bits(words,bit_size,1,1);
+    encode_first(words,bit_size,s,val);
+  }
+
+  static T decode_first(const std::uint64_t *words, std::size_t &bit,
+    state &s)
+  {
+    for(unsigned int i=0; i<chunks; ++i)
+      s.prev[i] = read_bits(words,bit,64);
+    return from_chunks(s.prev);
+  }
+
+  static T decode(const std::uint64_t *words, std::size_t &bit, state &s) {
+    if(read_bits(words,bit,1))
+      return decode_first(words,bit,s);
+
+    return from_chunks(s.prev);
+  }
+};
+
+/** \internal The codec used for values of type T, XOR encoding for float
+ *  and double sized floating point types, bytewise for other floating
+ *  point types and delta-of-delta for integral types
+ */
+template<typename T>
+struct compressed_codec {
+  typedef typename mpl::if_c<
+    b::is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8),
+    xor_codec<T,typename mpl::if_c<sizeof(T) == 8,
+      std::uint64_t,std::uint32_t>::type>,
+    typename mpl::if_<b::is_floating_point<T>,
+      raw_codec<T>,
+      delta_codec<T> >::type>::type type;
+};
+
+/** \brief Random access iterator decoding a compressed_sequence
+ *  \internal
+ *  Holds the decoder state of the current element so that sequential
+ *  traversal decodes each element once. Advancing within a block decodes
+ *  forward, advancing to another block or backward first skips directly to
+ *  the start of the block. Dereferencing yields a value rather than a
+ *  reference.
+ */
+template<typename SequenceT>
+class compressed_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename SequenceT::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type * pointer;
+    typedef value_type reference;
+
+    compressed_iterator(void) :seq(0), pos(0), bit(0), val() {}
+
+    compressed_iterator(const SequenceT *s, std::size_t p) :seq(s), pos(0),
+      bit(0), val()
+    {
+      seek(p);
+    }
+
+    reference operator*(void) const {
+      return val;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    compressed_iterator & operator++(void) {
+      ++pos;
+      if(pos < seq->count)
+        decode_next();
+
+      return *this;
+    }
+
+    compressed_iterator operator++(int) {
+      compressed_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    compressed_iterator & operator--(void) {
+      seek(pos-1);
+      return *this;
+    }
+
+    compressed_iterator operator--(int) {
+      compressed_iterator tmp(*this);
+      --*this;
+      return tmp;
+    }
+
+    compressed_iterator & operator+=(difference_type n);
+
+    compressed_iterator & operator-=(difference_type n) {
+      return *this += -n;
+    }
+
+    compressed_iterator operator+(difference_type n) const {
+      compressed_iterator tmp(*this);
+      return tmp += n;
+    }
+
+    compressed_iterator operator-(difference_type n) const {
+      compressed_iterator tmp(*this);
+      return tmp += -n;
+    }
+
+    difference_type operator-(const compressed_iterator &rhs) const {
+      return difference_type(pos) - difference_type(rhs.pos);
+    }
+
+    bool operator==(const compressed_iterator &rhs) const {
+      return pos == rhs.pos;
+    }
+
+    bool operator!=(const compressed_iterator &rhs) const {
+      return pos != rhs.pos;
+    }
+
+    bool operator<(const compressed_iterator &rhs) const {
+      return pos < rhs.pos;
+    }
+
+    bool operator>(const compressed_iterator &rhs) const {
+      return pos > rhs.pos;
+    }
+
+    bool operator<=(const compressed_iterator &rhs) const {
+      return pos <= rhs.pos;
+    }
+
+    bool operator>=(const compressed_iterator &rhs) const {
+      return pos >= rhs.pos;
+    }
+
+    /** the index of the element */
+    std::size_t index(void) const {
+      return pos;
+    }
+
+  private:
+    typedef typename SequenceT::codec_type codec_type;
+
+    const SequenceT *seq;
+    std::size_t pos;
+    std::size_t bit;
+    typename codec_type::state state;
+    value_type val;
+
+    void decode_next(void) {
+      if(!(pos % SequenceT::block_size)) {
+        bit = seq->blocks[pos / SequenceT::block_size];
+        val = codec_type::decode_first(seq->words.data(),bit,state);
+      }
+      else
+        val = codec_type::decode(seq->words.data(),bit,state);
+    }
+
+    void seek(std::size_t p);
+};
+
+template<typename SequenceT>
+inline compressed_iterator<SequenceT> &
+compressed_iterator<SequenceT>::operator+=(difference_type n)
+{
+  std::size_t target = pos + n;
+  if(n > 0 && target < seq->count &&
+    target / SequenceT::block_size == pos / SequenceT::block_size)
+  {
+    while(pos != target)
+      ++*this;
+  }
+  else if(n)
+    seek(target);
+
+  return *this;
+}
+
+template<typename SequenceT>
+inline void compressed_iterator<SequenceT>::seek(std::size_t p)
+{
+  if(p >= seq->count) {
+    pos = p;
+    return;
+  }
+
+  // block skip, then decode forward within the block
+  pos = p - p % SequenceT::block_size;
+  decode_next();
+  while(pos != p) {
+    ++pos;
+    decode_next();
+  }
+}
+
+template<typename SequenceT>
+inline compressed_iterator<SequenceT>
+operator+(std::ptrdiff_t n, const compressed_iterator<SequenceT> &it)
+{
+  return it + n;
+}
+
+}
+
+/** \brief Sequence of arithmetic values stored as a compressed bit stream
+ *  \tparam T The element type, must be arithmetic
+ *  \tparam A Allocator type, rebound for the bit stream
+ *
+ *  Model of std::sequence with optional members, except that elements are
+ *  not lvalues
+ *
+ *  \par Discussion
+ *  Float and double elements are XOR encoded against their predecessor and
+ *  integral elements are delta-of-delta encoded. Slowly varying signals,
+ *  repeated values, and regular ramps typically take a few bits per
+ *  element instead of sizeof(T)*8. Wider floating point types such as
+ *  long double are stored whole, only repeated values are compressed.
+ *
+ *  \par
+ *  Elements are encoded in independently decodable blocks of block_size.
+ *  Iterators decode on the fly and are random access: advancing by more
+ *  than the remainder of a block skips directly to the target block, so a
+ *  seek, eg a basic_channel::subchannel() by time, decodes at most
+ *  block_size elements. operator[] and at() seek in the same way.
+ *
+ *  \par
+ *  Since elements are not stored individually, element access returns
+ *  values and iterator and const_iterator are the same read only type.
+ *  Appending with push_back() costs amortized constant time. Insertion,
+ *  erasure and pop_back() re-encode from the start of the affected block
+ *  to the end of the sequence.
+ *
+ *  \code
+ *  typedef basic_channel<double,double,double,compressed_sequence>
+ *    channel_type;
+ *
+ *  channel_type channel;
+ *  channel.push_back(...);
+ *  \endcode
+ */
+template<typename T, typename A = std::allocator<T> >
+class compressed_sequence {
+  public:
+    /** T, elements are returned by value */
+    typedef T reference;
+    /** T, elements are returned by value */
+    typedef T const_reference;
+    /** read only iterator decoding T */
+    typedef detail::compressed_iterator<compressed_sequence> iterator;
+    /** read only iterator decoding T */
+    typedef detail::compressed_iterator<compressed_sequence> const_iterator;
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** T */
+    typedef T value_type;
+    /** Allocator */
+    typedef A allocator_type;
+    /** type modeling pointer to T */
+    typedef const T * pointer;
+    /** type modeling pointer to const T */
+    typedef const T * const_pointer;
+    /** reverse_iterator type decoding T */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type decoding T */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** Number of elements in each independently decodable block */
+    static const size_type block_size = 256;
+
+    /** \brief Default Constructor
+     *  \param alloc The allocator
+     */
+    explicit compressed_sequence(const allocator_type &a = allocator_type())
+      :alloc(a), words(word_allocator(a)), blocks(offset_allocator(a)),
+      bit_size(0), count(0), tail() {}
+
+    /** \brief Fill Constructor
+     *  \param n The number of copies of \e value to make
+     *  \param value The value to copy
+     *  \param alloc The allocator
+     *  \post size() == \e n
+     */
+    explicit compressed_sequence(size_type n, const T &value = T(),
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Constructor
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \param alloc The allocator
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    compressed_sequence(InputIterator first, InputIterator last,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Assignment Operator
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \post size() = <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /** \brief Fill Assignment Operator
+     *  \param n The number of <em>val</em> object to assign to this sequence
+     *  \param val The value of the objects that are assigned to this
+     *  \post size() = <em>n</em>
+     */
+    void assign(size_type n, const T &val);
+
+    /** \brief Obtain a copy of the allocator */
+    allocator_type get_allocator(void) const {
+      return alloc;
+    }
+
+    /** \brief Obtain iterator to sequence beginning */
+    const_iterator begin(void) const {
+      return const_iterator(this,0);
+    }
+
+    /** \brief Obtain iterator to one past sequence end */
+    const_iterator end(void) const {
+      return const_iterator(this,count);
+    }
+
+    /** \brief Obtain reverse iterator to sequence end */
+    const_reverse_iterator rbegin(void) const {
+      return const_reverse_iterator(end());
+    }
+
+    /** \brief Obtain reverse iterator to one before sequence beginning */
+    const_reverse_iterator rend(void) const {
+      return const_reverse_iterator(begin());
+    }
+
+    /** \brief Obtain the number of elements */
+    size_type size(void) const {
+      return count;
+    }
+
+    /** \brief Obtain the largest possible number of elements */
+    size_type max_size(void) const {
+      return std::numeric_limits<difference_type>::max();
+    }
+
+    /** \brief Resize to \e sz elements, appending copies of \e val */
+    void resize(size_type sz, const T &val = T());
+
+    /** \brief Obtain the number of elements, elements are not preallocated
+     */
+    size_type capacity(void) const {
+      return count;
+    }
+
+    /** \brief Determine if the sequence is empty */
+    bool empty(void) const {
+      return !count;
+    }
+
+    /** \brief Reserve block bookkeeping for \e n elements */
+    void reserve(size_type n) {
+      blocks.reserve((n + block_size - 1) / block_size);
+    }
+
+    /** \brief Obtain the element at \e n, decoding at most block_size
+     *    elements
+     *  \pre \e n < size()
+     */
+    const_reference operator[](size_type n) const {
+      return *const_iterator(this,n);
+    }
+
+    /** \brief Obtain the element at \e n
+     *  \throws <CODE>std::out_of_range</CODE> if \e n >= size()
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the first element \pre !empty() */
+    const_reference front(void) const {
+      return *begin();
+    }
+
+    /** \brief Obtain the last element \pre !empty() */
+    const_reference back(void) const {
+      return (*this)[count-1];
+    }
+
+    /** \brief Append \e val */
+    void push_back(const T &val);
+
+    /** \brief Remove the last element \pre !empty() */
+    void pop_back(void) {
+      truncate(count-1);
+    }
+
+    /** \brief Insert \e val before \e position
+     *  \return iterator to the inserted element
+     */
+    iterator insert(iterator position, const T &val);
+
+    /** \brief Insert \e n copies of \e val before \e position */
+    void insert(iterator position, size_type n, const T &val);
+
+    /** \brief Insert [\e first, \e last) before \e position */
+    template<typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last);
+
+    /** \brief Erase the element at \e position
+     *  \return iterator to the element following the erased one
+     */
+    iterator erase(iterator position) {
+      return erase(position,position+1);
+    }
+
+    /** \brief Erase [\e first, \e last)
+     *  \return iterator to the element following the erased ones
+     */
+    iterator erase(iterator first, iterator last);
+
+    /** \brief Swap contents with \e rhs */
+    void swap(compressed_sequence &rhs);
+
+    /** \brief Remove all elements \post empty() */
+    void clear(void);
+
+    /** \brief Obtain the number of bytes used to store the elements
+     *  \return The size of the bit stream and block index
+     */
+    std::size_t compressed_size(void) const {
+      return words.size()*sizeof(std::uint64_t) +
+        blocks.size()*sizeof(std::size_t);
+    }
+
+  private:
+    friend class detail::compressed_iterator<compressed_sequence>;
+
+    BOOST_STATIC_ASSERT(b::is_arithmetic<T>::value);
+
+    typedef typename detail::compressed_codec<T>::type codec_type;
+    typedef typename std::allocator_traits<A>::template
+      rebind_alloc<std::uint64_t> word_allocator;
+    typedef typename std::allocator_traits<A>::template
+      rebind_alloc<std::size_t> offset_allocator;
+
+    allocator_type alloc;
+    std::vector<std::uint64_t,word_allocator> words;
+    // bit offset of the start of each block
+    std::vector<std::size_t,offset_allocator> blocks;
+    std::size_t bit_size;
+    size_type count;
+    // encoder state following the last element
+    typename codec_type::state tail;
+
+    void truncate(size_type n);
+
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::false_);
+};
+
+
+
+template<typename T, typename A>
+const typename compressed_sequence<T,A>::size_type
+  compressed_sequence<T,A>::block_size;
+
+template<typename T, typename A>
+inline compressed_sequence<T,A>::compressed_sequence(size_type n,
+  const T &value, const allocator_type &a) :alloc(a),
+  words(word_allocator(a)), blocks(offset_allocator(a)), bit_size(0),
+  count(0), tail()
+{
+  assign(n,value);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline compressed_sequence<T,A>::compressed_sequence(InputIterator first,
+  InputIterator last, const allocator_type &a) :alloc(a),
+  words(word_allocator(a)), blocks(offset_allocator(a)), bit_size(0),
+  count(0), tail()
+{
+  assign(first,last);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::assign(InputIterator first,
+  InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::assign(size_type n, const T &val)
+{
+  clear();
+  for(size_type i=0; i<n; ++i)
+    push_back(val);
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::resize(size_type sz, const T &val)
+{
+  if(sz < count)
+    truncate(sz);
+
+  while(count < sz)
+    push_back(val);
+}
+
+template<typename T, typename A>
+inline typename compressed_sequence<T,A>::const_reference
+compressed_sequence<T,A>::at(size_type n) const
+{
+  if(n >= count)
+    throw std::out_of_range("compressed_sequence: index out of range");
+
+  return (*this)[n];
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::push_back(const T &val)
+{
+  std::size_t old_bits = bit_size;
+  std::size_t old_words = words.size();
+  typename codec_type::state old_tail = tail;
+
+  try {
+    if(!(count % block_size)) {
+      blocks.push_back(bit_size);
+      codec_type::encode_first(words,bit_size,tail,val);
+    }
+    else
+      codec_type::encode(words,bit_size,tail,val);
+  }
+  catch(...) {
+    if(blocks.size() > count / block_size + (count % block_size ? 1 : 0))
+      blocks.pop_back();
+
+    words.resize(old_words);
+    if(old_bits % 64)
+      words.back() &= (std::uint64_t(1) << (old_bits % 64)) - 1;
+
+    bit_size = old_bits;
+    tail = old_tail;
+    throw;
+  }
+
+  ++count;
+}
+
+template<typename T, typename A>
+inline typename compressed_sequence<T,A>::iterator
+compressed_sequence<T,A>::insert(iterator position, const T &val)
+{
+  size_type idx = position.index();
+  insert(position,size_type(1),val);
+  return iterator(this,idx);
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::insert(iterator position, size_type n,
+  const T &val)
+{
+  size_type idx = position.index();
+  std::vector<T> rest(position,end());
+
+  truncate(idx);
+  for(size_type i=0; i<n; ++i)
+    push_back(val);
+
+  append(rest.begin(),rest.end());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::insert(iterator position,
+  InputIterator first, InputIterator last)
+{
+  insert_thunk(position,first,last,
+    typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline typename compressed_sequence<T,A>::iterator
+compressed_sequence<T,A>::erase(iterator first, iterator last)
+{
+  size_type idx = first.index();
+  std::vector<T> rest(last,end());
+
+  truncate(idx);
+  append(rest.begin(),rest.end());
+
+  return iterator(this,idx);
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::swap(compressed_sequence &rhs)
+{
+  using std::swap;
+
+  swap(alloc,rhs.alloc);
+  words.swap(rhs.words);
+  blocks.swap(rhs.blocks);
+  swap(bit_size,rhs.bit_size);
+  swap(count,rhs.count);
+  swap(tail,rhs.tail);
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::clear(void)
+{
+  words.clear();
+  blocks.clear();
+  bit_size = 0;
+  count = 0;
+}
+
+template<typename T, typename A>
+inline void compressed_sequence<T,A>::truncate(size_type n)
+{
+  if(n >= count)
+    return;
+
+  // keep the whole blocks before n and re-encode the rest of its block
+  size_type block = n / block_size;
+  std::vector<T> head;
+  if(n % block_size)
+    head.assign(iterator(this,block*block_size),iterator(this,n));
+
+  bit_size = blocks[block];
+  blocks.resize(block);
+  count = block*block_size;
+
+  words.resize((bit_size + 63) / 64);
+  if(bit_size % 64)
+    words.back() &= (std::uint64_t(1) << (bit_size % 64)) - 1;
+
+  append(head.begin(),head.end());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::append(InputIterator first,
+  InputIterator last)
+{
+  for(; first != last; ++first)
+    push_back(*first);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::true_)
+{
+  assign(size_type(first),T(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::false_)
+{
+  clear();
+  append(first,last);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::true_)
+{
+  insert(position,size_type(first),T(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void compressed_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::false_)
+{
+  // copy the range first in case it refers to this sequence
+  std::vector<T> range(first,last);
+  size_type idx = position.index();
+  std::vector<T> rest(position,end());
+
+  truncate(idx);
+  append(range.begin(),range.end());
+  append(rest.begin(),rest.end());
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_DETAIL_CONTIGUOUS_H
+#define LEMMA_QSAT_DETAIL_CONTIGUOUS_H
+
+#include <boost/mpl/bool.hpp>
+
+#include <vector>
+
+/** \file
+ *  \brief Traits identifying containers and channels with contiguous
+ *    elements
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace mpl = boost::mpl;
+
+template<typename T, typename A, typename Counter>
+class basic_intrusive_sequence;
+
+template<typename T, typename A>
+class mapped_sequence;
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+class basic_channel;
+
+namespace detail {
+
+/** \brief Determine whether the elements of a container are contiguous
+ *  \internal
+ */
+template<typename Container>
+struct is_contiguous_sequence :public mpl::false_ {};
+
+template<typename T, typename A>
+struct is_contiguous_sequence<std::vector<T,A> > :public mpl::true_ {};
+
+template<typename T, typename A, typename Counter>
+struct is_contiguous_sequence<basic_intrusive_sequence<T,A,Counter> >
+  :public mpl::true_ {};
+
+template<typename T, typename A>
+struct is_contiguous_sequence<mapped_sequence<T,A> > :public mpl::true_ {};
+
+/** \brief Determine whether the samples of a channel are contiguous
+ *  \internal
+ */
+template<typename ChannelT>
+struct is_contiguous_channel :public mpl::false_ {};
+
+template<typename M, typename F, typename T,
+  template<typename, typename> class C, template<typename> class A>
+struct is_contiguous_channel<basic_channel<M,F,T,C,A> >
+  :public is_contiguous_sequence<typename basic_channel<M,F,T,C,A>::container_type> {};
+
+}
+}
+}
+
+
+#endif
@@ -0,0 +1,151 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_DETAIL_FFT_H
+#define LEMMA_QSAT_DETAIL_FFT_H
+
+#include <vector>
+#include <complex>
+#include <utility>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+
+/** \file
+ *  \brief In-place radix-2 fast Fourier transform used for fast convolution
+ */
+
+namespace lemma {
+namespace qsat {
+namespace detail {
+
+/** \brief Precomputed radix-2 transform of a fixed power of two size
+ *  \tparam T The real precision, float or double
+ *  \internal Iterative decimation in time. The bit reversal permutation and
+ *  twiddle factors are computed once so that repeated transforms of the
+ *  same size, eg overlap-save blocks, only perform the butterflies.
+ */
+template<typename T>
+class fft_plan {
+  public:
+    typedef std::complex<T> complex_type;
+
+    explicit fft_plan(std::size_t n);
+
+    std::size_t size(void) const {
+      return _size;
+    }
+
+    /** forward transform of size() elements at \e data in place */
+    void forward(complex_type *data) const {
+      transform(data,false);
+    }
+
+    /** inverse transform, including the 1/size() scale, in place */
+    void inverse(complex_type *data) const;
+
+  private:
+    std::size_t _size;
+    std::vector<std::size_t> bitrev;
+    std::vector<complex_type> twiddle;
+
+    void transform(complex_type *data, bool inv) const;
+};
+
+
+
+template<typename T>
+inline fft_plan<T>::fft_plan(std::size_t n) :_size(n), bitrev(n),
+  twiddle(n/2)
+{
+  if(!n || (n & (n-1)))
+    throw std::invalid_argument("fft_plan: size must be a power of two");
+
+  std::size_t bits = 0;
+  while((std::size_t(1) << bits) < n)
+    ++bits;
+
+  for(std::size_t i=0; i<n; ++i) {
+    std::size_t r = 0;
+    for(std::size_t j=0; j<bits; ++j)
+      r |= ((i >> j) & 1) << (bits-1-j);
+
+    bitrev[i] = r;
+  }
+
+  const double pi = 3.14159265358979323846;
+  for(std::size_t i=0; i<n/2; ++i) {
+    double arg = -2*pi*double(i)/double(n);
+    twiddle[i] = complex_type(T(std::cos(arg)),T(std::sin(arg)));
+  }
+}
+
+template<typename T>
+inline void fft_plan<T>::inverse(complex_type *data) const
+{
+  transform(data,true);
+
+  T scale = T(1)/T(_size);
+  for(std::size_t i=0; i<_size; ++i)
+    data[i] *= scale;
+}
+
+template<typename T>
+inline void fft_plan<T>::transform(complex_type *data, bool inv) const
+{
+  for(std::size_t i=0; i<_size; ++i) {
+    if(i < bitrev[i])
+      std::swap(data[i],data[bitrev[i]]);
+  }
+
+  for(std::size_t len=2; len<=_size; len <<= 1) {
+    std::size_t half = len/2;
+    std::size_t step = _size/len;
+    for(std::size_t i=0; i<_size; i += len) {
+      for(std::size_t j=0; j<half; ++j) {
+        const complex_type &w = twiddle[j*step];
+        const complex_type &d = data[i+j+half];
+        T wi = inv ? -w.imag() : w.imag();
+
+        // avoid the inf/nan handling of std::complex multiplication
+        complex_type t(w.real()*d.real() - wi*d.imag(),
+          w.real()*d.imag() + wi*d.real());
+        data[i+j+half] = data[i+j]-t;
+        data[i+j] += t;
+      }
+    }
+  }
+}
+
+
+
+}
+}
+}
+
+
+#endif
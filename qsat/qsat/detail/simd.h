@@ -0,0 +1,245 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_DETAIL_SIMD_H
+#define LEMMA_QSAT_DETAIL_SIMD_H
+
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/** \file
+ *  \brief Vectorized inner loops shared by the signal processing algorithms
+ *
+ *  \par Discussion
+ *  Explicit kernels are used for float and double when the compiler targets
+ *  AVX (using fused multiply-add when FMA is also enabled, eg with
+ *  <tt>-mavx2 -mfma</tt> or <tt>-march=native</tt>) or SSE2. All other
+ *  types, and all other targets, use a portable loop with independent
+ *  partial sums that compilers readily vectorize.
+ */
+
+namespace lemma {
+namespace qsat {
+namespace detail {
+
+/** \brief Type used for the arithmetic on a magnitude type
+ *  \internal Single precision is kept as is so the float kernels are used.
+ */
+template<typename T>
+struct simd_value_type {
+  typedef double type;
+};
+
+template<>
+struct simd_value_type<float> {
+  typedef float type;
+};
+
+/** \brief Inner product of two arrays
+ *  \param a The first array
+ *  \param b The second array
+ *  \param n The number of elements in \e a and \e b
+ *  \return <tt>a[0]*b[0] + ... + a[n-1]*b[n-1]</tt>
+ *  \internal Neither array needs any particular alignment.
+ */
+template<typename T>
+inline T dot_product(const T *a, const T *b, std::size_t n)
+{
+  T acc0 = T();
+  T acc1 = T();
+  T acc2 = T();
+  T acc3 = T();
+
+  std::size_t i = 0;
+  for(; i+4 <= n; i += 4) {
+    acc0 += a[i]*b[i];
+    acc1 += a[i+1]*b[i+1];
+    acc2 += a[i+2]*b[i+2];
+    acc3 += a[i+3]*b[i+3];
+  }
+
+  for(; i<n; ++i)
+    acc0 += a[i]*b[i];
+
+  return (acc0+acc1)+(acc2+acc3);
+}
+
+#if defined(__AVX__)
+
+/** \internal Sum the lanes of \e v */
+inline float horizontal_sum(__m256 v)
+{
+  __m128 x = _mm_add_ps(_mm256_castps256_ps128(v),_mm256_extractf128_ps(v,1));
+  x = _mm_add_ps(x,_mm_movehl_ps(x,x));
+  x = _mm_add_ss(x,_mm_shuffle_ps(x,x,1));
+  return _mm_cvtss_f32(x);
+}
+
+/** \internal Sum the lanes of \e v */
+inline double horizontal_sum(__m256d v)
+{
+  __m128d x = _mm_add_pd(_mm256_castpd256_pd128(v),
+    _mm256_extractf128_pd(v,1));
+  x = _mm_add_sd(x,_mm_unpackhi_pd(x,x));
+  return _mm_cvtsd_f64(x);
+}
+
+/** \internal <tt>acc + a*b</tt>, fused when FMA is available */
+inline __m256 multiply_add(__m256 a, __m256 b, __m256 acc)
+{
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a,b,acc);
+#else
+  return _mm256_add_ps(acc,_mm256_mul_ps(a,b));
+#endif
+}
+
+/** \internal <tt>acc + a*b</tt>, fused when FMA is available */
+inline __m256d multiply_add(__m256d a, __m256d b, __m256d acc)
+{
+#if defined(__FMA__)
+  return _mm256_fmadd_pd(a,b,acc);
+#else
+  return _mm256_add_pd(acc,_mm256_mul_pd(a,b));
+#endif
+}
+
+template<>
+inline float dot_product<float>(const float *a, const float *b, std::size_t n)
+{
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+
+  std::size_t i = 0;
+  for(; i+16 <= n; i += 16) {
+    acc0 = multiply_add(_mm256_loadu_ps(a+i),_mm256_loadu_ps(b+i),acc0);
+    acc1 = multiply_add(_mm256_loadu_ps(a+i+8),_mm256_loadu_ps(b+i+8),acc1);
+  }
+
+  if(i+8 <= n) {
+    acc0 = multiply_add(_mm256_loadu_ps(a+i),_mm256_loadu_ps(b+i),acc0);
+    i += 8;
+  }
+
+  float result = horizontal_sum(_mm256_add_ps(acc0,acc1));
+
+  for(; i<n; ++i)
+    result += a[i]*b[i];
+
+  return result;
+}
+
+template<>
+inline double dot_product<double>(const double *a, const double *b,
+  std::size_t n)
+{
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+
+  std::size_t i = 0;
+  for(; i+8 <= n; i += 8) {
+    acc0 = multiply_add(_mm256_loadu_pd(a+i),_mm256_loadu_pd(b+i),acc0);
+    acc1 = multiply_add(_mm256_loadu_pd(a+i+4),_mm256_loadu_pd(b+i+4),acc1);
+  }
+
+  if(i+4 <= n) {
+    acc0 = multiply_add(_mm256_loadu_pd(a+i),_mm256_loadu_pd(b+i),acc0);
+    i += 4;
+  }
+
+  double result = horizontal_sum(_mm256_add_pd(acc0,acc1));
+
+  for(; i<n; ++i)
+    result += a[i]*b[i];
+
+  return result;
+}
+
+#elif defined(__SSE2__)
+
+template<>
+inline float dot_product<float>(const float *a, const float *b, std::size_t n)
+{
+  __m128 acc0 = _mm_setzero_ps();
+  __m128 acc1 = _mm_setzero_ps();
+
+  std::size_t i = 0;
+  for(; i+8 <= n; i += 8) {
+    acc0 = _mm_add_ps(acc0,_mm_mul_ps(_mm_loadu_ps(a+i),_mm_loadu_ps(b+i)));
+    acc1 = _mm_add_ps(acc1,
+      _mm_mul_ps(_mm_loadu_ps(a+i+4),_mm_loadu_ps(b+i+4)));
+  }
+
+  float part[4];
+  _mm_storeu_ps(part,_mm_add_ps(acc0,acc1));
+  float result = (part[0]+part[1])+(part[2]+part[3]);
+
+  for(; i<n; ++i)
+    result += a[i]*b[i];
+
+  return result;
+}
+
+template<>
+inline double dot_product<double>(const double *a, const double *b,
+  std::size_t n)
+{
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  std::size_t i = 0;
+  for(; i+4 <= n; i += 4) {
+    acc0 = _mm_add_pd(acc0,_mm_mul_pd(_mm_loadu_pd(a+i),_mm_loadu_pd(b+i)));
+    acc1 = _mm_add_pd(acc1,
+      _mm_mul_pd(_mm_loadu_pd(a+i+2),_mm_loadu_pd(b+i+2)));
+  }
+
+  double part[2];
+  _mm_storeu_pd(part,_mm_add_pd(acc0,acc1));
+  double result = part[0]+part[1];
+
+  for(; i<n; ++i)
+    result += a[i]*b[i];
+
+  return result;
+}
+
+#endif
+
+
+
+}
+}
+}
+
+
+#endif
@@ -31,6 +31,11 @@
 #include <boost/numeric/conversion/cast.hpp>
 
 #include <boost/units/quantity.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/mpl/bool.hpp>
+
+#include <limits>
+#include <cmath>
 
 /** \file
  *  \brief Functions to genericaly and safely construct numeric types with a
@@ -67,6 +72,69 @@ struct value_cast<boost::units::quantity<Unit,Y> > {
   }
 };
 
+/** \brief Generic value extraction
+ *  \tparam T The type to obtain the plain value of
+ *  \internal The inverse of value_cast. Obtain the plain arithmetic value
+ *  of a numeric type as a double.
+ */
+template<typename T>
+struct scalar_value {
+  /** the value of \e val */
+  static double get(const T &val) {
+    return boost::numeric_cast<double>(val);
+  }
+};
+
+/** \brief Generic value extraction
+ *  \tparam Unit The unit type of boost::units::quantity
+ *  \tparam Y The value_type (or precision) of boost::units::quantity
+ *  \internal Specialization to obtain the value of a boost::unit
+ */
+template<typename Unit, typename Y>
+struct scalar_value<boost::units::quantity<Unit,Y> > {
+  /** the value of \e val */
+  static double get(const boost::units::quantity<Unit,Y> &val) {
+    return boost::numeric_cast<double>(val.value());
+  }
+};
+
+template<typename T, typename V>
+inline T sample_cast(const V &val, boost::mpl::true_)
+{
+  // NaN compares false against both limits and has no integral value
+  if(val != val)
+    throw boost::numeric::bad_numeric_cast();
+
+  V rounded = std::floor(val+V(0.5));
+  if(rounded <= V(std::numeric_limits<T>::min()))
+    return std::numeric_limits<T>::min();
+  if(rounded >= V(std::numeric_limits<T>::max()))
+    return std::numeric_limits<T>::max();
+
+  return value_cast<T>::construct(rounded);
+}
+
+template<typename T, typename V>
+inline T sample_cast(const V &val, boost::mpl::false_)
+{
+  return T(val);
+}
+
+/** \brief Convert a computed floating point value to a sample
+ *  \tparam T The sample type
+ *  \internal Integral samples are rounded to nearest rather than truncated
+ *  and clipped to the range of T, so that the overshoot of a filter near
+ *  full scale saturates. NaN throws
+ *  <code>boost::numeric::bad_numeric_cast</code>.
+ */
+template<typename T, typename V>
+inline T sample_cast(const V &val)
+{
+  return sample_cast<T>(val,typename boost::is_integral<T>::type());
+}
+
+
+
 
 
 }
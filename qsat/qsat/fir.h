@@ -0,0 +1,340 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_FIR_H
+#define LEMMA_QSAT_FIR_H
+
+#include "basic_channel.h"
+#include "detail/fft.h"
+#include "detail/simd.h"
+#include "detail/value_cast.h"
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/static_assert.hpp>
+
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+/** \file
+ *  \brief Finite impulse response filtering and convolution of channels
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \internal Kernels with at least this many taps use fast convolution
+ *  when fir_filter::automatic is requested
+ */
+static const std::size_t fir_fft_threshold = 64;
+
+}
+
+/** \brief Streaming finite impulse response filter
+ *  \tparam T The arithmetic precision of the filter, float or double
+ *
+ *  \par Discussion
+ *  Computes <tt>y[n] = h[0]*x[n] + h[1]*x[n-1] + ... + h[K-1]*x[n-K+1]</tt>
+ *  for a kernel \e h of K taps. The filter retains the last K-1 input
+ *  samples between calls so that consecutive pieces of a signal, eg
+ *  adjacent subchannels or blocks from a basic_live_channel, are filtered
+ *  exactly as if they were one signal without reprocessing any history.
+ *  Samples before the first call (or reset()) are taken as zero.
+ *
+ *  Short kernels are applied directly using the vectorized kernels of
+ *  detail/simd.h. Long kernels are applied by overlap-save convolution
+ *  with a radix-2 FFT at a cost proportional to log(K) per sample.
+ *
+ *  \par Thread safety
+ *  A fir_filter holds mutable state and may only be used by one thread at
+ *  a time.
+ *
+ *  \code
+ *  fir_filter<float> lowpass(coefs,coefs+63);
+ *  basic_channel<float,float,float> a = lowpass(ch.subchannel(b,m));
+ *  basic_channel<float,float,float> b = lowpass(ch.subchannel(m,e));
+ *  \endcode
+ */
+template<typename T>
+class fir_filter {
+  public:
+    /** T */
+    typedef T value_type;
+    /** Unsigned integral type */
+    typedef std::size_t size_type;
+
+    /** How the kernel is applied */
+    enum method_type {
+      /** choose by the number of taps */
+      automatic,
+      /** direct form */
+      direct,
+      /** overlap-save FFT convolution */
+      fft
+    };
+
+    /** \brief Kernel Constructor
+     *  \param first,last <code>InputIterator</code> range of filter
+     *    coefficients convertable to T, h[0] first
+     *  \param method How the kernel is applied
+     *  \throws <CODE>std::invalid_argument</CODE> if the range is empty
+     */
+    template<typename InputIterator>
+    fir_filter(InputIterator first, InputIterator last,
+      method_type method=automatic);
+
+    /** \brief Obtain the number of filter coefficients
+     *  \return The number of taps
+     */
+    size_type taps(void) const;
+
+    /** \brief Obtain how the kernel is applied
+     *  \return Either direct or fft
+     */
+    method_type method(void) const;
+
+    /** \brief Discard the retained history
+     *  \post The next sample is filtered as the first sample of a signal
+     */
+    void reset(void);
+
+    /** \brief Filter a range of samples
+     *  \param first,last <code>InputIterator</code> range of samples
+     *    convertable to T
+     *  \param out <code>OutputIterator</code> receiving one filtered sample
+     *    for each input sample
+     *  \return \e out advanced past the last filtered sample
+     */
+    template<typename InputIterator, typename OutputIterator>
+    OutputIterator process(InputIterator first, InputIterator last,
+      OutputIterator out);
+
+    /** \brief Filter a channel or subchannel
+     *  \tparam ChannelT A basic_channel or basic_subchannel with an
+     *    arithmetic magnitude_type
+     *  \param ch The channel to filter
+     *  \return A new channel of the same type as \e ch (the underlying
+     *    channel type for a subchannel) with the frequency and epoch of
+     *    \e ch. Integral magnitudes are rounded to nearest.
+     */
+    template<typename ChannelT>
+    typename b::remove_const<typename ChannelT::channel_type>::type
+    operator()(const ChannelT &ch);
+
+  private:
+    typedef std::complex<T> complex_type;
+
+    // h reversed so each output is one dot_product
+    std::vector<T> kernel;
+    // last taps()-1 inputs, oldest first, followed by the current input
+    std::vector<T> work;
+    std::vector<T> result;
+
+    method_type _method;
+    detail::fft_plan<T> plan;
+    std::vector<complex_type> spectrum;
+    std::vector<complex_type> block;
+
+    void filter_work(void);
+
+    static std::size_t fft_size(std::size_t taps, method_type method);
+};
+
+
+
+template<typename T>
+template<typename InputIterator>
+inline fir_filter<T>::fir_filter(InputIterator first, InputIterator last,
+  method_type method) :kernel(first,last),
+    _method(method == automatic ?
+      (kernel.size() >= detail::fir_fft_threshold ? fft : direct) : method),
+    plan(fft_size(kernel.size(),_method))
+{
+  if(kernel.empty())
+    throw std::invalid_argument("fir_filter: empty kernel");
+
+  if(_method == fft) {
+    spectrum.assign(plan.size(),complex_type());
+    std::copy(kernel.begin(),kernel.end(),spectrum.begin());
+    plan.forward(&spectrum[0]);
+  }
+
+  std::reverse(kernel.begin(),kernel.end());
+  work.assign(kernel.size()-1,T());
+}
+
+template<typename T>
+inline std::size_t fir_filter<T>::fft_size(std::size_t taps,
+  method_type method)
+{
+  if(method != fft)
+    return 1;
+
+  // blocks of about 4x the kernel keep the discarded overlap small
+  std::size_t n = 1;
+  while(n < 4*taps)
+    n <<= 1;
+
+  return n;
+}
+
+template<typename T>
+inline typename fir_filter<T>::size_type fir_filter<T>::taps(void) const
+{
+  return kernel.size();
+}
+
+template<typename T>
+inline typename fir_filter<T>::method_type fir_filter<T>::method(void) const
+{
+  return _method;
+}
+
+template<typename T>
+inline void fir_filter<T>::reset(void)
+{
+  work.assign(kernel.size()-1,T());
+}
+
+template<typename T>
+template<typename InputIterator, typename OutputIterator>
+inline OutputIterator fir_filter<T>::process(InputIterator first,
+  InputIterator last, OutputIterator out)
+{
+  work.insert(work.end(),first,last);
+  filter_work();
+
+  return std::copy(result.begin(),result.end(),out);
+}
+
+template<typename T>
+template<typename ChannelT>
+inline typename b::remove_const<typename ChannelT::channel_type>::type
+fir_filter<T>::operator()(const ChannelT &ch)
+{
+  typedef typename b::remove_const<typename ChannelT::channel_type>::type
+    result_type;
+  typedef typename result_type::container_type container_type;
+  typedef typename ChannelT::magnitude_type magnitude_type;
+
+  BOOST_STATIC_ASSERT(b::is_arithmetic<magnitude_type>::value);
+
+  work.insert(work.end(),ch.begin(),ch.end());
+  filter_work();
+
+  container_type seq(result.size());
+  typename std::vector<T>::const_iterator cur = result.begin();
+  for(typename container_type::iterator dst = seq.begin(); dst != seq.end();
+    ++dst, ++cur)
+  {
+    *dst = detail::sample_cast<magnitude_type>(*cur);
+  }
+
+  return result_type(std::move(seq),ch.frequency(),ch.epoch());
+}
+
+template<typename T>
+inline void fir_filter<T>::filter_work(void)
+{
+  const std::size_t taps = kernel.size();
+  const std::size_t count = work.size()-(taps-1);
+
+  result.resize(count);
+
+  if(_method == direct) {
+    for(std::size_t i=0; i<count; ++i)
+      result[i] = detail::dot_product(&kernel[0],&work[i],taps);
+  }
+  else {
+    const std::size_t n = plan.size();
+    const std::size_t step = n-(taps-1);
+
+    block.resize(n);
+    for(std::size_t start=0; start<count; start += step) {
+      std::size_t avail = std::min(n,work.size()-start);
+      std::copy(work.begin()+start,work.begin()+start+avail,block.begin());
+      std::fill(block.begin()+avail,block.end(),complex_type());
+
+      plan.forward(&block[0]);
+      for(std::size_t i=0; i<n; ++i) {
+        const complex_type &x = block[i];
+        const complex_type &h = spectrum[i];
+        block[i] = complex_type(x.real()*h.real() - x.imag()*h.imag(),
+          x.real()*h.imag() + x.imag()*h.real());
+      }
+      plan.inverse(&block[0]);
+
+      // the first taps-1 outputs of each block are circularly aliased
+      std::size_t len = std::min(step,count-start);
+      for(std::size_t i=0; i<len; ++i)
+        result[start+i] = block[taps-1+i].real();
+    }
+  }
+
+  // retain the history for the next call
+  work.erase(work.begin(),work.end()-(taps-1));
+}
+
+/** \brief Convolve a channel with a kernel
+ *  \tparam ChannelT A basic_channel or basic_subchannel with an arithmetic
+ *    magnitude_type
+ *  \param ch The channel to convolve
+ *  \param first,last <code>InputIterator</code> range of kernel
+ *    coefficients, h[0] first
+ *  \return A new channel of the same type as \e ch (the underlying channel
+ *    type for a subchannel) holding the first <tt>ch.size()</tt> samples of
+ *    the convolution with the frequency and epoch of \e ch
+ *  \throws <CODE>std::invalid_argument</CODE> if the kernel is empty
+ *
+ *  \par Discussion
+ *  Equivalent to applying a newly constructed fir_filter. Use a fir_filter
+ *  directly to filter a signal in pieces.
+ */
+template<typename ChannelT, typename InputIterator>
+inline typename b::remove_const<typename ChannelT::channel_type>::type
+convolve(const ChannelT &ch, InputIterator first, InputIterator last)
+{
+  typedef typename detail::simd_value_type<
+    typename ChannelT::magnitude_type>::type value_type;
+
+  fir_filter<value_type> filter(first,last);
+  return filter(ch);
+}
+
+}
+}
+
+
+#endif
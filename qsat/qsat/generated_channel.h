@@ -0,0 +1,699 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_GENERATED_CHANNEL_H
+#define LEMMA_QSAT_GENERATED_CHANNEL_H
+
+#include "basic_channel.h"
+#include "channel_expression.h"
+#include "detail/value_cast.h"
+
+#include <boost/mpl/bool.hpp>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/** \file
+ *  \brief Implementation of basic_generated_channel, a read-only channel
+ *    whose samples are computed on demand, and the standard generators
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+/** \brief Random access iterator computing the samples of a
+ *    basic_generated_channel
+ *  \internal Dereferencing yields a value rather than a reference.
+ */
+template<typename GeneratedT>
+class generated_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename GeneratedT::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type * pointer;
+    typedef value_type reference;
+
+    generated_iterator(void) :ch(0), pos(0) {}
+
+    generated_iterator(const GeneratedT *c, std::size_t p) :ch(c), pos(p) {}
+
+    reference operator*(void) const {
+      return ch->sample(pos);
+    }
+
+    reference operator[](difference_type n) const {
+      return ch->sample(pos+n);
+    }
+
+    generated_iterator & operator++(void) {
+      ++pos;
+      return *this;
+    }
+
+    generated_iterator operator++(int) {
+      generated_iterator tmp(*this);
+      ++pos;
+      return tmp;
+    }
+
+    generated_iterator & operator--(void) {
+      --pos;
+      return *this;
+    }
+
+    generated_iterator operator--(int) {
+      generated_iterator tmp(*this);
+      --pos;
+      return tmp;
+    }
+
+    generated_iterator & operator+=(difference_type n) {
+      pos += n;
+      return *this;
+    }
+
+    generated_iterator & operator-=(difference_type n) {
+      pos -= n;
+      return *this;
+    }
+
+    generated_iterator operator+(difference_type n) const {
+      generated_iterator tmp(*this);
+      return tmp += n;
+    }
+
+    generated_iterator operator-(difference_type n) const {
+      generated_iterator tmp(*this);
+      return tmp -= n;
+    }
+
+    difference_type operator-(const generated_iterator &rhs) const {
+      return difference_type(pos) - difference_type(rhs.pos);
+    }
+
+    bool operator==(const generated_iterator &rhs) const {
+      return pos == rhs.pos;
+    }
+
+    bool operator!=(const generated_iterator &rhs) const {
+      return pos != rhs.pos;
+    }
+
+    bool operator<(const generated_iterator &rhs) const {
+      return pos < rhs.pos;
+    }
+
+    bool operator>(const generated_iterator &rhs) const {
+      return pos > rhs.pos;
+    }
+
+    bool operator<=(const generated_iterator &rhs) const {
+      return pos <= rhs.pos;
+    }
+
+    bool operator>=(const generated_iterator &rhs) const {
+      return pos >= rhs.pos;
+    }
+
+  private:
+    const GeneratedT *ch;
+    std::size_t pos;
+};
+
+template<typename GeneratedT>
+inline generated_iterator<GeneratedT>
+operator+(std::ptrdiff_t n, const generated_iterator<GeneratedT> &it)
+{
+  return it + n;
+}
+
+/** \internal SplitMix64 finalizer, a bijective mix of the bits of \e x */
+inline std::uint64_t mix64(std::uint64_t x)
+{
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+}
+
+/** \brief Read-only channel whose samples are computed by a generator
+ *  \tparam ChannelT The basic_channel type the samples materialize into
+ *  \tparam GeneratorT Function object called as <code>gen(n,t)</code>
+ *    with the index <em>n</em> and time <em>t</em> of a sample, returning
+ *    a value convertible to ChannelT::value_type
+ *
+ *  \par Discussion
+ *  A basic_generated_channel stores its generator, frequency, epoch and
+ *  length rather than its samples. Samples are computed when dereferenced,
+ *  so a channel of any length costs the size of the generator and may be
+ *  traversed, sliced, resampled or used in channel expressions like any
+ *  other read-only channel. for_each_block() computes successive blocks
+ *  into a single buffer for kernels that want contiguous samples.
+ *
+ *  The generator is passed the index of the sample relative to the
+ *  channel it was constructed as, together with its time
+ *  <code>epoch + n/frequency</code>. Slices therefore compute the same
+ *  values for the same samples, including seeded noise. Generators must
+ *  be pure: the same arguments must always produce the same value, and
+ *  concurrent calls on a const generator must be safe.
+ *
+ *  The samples are not writable. to_channel() materializes them into a
+ *  channel_type, which may then be modified.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double> channel_type;
+ *
+ *  // an hour of a 440Hz tone at 48kHz, nothing is stored
+ *  basic_generated_channel<channel_type,sine_generator<float> > tone =
+ *    generate_channel<channel_type>(sine_generator<float>(1.0f,440.0),
+ *      48000*3600,48000.0);
+ *
+ *  channel_type second = tone.time_slice(10.0,11.0).to_channel();
+ *  \endcode
+ */
+template<typename ChannelT, typename GeneratorT>
+class basic_generated_channel {
+  public:
+    /** ChannelT::value_type, samples are returned by value */
+    typedef typename ChannelT::value_type reference;
+    /** ChannelT::value_type, samples are returned by value */
+    typedef typename ChannelT::value_type const_reference;
+    /** read only iterator computing ChannelT::value_type */
+    typedef detail::generated_iterator<basic_generated_channel> iterator;
+    /** read only iterator computing ChannelT::value_type */
+    typedef detail::generated_iterator<basic_generated_channel>
+      const_iterator;
+    /** reverse_iterator type computing ChannelT::value_type */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type computing ChannelT::value_type */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+    /** type modeling pointer to const ChannelT::value_type */
+    typedef typename ChannelT::const_pointer pointer;
+    /** type modeling pointer to const ChannelT::value_type */
+    typedef typename ChannelT::const_pointer const_pointer;
+    /** unsigned integral type */
+    typedef typename ChannelT::size_type size_type;
+    /** signed integral type */
+    typedef typename ChannelT::difference_type difference_type;
+    /** MagnitudeT */
+    typedef typename ChannelT::value_type value_type;
+
+    /** Channel type the samples materialize into */
+    typedef ChannelT channel_type;
+    /** GeneratorT */
+    typedef GeneratorT generator_type;
+
+    /** MagnitudeT */
+    typedef typename ChannelT::magnitude_type magnitude_type;
+    /** FrequencyT */
+    typedef typename ChannelT::frequency_type frequency_type;
+    /** TimeT */
+    typedef typename ChannelT::time_type time_type;
+
+    /** Samples per call of for_each_block() by default */
+    static const size_type default_block_size = 4096;
+
+    /** \brief Default Constructor
+     *
+     *  An empty channel with a default constructed generator
+     */
+    basic_generated_channel(void);
+
+    /** \brief Constructor
+     *
+     *  \param gen The generator, which is copied
+     *  \param n The number of samples
+     *  \param freq The sample frequency
+     *  \param start The time of the first sample
+     *  \post size() == <em>n</em>
+     */
+    basic_generated_channel(const GeneratorT &gen, size_type n,
+      const frequency_type &freq =
+        detail::value_cast<frequency_type>::construct(1),
+      const time_type &start = detail::value_cast<time_type>::construct(0));
+
+    /** \brief Obtain iterator to channel beginning */
+    const_iterator begin(void) const {
+      return const_iterator(this,first);
+    }
+
+    /** \brief Obtain iterator to channel end */
+    const_iterator end(void) const {
+      return const_iterator(this,first+length);
+    }
+
+    /** \brief Obtain reverse iterator to channel end */
+    const_reverse_iterator rbegin(void) const {
+      return const_reverse_iterator(end());
+    }
+
+    /** \brief Obtain reverse iterator to channel beginning */
+    const_reverse_iterator rend(void) const {
+      return const_reverse_iterator(begin());
+    }
+
+    /** \brief Obtain the number of samples */
+    size_type size(void) const {
+      return length;
+    }
+
+    /** \brief Determine if the channel has no samples */
+    bool empty(void) const {
+      return !length;
+    }
+
+    /** \brief Obtain the sample at location <em>n</em> */
+    const_reference operator[](size_type n) const {
+      return sample(first+n);
+    }
+
+    /** \brief Obtain the sample at location <em>n</em>
+     *  \throws <CODE>std::out_of_range</CODE> if <em>n</em> >= size()
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the first sample */
+    const_reference front(void) const {
+      return sample(first);
+    }
+
+    /** \brief Obtain the last sample */
+    const_reference back(void) const {
+      return sample(first+length-1);
+    }
+
+    /** \brief Obtain the sample frequency */
+    const frequency_type & frequency(void) const {
+      return freq;
+    }
+
+    /** \brief Obtain the time of the first sample */
+    time_type epoch(void) const {
+      return time_at(0);
+    }
+
+    /** \brief Obtain the index of the first sample at or after <em>t</em>,
+     *    clamped to [0,size()]
+     */
+    size_type index_at(const time_type &t) const {
+      return detail::time_index(epoch(),freq,t,length);
+    }
+
+    /** \brief Obtain the time of sample <em>n</em> */
+    time_type time_at(size_type n) const {
+      return detail::channel_position<channel_type>::time(start,freq,first+n);
+    }
+
+    /** \brief Obtain the generator */
+    const generator_type & generator(void) const {
+      return gen;
+    }
+
+    /** \brief Obtain the samples [<em>pos</em>, <em>pos</em> + <em>n</em>)
+     *    as a generated channel
+     *
+     *  \param pos The offset of the first sample
+     *  \param n The number of samples, clipped to the end of this channel
+     *  \throws <CODE>std::out_of_range</CODE> if <em>pos</em> > size()
+     */
+    basic_generated_channel slice(size_type pos, size_type n) const;
+
+    /** \brief Obtain the samples in [<em>t0</em>, <em>t1</em>) as a
+     *    generated channel
+     *
+     *  \return The samples [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>)
+     */
+    basic_generated_channel time_slice(const time_type &t0,
+      const time_type &t1) const;
+
+    /** \brief Call a function with successive blocks of samples
+     *
+     *  \par Discussion
+     *  <em>f</em> is called as <code>f(first,last)</code> with
+     *  <code>const value_type *</code> pointers to at most <em>block</em>
+     *  samples at a time, in order. Each block is computed into the same
+     *  buffer, which is only valid for the duration of the call.
+     *
+     *  \param f The function object, which is not copied
+     *  \param block The maximum number of samples per call
+     */
+    template<typename Function>
+    void for_each_block(Function &&f,
+      size_type block = default_block_size) const;
+
+    /** \brief Materialize the samples
+     *
+     *  \return A channel with the samples, frequency and epoch of this
+     *    channel
+     */
+    channel_type to_channel(void) const {
+      return channel_type(begin(),end(),freq,epoch());
+    }
+
+  private:
+    friend class detail::generated_iterator<basic_generated_channel>;
+
+    GeneratorT gen;
+    frequency_type freq;
+    time_type start;
+    // offset of the first sample from the one at start
+    size_type first;
+    size_type length;
+
+    value_type sample(size_type n) const {
+      return value_type(gen(n,
+        detail::channel_position<channel_type>::time(start,freq,n)));
+    }
+};
+
+/** \brief Make a generated channel
+ *
+ *  \tparam ChannelT The channel type the samples materialize into, which
+ *    must be given explicitly
+ *  \param gen The generator
+ *  \param n The number of samples
+ *  \param freq The sample frequency
+ *  \param start The time of the first sample
+ */
+template<typename ChannelT, typename GeneratorT>
+inline basic_generated_channel<ChannelT,GeneratorT>
+generate_channel(const GeneratorT &gen, typename ChannelT::size_type n,
+  const typename ChannelT::frequency_type &freq =
+    detail::value_cast<typename ChannelT::frequency_type>::construct(1),
+  const typename ChannelT::time_type &start =
+    detail::value_cast<typename ChannelT::time_type>::construct(0))
+{
+  return basic_generated_channel<ChannelT,GeneratorT>(gen,n,freq,start);
+}
+
+namespace detail {
+
+template<typename ChannelT, typename GeneratorT>
+struct is_channel_operand<basic_generated_channel<ChannelT,GeneratorT> >
+  :mpl::true_ {};
+
+}
+
+
+
+/** \brief Sinusoid generator
+ *
+ *  <code>amplitude * sin(2*pi*frequency*t + phase) + offset</code>
+ */
+template<typename T>
+class sine_generator {
+  public:
+    /** \brief Constructor
+     *
+     *  \param amplitude The peak amplitude
+     *  \param frequency The frequency in cycles per unit time
+     *  \param phase The phase at t == 0 in radians
+     *  \param offset The value added to every sample
+     */
+    explicit sine_generator(const T &amplitude = T(1),
+      double frequency = 1, double phase = 0, const T &offset = T())
+        :amp(amplitude), freq(frequency), phi(phase), off(offset) {}
+
+    T operator()(std::size_t, double t) const {
+      const double pi = 3.14159265358979323846;
+      return detail::sample_cast<T>(amp*std::sin(2*pi*freq*t + phi) + off);
+    }
+
+  private:
+    T amp;
+    double freq;
+    double phi;
+    T off;
+};
+
+/** \brief Linear frequency sweep generator
+ *
+ *  A sinusoid whose frequency changes linearly from <em>f0</em> at time
+ *  <em>t0</em> to <em>f1</em> at <em>t0</em> + <em>duration</em>,
+ *  continuing at the same rate outside that interval.
+ */
+template<typename T>
+class chirp_generator {
+  public:
+    /** \brief Constructor
+     *
+     *  \param amplitude The peak amplitude
+     *  \param f0 The frequency at <em>t0</em>
+     *  \param f1 The frequency at <em>t0</em> + <em>duration</em>
+     *  \param duration The length of the sweep, must be nonzero
+     *  \param t0 The start of the sweep, where the phase is zero
+     *  \throws <CODE>std::invalid_argument</CODE> if <em>duration</em> is
+     *    zero
+     */
+    chirp_generator(const T &amplitude, double f0, double f1,
+      double duration, double t0 = 0);
+
+    T operator()(std::size_t, double t) const {
+      const double pi = 3.14159265358979323846;
+      double x = t - start;
+      return detail::sample_cast<T>(
+        amp*std::sin(2*pi*(f_start*x + rate*x*x/2)));
+    }
+
+  private:
+    T amp;
+    double f_start;
+    double rate;
+    double start;
+};
+
+/** \brief Seeded uniform white noise generator
+ *
+ *  Uniformly distributed in [-<em>amplitude</em>, <em>amplitude</em>).
+ *  Each sample is a hash of the seed and its index, so any sample may be
+ *  computed independently and the same seed always yields the same
+ *  samples regardless of the order they are visited.
+ */
+template<typename T>
+class noise_generator {
+  public:
+    /** \brief Constructor
+     *
+     *  \param amplitude The half width of the distribution
+     *  \param seed The seed
+     */
+    explicit noise_generator(const T &amplitude = T(1),
+      std::uint64_t seed = 0) :amp(amplitude), key(detail::mix64(seed)) {}
+
+    T operator()(std::size_t n, double) const {
+      std::uint64_t bits =
+        detail::mix64(key + 0x9e3779b97f4a7c15ULL*std::uint64_t(n));
+      double u = double(bits >> 11) * (1.0/9007199254740992.0);
+      return detail::sample_cast<T>(amp*(2*u - 1));
+    }
+
+  private:
+    T amp;
+    std::uint64_t key;
+};
+
+/** \brief Piecewise linear generator
+ *
+ *  Interpolates linearly between breakpoints (t, value) ordered by time.
+ *  Samples before the first or after the last breakpoint take its value.
+ *  Finding the segment of a sample costs time logarithmic in the number of
+ *  breakpoints.
+ */
+template<typename T>
+class piecewise_linear_generator {
+  public:
+    /** \brief Default Constructor, every sample is T() */
+    piecewise_linear_generator(void) {}
+
+    /** \brief Constructor
+     *
+     *  \param first,last <code>InputIterator</code> range of
+     *    <code>std::pair</code> of time and value
+     *  \throws <CODE>std::invalid_argument</CODE> if the times are not
+     *    increasing
+     */
+    template<typename InputIterator>
+    piecewise_linear_generator(InputIterator first, InputIterator last);
+
+    T operator()(std::size_t, double t) const;
+
+  private:
+    typedef std::pair<double,T> point_type;
+
+    struct time_compare {
+      bool operator()(double t, const point_type &pt) const {
+        return t < pt.first;
+      }
+    };
+
+    std::vector<point_type> points;
+};
+
+
+
+template<typename ChannelT, typename GeneratorT>
+const typename basic_generated_channel<ChannelT,GeneratorT>::size_type
+  basic_generated_channel<ChannelT,GeneratorT>::default_block_size;
+
+template<typename ChannelT, typename GeneratorT>
+inline basic_generated_channel<ChannelT,GeneratorT>::basic_generated_channel(
+  void) :gen(), freq(detail::value_cast<frequency_type>::construct(1)),
+    start(detail::value_cast<time_type>::construct(0)), first(0), length(0)
+{
+}
+
+template<typename ChannelT, typename GeneratorT>
+inline basic_generated_channel<ChannelT,GeneratorT>::basic_generated_channel(
+  const GeneratorT &g, size_type n, const frequency_type &f,
+  const time_type &t) :gen(g), freq(f), start(t), first(0), length(n)
+{
+}
+
+template<typename ChannelT, typename GeneratorT>
+inline typename basic_generated_channel<ChannelT,GeneratorT>::const_reference
+basic_generated_channel<ChannelT,GeneratorT>::at(size_type n) const
+{
+  if(n >= length)
+    throw std::out_of_range("basic_generated_channel: index out of range");
+
+  return (*this)[n];
+}
+
+template<typename ChannelT, typename GeneratorT>
+inline basic_generated_channel<ChannelT,GeneratorT>
+basic_generated_channel<ChannelT,GeneratorT>::slice(size_type pos,
+  size_type n) const
+{
+  if(pos > length)
+    throw std::out_of_range("basic_generated_channel: offset out of range");
+
+  if(n > length-pos)
+    n = length-pos;
+
+  basic_generated_channel result(*this);
+  result.first += pos;
+  result.length = n;
+  return result;
+}
+
+template<typename ChannelT, typename GeneratorT>
+inline basic_generated_channel<ChannelT,GeneratorT>
+basic_generated_channel<ChannelT,GeneratorT>::time_slice(const time_type &t0,
+  const time_type &t1) const
+{
+  size_type lo = index_at(t0);
+  size_type hi = index_at(t1);
+  if(hi < lo)
+    hi = lo;
+
+  return slice(lo,hi-lo);
+}
+
+template<typename ChannelT, typename GeneratorT>
+template<typename Function>
+inline void basic_generated_channel<ChannelT,GeneratorT>::for_each_block(
+  Function &&f, size_type block) const
+{
+  if(!length)
+    return;
+
+  if(!block)
+    block = default_block_size;
+
+  std::vector<value_type> buf(std::min(block,length));
+  for(size_type off=0; off<length; off += block) {
+    size_type k = std::min(block,length-off);
+    for(size_type i=0; i<k; ++i)
+      buf[i] = sample(first+off+i);
+
+    f(&buf[0],&buf[0]+k);
+  }
+}
+
+template<typename T>
+inline chirp_generator<T>::chirp_generator(const T &amplitude, double f0,
+  double f1, double duration, double t0) :amp(amplitude), f_start(f0),
+    rate(0), start(t0)
+{
+  if(duration == 0)
+    throw std::invalid_argument("chirp_generator: zero duration");
+
+  rate = (f1 - f0) / duration;
+}
+
+template<typename T>
+template<typename InputIterator>
+inline piecewise_linear_generator<T>::piecewise_linear_generator(
+  InputIterator first, InputIterator last) :points(first,last)
+{
+  for(std::size_t i=1; i<points.size(); ++i) {
+    if(!(points[i-1].first < points[i].first))
+      throw std::invalid_argument(
+        "piecewise_linear_generator: times are not increasing");
+  }
+}
+
+template<typename T>
+inline T piecewise_linear_generator<T>::operator()(std::size_t,
+  double t) const
+{
+  if(points.empty())
+    return T();
+
+  typename std::vector<point_type>::const_iterator hi =
+    std::upper_bound(points.begin(),points.end(),t,time_compare());
+
+  if(hi == points.begin())
+    return points.front().second;
+
+  if(hi == points.end())
+    return points.back().second;
+
+  typename std::vector<point_type>::const_iterator lo = hi - 1;
+  double x = (t - lo->first) / (hi->first - lo->first);
+  return detail::sample_cast<T>(lo->second + (hi->second - lo->second)*x);
+}
+
+}
+}
+
+
+#endif
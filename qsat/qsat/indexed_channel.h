@@ -0,0 +1,732 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_INDEXED_CHANNEL_H
+#define LEMMA_QSAT_INDEXED_CHANNEL_H
+
+#include "basic_channel.h"
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cstddef>
+
+/** \file
+ *  \brief Implementation of basic_indexed_channel, a channel with a
+ *    multi-resolution min/max/mean summary index
+ */
+
+namespace lemma {
+namespace qsat {
+
+/** \brief Summary statistics of an interval of samples
+ *  \tparam T The sample type
+ *
+ *  For an empty interval count is zero and the remaining members are
+ *  value initialized.
+ */
+template<typename T>
+struct sample_summary {
+  /** Smallest sample */
+  T min;
+  /** Largest sample */
+  T max;
+  /** Arithmetic mean of the samples */
+  double mean;
+  /** Number of samples */
+  std::size_t count;
+
+  sample_summary(void) :min(), max(), mean(0), count(0) {}
+};
+
+namespace detail {
+
+/** \brief Node of the summary pyramid
+ *  \internal
+ */
+template<typename T>
+struct summary_node {
+  T min;
+  T max;
+  double sum;
+
+  summary_node(void) :min(), max(), sum(0) {}
+
+  summary_node(const T &lo, const T &hi, double s) :min(lo), max(hi), sum(s) {}
+
+  static summary_node combine(const summary_node &a, const summary_node &b) {
+    return summary_node(b.min < a.min ? b.min : a.min,
+      a.max < b.max ? b.max : a.max,a.sum+b.sum);
+  }
+};
+
+/** \brief Running accumulation of a sample_summary
+ *  \internal
+ */
+template<typename T>
+struct summary_accumulator {
+  T min;
+  T max;
+  double sum;
+  std::size_t count;
+
+  summary_accumulator(void) :min(), max(), sum(0), count(0) {}
+
+  void add(const T &val) {
+    if(!count || val < min)
+      min = val;
+    if(!count || max < val)
+      max = val;
+
+    sum += val;
+    ++count;
+  }
+
+  void add(const summary_node<T> &node, std::size_t n) {
+    if(!count || node.min < min)
+      min = node.min;
+    if(!count || max < node.max)
+      max = node.max;
+
+    sum += node.sum;
+    count += n;
+  }
+
+  sample_summary<T> result(void) const {
+    sample_summary<T> res;
+    if(count) {
+      res.min = min;
+      res.max = max;
+      res.mean = sum/count;
+      res.count = count;
+    }
+
+    return res;
+  }
+};
+
+}
+
+/** \brief Channel with a multi-resolution summary index
+ *  \tparam ChannelT The indexed channel type, eg basic_channel
+ *
+ *  \par Discussion
+ *  A basic_indexed_channel owns a channel and maintains a pyramid of
+ *  min/max/sum summaries over it. Level 0 summarizes consecutive blocks of
+ *  <code>2^leaf_shift</code> samples and every level above halves the
+ *  number of blocks. The pyramid costs about
+ *  <code>2/2^leaf_shift</code> nodes per sample.
+ *
+ *  summary() of any interval combines O(log n) nodes with at most
+ *  <code>2*2^leaf_shift</code> samples at the interval ends. summarize()
+ *  divides an interval into buckets, eg one per display pixel, and
+ *  summarizes each. Zoomed out views of very long channels therefore cost
+ *  O(buckets log n) rather than a scan of every sample.
+ *
+ *  All modification goes through the indexed channel so the index is
+ *  always current:
+ *  - push_back() and append() extend the pyramid incrementally, amortized
+ *    O(1) per sample.
+ *  - set() recomputes only the nodes covering the changed sample.
+ *  - insert() and erase() shift every later sample, so the nodes covering
+ *    those samples are discarded and rebuilt. Nodes before the position
+ *    are kept.
+ *
+ *  The channel itself is only available as a constant reference.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double> channel_type;
+ *  basic_indexed_channel<channel_type> ich(channel_type(first,last,1e4));
+ *
+ *  std::vector<sample_summary<float> > pixels;
+ *  ich.summarize(t0,t1,2000,std::back_inserter(pixels));
+ *  \endcode
+ */
+template<typename ChannelT>
+class basic_indexed_channel {
+  public:
+    /** The indexed channel type */
+    typedef ChannelT channel_type;
+    /** const lvalue of ChannelT::value_type */
+    typedef typename ChannelT::const_reference const_reference;
+    /** iterator type pointing to const ChannelT::value_type */
+    typedef typename ChannelT::const_iterator const_iterator;
+    /** iterator type pointing to const ChannelT::value_type */
+    typedef const_iterator iterator;
+    /** unsigned integral type */
+    typedef typename ChannelT::size_type size_type;
+    /** ChannelT::value_type */
+    typedef typename ChannelT::value_type value_type;
+    /** ChannelT::magnitude_type */
+    typedef typename ChannelT::magnitude_type magnitude_type;
+    /** ChannelT::frequency_type */
+    typedef typename ChannelT::frequency_type frequency_type;
+    /** ChannelT::time_type */
+    typedef typename ChannelT::time_type time_type;
+    /** Summary of an interval of samples */
+    typedef sample_summary<magnitude_type> summary_type;
+
+    /** \brief Constructor
+     *
+     *  \param ch The channel to index
+     *  \param leaf_shift log2 of the number of samples summarized by each
+     *    node of the lowest level
+     */
+    explicit basic_indexed_channel(const ChannelT &ch=ChannelT(),
+      std::size_t leaf_shift=6);
+
+    /** \brief Obtain the indexed channel
+     *  \return Constant reference to the channel
+     */
+    const channel_type & channel(void) const;
+
+    /** \brief Obtain iterator to the first sample */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past the last sample */
+    const_iterator end(void) const;
+
+    /** \brief Obtain the number of samples */
+    size_type size(void) const;
+
+    /** \brief Obtain whether or not the channel contains any samples */
+    bool empty(void) const;
+
+    /** \brief Obtain the sample at location <EM>n</EM> */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain the sample frequency */
+    const frequency_type & frequency(void) const;
+
+    /** \brief Obtain the sample epoch */
+    const time_type & epoch(void) const;
+
+    /** \brief Obtain the index of the sample at a given time, see
+     *    basic_channel::index_at()
+     */
+    size_type index_at(const time_type &t) const;
+
+    /** \brief Obtain the time of a given sample */
+    time_type time_at(size_type n) const;
+
+    /** \brief Obtain the number of pyramid levels */
+    std::size_t levels(void) const;
+
+    /** \brief Append a sample
+     *  \param val The sample value
+     */
+    void push_back(const magnitude_type &val);
+
+    /** \brief Append a range of samples
+     *  \param first,last <code>InputIterator</code> range of values
+     *    convertable to magnitude_type
+     */
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    /** \brief Replace a sample
+     *  \param n The sample location
+     *  \param val The new sample value
+     */
+    void set(size_type n, const magnitude_type &val);
+
+    /** \brief Insert a sample
+     *  \param pos The location to insert before
+     *  \param val The sample value
+     */
+    void insert(size_type pos, const magnitude_type &val);
+
+    /** \brief Insert a range of samples
+     *  \param pos The location to insert before
+     *  \param first,last <code>InputIterator</code> range of values
+     *    convertable to magnitude_type
+     */
+    template<typename InputIterator>
+    void insert(size_type pos, InputIterator first, InputIterator last);
+
+    /** \brief Remove a sample
+     *  \param pos The location of the sample to remove
+     */
+    void erase(size_type pos);
+
+    /** \brief Remove a range of samples
+     *  \param first,last The interval [\e first, \e last) of samples to
+     *    remove
+     */
+    void erase(size_type first, size_type last);
+
+    /** \brief Remove the last sample
+     */
+    void pop_back(void);
+
+    /** \brief Remove every sample
+     */
+    void clear(void);
+
+    /** \brief Summarize an interval of samples
+     *  \param first,last The interval [\e first, \e last) of sample
+     *    locations
+     *  \return The summary of the samples
+     *  \throws <CODE>std::out_of_range</CODE> if the interval is not within
+     *    [0,size())
+     */
+    summary_type summary(size_type first, size_type last) const;
+
+    /** \brief Summarize equal divisions of an interval of samples
+     *  \param first,last The interval [\e first, \e last) of sample
+     *    locations
+     *  \param buckets The number of divisions
+     *  \param out <code>OutputIterator</code> receiving \e buckets
+     *    summary_type values in order. Bucket i covers
+     *    <code>[first+i*n/buckets, first+(i+1)*n/buckets)</code> where
+     *    <code>n = last-first</code>.
+     *  \return \e out advanced past the last summary
+     *  \throws <CODE>std::out_of_range</CODE> if the interval is not within
+     *    [0,size())
+     */
+    template<typename OutputIterator>
+    OutputIterator summarize(size_type first, size_type last,
+      size_type buckets, OutputIterator out) const;
+
+    /** \brief Summarize equal divisions of a time interval
+     *  \param t0,t1 The time interval [\e t0, \e t1), clamped to the
+     *    channel
+     *  \param buckets The number of divisions
+     *  \param out <code>OutputIterator</code> receiving \e buckets
+     *    summary_type values in order
+     *  \return \e out advanced past the last summary
+     */
+    template<typename OutputIterator>
+    OutputIterator summarize(const time_type &t0, const time_type &t1,
+      size_type buckets, OutputIterator out) const;
+
+  private:
+    typedef detail::summary_node<magnitude_type> node_type;
+    typedef detail::summary_accumulator<magnitude_type> accumulator_type;
+
+    ChannelT ch;
+    std::size_t shift;
+    std::vector<std::vector<node_type> > pyramid;
+
+    size_type block_size(std::size_t level) const {
+      return size_type(1) << (shift+level);
+    }
+
+    const_iterator position(size_type n) const;
+    typename ChannelT::iterator mutable_position(size_type n);
+
+    node_type leaf(size_type blk) const;
+    void push_node(std::size_t level, const node_type &node);
+    void extend(void);
+    void truncate(size_type n);
+    void refresh(size_type n);
+
+    bool fits(std::size_t level, size_type pos, size_type last) const;
+
+    void accumulate(accumulator_type &acc, const_iterator &cur,
+      size_type &cur_pos, std::size_t &level, size_type first,
+      size_type last) const;
+};
+
+
+
+template<typename ChannelT>
+inline basic_indexed_channel<ChannelT>::basic_indexed_channel(
+  const ChannelT &c, std::size_t leaf_shift) :ch(c), shift(leaf_shift)
+{
+  extend();
+}
+
+template<typename ChannelT>
+inline const typename basic_indexed_channel<ChannelT>::channel_type &
+basic_indexed_channel<ChannelT>::channel(void) const
+{
+  return ch;
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::const_iterator
+basic_indexed_channel<ChannelT>::begin(void) const
+{
+  return ch.begin();
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::const_iterator
+basic_indexed_channel<ChannelT>::end(void) const
+{
+  return ch.end();
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::size_type
+basic_indexed_channel<ChannelT>::size(void) const
+{
+  return ch.size();
+}
+
+template<typename ChannelT>
+inline bool basic_indexed_channel<ChannelT>::empty(void) const
+{
+  return ch.empty();
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::const_reference
+basic_indexed_channel<ChannelT>::operator[](size_type n) const
+{
+  return ch[n];
+}
+
+template<typename ChannelT>
+inline const typename basic_indexed_channel<ChannelT>::frequency_type &
+basic_indexed_channel<ChannelT>::frequency(void) const
+{
+  return ch.frequency();
+}
+
+template<typename ChannelT>
+inline const typename basic_indexed_channel<ChannelT>::time_type &
+basic_indexed_channel<ChannelT>::epoch(void) const
+{
+  return ch.epoch();
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::size_type
+basic_indexed_channel<ChannelT>::index_at(const time_type &t) const
+{
+  return ch.index_at(t);
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::time_type
+basic_indexed_channel<ChannelT>::time_at(size_type n) const
+{
+  return ch.time_at(n);
+}
+
+template<typename ChannelT>
+inline std::size_t basic_indexed_channel<ChannelT>::levels(void) const
+{
+  return pyramid.size();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::push_back(
+  const magnitude_type &val)
+{
+  ch.push_back(val);
+  if((ch.size() & (block_size(0)-1)) == 0)
+    extend();
+}
+
+template<typename ChannelT>
+template<typename InputIterator>
+inline void basic_indexed_channel<ChannelT>::append(InputIterator first,
+  InputIterator last)
+{
+  for(; first != last; ++first)
+    ch.push_back(*first);
+
+  extend();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::set(size_type n,
+  const magnitude_type &val)
+{
+  ch[n] = val;
+  refresh(n);
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::insert(size_type pos,
+  const magnitude_type &val)
+{
+  ch.insert(mutable_position(pos),val);
+  truncate(pos);
+  extend();
+}
+
+template<typename ChannelT>
+template<typename InputIterator>
+inline void basic_indexed_channel<ChannelT>::insert(size_type pos,
+  InputIterator first, InputIterator last)
+{
+  ch.insert(mutable_position(pos),first,last);
+  truncate(pos);
+  extend();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::erase(size_type pos)
+{
+  ch.erase(mutable_position(pos));
+  truncate(pos);
+  extend();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::erase(size_type first,
+  size_type last)
+{
+  typename ChannelT::iterator pos = mutable_position(first);
+  typename ChannelT::iterator end = pos;
+  std::advance(end,last-first);
+
+  ch.erase(pos,end);
+  truncate(first);
+  extend();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::pop_back(void)
+{
+  ch.pop_back();
+  truncate(ch.size());
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::clear(void)
+{
+  ch.clear();
+  pyramid.clear();
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::summary_type
+basic_indexed_channel<ChannelT>::summary(size_type first, size_type last) const
+{
+  if(first > last || last > size())
+    throw std::out_of_range("basic_indexed_channel::summary");
+
+  accumulator_type acc;
+  const_iterator cur = ch.begin();
+  size_type cur_pos = 0;
+  std::size_t level = 0;
+  accumulate(acc,cur,cur_pos,level,first,last);
+
+  return acc.result();
+}
+
+template<typename ChannelT>
+template<typename OutputIterator>
+inline OutputIterator basic_indexed_channel<ChannelT>::summarize(
+  size_type first, size_type last, size_type buckets,
+  OutputIterator out) const
+{
+  if(first > last || last > size())
+    throw std::out_of_range("basic_indexed_channel::summarize");
+
+  // a single cursor walks forward through the raw samples of all buckets
+  // and the pyramid level reached carries over from one bucket to the next
+  const_iterator cur = ch.begin();
+  size_type cur_pos = 0;
+  std::size_t level = 0;
+
+  size_type n = last-first;
+  for(size_type i=0; i<buckets; ++i) {
+    accumulator_type acc;
+    accumulate(acc,cur,cur_pos,level,first+(i*n)/buckets,
+      first+((i+1)*n)/buckets);
+    *out++ = acc.result();
+  }
+
+  return out;
+}
+
+template<typename ChannelT>
+template<typename OutputIterator>
+inline OutputIterator basic_indexed_channel<ChannelT>::summarize(
+  const time_type &t0, const time_type &t1, size_type buckets,
+  OutputIterator out) const
+{
+  size_type first = ch.index_at(t0);
+  size_type last = ch.index_at(t1);
+
+  return summarize(first,last < first ? first : last,buckets,out);
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::const_iterator
+basic_indexed_channel<ChannelT>::position(size_type n) const
+{
+  const_iterator res = ch.begin();
+  std::advance(res,n);
+  return res;
+}
+
+template<typename ChannelT>
+inline typename ChannelT::iterator
+basic_indexed_channel<ChannelT>::mutable_position(size_type n)
+{
+  typename ChannelT::iterator res = ch.begin();
+  std::advance(res,n);
+  return res;
+}
+
+template<typename ChannelT>
+inline typename basic_indexed_channel<ChannelT>::node_type
+basic_indexed_channel<ChannelT>::leaf(size_type blk) const
+{
+  accumulator_type acc;
+  const_iterator cur = position(blk*block_size(0));
+  for(size_type i=0; i<block_size(0); ++i, ++cur)
+    acc.add(*cur);
+
+  return node_type(acc.min,acc.max,acc.sum);
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::push_node(std::size_t level,
+  const node_type &node)
+{
+  // carry completed pairs upward
+  for(node_type cur = node; ; ++level) {
+    if(pyramid.size() == level)
+      pyramid.push_back(std::vector<node_type>());
+
+    std::vector<node_type> &nodes = pyramid[level];
+    nodes.push_back(cur);
+
+    size_type idx = nodes.size()-1;
+    if(!(idx & 1) || (level+1 < pyramid.size() &&
+      pyramid[level+1].size() > idx/2))
+    {
+      break;
+    }
+
+    cur = node_type::combine(nodes[idx-1],nodes[idx]);
+  }
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::extend(void)
+{
+  size_type complete = ch.size() >> shift;
+  size_type blk = pyramid.empty() ? 0 : pyramid[0].size();
+
+  for(; blk<complete; ++blk)
+    push_node(0,leaf(blk));
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::truncate(size_type n)
+{
+  // keep only the nodes that lie entirely before n
+  for(std::size_t level=0; level<pyramid.size(); ++level) {
+    size_type keep = n >> (shift+level);
+    if(pyramid[level].size() > keep)
+      pyramid[level].resize(keep);
+  }
+
+  while(!pyramid.empty() && pyramid.back().empty())
+    pyramid.pop_back();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::refresh(size_type n)
+{
+  size_type blk = n >> shift;
+  if(pyramid.empty() || blk >= pyramid[0].size())
+    return;
+
+  pyramid[0][blk] = leaf(blk);
+  for(std::size_t level=1; level<pyramid.size(); ++level) {
+    blk >>= 1;
+    if(blk >= pyramid[level].size())
+      break;
+
+    const std::vector<node_type> &below = pyramid[level-1];
+    pyramid[level][blk] = node_type::combine(below[2*blk],below[2*blk+1]);
+  }
+}
+
+template<typename ChannelT>
+inline bool basic_indexed_channel<ChannelT>::fits(std::size_t level,
+  size_type pos, size_type last) const
+{
+  return pos+block_size(level) <= last &&
+    (pos >> (shift+level)) < pyramid[level].size();
+}
+
+template<typename ChannelT>
+inline void basic_indexed_channel<ChannelT>::accumulate(accumulator_type &acc,
+  const_iterator &cur, size_type &cur_pos, std::size_t &level,
+  size_type first, size_type last) const
+{
+  // pos is aligned to the node size of level whenever level > 0, so the
+  // level only climbs while the parent node is aligned at pos and fits,
+  // and otherwise descends, O(log n) steps per call
+  size_type pos = first;
+  while(pos < last) {
+    if(!pyramid.empty() && (pos & (block_size(0)-1)) == 0) {
+      while(level+1 < pyramid.size() &&
+        (pos & (block_size(level+1)-1)) == 0 && fits(level+1,pos,last))
+      {
+        ++level;
+      }
+
+      while(level > 0 && !fits(level,pos,last))
+        --level;
+
+      if(fits(level,pos,last)) {
+        acc.add(pyramid[level][pos >> (shift+level)],block_size(level));
+        pos += block_size(level);
+        continue;
+      }
+    }
+
+    level = 0;
+
+    // raw samples up to the next leaf boundary or last
+    size_type stop = ((pos >> shift)+1) << shift;
+    if(stop > last)
+      stop = last;
+
+    if(cur_pos > pos) {
+      cur = ch.begin();
+      cur_pos = 0;
+    }
+
+    std::advance(cur,pos-cur_pos);
+    cur_pos = pos;
+    for(; cur_pos<stop; ++cur_pos, ++cur)
+      acc.add(*cur);
+
+    pos = stop;
+  }
+}
+
+}
+}
+
+
+#endif
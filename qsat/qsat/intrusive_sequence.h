@@ -0,0 +1,1175 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_INTRUSIVE_SEQUENCE_H
+#define LEMMA_QSAT_INTRUSIVE_SEQUENCE_H
+
+#include "basic_channel.h"
+
+#include <boost/mpl/bool.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/** \file
+ *  \brief Implementation of basic_intrusive_sequence, a random-access
+ *    sequence stored in a single reference counted allocation
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+template<typename C>
+class intrusive_sequence_ptr;
+
+/** \brief Thread-safe reference count policy of basic_intrusive_sequence
+ *  \internal
+ */
+struct atomic_ref_count {
+  typedef std::atomic<std::size_t> type;
+
+  static void increment(type &count) {
+    count.fetch_add(1,std::memory_order_relaxed);
+  }
+
+  static std::size_t decrement(type &count) {
+    return count.fetch_sub(1,std::memory_order_acq_rel)-1;
+  }
+
+  static std::size_t load(const type &count) {
+    return count.load(std::memory_order_acquire);
+  }
+};
+
+/** \brief Thread-confined reference count policy of basic_intrusive_sequence
+ *  \internal
+ */
+struct local_ref_count {
+  typedef std::size_t type;
+
+  static void increment(type &count) {
+    ++count;
+  }
+
+  static std::size_t decrement(type &count) {
+    return --count;
+  }
+
+  static std::size_t load(const type &count) {
+    return count;
+  }
+};
+
+/** \brief Header placed at the start of a basic_intrusive_sequence
+ *    allocation, immediately followed by the elements
+ *  \internal
+ */
+template<typename Counter, typename SizeT>
+struct intrusive_header {
+  explicit intrusive_header(SizeT cap) :refs(1), size(0), capacity(cap) {}
+
+  typename Counter::type refs;
+  SizeT size;
+  SizeT capacity;
+};
+
+}
+
+/** \brief Random-access sequence whose reference count, size, capacity and
+ *    elements are stored in a single allocation
+ *  \tparam T The element type
+ *  \tparam A The allocator used for storage
+ *  \tparam Counter The reference count policy, detail::atomic_ref_count or
+ *    detail::local_ref_count
+ *
+ *  Model of std::sequence with optional members
+ *
+ *  \par Discussion
+ *  basic_intrusive_sequence is a value type: copying it copies the elements,
+ *  just like <code>std::vector</code>. Its storage however begins with a
+ *  header holding a reference count, which allows basic_channel to share the
+ *  storage between channel copies without a separate container object or
+ *  shared_ptr control block. A basic_channel using a vector for storage
+ *  requires two allocations (the container with its reference count and the
+ *  element array) and two pointer hops to reach a sample. Using
+ *  basic_intrusive_sequence it requires one of each, and an empty channel
+ *  requires no allocation at all. This matters most for large numbers of
+ *  short lived channels.
+ *
+ *  \par
+ *  Use the intrusive_sequence alias where copies of a channel may be used
+ *  from multiple threads. Use local_intrusive_sequence, whose reference count
+ *  is not atomic, when all copies of a channel are confined to one thread.
+ *  \code
+ *  typedef basic_channel<float,float,float,intrusive_sequence> channel_type;
+ *  typedef basic_channel<float,float,float,local_intrusive_sequence>
+ *    local_channel_type;
+ *  \endcode
+ */
+template<typename T, typename A, typename Counter>
+class basic_intrusive_sequence {
+  private:
+    typedef std::allocator_traits<A> alloc_traits;
+
+  public:
+    /** lvalue of T */
+    typedef T & reference;
+    /** const lvalue of T */
+    typedef const T & const_reference;
+    /** iterator type pointing to T */
+    typedef T * iterator;
+    /** iterator type pointing to const T */
+    typedef const T * const_iterator;
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** T */
+    typedef T value_type;
+    /** Allocator */
+    typedef A allocator_type;
+    /** type modeling pointer to T */
+    typedef T * pointer;
+    /** type modeling pointer to const T */
+    typedef const T * const_pointer;
+    /** reverse_iterator type pointing to T */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type pointing to const T */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** \brief Default Constructor
+     *
+     *  Does not allocate
+     *
+     *  \param alloc The allocator used for storage
+     */
+    explicit basic_intrusive_sequence(
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Fill Constructor
+     *  \param n The number of copies of \e value to make
+     *  \param value The value to copy
+     *  \param alloc The allocator used for storage
+     *  \post size() == \e n
+     */
+    explicit basic_intrusive_sequence(size_type n, const T &value = T(),
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Constructor
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \param alloc The allocator used for storage
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    basic_intrusive_sequence(InputIterator first, InputIterator last,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Copy Constructor
+     *
+     *  Copies the elements of \e rhs into a new allocation
+     *
+     *  \param rhs rvalue of type basic_intrusive_sequence
+     */
+    basic_intrusive_sequence(const basic_intrusive_sequence &rhs);
+
+    /** \brief Move Constructor
+     *  \param rhs basic_intrusive_sequence whose storage is taken
+     *  \post rhs.empty()
+     */
+    basic_intrusive_sequence(basic_intrusive_sequence &&rhs) noexcept;
+
+    /** \brief Destructor
+     *
+     *  Releases this reference to the storage
+     */
+    ~basic_intrusive_sequence(void);
+
+    /** \brief Assignment Operator
+     *  \param rhs rvalue of type basic_intrusive_sequence
+     *  \return <code>*this</code>
+     */
+    basic_intrusive_sequence & operator=(const basic_intrusive_sequence &rhs);
+
+    /** \brief Move Assignment Operator
+     *  \param rhs basic_intrusive_sequence whose storage is taken
+     *  \return <code>*this</code>
+     */
+    basic_intrusive_sequence & operator=(basic_intrusive_sequence &&rhs);
+
+    /** \brief Range Assignment Operator
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \post size() = <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /** \brief Fill Assignment Operator
+     *  \param n The number of <em>val</em> object to assign to this sequence
+     *  \param val The value of the objects that are assigned to this
+     *  \post size() = <em>n</em>
+     */
+    void assign(size_type n, const T &val);
+
+    /** \brief Obtain the allocator used for storage
+     *  \return A copy of the allocator
+     */
+    allocator_type get_allocator(void) const;
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to T
+     */
+    iterator begin(void);
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to const T
+     */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to T
+     */
+    iterator end(void);
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to const T
+     */
+    const_iterator end(void) const;
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rbegin(void);
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rbegin(void) const;
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rend(void);
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rend(void) const;
+
+    /** \brief Obtain the number of elements contained in the sequence
+     *  \return sequence size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain the maximum number of elements that can be held in
+     *    this sequence
+     *  \return sequence maximum size
+     */
+    size_type max_size(void) const;
+
+    /** \brief Resize the sequence
+     *  \param sz The new sequence size
+     *  \param val The value of the new objects copied to the end of the
+     *    sequence
+     */
+    void resize(size_type sz, const T &val = T());
+
+    /** \brief Obtain the total number of elements that this sequence can hold
+     *    without requiring reallocation
+     *  \return sequence storage capacity
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain whether or not the sequence contains any values
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Ensure that <EM>n</EM> elements can be contained in the
+     *    sequence without reallocation occuring
+     *  \param n the new capacity
+     */
+    void reserve(size_type n);
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     */
+    reference operator[](size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    reference at(size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element reference
+     */
+    reference front(void);
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element const_reference
+     */
+    const_reference front(void) const;
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element reference
+     */
+    reference back(void);
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element const_reference
+     */
+    const_reference back(void) const;
+
+    /** \brief Add a new element at the end of the sequence
+     *
+     *  Capacity grows geometrically.
+     *
+     *  \param val The value of the new element
+     */
+    void push_back(const T &val);
+
+    /** \brief Remove the last element of the sequence
+     */
+    void pop_back(void);
+
+    /** \brief Insert a new element into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param val The value of the new element
+     *  \return Iterator pointing to the new element
+     */
+    iterator insert(iterator position, const T &val);
+
+    /** \brief Insert <em>n</em> elements into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param n The number of new elements
+     *  \param val The value of the new elements
+     */
+    void insert(iterator position, size_type n, const T &val);
+
+    /** \brief Insert elements in the range <em>[first,last)</em>
+     *    into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     */
+    template<typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last);
+
+    /** \brief Remove the element pointed to by <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \return Iterator pointing to the element following the erased element
+     */
+    iterator erase(iterator position);
+
+    /** \brief Remove the elements in the range <em>[first,last)</em>
+     *  \param first,last An iterator range in the sequence
+     *  \return Iterator pointing to the element following the erased elements
+     */
+    iterator erase(iterator first, iterator last);
+
+    /** \brief Swap the contents of this sequence with <em>rhs</em>
+     *  \param rhs The sequence to swap with
+     */
+    void swap(basic_intrusive_sequence &rhs);
+
+    /** \brief Remove all elements of the sequence
+     *
+     *  The capacity is left unchanged
+     */
+    void clear(void);
+
+    /** \brief Obtain the number of references to the storage of this
+     *    sequence
+     *
+     *  References beyond the first are only created by the storage policy of
+     *  basic_channel when channels are copied.
+     *
+     *  \return The reference count or zero if no storage is allocated
+     */
+    size_type use_count(void) const;
+
+  private:
+    template<typename C>
+    friend class detail::intrusive_sequence_ptr;
+
+    typedef detail::intrusive_header<Counter,size_type> header_type;
+
+    static const std::size_t alignment =
+      (std::alignment_of<T>::value > std::alignment_of<header_type>::value ?
+        std::alignment_of<T>::value : std::alignment_of<header_type>::value);
+
+    typedef typename std::aligned_storage<alignment,alignment>::type unit_type;
+    typedef typename alloc_traits::template rebind_alloc<unit_type>
+      unit_allocator;
+    typedef std::allocator_traits<unit_allocator> unit_traits;
+
+    static const size_type header_units =
+      (sizeof(header_type)+sizeof(unit_type)-1)/sizeof(unit_type);
+
+    struct share_tag {};
+
+    A alloc;
+    header_type *block;
+
+    basic_intrusive_sequence(const basic_intrusive_sequence &rhs, share_tag);
+
+    static size_type block_units(size_type cap);
+    static T * elements(header_type *blk);
+
+    header_type * allocate_block(size_type cap);
+    void deallocate_block(header_type *blk);
+
+    void destroy(T *first, T *last);
+    void release(void);
+    void relocate(header_type *blk, size_type constructed = 0);
+    void grow(size_type n);
+
+    template<typename InputIterator>
+    void append_range(InputIterator first, InputIterator last,
+      std::input_iterator_tag);
+
+    template<typename ForwardIterator>
+    void append_range(ForwardIterator first, ForwardIterator last,
+      std::forward_iterator_tag);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::true_);
+};
+
+/** \brief Random-access sequence in a single allocation with a thread-safe
+ *    reference count
+ */
+template<typename T, typename A = std::allocator<T> >
+using intrusive_sequence =
+  basic_intrusive_sequence<T,A,detail::atomic_ref_count>;
+
+/** \brief Random-access sequence in a single allocation with a reference
+ *    count for use by a single thread
+ */
+template<typename T, typename A = std::allocator<T> >
+using local_intrusive_sequence =
+  basic_intrusive_sequence<T,A,detail::local_ref_count>;
+
+/** \brief Compare two sequences element by element
+ *  \return <code>true</code> if the sequences are equal
+ */
+template<typename T, typename A, typename Counter>
+bool operator==(const basic_intrusive_sequence<T,A,Counter> &lhs,
+  const basic_intrusive_sequence<T,A,Counter> &rhs);
+
+/** \brief Compare two sequences element by element
+ *  \return <code>true</code> if the sequences are not equal
+ */
+template<typename T, typename A, typename Counter>
+bool operator!=(const basic_intrusive_sequence<T,A,Counter> &lhs,
+  const basic_intrusive_sequence<T,A,Counter> &rhs);
+
+/** \brief Swap the contents of two basic_intrusive_sequence objects
+ */
+template<typename T, typename A, typename Counter>
+void swap(basic_intrusive_sequence<T,A,Counter> &lhs,
+  basic_intrusive_sequence<T,A,Counter> &rhs);
+
+
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(const allocator_type &a) :alloc(a), block(0)
+{
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(size_type n, const T &value,
+    const allocator_type &a) :alloc(a), block(0)
+{
+  insert(end(),n,value);
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(InputIterator first, InputIterator last,
+    const allocator_type &a) :alloc(a), block(0)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(const basic_intrusive_sequence &rhs)
+    :alloc(alloc_traits::select_on_container_copy_construction(rhs.alloc)),
+      block(0)
+{
+  append_range(rhs.begin(),rhs.end(),std::random_access_iterator_tag());
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(basic_intrusive_sequence &&rhs) noexcept
+    :alloc(rhs.alloc), block(rhs.block)
+{
+  rhs.block = 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::
+  basic_intrusive_sequence(const basic_intrusive_sequence &rhs, share_tag)
+    :alloc(rhs.alloc), block(rhs.block)
+{
+  if(block)
+    Counter::increment(block->refs);
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter>::~basic_intrusive_sequence(void)
+{
+  release();
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter> &
+basic_intrusive_sequence<T,A,Counter>::
+  operator=(const basic_intrusive_sequence &rhs)
+{
+  if(&rhs != this)
+    assign(rhs.begin(),rhs.end());
+
+  return *this;
+}
+
+template<typename T, typename A, typename Counter>
+inline basic_intrusive_sequence<T,A,Counter> &
+basic_intrusive_sequence<T,A,Counter>::
+  operator=(basic_intrusive_sequence &&rhs)
+{
+  swap(rhs);
+  return *this;
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::assign(InputIterator first,
+  InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::assign(size_type n,
+  const T &val)
+{
+  T tmp(val);
+  clear();
+  insert(end(),n,tmp);
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::allocator_type
+basic_intrusive_sequence<T,A,Counter>::get_allocator(void) const
+{
+  return alloc;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::iterator
+basic_intrusive_sequence<T,A,Counter>::begin(void)
+{
+  return block ? elements(block) : 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_iterator
+basic_intrusive_sequence<T,A,Counter>::begin(void) const
+{
+  return block ? elements(block) : 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::iterator
+basic_intrusive_sequence<T,A,Counter>::end(void)
+{
+  return begin()+size();
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_iterator
+basic_intrusive_sequence<T,A,Counter>::end(void) const
+{
+  return begin()+size();
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reverse_iterator
+basic_intrusive_sequence<T,A,Counter>::rbegin(void)
+{
+  return reverse_iterator(end());
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reverse_iterator
+basic_intrusive_sequence<T,A,Counter>::rbegin(void) const
+{
+  return const_reverse_iterator(end());
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reverse_iterator
+basic_intrusive_sequence<T,A,Counter>::rend(void)
+{
+  return reverse_iterator(begin());
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reverse_iterator
+basic_intrusive_sequence<T,A,Counter>::rend(void) const
+{
+  return const_reverse_iterator(begin());
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::size_type
+basic_intrusive_sequence<T,A,Counter>::size(void) const
+{
+  return block ? block->size : 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::size_type
+basic_intrusive_sequence<T,A,Counter>::max_size(void) const
+{
+  return (unit_traits::max_size(unit_allocator(alloc))-header_units)*
+    sizeof(unit_type)/sizeof(T);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::resize(size_type sz,
+  const T &val)
+{
+  if(sz < size())
+    erase(begin()+sz,end());
+  else
+    insert(end(),sz-size(),val);
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::size_type
+basic_intrusive_sequence<T,A,Counter>::capacity(void) const
+{
+  return block ? block->capacity : 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline bool basic_intrusive_sequence<T,A,Counter>::empty(void) const
+{
+  return size() == 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::reserve(size_type n)
+{
+  if(n > capacity())
+    relocate(allocate_block(n));
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reference
+basic_intrusive_sequence<T,A,Counter>::operator[](size_type n)
+{
+  return begin()[n];
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reference
+basic_intrusive_sequence<T,A,Counter>::operator[](size_type n) const
+{
+  return begin()[n];
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reference
+basic_intrusive_sequence<T,A,Counter>::at(size_type n)
+{
+  if(n >= size())
+    throw std::out_of_range("basic_intrusive_sequence::at");
+
+  return begin()[n];
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reference
+basic_intrusive_sequence<T,A,Counter>::at(size_type n) const
+{
+  if(n >= size())
+    throw std::out_of_range("basic_intrusive_sequence::at");
+
+  return begin()[n];
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reference
+basic_intrusive_sequence<T,A,Counter>::front(void)
+{
+  return *begin();
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reference
+basic_intrusive_sequence<T,A,Counter>::front(void) const
+{
+  return *begin();
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::reference
+basic_intrusive_sequence<T,A,Counter>::back(void)
+{
+  return *(end()-1);
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::const_reference
+basic_intrusive_sequence<T,A,Counter>::back(void) const
+{
+  return *(end()-1);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::push_back(const T &val)
+{
+  if(size() == capacity()) {
+    // val may refer to an element of this sequence
+    T tmp(val);
+    grow(size()+1);
+    alloc_traits::construct(alloc,end(),std::move(tmp));
+  }
+  else
+    alloc_traits::construct(alloc,end(),val);
+
+  ++block->size;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::pop_back(void)
+{
+  destroy(end()-1,end());
+  --block->size;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::iterator
+basic_intrusive_sequence<T,A,Counter>::insert(iterator position,
+  const T &val)
+{
+  difference_type off = position-begin();
+  push_back(val);
+  std::rotate(begin()+off,end()-1,end());
+
+  return begin()+off;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::insert(iterator position,
+  size_type n, const T &val)
+{
+  if(!n)
+    return;
+
+  difference_type off = position-begin();
+  T tmp(val);
+  grow(size()+n);
+  std::uninitialized_fill_n(end(),n,tmp);
+  block->size += n;
+  std::rotate(begin()+off,end()-n,end());
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::insert(iterator position,
+  InputIterator first, InputIterator last)
+{
+  insert_thunk(position,first,last,
+    typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::iterator
+basic_intrusive_sequence<T,A,Counter>::erase(iterator position)
+{
+  return erase(position,position+1);
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::iterator
+basic_intrusive_sequence<T,A,Counter>::erase(iterator first, iterator last)
+{
+  if(first != last) {
+    iterator tail = std::move(last,end(),first);
+    destroy(tail,end());
+    block->size -= last-first;
+  }
+
+  return first;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::
+  swap(basic_intrusive_sequence &rhs)
+{
+  std::swap(alloc,rhs.alloc);
+  std::swap(block,rhs.block);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::clear(void)
+{
+  if(block) {
+    destroy(begin(),end());
+    block->size = 0;
+  }
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::size_type
+basic_intrusive_sequence<T,A,Counter>::use_count(void) const
+{
+  return block ? Counter::load(block->refs) : 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::size_type
+basic_intrusive_sequence<T,A,Counter>::block_units(size_type cap)
+{
+  return header_units + (cap*sizeof(T)+sizeof(unit_type)-1)/sizeof(unit_type);
+}
+
+template<typename T, typename A, typename Counter>
+inline T * basic_intrusive_sequence<T,A,Counter>::elements(header_type *blk)
+{
+  return reinterpret_cast<T*>(reinterpret_cast<unit_type*>(blk)+header_units);
+}
+
+template<typename T, typename A, typename Counter>
+inline typename basic_intrusive_sequence<T,A,Counter>::header_type *
+basic_intrusive_sequence<T,A,Counter>::allocate_block(size_type cap)
+{
+  unit_allocator ualloc(alloc);
+  unit_type *units = unit_traits::allocate(ualloc,block_units(cap));
+
+  return ::new(static_cast<void*>(units)) header_type(cap);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::
+  deallocate_block(header_type *blk)
+{
+  size_type units = block_units(blk->capacity);
+  blk->~header_type();
+
+  unit_allocator ualloc(alloc);
+  unit_traits::deallocate(ualloc,reinterpret_cast<unit_type*>(blk),units);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::destroy(T *first, T *last)
+{
+  for(; first != last; ++first)
+    alloc_traits::destroy(alloc,first);
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::release(void)
+{
+  if(block && Counter::decrement(block->refs) == 0) {
+    destroy(begin(),end());
+    deallocate_block(block);
+  }
+
+  block = 0;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::relocate(header_type *blk,
+  size_type constructed)
+{
+  // The caller may have already constructed elements immediately following
+  // size() in blk. They are destroyed along with blk on failure.
+  try {
+    std::uninitialized_copy(std::make_move_iterator(begin()),
+      std::make_move_iterator(end()),elements(blk));
+  }
+  catch(...) {
+    destroy(elements(blk)+size(),elements(blk)+size()+constructed);
+    deallocate_block(blk);
+    throw;
+  }
+
+  blk->size = size();
+  release();
+  block = blk;
+}
+
+template<typename T, typename A, typename Counter>
+inline void basic_intrusive_sequence<T,A,Counter>::grow(size_type n)
+{
+  if(n > capacity())
+    relocate(allocate_block(std::max(n,2*capacity())));
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::append_range(
+  InputIterator first, InputIterator last, std::input_iterator_tag)
+{
+  while(first != last)
+    push_back(*first++);
+}
+
+template<typename T, typename A, typename Counter>
+template<typename ForwardIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::append_range(
+  ForwardIterator first, ForwardIterator last, std::forward_iterator_tag)
+{
+  size_type n = std::distance(first,last);
+  if(!n)
+    return;
+
+  if(size()+n <= capacity()) {
+    std::uninitialized_copy(first,last,end());
+    block->size += n;
+    return;
+  }
+
+  // [first,last) may refer to elements of this sequence so construct the
+  // new elements before the current storage is released
+  header_type *blk = allocate_block(std::max(size()+n,2*capacity()));
+  T *tail = elements(blk)+size();
+  try {
+    std::uninitialized_copy(first,last,tail);
+  }
+  catch(...) {
+    deallocate_block(blk);
+    throw;
+  }
+
+  relocate(blk,n);
+  block->size += n;
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::assign_thunk(
+  InputIterator first, InputIterator last, mpl::false_)
+{
+  clear();
+  append_range(first,last,
+    typename std::iterator_traits<InputIterator>::iterator_category());
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::assign_thunk(
+  InputIterator first, InputIterator last, mpl::true_)
+{
+  assign(size_type(first),T(last));
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::insert_thunk(
+  iterator position, InputIterator first, InputIterator last, mpl::false_)
+{
+  difference_type off = position-begin();
+  size_type len = size();
+
+  append_range(first,last,
+    typename std::iterator_traits<InputIterator>::iterator_category());
+  std::rotate(begin()+off,begin()+len,end());
+}
+
+template<typename T, typename A, typename Counter>
+template<typename InputIterator>
+inline void basic_intrusive_sequence<T,A,Counter>::insert_thunk(
+  iterator position, InputIterator first, InputIterator last, mpl::true_)
+{
+  insert(position,size_type(first),T(last));
+}
+
+template<typename T, typename A, typename Counter>
+inline bool operator==(const basic_intrusive_sequence<T,A,Counter> &lhs,
+  const basic_intrusive_sequence<T,A,Counter> &rhs)
+{
+  return lhs.size() == rhs.size() &&
+    std::equal(lhs.begin(),lhs.end(),rhs.begin());
+}
+
+template<typename T, typename A, typename Counter>
+inline bool operator!=(const basic_intrusive_sequence<T,A,Counter> &lhs,
+  const basic_intrusive_sequence<T,A,Counter> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+template<typename T, typename A, typename Counter>
+inline void swap(basic_intrusive_sequence<T,A,Counter> &lhs,
+  basic_intrusive_sequence<T,A,Counter> &rhs)
+{
+  lhs.swap(rhs);
+}
+
+
+
+namespace detail {
+
+/** \brief Reference counted pointer to a basic_intrusive_sequence used as
+ *    the shared representation of basic_channel
+ *  \internal Copies share the storage of the sequence by incrementing the
+ *    reference count in its header. The pointer holds the sequence by value
+ *    so reaching an element from a basic_channel is a single pointer hop.
+ */
+template<typename C>
+class intrusive_sequence_ptr {
+  public:
+    intrusive_sequence_ptr(void) {}
+
+    explicit intrusive_sequence_ptr(C &&seq) :sequence(std::move(seq)) {}
+
+    intrusive_sequence_ptr(const intrusive_sequence_ptr &rhs)
+      :sequence(rhs.sequence,typename C::share_tag()) {}
+
+    intrusive_sequence_ptr(intrusive_sequence_ptr &&rhs) noexcept
+      :sequence(std::move(rhs.sequence)) {}
+
+    intrusive_sequence_ptr & operator=(const intrusive_sequence_ptr &rhs) {
+      intrusive_sequence_ptr tmp(rhs);
+      swap(tmp);
+      return *this;
+    }
+
+    intrusive_sequence_ptr & operator=(intrusive_sequence_ptr &&rhs) {
+      swap(rhs);
+      return *this;
+    }
+
+    C & operator*(void) {
+      return sequence;
+    }
+
+    const C & operator*(void) const {
+      return sequence;
+    }
+
+    C * operator->(void) {
+      return &sequence;
+    }
+
+    const C * operator->(void) const {
+      return &sequence;
+    }
+
+    /** An empty sequence has no storage to share and allocates its own on
+     *  first modification.
+     */
+    bool unique(void) const {
+      return sequence.use_count() <= 1;
+    }
+
+    void swap(intrusive_sequence_ptr &rhs) {
+      sequence.swap(rhs.sequence);
+    }
+
+    bool operator==(const intrusive_sequence_ptr &rhs) const {
+      return sequence.block == rhs.sequence.block;
+    }
+
+  private:
+    C sequence;
+};
+
+/** \brief Store basic_intrusive_sequence by value and share its storage
+ *    through the reference count in its header
+ *  \internal
+ */
+template<typename T, typename A, typename Counter>
+struct sequence_storage<basic_intrusive_sequence<T,A,Counter> > {
+  typedef basic_intrusive_sequence<T,A,Counter> container_type;
+  typedef intrusive_sequence_ptr<container_type> pointer;
+
+  template<typename... Args>
+  static pointer make(Args &&...args) {
+    return pointer(container_type(std::forward<Args>(args)...));
+  }
+};
+
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,702 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_IRREGULAR_CHANNEL_H
+#define LEMMA_QSAT_IRREGULAR_CHANNEL_H
+
+#include "basic_channel.h"
+#include "resample.h"
+#include "detail/value_cast.h"
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/static_assert.hpp>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+
+/** \file
+ *  \brief Implementation of channels with irregularly spaced samples
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \internal Minimum number of unindexed samples before the timestamp
+ *  index is rebuilt
+ */
+static const std::size_t irregular_index_min = 1024;
+
+/** \brief Eytzinger (breadth first) layout of a sorted sequence of keys
+ *  \internal
+ *  The keys are the first timestamp of each block of samples filling a
+ *  cache line. The tree is padded to a perfect tree with copies of the
+ *  largest key so that the rank of a node follows from its position. A
+ *  search descends without branching on the comparison and touches one
+ *  cache line per level for the top levels, unlike a binary search over
+ *  the timestamps themselves which touches a new line at every step.
+ */
+template<typename T>
+class eytzinger_index {
+  public:
+    eytzinger_index(void) :height(0) {}
+
+    template<typename RandomAccessIterator>
+    void assign(RandomAccessIterator first, std::size_t n);
+
+    void clear(void) {
+      keys.clear();
+      height = 0;
+    }
+
+    bool empty(void) const {
+      return keys.empty();
+    }
+
+    /** the rank of the first key not less than \e key, or the number of
+     *  keys if there is none
+     */
+    std::size_t lower_bound(const T &key, std::size_t n) const;
+
+  private:
+    // 1-based, keys[0] is unused
+    std::vector<T> keys;
+    unsigned int height;
+
+    template<typename RandomAccessIterator>
+    void fill(RandomAccessIterator first, std::size_t n, std::size_t &rank,
+      std::size_t k);
+};
+
+template<typename T>
+template<typename RandomAccessIterator>
+inline void eytzinger_index<T>::assign(RandomAccessIterator first,
+  std::size_t n)
+{
+  clear();
+  if(!n)
+    return;
+
+  height = 1;
+  while((std::size_t(1) << height) - 1 < n)
+    ++height;
+
+  keys.resize(std::size_t(1) << height);
+
+  std::size_t rank = 0;
+  fill(first,n,rank,1);
+}
+
+template<typename T>
+template<typename RandomAccessIterator>
+inline void eytzinger_index<T>::fill(RandomAccessIterator first,
+  std::size_t n, std::size_t &rank, std::size_t k)
+{
+  if(k >= keys.size())
+    return;
+
+  fill(first,n,rank,2*k);
+  keys[k] = first[rank < n ? rank : n-1];
+  ++rank;
+  fill(first,n,rank,2*k+1);
+}
+
+template<typename T>
+inline std::size_t eytzinger_index<T>::lower_bound(const T &key,
+  std::size_t n) const
+{
+  std::size_t k = 1;
+  while(k < keys.size())
+    k = 2*k + (keys[k] < key);
+
+  // undo the right turns taken after the last left turn
+  while(k & 1)
+    k >>= 1;
+  k >>= 1;
+
+  if(!k)
+    return n;
+
+  unsigned int depth = 0;
+  while((std::size_t(2) << depth) <= k)
+    ++depth;
+
+  return ((2*(k - (std::size_t(1) << depth)) + 1) << (height-1-depth)) - 1;
+}
+
+}
+
+template<typename ChannelT>
+class basic_irregular_subchannel;
+
+/** \brief Channel of samples with individual, nondecreasing timestamps
+ *
+ *  \tparam MagnitudeT The sample type
+ *  \tparam TimeT The timestamp type
+ *  \tparam Container A random access sequence used for both the samples
+ *    and the timestamps
+ *  \tparam Allocator The allocator of both containers
+ *
+ *  \par Discussion
+ *  Samples and timestamps are stored as two parallel columns so a channel
+ *  costs exactly one MagnitudeT and one TimeT per sample. Time queries,
+ *  index_at() and subchannel(), search the timestamp column through a
+ *  cache friendly Eytzinger index over the first timestamp of each cache
+ *  line, followed by a search of the one line found. The index is kept up
+ *  to date by push_back() in amortized constant time. Samples appended
+ *  since the last rebuild are searched directly.
+ *
+ *  Unlike basic_channel, a basic_irregular_channel is not copy-on-write.
+ *  Use to_channel() to obtain a uniformly sampled basic_channel.
+ *
+ *  \code
+ *  basic_irregular_channel<float,double> ch;
+ *  ch.push_back(0.0,1.0f);
+ *  ch.push_back(0.013,2.0f);
+ *  ch.push_back(0.031,1.5f);
+ *
+ *  basic_irregular_channel<float,double>::const_subchannel_type sub =
+ *    ch.subchannel(0.01,0.05);
+ *  \endcode
+ */
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container = std::vector,
+  template<typename T> class Allocator = std::allocator>
+class basic_irregular_channel {
+  public:
+    /** Container of samples */
+    typedef Container<MagnitudeT,Allocator<MagnitudeT> > container_type;
+    /** Container of timestamps */
+    typedef Container<TimeT,Allocator<TimeT> > time_container_type;
+    /** const lvalue of MagnitudeT */
+    typedef typename container_type::const_reference const_reference;
+    /** iterator type pointing to const MagnitudeT */
+    typedef typename container_type::const_iterator const_iterator;
+    /** iterator type pointing to const TimeT */
+    typedef typename time_container_type::const_iterator time_iterator;
+    /** unsigned integral type */
+    typedef typename container_type::size_type size_type;
+    /** signed integral type */
+    typedef typename container_type::difference_type difference_type;
+    /** MagnitudeT */
+    typedef typename container_type::value_type value_type;
+
+    /** This type */
+    typedef basic_irregular_channel channel_type;
+    /** MagnitudeT */
+    typedef MagnitudeT magnitude_type;
+    /** TimeT */
+    typedef TimeT time_type;
+
+    /** Subchannel type representing a const interval */
+    typedef basic_irregular_subchannel<basic_irregular_channel>
+      const_subchannel_type;
+
+    /** \brief Default Constructor
+     *  \post empty()
+     */
+    basic_irregular_channel(void) :indexed(0) {}
+
+    /** \brief Range Constructor
+     *  \param tfirst,tlast The timestamps of the samples
+     *  \param first The samples, one for each timestamp
+     *  \throws <CODE>std::invalid_argument</CODE> if the timestamps
+     *    decrease
+     *  \post size() == <code>std::distance(tfirst,tlast)</code>
+     */
+    template<typename TimeIterator, typename InputIterator>
+    basic_irregular_channel(TimeIterator tfirst, TimeIterator tlast,
+      InputIterator first);
+
+    /** \brief Append a sample
+     *  \param t The timestamp of \e val
+     *  \param val The sample
+     *  \throws <CODE>std::invalid_argument</CODE> if \e t is earlier than
+     *    the last timestamp
+     */
+    void push_back(const TimeT &t, const MagnitudeT &val);
+
+    /** \brief Remove all samples
+     *  \post empty()
+     */
+    void clear(void);
+
+    /** \brief Swap contents with \e rhs */
+    void swap(basic_irregular_channel &rhs);
+
+    /** \brief Obtain iterator to the first sample */
+    const_iterator begin(void) const {
+      return mags.begin();
+    }
+
+    /** \brief Obtain iterator to one past the last sample */
+    const_iterator end(void) const {
+      return mags.end();
+    }
+
+    /** \brief Obtain iterator to the first timestamp */
+    time_iterator time_begin(void) const {
+      return times.begin();
+    }
+
+    /** \brief Obtain iterator to one past the last timestamp */
+    time_iterator time_end(void) const {
+      return times.end();
+    }
+
+    /** \brief Obtain the number of samples */
+    size_type size(void) const {
+      return mags.size();
+    }
+
+    /** \brief Determine if there are no samples */
+    bool empty(void) const {
+      return mags.empty();
+    }
+
+    /** \brief Obtain the sample at \e n
+     *  \pre \e n < size()
+     */
+    const_reference operator[](size_type n) const {
+      return mags[n];
+    }
+
+    /** \brief Obtain the sample at \e n
+     *  \throws <CODE>std::out_of_range</CODE> if \e n >= size()
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the timestamp of the sample at \e n
+     *  \pre \e n < size()
+     */
+    const time_type & time_at(size_type n) const {
+      return times[n];
+    }
+
+    /** \brief Obtain the timestamp of the first sample
+     *  \pre !empty()
+     */
+    const time_type & epoch(void) const {
+      return times.front();
+    }
+
+    /** \brief Obtain the index of the first sample at or after \e t
+     *  \return A value in [0,size()]
+     */
+    size_type index_at(const time_type &t) const;
+
+    /** \brief Obtain the samples within a time interval
+     *  \param t0,t1 The time interval [\e t0, \e t1)
+     *  \return A subset over [<code>index_at(t0)</code>,
+     *    <code>index_at(t1)</code>)
+     */
+    const_subchannel_type subchannel(const time_type &t0,
+      const time_type &t1) const;
+
+  private:
+    time_container_type times;
+    container_type mags;
+
+    detail::eytzinger_index<TimeT> index;
+    size_type indexed;
+
+    static size_type block_size(void) {
+      return sizeof(TimeT) < 64 ? 64/sizeof(TimeT) : 1;
+    }
+
+    void rebuild_index(void);
+};
+
+
+
+/** \brief Const interval of a basic_irregular_channel
+ *
+ *  \par Discussion
+ *  The lifetime of the channel is not bound to the subchannel and the
+ *  subchannel is invalidated by any change to the channel's size.
+ */
+template<typename ChannelT>
+class basic_irregular_subchannel {
+  public:
+    typedef typename ChannelT::const_reference const_reference;
+    typedef typename ChannelT::const_iterator const_iterator;
+    typedef typename ChannelT::time_iterator time_iterator;
+    typedef typename ChannelT::size_type size_type;
+    typedef typename ChannelT::difference_type difference_type;
+    typedef typename ChannelT::value_type value_type;
+
+    /** Underlying channel type */
+    typedef ChannelT channel_type;
+    typedef typename ChannelT::magnitude_type magnitude_type;
+    typedef typename ChannelT::time_type time_type;
+    typedef basic_irregular_subchannel const_subchannel_type;
+
+    /** \brief Constructor
+     *  \param ch The channel
+     *  \param first,last The interval of \e ch as indices
+     */
+    basic_irregular_subchannel(const ChannelT &ch, size_type first,
+      size_type last) :base(&ch), sub_first(first), sub_last(last) {}
+
+    const_iterator begin(void) const {
+      return base->begin() + sub_first;
+    }
+
+    const_iterator end(void) const {
+      return base->begin() + sub_last;
+    }
+
+    time_iterator time_begin(void) const {
+      return base->time_begin() + sub_first;
+    }
+
+    time_iterator time_end(void) const {
+      return base->time_begin() + sub_last;
+    }
+
+    size_type size(void) const {
+      return sub_last - sub_first;
+    }
+
+    bool empty(void) const {
+      return sub_first == sub_last;
+    }
+
+    const_reference operator[](size_type n) const {
+      return (*base)[sub_first+n];
+    }
+
+    const time_type & time_at(size_type n) const {
+      return base->time_at(sub_first+n);
+    }
+
+    /** \pre !empty() */
+    const time_type & epoch(void) const {
+      return base->time_at(sub_first);
+    }
+
+    /** \brief Obtain the offset of the first sample within the channel */
+    size_type offset(void) const {
+      return sub_first;
+    }
+
+    /** \brief Obtain the index of the first sample at or after \e t
+     *  \return A value in [0,size()]
+     */
+    size_type index_at(const time_type &t) const {
+      size_type n = base->index_at(t);
+      return n < sub_first ? 0 : (n > sub_last ? size() : n - sub_first);
+    }
+
+    /** \brief Obtain the samples of this subchannel within a time
+     *    interval
+     */
+    const_subchannel_type subchannel(const time_type &t0,
+      const time_type &t1) const
+    {
+      size_type first = index_at(t0);
+      size_type last = index_at(t1);
+      if(last < first)
+        last = first;
+
+      return const_subchannel_type(*base,sub_first+first,sub_first+last);
+    }
+
+  private:
+    const ChannelT *base;
+    size_type sub_first;
+    size_type sub_last;
+};
+
+
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+template<typename TimeIterator, typename InputIterator>
+inline basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  basic_irregular_channel(TimeIterator tfirst, TimeIterator tlast,
+    InputIterator first) :times(tfirst,tlast), indexed(0)
+{
+  for(size_type i=1; i<times.size(); ++i) {
+    if(times[i] < times[i-1])
+      throw std::invalid_argument("basic_irregular_channel: timestamps "
+        "must be nondecreasing");
+  }
+
+  InputIterator last = first;
+  std::advance(last,times.size());
+  mags.assign(first,last);
+
+  rebuild_index();
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  push_back(const TimeT &t, const MagnitudeT &val)
+{
+  if(!times.empty() && t < times.back())
+    throw std::invalid_argument("basic_irregular_channel: timestamps "
+      "must be nondecreasing");
+
+  times.push_back(t);
+  try {
+    mags.push_back(val);
+  }
+  catch(...) {
+    times.pop_back();
+    throw;
+  }
+
+  size_type tail = times.size() - indexed;
+  if(tail >= detail::irregular_index_min && tail >= indexed)
+    rebuild_index();
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  clear(void)
+{
+  times.clear();
+  mags.clear();
+  index.clear();
+  indexed = 0;
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  swap(basic_irregular_channel &rhs)
+{
+  using std::swap;
+
+  times.swap(rhs.times);
+  mags.swap(rhs.mags);
+  swap(index,rhs.index);
+  swap(indexed,rhs.indexed);
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_irregular_channel<MagnitudeT,TimeT,Container,
+  Allocator>::const_reference
+basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  at(size_type n) const
+{
+  if(n >= size())
+    throw std::out_of_range("basic_irregular_channel: index out of range");
+
+  return mags[n];
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_irregular_channel<MagnitudeT,TimeT,Container,
+  Allocator>::size_type
+basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  index_at(const time_type &t) const
+{
+  time_iterator first = times.begin();
+  time_iterator last = times.end();
+
+  if(indexed) {
+    const size_type bs = block_size();
+    size_type blocks = indexed/bs;
+    size_type block = index.lower_bound(t,blocks);
+
+    // the first block starting at or after t, the answer is at its start
+    // or within the block before it
+    if(block < blocks) {
+      if(!block)
+        return 0;
+
+      last = first + block*bs;
+      first += (block-1)*bs;
+    }
+    else
+      first += (blocks-1)*bs;
+  }
+
+  return std::lower_bound(first,last,t) - times.begin();
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline typename basic_irregular_channel<MagnitudeT,TimeT,Container,
+  Allocator>::const_subchannel_type
+basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  subchannel(const time_type &t0, const time_type &t1) const
+{
+  size_type first = index_at(t0);
+  size_type last = index_at(t1);
+  if(last < first)
+    last = first;
+
+  return const_subchannel_type(*this,first,last);
+}
+
+template<typename MagnitudeT, typename TimeT,
+  template<typename T, typename A> class Container,
+  template<typename T> class Allocator>
+inline void basic_irregular_channel<MagnitudeT,TimeT,Container,Allocator>::
+  rebuild_index(void)
+{
+  const size_type bs = block_size();
+  size_type blocks = times.size()/bs;
+
+  std::vector<TimeT> keys;
+  keys.reserve(blocks);
+  for(size_type i=0; i<blocks; ++i)
+    keys.push_back(times[i*bs]);
+
+  index.assign(keys.begin(),blocks);
+  indexed = blocks*bs;
+}
+
+/** \brief Convert an irregularly sampled channel to a uniform one
+ *  \tparam ChannelT The basic_channel type of the result. Its
+ *    magnitude_type must be arithmetic.
+ *  \param ch A basic_irregular_channel or basic_irregular_subchannel with
+ *    arithmetic timestamps
+ *  \param freq The sample frequency of the result
+ *  \param zero_crossings As for resample()
+ *  \return A channel with epoch <code>ch.epoch()</code> covering
+ *    [<code>ch.epoch()</code>, last timestamp of \e ch]
+ *  \throws <CODE>std::invalid_argument</CODE> if \e freq is not positive
+ *
+ *  \par Discussion
+ *  \e ch is first linearly interpolated onto a uniform grid at the
+ *  smallest integral multiple of \e freq not below its mean sample rate,
+ *  limited to 65536 times \e freq. If that multiple is larger than one
+ *  the grid is then decimated to \e freq by resample(), which removes
+ *  content above the new Nyquist frequency, rather than interpolated at
+ *  \e freq directly, which would alias it.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double> channel_type;
+ *  channel_type uniform = to_channel<channel_type>(irregular,100.0);
+ *  \endcode
+ */
+template<typename ChannelT, typename IrregularT>
+inline ChannelT to_channel(const IrregularT &ch,
+  const typename ChannelT::frequency_type &freq,
+  std::size_t zero_crossings=16)
+{
+  typedef typename ChannelT::container_type container_type;
+  typedef typename ChannelT::magnitude_type magnitude_type;
+  typedef typename ChannelT::frequency_type frequency_type;
+  typedef typename IrregularT::time_type time_type;
+
+  BOOST_STATIC_ASSERT(b::is_arithmetic<magnitude_type>::value);
+  BOOST_STATIC_ASSERT(b::is_arithmetic<time_type>::value);
+
+  double out_freq = detail::scalar_value<frequency_type>::get(freq);
+  if(!(out_freq > 0))
+    throw std::invalid_argument("to_channel: frequency must be positive");
+
+  if(ch.empty())
+    return ChannelT(container_type(),freq);
+
+  const time_type start = ch.epoch();
+  const std::size_t n = ch.size();
+  double span = double(ch.time_at(n-1) - start);
+
+  // the grid is an integral multiple of the output rate, at least the
+  // mean input rate where possible, so that resample() decimates by an
+  // exact integer factor
+  double factor = 1;
+  if(n > 1 && span > 0 && double(n-1)/span > out_freq) {
+    factor = std::ceil(double(n-1)/span/out_freq);
+    if(factor > double(detail::resample_max_factor))
+      factor = double(detail::resample_max_factor);
+  }
+
+  double grid_freq = out_freq*factor;
+
+  std::size_t grid_size = std::size_t(std::floor(span*grid_freq + 1e-9))+1;
+  container_type seq(grid_size);
+
+  // single forward pass over both the grid and the timestamps
+  typename IrregularT::time_iterator t = ch.time_begin();
+  typename IrregularT::const_iterator v = ch.begin();
+  std::size_t i = 0;
+  typename container_type::iterator out = seq.begin();
+  for(std::size_t k=0; k<grid_size; ++k, ++out) {
+    double x = double(k)/grid_freq;
+    while(i+1 < n && double(t[i+1] - start) <= x)
+      ++i;
+
+    double val = double(v[i]);
+    if(i+1 < n) {
+      double x0 = double(t[i] - start);
+      double x1 = double(t[i+1] - start);
+      if(x1 > x0)
+        val += (double(v[i+1]) - val)*(x - x0)/(x1 - x0);
+    }
+
+    *out = detail::sample_cast<magnitude_type>(val);
+  }
+
+  ChannelT grid(std::move(seq),
+    detail::value_cast<frequency_type>::construct(grid_freq),start);
+
+  if(factor == 1)
+    return grid;
+
+  const ChannelT result = resample(grid,freq,zero_crossings);
+
+  // the resampled grid may extend one sample past the last timestamp
+  std::size_t keep = std::size_t(std::floor(span*out_freq + 1e-9))+1;
+  if(result.size() <= keep)
+    return result;
+
+  typename ChannelT::const_iterator last = result.begin();
+  std::advance(last,keep);
+
+  return ChannelT(result.begin(),last,freq,start);
+}
+
+}
+}
+
+
+#endif
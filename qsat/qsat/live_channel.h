@@ -0,0 +1,717 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_LIVE_CHANNEL_H
+#define LEMMA_QSAT_LIVE_CHANNEL_H
+
+#include "basic_channel.h"
+#include "detail/value_cast.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <stdexcept>
+
+/** \file
+ *  \brief Implementation of basic_live_channel, a single writer channel with
+ *    thread-safe constant time snapshots
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \brief Fixed capacity sample storage shared between a live channel and
+ *    its snapshots
+ *  \internal Samples in [0,published) are never modified again. The writer
+ *    constructs sample \e n and then publishes it with a release store so that
+ *    a reader performing an acquire load of \e published observes fully
+ *    constructed samples only.
+ */
+template<typename T, typename A>
+struct live_block :public b::enable_shared_from_this<live_block<T,A> >,
+  private b::noncopyable
+{
+  typedef std::allocator_traits<A> alloc_traits;
+  typedef typename alloc_traits::pointer pointer;
+  typedef typename alloc_traits::size_type size_type;
+
+  live_block(size_type cap, const A &a) :alloc(a), data(0), capacity(cap),
+    published(0)
+  {
+    if(capacity)
+      data = alloc_traits::allocate(alloc,capacity);
+  }
+
+  ~live_block(void) {
+    size_type n = published.load(std::memory_order_relaxed);
+    for(size_type i=0; i<n; ++i)
+      alloc_traits::destroy(alloc,&data[i]);
+
+    if(capacity)
+      alloc_traits::deallocate(alloc,data,capacity);
+  }
+
+  A alloc;
+  pointer data;
+  size_type capacity;
+  std::atomic<size_type> published;
+};
+
+}
+
+/** \brief Immutable, shared view of the samples of a basic_live_channel
+ *  \tparam MagnitudeT The signal magnitude type
+ *  \tparam FrequencyT The signal frequency type
+ *  \tparam TimeT The type used to represent the channels time quantum
+ *  \tparam Allocator The allocator used for sample storage
+ *
+ *  Model of const std::sequence with Channel additions
+ *
+ *  \par Discussion
+ *  A snapshot is obtained from basic_live_channel::snapshot() and contains
+ *  every sample that was appended to the live channel before the snapshot was
+ *  taken. It shares the storage of the live channel and keeps it alive by
+ *  reference count so it remains valid after the live channel is destroyed.
+ *  Snapshots are never modified and may be freely copied and read from any
+ *  number of threads. Use channel() to obtain a mutable basic_channel copy.
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator = std::allocator>
+class basic_channel_snapshot {
+  private:
+    typedef detail::live_block<MagnitudeT,Allocator<MagnitudeT> > block_type;
+
+  public:
+    /** const lvalue of MagnitudeT */
+    typedef const MagnitudeT & reference;
+    /** const lvalue of MagnitudeT */
+    typedef const MagnitudeT & const_reference;
+    /** iterator type pointing to const MagnitudeT */
+    typedef const MagnitudeT * iterator;
+    /** iterator type pointing to const MagnitudeT */
+    typedef const MagnitudeT * const_iterator;
+    /** unsigned integral type */
+    typedef typename block_type::size_type size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** MagnitudeT */
+    typedef MagnitudeT value_type;
+    /** type modeling pointer to const MagnitudeT */
+    typedef const MagnitudeT * pointer;
+    /** type modeling pointer to const MagnitudeT */
+    typedef const MagnitudeT * const_pointer;
+    /** reverse_iterator type pointing to const MagnitudeT */
+    typedef std::reverse_iterator<const_iterator> reverse_iterator;
+    /** reverse_iterator type pointing to const MagnitudeT */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** This type */
+    typedef basic_channel_snapshot channel_type;
+    /** MagnitudeT */
+    typedef MagnitudeT magnitude_type;
+    /** FrequencyT */
+    typedef FrequencyT frequency_type;
+    /** TimeT */
+    typedef TimeT time_type;
+
+    /** Subchannel type representing an interval of the snapshot */
+    typedef basic_subchannel<const basic_channel_snapshot> const_subchannel_type;
+    /** Subchannel type representing an interval of the snapshot */
+    typedef const_subchannel_type subchannel_type;
+
+    /** Mutable channel type holding a copy of the snapshot */
+    typedef basic_channel<MagnitudeT,FrequencyT,TimeT,std::vector,Allocator>
+      materialized_type;
+
+    /** \brief Default Constructor
+     *
+     *  Construct an empty snapshot
+     *
+     *  \param tp A <code>std::pair<FrequencyT,TimeT></code> where
+     *    <em>tp.first</em> represents the sample frequency and
+     *    <em>tp.second</em> represents the time sampling started.
+     */
+    basic_channel_snapshot(const std::pair<FrequencyT,TimeT> &tp =
+      std::make_pair(detail::value_cast<FrequencyT>::construct(1),
+        detail::value_cast<TimeT>::construct(0)));
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to const MagnitudeT
+     */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to const MagnitudeT
+     */
+    const_iterator end(void) const;
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to const MagnitudeT
+     */
+    const_reverse_iterator rbegin(void) const;
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to const MagnitudeT
+     */
+    const_reverse_iterator rend(void) const;
+
+    /** \brief Obtain the number of elements contained in the snapshot
+     *  \return snapshot size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain whether or not the snapshot contains any values
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the element at the beginning of the snapshot
+     *  \return element const_reference
+     */
+    const_reference front(void) const;
+
+    /** \brief Obtain the last element of the snapshot
+     *  \return element const_reference
+     */
+    const_reference back(void) const;
+
+    /** \brief Obtain the sample frequency
+     *
+     *  \return The sample frequency
+     */
+    const frequency_type & frequency(void) const;
+
+    /** \brief Obtain the sample epoch
+     *
+     *  \return The sample epoch
+     */
+    const time_type & epoch(void) const;
+
+    /** \brief Obtain a constant subset of this snapshot
+     *
+     *  \par Discussion
+     *  The lifetime of the snapshot is not bound to the returned
+     *  subchannel. Make sure that the snapshot bound to the subchannel has
+     *  a longer lifetime than the subchannel to be used.
+     *
+     *  \return A constant subset into this snapshot.
+     */
+    const_subchannel_type subchannel(const_iterator first,
+      const_iterator last) const;
+
+    /** \brief Copy the snapshot into a mutable channel
+     *  \return A basic_channel holding a copy of the snapshot samples
+     */
+    materialized_type channel(void) const;
+
+  private:
+    template<typename M, typename F, typename T, template<typename> class A>
+    friend class basic_live_channel;
+
+    basic_channel_snapshot(const b::shared_ptr<block_type> &blk, size_type n,
+      const FrequencyT &freq, const TimeT &start);
+
+    FrequencyT _sample_frequency;
+    TimeT _time_start;
+
+    b::shared_ptr<block_type> block;
+    size_type count;
+};
+
+/** \brief Append-only channel with thread-safe constant time snapshots
+ *  \tparam MagnitudeT The signal magnitude type
+ *  \tparam FrequencyT The signal frequency type
+ *  \tparam TimeT The type used to represent the channels time quantum
+ *  \tparam Allocator The allocator used for sample storage
+ *
+ *  \par Discussion
+ *  basic_channel shares its representation between copies and detaches on
+ *  write. As with the standard containers, this is safe for distinct
+ *  basic_channel objects used concurrently, but a basic_channel object cannot
+ *  be copied in one thread while it is being modified in another. A
+ *  basic_live_channel is intended for exactly that case: a single writer
+ *  thread appends samples while any number of reader threads take snapshots.
+ *
+ *  \par Thread safety
+ *  push_back(), reserve() and the other non-const members may only be called
+ *  by one (writer) thread at a time. snapshot(), frequency() and epoch() may
+ *  be called from any thread concurrently with the writer. snapshot() never
+ *  blocks and never copies samples: the returned basic_channel_snapshot holds
+ *  a reference to the current storage together with the number of samples
+ *  published at the time of the call. Samples are never modified once
+ *  published, so a snapshot can never observe a partially written (torn)
+ *  sample.
+ *
+ *  \par
+ *  When the storage is full the writer moves the samples into storage of
+ *  twice the capacity. Outstanding snapshots keep the previous storage alive.
+ *  The live channel itself releases previous storage as soon as no reader is
+ *  in the middle of taking a snapshot.
+ *  \code
+ *  typedef basic_live_channel<float,float,float> live_type;
+ *
+ *  live_type live(1000.0f,0.0f);
+ *
+ *  // acquisition thread
+ *  live.push_back(sample);
+ *
+ *  // analysis thread
+ *  live_type::snapshot_type snap = live.snapshot();
+ *  process(snap.begin(),snap.end());
+ *  \endcode
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator = std::allocator>
+class basic_live_channel :private b::noncopyable {
+  private:
+    typedef detail::live_block<MagnitudeT,Allocator<MagnitudeT> > block_type;
+    typedef std::allocator_traits<Allocator<MagnitudeT> > alloc_traits;
+
+  public:
+    /** Snapshot type */
+    typedef basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>
+      snapshot_type;
+    /** unsigned integral type */
+    typedef typename block_type::size_type size_type;
+    /** MagnitudeT */
+    typedef MagnitudeT value_type;
+    /** Allocator */
+    typedef Allocator<MagnitudeT> allocator_type;
+
+    /** MagnitudeT */
+    typedef MagnitudeT magnitude_type;
+    /** FrequencyT */
+    typedef FrequencyT frequency_type;
+    /** TimeT */
+    typedef TimeT time_type;
+
+    /** \brief Constructor
+     *
+     *  \param freq A value of <code>basic_channel::frequency_type</code>
+     *    representing the sample frequency. Default is
+     *    <code>basic_channel::frequency_type(1)</code>.
+     *  \param start A value of <code>basic_channel::time_type</code>
+     *    representing the time sampling started. Default is
+     *    <code>basic_channel::time_type(0)</code>.
+     *  \param cap The initial storage capacity
+     *  \param alloc The allocator used for sample storage
+     */
+    explicit basic_live_channel(
+      const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
+      const TimeT &start=detail::value_cast<TimeT>::construct(0),
+      size_type cap = 1024, const allocator_type &alloc = allocator_type());
+
+    /** \brief Destructor
+     *
+     *  Outstanding snapshots remain valid.
+     */
+    ~basic_live_channel(void);
+
+    /** \brief Add a new sample at the end of the channel and publish it to
+     *    subsequent snapshots
+     *
+     *  Writer thread only.
+     *
+     *  \param val The value of the new sample
+     */
+    void push_back(const MagnitudeT &val);
+
+    /** \brief Add the samples in <code>[first,last)</code> at the end of the
+     *    channel
+     *
+     *  Writer thread only. Each sample is published as it is appended.
+     *
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to MagnitudeT
+     */
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    /** \brief Ensure that <EM>n</EM> samples can be appended without
+     *    reallocation occuring
+     *
+     *  Writer thread only.
+     *
+     *  \param n the new capacity
+     */
+    void reserve(size_type n);
+
+    /** \brief Obtain the number of published samples
+     *
+     *  Writer thread only. Readers should use <code>snapshot().size()</code>.
+     *
+     *  \return channel size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain the storage capacity
+     *
+     *  Writer thread only.
+     *
+     *  \return storage capacity
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain an immutable snapshot of all samples published so far
+     *
+     *  May be called from any thread. Constant time and lock free.
+     *
+     *  \return A snapshot sharing the channel storage
+     */
+    snapshot_type snapshot(void) const;
+
+    /** \brief Obtain the sample frequency
+     *
+     *  \return The sample frequency
+     */
+    const frequency_type & frequency(void) const;
+
+    /** \brief Obtain the sample epoch
+     *
+     *  \return The sample epoch
+     */
+    const time_type & epoch(void) const;
+
+  private:
+    const FrequencyT _sample_frequency;
+    const TimeT _time_start;
+
+    allocator_type alloc;
+
+    // writer owned
+    b::shared_ptr<block_type> head;
+    std::vector<b::shared_ptr<block_type> > retired;
+
+    // shared with readers
+    std::atomic<block_type *> current;
+    mutable std::atomic<size_type> acquiring;
+
+    void grow(size_type cap);
+    void reclaim(void);
+};
+
+
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_channel_snapshot(const std::pair<FrequencyT,TimeT> &tp)
+    :_sample_frequency(tp.first), _time_start(tp.second), count(0)
+{
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_channel_snapshot(const b::shared_ptr<block_type> &blk, size_type n,
+    const FrequencyT &freq, const TimeT &start) :_sample_frequency(freq),
+      _time_start(start), block(blk), count(n)
+{
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_iterator
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::begin(void) const
+{
+  return (block && block->capacity) ? &*block->data : 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_iterator
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::end(void) const
+{
+  return begin()+count;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reverse_iterator
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::rbegin(void) const
+{
+  return const_reverse_iterator(end());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reverse_iterator
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::rend(void) const
+{
+  return const_reverse_iterator(begin());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::size(void) const
+{
+  return count;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline bool basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  empty(void) const
+{
+  return count == 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  operator[](size_type n) const
+{
+  return begin()[n];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  at(size_type n) const
+{
+  if(n >= count)
+    throw std::out_of_range("basic_channel_snapshot::at");
+
+  return begin()[n];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::front(void) const
+{
+  return *begin();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::back(void) const
+{
+  return begin()[count-1];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency_type &
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  frequency(void) const
+{
+  return _sample_frequency;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type &
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::epoch(void) const
+{
+  return _time_start;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::const_subchannel_type
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  subchannel(const_iterator first, const_iterator last) const
+{
+  return const_subchannel_type(*this,first,last);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::materialized_type
+basic_channel_snapshot<MagnitudeT,FrequencyT,TimeT,Allocator>::channel(void) const
+{
+  return materialized_type(begin(),end(),_sample_frequency,_time_start);
+}
+
+
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_live_channel(const FrequencyT &freq, const TimeT &start, size_type cap,
+    const allocator_type &a) :_sample_frequency(freq), _time_start(start),
+      alloc(a), head(new block_type(cap ? cap : 1,a)), current(head.get()),
+      acquiring(0)
+{
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  ~basic_live_channel(void)
+{
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  push_back(const MagnitudeT &val)
+{
+  size_type n = head->published.load(std::memory_order_relaxed);
+  if(n == head->capacity)
+    grow(n ? 2*n : 16);
+
+  alloc_traits::construct(alloc,&head->data[n],val);
+  head->published.store(n+1,std::memory_order_release);
+
+  if(!retired.empty())
+    reclaim();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+template<typename InputIterator>
+inline void basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  append(InputIterator first, InputIterator last)
+{
+  while(first != last)
+    push_back(*first++);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  reserve(size_type n)
+{
+  if(n > head->capacity)
+    grow(n);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size(void) const
+{
+  return head->published.load(std::memory_order_relaxed);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::capacity(void) const
+{
+  return head->capacity;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::snapshot_type
+basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::snapshot(void) const
+{
+  // Announce the acquisition before loading the block so that the writer
+  // does not release a block that we are about to take a reference to.
+  acquiring.fetch_add(1,std::memory_order_seq_cst);
+  block_type *blk = current.load(std::memory_order_seq_cst);
+  b::shared_ptr<block_type> keep = blk->shared_from_this();
+  acquiring.fetch_sub(1,std::memory_order_release);
+
+  return snapshot_type(keep,keep->published.load(std::memory_order_acquire),
+    _sample_frequency,_time_start);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency_type &
+basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency(void) const
+{
+  return _sample_frequency;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type &
+basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::epoch(void) const
+{
+  return _time_start;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  grow(size_type cap)
+{
+  size_type n = head->published.load(std::memory_order_relaxed);
+
+  b::shared_ptr<block_type> tmp(new block_type(cap,alloc));
+  for(size_type i=0; i<n; ++i) {
+    alloc_traits::construct(alloc,&tmp->data[i],head->data[i]);
+    tmp->published.store(i+1,std::memory_order_relaxed);
+  }
+
+  // readers arriving after this store only ever see the new block
+  current.store(tmp.get(),std::memory_order_seq_cst);
+
+  retired.push_back(head);
+  head.swap(tmp);
+
+  reclaim();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_live_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  reclaim(void)
+{
+  // If no reader is between loading current and taking its reference then
+  // every reader that has yet to load current will observe head, so the
+  // retired blocks are only referenced by the snapshots that own them.
+  if(acquiring.load(std::memory_order_seq_cst) == 0)
+    retired.clear();
+}
+
+}
+}
+
+
+#endif
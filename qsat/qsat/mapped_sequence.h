@@ -0,0 +1,1182 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_MAPPED_SEQUENCE_H
+#define LEMMA_QSAT_MAPPED_SEQUENCE_H
+
+#include <boost/mpl/bool.hpp>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/** \file
+ *  \brief Implementation of mapped_sequence, a random-access sequence stored
+ *    in a memory mapped file
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+/** \brief Random-access sequence of trivially copyable values stored in a
+ *    memory mapped file
+ *  \tparam T The element type, must be trivially copyable
+ *  \tparam A Allocator type. Only used to satisfy the Container requirements
+ *    of basic_channel, storage is always obtained with mmap.
+ *
+ *  Model of std::sequence with optional members
+ *
+ *  \par Discussion
+ *  A mapped_sequence bound to a file maps the samples stored in the file
+ *  starting at a given byte offset directly into memory. Opening a file is
+ *  independent of its size because the operating system pages samples in
+ *  lazily as they are first accessed, and pages that are only read are shared
+ *  with the page cache instead of being copied into process memory. Samples
+ *  are stored in native byte order.
+ *
+ *  \par
+ *  In <em>read_only</em> mode the file is mapped privately. Writes modify
+ *  process memory only and are never written back to the file. Growing the
+ *  sequence beyond the size of the file moves it into anonymous memory. In
+ *  <em>read_write</em> mode the file is mapped shared and created if it
+ *  does not exist. Writes go to the file and reserve(), resize(), and the
+ *  other growing operations extend the file. On destruction capacity added
+ *  beyond the last element is truncated away, but the file is never made
+ *  shorter than it was when opened, so that mapping the start of a file or
+ *  erasing elements does not discard the samples that follow.
+ *
+ *  \par
+ *  Sequences that are not bound to a file (eg default constructed, or copy
+ *  constructed) use anonymous mappings. Copying a mapped_sequence copies the
+ *  elements, as for <code>std::vector</code>. Since every non-empty mapping
+ *  occupies at least one page, mapped_sequence is intended for long
+ *  recordings rather than short snippets.
+ *
+ *  \par
+ *  Use the adopting constructor of basic_channel to construct a channel
+ *  over a file.
+ *  \code
+ *  typedef basic_channel<float,float,float,mapped_sequence> channel_type;
+ *  typedef channel_type::container_type sequence_type;
+ *
+ *  channel_type channel(sequence_type("recording.f32"),48000.0f);
+ *  \endcode
+ */
+template<typename T, typename A = std::allocator<T> >
+class mapped_sequence {
+  public:
+    /** lvalue of T */
+    typedef T & reference;
+    /** const lvalue of T */
+    typedef const T & const_reference;
+    /** iterator type pointing to T */
+    typedef T * iterator;
+    /** iterator type pointing to const T */
+    typedef const T * const_iterator;
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** T */
+    typedef T value_type;
+    /** Allocator */
+    typedef A allocator_type;
+    /** type modeling pointer to T */
+    typedef T * pointer;
+    /** type modeling pointer to const T */
+    typedef const T * const_pointer;
+    /** reverse_iterator type pointing to T */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type pointing to const T */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** File access mode */
+    enum mode_type {
+      /** Map the file privately, the file is never modified */
+      read_only,
+      /** Map the file shared, writes and growth modify the file */
+      read_write
+    };
+
+    /** Sample count denoting all samples through the end of the file */
+    static const size_type npos = size_type(-1);
+
+    /** \brief Default Constructor
+     *
+     *  Does not map any memory
+     *
+     *  \param alloc Unused
+     */
+    explicit mapped_sequence(const allocator_type &alloc = allocator_type());
+
+    /** \brief Fill Constructor
+     *  \param n The number of copies of \e value to make
+     *  \param value The value to copy
+     *  \param alloc Unused
+     *  \post size() == \e n
+     */
+    explicit mapped_sequence(size_type n, const T &value = T(),
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Constructor
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \param alloc Unused
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    mapped_sequence(InputIterator first, InputIterator last,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief File Constructor
+     *
+     *  Map the samples stored in <em>path</em>
+     *
+     *  \param path The file name
+     *  \param mode The file access mode
+     *  \param offset The byte offset of the first sample in the file. Must be
+     *    a multiple of the alignment of T.
+     *  \param n The number of samples, or <em>npos</em> to map all whole
+     *    samples from <em>offset</em> to the end of the file. In
+     *    <em>read_write</em> mode, the file is extended if necessary.
+     *  \param alloc Unused
+     *  \throws <CODE>std::system_error</CODE> if the file cannot be opened,
+     *    resized or mapped
+     *  \throws <CODE>std::invalid_argument</CODE> if <em>offset</em> is
+     *    misaligned or <em>n</em> samples extend past the end of a
+     *    <em>read_only</em> file
+     */
+    explicit mapped_sequence(const std::string &path,
+      mode_type mode = read_only, std::size_t offset = 0, size_type n = npos,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Copy Constructor
+     *
+     *  Copies the elements of \e rhs into anonymous memory
+     *
+     *  \param rhs rvalue of type mapped_sequence
+     */
+    mapped_sequence(const mapped_sequence &rhs);
+
+    /** \brief Move Constructor
+     *  \param rhs mapped_sequence whose mapping (and file) is taken
+     *  \post rhs.empty()
+     */
+    mapped_sequence(mapped_sequence &&rhs);
+
+    /** \brief Destructor
+     *
+     *  Unmaps the sequence. In <em>read_write</em> mode, the file is
+     *  truncated to the end of the last element.
+     */
+    ~mapped_sequence(void);
+
+    /** \brief Assignment Operator
+     *
+     *  Copies the elements of \e rhs into this sequence, and therefore into
+     *  the bound file in <em>read_write</em> mode.
+     *
+     *  \param rhs rvalue of type mapped_sequence
+     *  \return <code>*this</code>
+     */
+    mapped_sequence & operator=(const mapped_sequence &rhs);
+
+    /** \brief Move Assignment Operator
+     *  \param rhs mapped_sequence whose mapping (and file) is taken
+     *  \return <code>*this</code>
+     */
+    mapped_sequence & operator=(mapped_sequence &&rhs);
+
+    /** \brief Range Assignment Operator
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \post size() = <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /** \brief Fill Assignment Operator
+     *  \param n The number of <em>val</em> object to assign to this sequence
+     *  \param val The value of the objects that are assigned to this
+     *  \post size() = <em>n</em>
+     */
+    void assign(size_type n, const T &val);
+
+    /** \brief Obtain the allocator
+     *  \return A copy of the allocator
+     */
+    allocator_type get_allocator(void) const;
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to T
+     */
+    iterator begin(void);
+
+    /** \brief Obtain iterator to sequence beginning
+     *  \return iterator to const T
+     */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to T
+     */
+    iterator end(void);
+
+    /** \brief Obtain iterator to one past sequence end
+     *  \return iterator to const T
+     */
+    const_iterator end(void) const;
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rbegin(void);
+
+    /** \brief Obtain reverse_iterator to sequence beginning
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rbegin(void) const;
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to T
+     */
+    reverse_iterator rend(void);
+
+    /** \brief Obtain reverse_iterator to one past sequence end
+     *  \return reverse_iterator to const T
+     */
+    const_reverse_iterator rend(void) const;
+
+    /** \brief Obtain the number of elements contained in the sequence
+     *  \return sequence size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain the maximum number of elements that can be held in
+     *    this sequence
+     *  \return sequence maximum size
+     */
+    size_type max_size(void) const;
+
+    /** \brief Resize the sequence
+     *  \param sz The new sequence size
+     *  \param val The value of the new objects copied to the end of the
+     *    sequence
+     */
+    void resize(size_type sz, const T &val = T());
+
+    /** \brief Obtain the total number of elements that this sequence can hold
+     *    without remapping
+     *  \return sequence storage capacity
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain whether or not the sequence contains any values
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Ensure that <EM>n</EM> elements can be contained in the
+     *    sequence without remapping
+     *
+     *  In <em>read_write</em> mode, the file is extended to hold <em>n</em>
+     *  elements.
+     *
+     *  \param n the new capacity
+     */
+    void reserve(size_type n);
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     */
+    reference operator[](size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain a reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    reference at(size_type n);
+
+    /** \brief Obtain a const_reference to the value stored at location <EM>n</EM>
+     *  \param n The element location
+     *  \return element const_reference
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element reference
+     */
+    reference front(void);
+
+    /** \brief Obtain the element at the beginning of the sequence
+     *  \return element const_reference
+     */
+    const_reference front(void) const;
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element reference
+     */
+    reference back(void);
+
+    /** \brief Obtain the last element of the sequence
+     *  \return element const_reference
+     */
+    const_reference back(void) const;
+
+    /** \brief Add a new element at the end of the sequence
+     *
+     *  Capacity grows geometrically.
+     *
+     *  \param val The value of the new element
+     */
+    void push_back(const T &val);
+
+    /** \brief Remove the last element of the sequence
+     */
+    void pop_back(void);
+
+    /** \brief Insert a new element into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param val The value of the new element
+     *  \return Iterator pointing to the new element
+     */
+    iterator insert(iterator position, const T &val);
+
+    /** \brief Insert <em>n</em> elements into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param n The number of new elements
+     *  \param val The value of the new elements
+     */
+    void insert(iterator position, size_type n, const T &val);
+
+    /** \brief Insert elements in the range <em>[first,last)</em>
+     *    into the sequence before <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     */
+    template<typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last);
+
+    /** \brief Remove the element pointed to by <em>position</em>
+     *  \param position Iterator into the sequence
+     *  \return Iterator pointing to the element following the erased element
+     */
+    iterator erase(iterator position);
+
+    /** \brief Remove the elements in the range <em>[first,last)</em>
+     *  \param first,last An iterator range in the sequence
+     *  \return Iterator pointing to the element following the erased elements
+     */
+    iterator erase(iterator first, iterator last);
+
+    /** \brief Swap the contents (and files) of this sequence with <em>rhs</em>
+     *  \param rhs The sequence to swap with
+     */
+    void swap(mapped_sequence &rhs);
+
+    /** \brief Remove all elements of the sequence
+     *
+     *  The capacity is left unchanged
+     */
+    void clear(void);
+
+    /** \brief Determine whether the sequence is bound to a file
+     *  \return <code>true</code> if the elements are mapped from a file
+     */
+    bool file_backed(void) const;
+
+    /** \brief Obtain the file access mode
+     *  \return The file access mode. Sequences that are not bound to a file
+     *    are <em>read_only</em>.
+     */
+    mode_type mode(void) const;
+
+    /** \brief Write modified elements back to the bound file
+     *
+     *  Only has an effect in <em>read_write</em> mode.
+     *
+     *  \throws <CODE>std::system_error</CODE> on failure
+     */
+    void flush(void);
+
+  private:
+    static_assert(std::is_trivially_copyable<T>::value,
+      "mapped_sequence requires a trivially copyable T");
+
+    A alloc;
+
+    // open only for read_write files
+    int fd;
+    mode_type map_mode;
+    bool backed;
+    std::size_t file_offset;
+    // length of the file when opened, never truncated below
+    std::size_t file_length;
+
+    void *base;
+    std::size_t base_length;
+    T *elements;
+    size_type count;
+    size_type cap;
+
+    static std::size_t page_size(void);
+
+    void map_file(size_type n, int flags, int file);
+    void map_anonymous(size_type n);
+    void unmap(void);
+    void close(void);
+    void remap(size_type n);
+    void grow(size_type n);
+    bool contains(const T *ptr) const;
+
+    template<typename InputIterator>
+    void append_range(InputIterator first, InputIterator last,
+      std::input_iterator_tag);
+
+    template<typename ForwardIterator>
+    void append_range(ForwardIterator first, ForwardIterator last,
+      std::forward_iterator_tag);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::true_);
+};
+
+/** \brief Compare two sequences element by element
+ *  \return <code>true</code> if the sequences are equal
+ */
+template<typename T, typename A>
+bool operator==(const mapped_sequence<T,A> &lhs,
+  const mapped_sequence<T,A> &rhs);
+
+/** \brief Compare two sequences element by element
+ *  \return <code>true</code> if the sequences are not equal
+ */
+template<typename T, typename A>
+bool operator!=(const mapped_sequence<T,A> &lhs,
+  const mapped_sequence<T,A> &rhs);
+
+/** \brief Swap the contents of two mapped_sequence objects
+ */
+template<typename T, typename A>
+void swap(mapped_sequence<T,A> &lhs, mapped_sequence<T,A> &rhs);
+
+
+
+template<typename T, typename A>
+const typename mapped_sequence<T,A>::size_type mapped_sequence<T,A>::npos;
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::mapped_sequence(const allocator_type &a)
+  :alloc(a), fd(-1), map_mode(read_only), backed(false), file_offset(0),
+    file_length(0), base(0), base_length(0), elements(0), count(0), cap(0)
+{
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::mapped_sequence(size_type n, const T &value,
+  const allocator_type &a) :alloc(a), fd(-1), map_mode(read_only),
+    backed(false), file_offset(0), file_length(0), base(0), base_length(0),
+    elements(0), count(0), cap(0)
+{
+  insert(end(),n,value);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline mapped_sequence<T,A>::mapped_sequence(InputIterator first,
+  InputIterator last, const allocator_type &a) :alloc(a), fd(-1),
+    map_mode(read_only), backed(false), file_offset(0), file_length(0),
+    base(0), base_length(0), elements(0), count(0), cap(0)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::mapped_sequence(const std::string &path,
+  mode_type m, std::size_t offset, size_type n, const allocator_type &a)
+    :alloc(a), fd(-1), map_mode(m), backed(true), file_offset(offset),
+      file_length(0), base(0), base_length(0), elements(0), count(0), cap(0)
+{
+  if(offset % std::alignment_of<T>::value)
+    throw std::invalid_argument("mapped_sequence: misaligned offset");
+
+  int file = ::open(path.c_str(),
+    (m == read_write ? O_RDWR | O_CREAT : O_RDONLY),0666);
+  if(file < 0)
+    throw std::system_error(errno,std::system_category(),
+      "mapped_sequence: open " + path);
+
+  try {
+    struct stat st;
+    if(::fstat(file,&st) < 0)
+      throw std::system_error(errno,std::system_category(),
+        "mapped_sequence: stat " + path);
+
+    std::size_t length = st.st_size;
+    file_length = length;
+    size_type available =
+      (length > offset ? (length-offset)/sizeof(T) : 0);
+
+    if(n == npos)
+      n = available;
+    else if(n > available) {
+      if(m == read_only)
+        throw std::invalid_argument("mapped_sequence: file too short");
+
+      if(::ftruncate(file,offset+n*sizeof(T)) < 0)
+        throw std::system_error(errno,std::system_category(),
+          "mapped_sequence: truncate " + path);
+    }
+
+    map_file(n,(m == read_write ? MAP_SHARED : MAP_PRIVATE),file);
+    count = n;
+  }
+  catch(...) {
+    ::close(file);
+    throw;
+  }
+
+  if(m == read_write)
+    fd = file;
+  else
+    ::close(file);
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::mapped_sequence(const mapped_sequence &rhs)
+  :alloc(rhs.alloc), fd(-1), map_mode(read_only), backed(false),
+    file_offset(0), file_length(0), base(0), base_length(0), elements(0),
+    count(0), cap(0)
+{
+  append_range(rhs.begin(),rhs.end(),std::random_access_iterator_tag());
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::mapped_sequence(mapped_sequence &&rhs)
+  :alloc(rhs.alloc), fd(rhs.fd), map_mode(rhs.map_mode), backed(rhs.backed),
+    file_offset(rhs.file_offset), file_length(rhs.file_length),
+    base(rhs.base), base_length(rhs.base_length), elements(rhs.elements),
+    count(rhs.count), cap(rhs.cap)
+{
+  rhs.fd = -1;
+  rhs.map_mode = read_only;
+  rhs.backed = false;
+  rhs.file_offset = 0;
+  rhs.file_length = 0;
+  rhs.base = 0;
+  rhs.base_length = 0;
+  rhs.elements = 0;
+  rhs.count = 0;
+  rhs.cap = 0;
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A>::~mapped_sequence(void)
+{
+  unmap();
+  close();
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A> &
+mapped_sequence<T,A>::operator=(const mapped_sequence &rhs)
+{
+  if(&rhs != this)
+    assign(rhs.begin(),rhs.end());
+
+  return *this;
+}
+
+template<typename T, typename A>
+inline mapped_sequence<T,A> &
+mapped_sequence<T,A>::operator=(mapped_sequence &&rhs)
+{
+  swap(rhs);
+  return *this;
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::assign(InputIterator first,
+  InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::assign(size_type n, const T &val)
+{
+  T tmp(val);
+  clear();
+  insert(end(),n,tmp);
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::allocator_type
+mapped_sequence<T,A>::get_allocator(void) const
+{
+  return alloc;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::iterator
+mapped_sequence<T,A>::begin(void)
+{
+  return elements;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_iterator
+mapped_sequence<T,A>::begin(void) const
+{
+  return elements;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::iterator
+mapped_sequence<T,A>::end(void)
+{
+  return elements+count;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_iterator
+mapped_sequence<T,A>::end(void) const
+{
+  return elements+count;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reverse_iterator
+mapped_sequence<T,A>::rbegin(void)
+{
+  return reverse_iterator(end());
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reverse_iterator
+mapped_sequence<T,A>::rbegin(void) const
+{
+  return const_reverse_iterator(end());
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reverse_iterator
+mapped_sequence<T,A>::rend(void)
+{
+  return reverse_iterator(begin());
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reverse_iterator
+mapped_sequence<T,A>::rend(void) const
+{
+  return const_reverse_iterator(begin());
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::size_type
+mapped_sequence<T,A>::size(void) const
+{
+  return count;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::size_type
+mapped_sequence<T,A>::max_size(void) const
+{
+  return size_type(-1)/sizeof(T);
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::resize(size_type sz, const T &val)
+{
+  if(sz < count)
+    erase(begin()+sz,end());
+  else
+    insert(end(),sz-count,val);
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::size_type
+mapped_sequence<T,A>::capacity(void) const
+{
+  return cap;
+}
+
+template<typename T, typename A>
+inline bool mapped_sequence<T,A>::empty(void) const
+{
+  return count == 0;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::reserve(size_type n)
+{
+  if(n > cap)
+    remap(n);
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reference
+mapped_sequence<T,A>::operator[](size_type n)
+{
+  return elements[n];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reference
+mapped_sequence<T,A>::operator[](size_type n) const
+{
+  return elements[n];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reference
+mapped_sequence<T,A>::at(size_type n)
+{
+  if(n >= count)
+    throw std::out_of_range("mapped_sequence::at");
+
+  return elements[n];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reference
+mapped_sequence<T,A>::at(size_type n) const
+{
+  if(n >= count)
+    throw std::out_of_range("mapped_sequence::at");
+
+  return elements[n];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reference
+mapped_sequence<T,A>::front(void)
+{
+  return elements[0];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reference
+mapped_sequence<T,A>::front(void) const
+{
+  return elements[0];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::reference
+mapped_sequence<T,A>::back(void)
+{
+  return elements[count-1];
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::const_reference
+mapped_sequence<T,A>::back(void) const
+{
+  return elements[count-1];
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::push_back(const T &val)
+{
+  // val may refer to an element of this sequence
+  T tmp(val);
+  grow(count+1);
+  elements[count++] = tmp;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::pop_back(void)
+{
+  --count;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::iterator
+mapped_sequence<T,A>::insert(iterator position, const T &val)
+{
+  difference_type off = position-begin();
+  push_back(val);
+  std::rotate(begin()+off,end()-1,end());
+
+  return begin()+off;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::insert(iterator position, size_type n,
+  const T &val)
+{
+  if(!n)
+    return;
+
+  difference_type off = position-begin();
+  T tmp(val);
+  grow(count+n);
+  std::fill_n(end(),n,tmp);
+  count += n;
+  std::rotate(begin()+off,end()-n,end());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::insert(iterator position,
+  InputIterator first, InputIterator last)
+{
+  insert_thunk(position,first,last,
+    typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::iterator
+mapped_sequence<T,A>::erase(iterator position)
+{
+  return erase(position,position+1);
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::iterator
+mapped_sequence<T,A>::erase(iterator first, iterator last)
+{
+  std::copy(last,end(),first);
+  count -= last-first;
+
+  return first;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::swap(mapped_sequence &rhs)
+{
+  std::swap(alloc,rhs.alloc);
+  std::swap(fd,rhs.fd);
+  std::swap(map_mode,rhs.map_mode);
+  std::swap(backed,rhs.backed);
+  std::swap(file_offset,rhs.file_offset);
+  std::swap(file_length,rhs.file_length);
+  std::swap(base,rhs.base);
+  std::swap(base_length,rhs.base_length);
+  std::swap(elements,rhs.elements);
+  std::swap(count,rhs.count);
+  std::swap(cap,rhs.cap);
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::clear(void)
+{
+  count = 0;
+}
+
+template<typename T, typename A>
+inline bool mapped_sequence<T,A>::file_backed(void) const
+{
+  return backed;
+}
+
+template<typename T, typename A>
+inline typename mapped_sequence<T,A>::mode_type
+mapped_sequence<T,A>::mode(void) const
+{
+  return map_mode;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::flush(void)
+{
+  if(fd >= 0 && base && ::msync(base,base_length,MS_SYNC) < 0)
+    throw std::system_error(errno,std::system_category(),
+      "mapped_sequence: msync");
+}
+
+template<typename T, typename A>
+inline std::size_t mapped_sequence<T,A>::page_size(void)
+{
+  static const std::size_t size = ::sysconf(_SC_PAGESIZE);
+  return size;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::map_file(size_type n, int flags, int file)
+{
+  // mmap offsets must be page aligned, map from the enclosing page
+  std::size_t page_offset = file_offset & ~(page_size()-1);
+  std::size_t delta = file_offset-page_offset;
+  std::size_t length = delta+n*sizeof(T);
+
+  if(n) {
+    void *addr = ::mmap(0,length,PROT_READ | PROT_WRITE,flags,file,
+      page_offset);
+    if(addr == MAP_FAILED)
+      throw std::system_error(errno,std::system_category(),
+        "mapped_sequence: mmap");
+
+    base = addr;
+    base_length = length;
+    elements = reinterpret_cast<T*>(static_cast<char*>(addr)+delta);
+  }
+
+  cap = n;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::map_anonymous(size_type n)
+{
+#if defined(MAP_ANONYMOUS)
+  const int anonymous = MAP_ANONYMOUS;
+#else
+  const int anonymous = MAP_ANON;
+#endif
+
+  std::size_t length = n*sizeof(T);
+  void *addr = ::mmap(0,length,PROT_READ | PROT_WRITE,MAP_PRIVATE | anonymous,
+    -1,0);
+  if(addr == MAP_FAILED)
+    throw std::system_error(errno,std::system_category(),
+      "mapped_sequence: mmap");
+
+  base = addr;
+  base_length = length;
+  elements = static_cast<T*>(addr);
+  cap = n;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::unmap(void)
+{
+  if(base)
+    ::munmap(base,base_length);
+
+  base = 0;
+  base_length = 0;
+  elements = 0;
+  cap = 0;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::close(void)
+{
+  if(fd >= 0) {
+    // drop any capacity added beyond the last element, never the samples
+    // that were in the file to begin with
+    std::size_t length =
+      std::max<std::size_t>(file_length,file_offset+count*sizeof(T));
+    struct stat st;
+    if(::fstat(fd,&st) == 0 && std::size_t(st.st_size) > length) {
+      int res = ::ftruncate(fd,length);
+      (void)res;
+    }
+    ::close(fd);
+  }
+
+  fd = -1;
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::remap(size_type n)
+{
+  if(fd >= 0) {
+    // read_write: extend the file, never shorten it, and map the new extent
+    std::size_t length = file_offset+n*sizeof(T);
+    struct stat st;
+    if(::fstat(fd,&st) < 0)
+      throw std::system_error(errno,std::system_category(),
+        "mapped_sequence: stat");
+
+    if(std::size_t(st.st_size) < length && ::ftruncate(fd,length) < 0)
+      throw std::system_error(errno,std::system_category(),
+        "mapped_sequence: truncate");
+
+    // map the new extent before releasing the old one so that a failed
+    // mmap leaves this sequence unchanged, tmp unmaps the old region
+    mapped_sequence tmp;
+    tmp.file_offset = file_offset;
+    tmp.map_file(n,MAP_SHARED,fd);
+
+    std::swap(base,tmp.base);
+    std::swap(base_length,tmp.base_length);
+    std::swap(elements,tmp.elements);
+    std::swap(cap,tmp.cap);
+    return;
+  }
+
+  // anonymous or read_only: copy into a new anonymous mapping
+  mapped_sequence tmp;
+  tmp.map_anonymous(n);
+  if(count)
+    std::memcpy(tmp.elements,elements,count*sizeof(T));
+  tmp.count = count;
+  tmp.alloc = alloc;
+
+  swap(tmp);
+}
+
+template<typename T, typename A>
+inline bool mapped_sequence<T,A>::contains(const T *ptr) const
+{
+  std::less_equal<const T *> le;
+  return cap && le(elements,ptr) && !le(elements+cap,ptr);
+}
+
+template<typename T, typename A>
+inline void mapped_sequence<T,A>::grow(size_type n)
+{
+  if(n > cap)
+    remap(std::max(n,2*cap));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::append_range(InputIterator first,
+  InputIterator last, std::input_iterator_tag)
+{
+  while(first != last)
+    push_back(*first++);
+}
+
+template<typename T, typename A>
+template<typename ForwardIterator>
+inline void mapped_sequence<T,A>::append_range(ForwardIterator first,
+  ForwardIterator last, std::forward_iterator_tag)
+{
+  size_type n = std::distance(first,last);
+  if(n && count+n > cap && contains(std::addressof(*first))) {
+    // [first,last) lies in this sequence, which grow() unmaps
+    std::vector<T,A> tmp(first,last,alloc);
+    append_range(tmp.begin(),tmp.end(),std::forward_iterator_tag());
+    return;
+  }
+
+  grow(count+n);
+  std::copy(first,last,end());
+  count += n;
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::false_)
+{
+  clear();
+  append_range(first,last,
+    typename std::iterator_traits<InputIterator>::iterator_category());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::true_)
+{
+  assign(size_type(first),T(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::false_)
+{
+  difference_type off = position-begin();
+  size_type len = count;
+
+  append_range(first,last,
+    typename std::iterator_traits<InputIterator>::iterator_category());
+  std::rotate(begin()+off,begin()+len,end());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void mapped_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::true_)
+{
+  insert(position,size_type(first),T(last));
+}
+
+template<typename T, typename A>
+inline bool operator==(const mapped_sequence<T,A> &lhs,
+  const mapped_sequence<T,A> &rhs)
+{
+  return lhs.size() == rhs.size() &&
+    std::equal(lhs.begin(),lhs.end(),rhs.begin());
+}
+
+template<typename T, typename A>
+inline bool operator!=(const mapped_sequence<T,A> &lhs,
+  const mapped_sequence<T,A> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+template<typename T, typename A>
+inline void swap(mapped_sequence<T,A> &lhs, mapped_sequence<T,A> &rhs)
+{
+  lhs.swap(rhs);
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,461 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_PARALLEL_H
+#define LEMMA_QSAT_PARALLEL_H
+
+#include "basic_channel.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/make_shared.hpp>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <cstddef>
+
+/** \file
+ *  \brief Parallel algorithms over channels
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+/** \brief Fixed set of worker threads executing indexed jobs
+ *
+ *  \par Discussion
+ *  A thread_pool executes run() jobs. A job is a function called once for
+ *  each index in [0,n). The calling thread takes part in its own job so a
+ *  job submitted from inside another job, or to a pool with no threads,
+ *  completes rather than deadlocks.
+ *
+ *  The pool itself is safe to use from multiple threads concurrently. Jobs
+ *  from different callers share the workers.
+ */
+class thread_pool :private b::noncopyable {
+  public:
+    /** \brief Constructor
+     *  \param threads The number of worker threads. Default is the number
+     *    of hardware threads.
+     */
+    explicit thread_pool(std::size_t threads = hardware_threads());
+
+    /** \brief Destructor
+     *  \pre No job is running
+     */
+    ~thread_pool(void);
+
+    /** \brief Obtain the number of worker threads */
+    std::size_t size(void) const {
+      return workers.size();
+    }
+
+    /** \brief Call <code>f(i)</code> for every <em>i</em> in [0,\e n) and
+     *    wait for all of them to finish
+     *  \param n The number of indices
+     *  \param f A function object callable with <code>std::size_t</code>.
+     *    It is called concurrently and in no particular index order.
+     *  \throws The first exception thrown by \e f, after every call that
+     *    had started has finished. Indices not yet started are skipped.
+     */
+    template<typename Function>
+    void run(std::size_t n, const Function &f);
+
+    /** \brief The number of hardware threads, at least one */
+    static std::size_t hardware_threads(void) {
+      unsigned int n = std::thread::hardware_concurrency();
+      return n ? n : 1;
+    }
+
+  private:
+    template<typename Function>
+    struct job {
+      job(std::size_t count, const Function &func)
+        :next(0), n(count), active(0), f(&func) {}
+
+      std::mutex lock;
+      std::condition_variable done;
+      std::size_t next;
+      std::size_t n;
+      std::size_t active;
+      std::exception_ptr error;
+      const Function *f;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void(void)> > tasks;
+    std::mutex lock;
+    std::condition_variable ready;
+    bool stopping;
+
+    void work(void);
+
+    template<typename Function>
+    static void execute(job<Function> &j);
+};
+
+
+
+inline thread_pool::thread_pool(std::size_t threads) :stopping(false)
+{
+  workers.reserve(threads);
+  for(std::size_t i=0; i<threads; ++i)
+    workers.push_back(std::thread(&thread_pool::work,this));
+}
+
+inline thread_pool::~thread_pool(void)
+{
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    stopping = true;
+  }
+
+  ready.notify_all();
+  for(std::size_t i=0; i<workers.size(); ++i)
+    workers[i].join();
+}
+
+inline void thread_pool::work(void)
+{
+  for(;;) {
+    std::function<void(void)> task;
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      while(!stopping && tasks.empty())
+        ready.wait(guard);
+
+      if(tasks.empty())
+        return;
+
+      task.swap(tasks.front());
+      tasks.pop_front();
+    }
+
+    task();
+  }
+}
+
+template<typename Function>
+inline void thread_pool::run(std::size_t n, const Function &f)
+{
+  if(!n)
+    return;
+
+  b::shared_ptr<job<Function> > j = b::make_shared<job<Function> >(n,f);
+
+  // helpers that start after the job is finished return immediately and
+  // only touch the shared job state, never f
+  std::size_t helpers = std::min(n-1,workers.size());
+  if(helpers) {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      for(std::size_t i=0; i<helpers; ++i)
+        tasks.push_back([j]() { execute(*j); });
+    }
+
+    ready.notify_all();
+  }
+
+  execute(*j);
+
+  std::unique_lock<std::mutex> guard(j->lock);
+  while(j->active)
+    j->done.wait(guard);
+
+  if(j->error)
+    std::rethrow_exception(j->error);
+}
+
+template<typename Function>
+inline void thread_pool::execute(job<Function> &j)
+{
+  std::unique_lock<std::mutex> guard(j.lock);
+  while(j.next < j.n) {
+    std::size_t i = j.next++;
+    ++j.active;
+    guard.unlock();
+
+    try {
+      (*j.f)(i);
+    }
+    catch(...) {
+      guard.lock();
+      if(!j.error)
+        j.error = std::current_exception();
+      j.next = j.n;
+      guard.unlock();
+    }
+
+    guard.lock();
+    if(!--j.active && j.next >= j.n)
+      j.done.notify_all();
+  }
+}
+
+/** \brief Obtain the process wide thread_pool used by default
+ *  \return A pool with thread_pool::hardware_threads() workers, created on
+ *    first use
+ */
+inline thread_pool & default_thread_pool(void)
+{
+  static thread_pool pool;
+  return pool;
+}
+
+namespace detail {
+
+/** \internal Minimum number of samples worth handing to another thread */
+static const std::size_t parallel_grain_size = 4096;
+
+/** \brief Split [\e first, \e first + \e size) of \e ch into subchannels
+ *  \internal One subchannel per thread of \e pool, each no smaller than
+ *  parallel_grain_size unless there is only one. The boundaries are found
+ *  in a single pass so non random access channels are partitioned in
+ *  linear time.
+ */
+template<typename SubchannelT, typename ChannelT, typename Iterator>
+inline std::vector<SubchannelT>
+partition_channel(ChannelT &ch, Iterator first, std::size_t size,
+  const thread_pool &pool)
+{
+  std::size_t parts = std::min(
+    std::max<std::size_t>(pool.size(),1),
+    std::max<std::size_t>(size/parallel_grain_size,1));
+
+  std::vector<SubchannelT> result;
+  result.reserve(parts);
+  for(std::size_t i=0; i<parts; ++i) {
+    std::size_t len = size/parts + (i < size%parts ? 1 : 0);
+    Iterator last = first;
+    std::advance(last,len);
+    result.push_back(ch.subchannel(first,last));
+    first = last;
+  }
+
+  return result;
+}
+
+/** \brief Detach the storage of [\e first, \e first + \e size) that a
+ *    write through \e first would detach lazily
+ *  \internal Writing one element detaches detach_stride<Iterator>::value
+ *  consecutive elements, so touching every stride-th element and the last
+ *  reaches all of them. Called before the range is handed to several
+ *  threads, which would otherwise race to detach the same storage.
+ */
+template<typename Iterator>
+inline void detach_range(Iterator first, std::size_t size)
+{
+  const std::size_t stride = detach_stride<Iterator>::value;
+  if(!stride || !size)
+    return;
+
+  Iterator last = first;
+  std::advance(last,size-1);
+  for(std::size_t i=0; i+stride<size; i+=stride) {
+    (void)&*first;
+    std::advance(first,stride);
+  }
+
+  (void)&*first;
+  (void)&*last;
+}
+
+/** \internal The mutable partitions of \e ch. Obtaining begin() performs
+ *  the copy-on-write check, if any, exactly once for all partitions, and
+ *  storage that is detached lazily is detached here before any thread
+ *  writes to it.
+ */
+template<typename ChannelT>
+inline std::vector<typename ChannelT::subchannel_type>
+mutable_partitions(ChannelT &ch, const thread_pool &pool)
+{
+  typedef decltype(ch.begin()) iterator;
+
+  iterator first = ch.begin();
+  detach_range(first,ch.size());
+  return partition_channel<typename ChannelT::subchannel_type>(ch,first,
+    ch.size(),pool);
+}
+
+template<typename ChannelT>
+inline std::vector<decltype(std::declval<const ChannelT &>().subchannel(
+  std::declval<const ChannelT &>().begin(),
+  std::declval<const ChannelT &>().begin()))>
+const_partitions(const ChannelT &ch, const thread_pool &pool)
+{
+  typedef decltype(ch.begin()) iterator;
+  typedef decltype(ch.subchannel(ch.begin(),ch.begin())) subchannel_type;
+
+  iterator first = ch.begin();
+  return partition_channel<subchannel_type>(ch,first,ch.size(),pool);
+}
+
+}
+
+/** \brief Apply a function to every sample of a channel in parallel
+ *  \param ch A basic_channel or basic_subchannel
+ *  \param f A function object callable with
+ *    <code>ChannelT::reference</code>. It is copied once per partition and
+ *    the copies are called concurrently.
+ *  \param pool The thread_pool to execute on
+ *  \return The samples of \e ch are modified in place
+ *  \throws The first exception thrown by \e f
+ *
+ *  \par Discussion
+ *  \e ch is split into one contiguous basic_subchannel per thread. The
+ *  copy-on-write check of \e ch is performed once before any thread starts
+ *  so the threads write directly into the detached representation. Shared
+ *  storage that the container copies lazily, eg the chunks of a
+ *  chunked_sequence, is also detached before any thread starts.
+ *
+ *  \code
+ *  basic_channel<float,double,double> ch; // assume filled with values
+ *  parallel_for_each(ch,[](float &x) { x = std::abs(x); });
+ *  \endcode
+ */
+template<typename ChannelT, typename UnaryFunction>
+inline void parallel_for_each(ChannelT &ch, UnaryFunction f,
+  thread_pool &pool = default_thread_pool())
+{
+  typedef typename ChannelT::subchannel_type subchannel_type;
+
+  std::vector<subchannel_type> parts = detail::mutable_partitions(ch,pool);
+
+  pool.run(parts.size(),[&](std::size_t i) {
+    std::for_each(parts[i].begin(),parts[i].end(),f);
+  });
+}
+
+/** \brief Transform the samples of a channel into another in parallel
+ *  \param in The source channel
+ *  \param out The destination channel with the same size as \e in. It may
+ *    be \e in itself.
+ *  \param op A function object callable with
+ *    <code>InChannelT::const_reference</code> returning a value
+ *    convertible to <code>OutChannelT::value_type</code>
+ *  \param pool The thread_pool to execute on
+ *  \throws <CODE>std::invalid_argument</CODE> if \e in and \e out differ
+ *    in size
+ *  \throws The first exception thrown by \e op
+ */
+template<typename InChannelT, typename OutChannelT, typename UnaryOperation>
+inline void parallel_transform(const InChannelT &in, OutChannelT &out,
+  UnaryOperation op, thread_pool &pool = default_thread_pool())
+{
+  typedef typename OutChannelT::subchannel_type out_subchannel_type;
+
+  if(in.size() != out.size())
+    throw std::invalid_argument("parallel_transform: size mismatch");
+
+  // detach the destination first in case it shares with the source
+  std::vector<out_subchannel_type> out_parts =
+    detail::mutable_partitions(out,pool);
+  auto in_parts = detail::const_partitions(in,pool);
+
+  pool.run(out_parts.size(),[&](std::size_t i) {
+    std::transform(in_parts[i].begin(),in_parts[i].end(),
+      out_parts[i].begin(),op);
+  });
+}
+
+/** \brief Reduce the samples of a channel in parallel
+ *  \param ch The channel to reduce
+ *  \param init The initial value of each partition's result. It should be
+ *    an identity of \e combine, eg 0 for a sum.
+ *  \param op A function object called as <code>op(T,sample)</code>
+ *    accumulating one sample into a partial result
+ *  \param combine A function object called as <code>combine(T,T)</code>
+ *    merging two partial results
+ *  \param pool The thread_pool to execute on
+ *  \return The combined result
+ *  \throws The first exception thrown by \e op or \e combine
+ *
+ *  \par Discussion
+ *  Each partition is accumulated with \e op in order, starting from
+ *  \e init, and the partial results are combined in partition order. With
+ *  a single partition the result is that of <code>std::accumulate</code>.
+ *  The result of a non associative reduction, eg a floating point sum,
+ *  depends on the number of threads of \e pool.
+ *
+ *  \code
+ *  double energy = parallel_reduce(ch,0.0,
+ *    [](double acc, float x) { return acc + double(x)*x; },
+ *    std::plus<double>());
+ *  \endcode
+ */
+template<typename ChannelT, typename T, typename BinaryOperation,
+  typename CombineOperation>
+inline T parallel_reduce(const ChannelT &ch, T init, BinaryOperation op,
+  CombineOperation combine, thread_pool &pool = default_thread_pool())
+{
+  auto parts = detail::const_partitions(ch,pool);
+
+  std::vector<T> partial(parts.size(),init);
+  pool.run(parts.size(),[&](std::size_t i) {
+    partial[i] = std::accumulate(parts[i].begin(),parts[i].end(),
+      partial[i],op);
+  });
+
+  T result = partial[0];
+  for(std::size_t i=1; i<partial.size(); ++i)
+    result = combine(result,partial[i]);
+
+  return result;
+}
+
+/** \brief Reduce the samples of a channel in parallel with one operation
+ *  \param ch The channel to reduce
+ *  \param init An identity of \e op
+ *  \param op An associative function object called both to accumulate a
+ *    sample, <code>op(T,sample)</code>, and to merge partial results,
+ *    <code>op(T,T)</code>, eg <code>std::plus<double>()</code>
+ *  \param pool The thread_pool to execute on
+ *  \return The reduced result
+ */
+template<typename ChannelT, typename T, typename BinaryOperation>
+inline T parallel_reduce(const ChannelT &ch, T init, BinaryOperation op,
+  thread_pool &pool = default_thread_pool())
+{
+  return parallel_reduce(ch,init,op,op,pool);
+}
+
+}
+}
+
+
+#endif
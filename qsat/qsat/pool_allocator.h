@@ -0,0 +1,244 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_POOL_ALLOCATOR_H
+#define LEMMA_QSAT_POOL_ALLOCATOR_H
+
+#include <boost/noncopyable.hpp>
+#include <boost/static_assert.hpp>
+
+#include <new>
+#include <limits>
+#include <cstddef>
+
+/** \file
+ *  \brief Implementation of pool_allocator, an allocator recycling blocks
+ *    of power of two size classes
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \internal log2 of the smallest size class */
+static const std::size_t pool_min_shift = 4;
+
+/** \internal log2 of the largest size class. Larger requests bypass the
+ *  pool.
+ */
+static const std::size_t pool_max_shift = 20;
+
+/** \internal Bytes each size class may keep for reuse */
+static const std::size_t pool_class_bytes = 1024*1024;
+
+/** \internal Blocks each size class may keep for reuse at least */
+static const std::size_t pool_class_blocks = 4;
+
+/** \brief Per thread cache of free blocks, one list per size class
+ *  \internal
+ *
+ *  Blocks are individually obtained from operator new so a block freed on
+ *  a different thread than it was allocated on can join that thread's
+ *  cache. Each size class keeps at most the larger of pool_class_bytes and
+ *  pool_class_blocks blocks, the rest go back to operator delete.
+ */
+class size_class_pool :private b::noncopyable {
+  public:
+    size_class_pool(void) {
+      for(std::size_t i=0; i<classes; ++i) {
+        free_list[i] = 0;
+        cached[i] = 0;
+      }
+    }
+
+    ~size_class_pool(void) {
+      for(std::size_t i=0; i<classes; ++i) {
+        while(free_list[i]) {
+          node *next = free_list[i]->next;
+          ::operator delete(free_list[i]);
+          free_list[i] = next;
+        }
+      }
+
+      destroyed() = true;
+    }
+
+    void * allocate(std::size_t bytes) {
+      std::size_t k = class_of(bytes);
+      if(node *n = free_list[k]) {
+        free_list[k] = n->next;
+        --cached[k];
+        return n;
+      }
+
+      return ::operator new(std::size_t(1) << (k+pool_min_shift));
+    }
+
+    void deallocate(void *p, std::size_t bytes) {
+      std::size_t k = class_of(bytes);
+      if(cached[k] >= limit(k)) {
+        ::operator delete(p);
+        return;
+      }
+
+      node *n = static_cast<node *>(p);
+      n->next = free_list[k];
+      free_list[k] = n;
+      ++cached[k];
+    }
+
+    /** true once the calling thread's pool has been destroyed at thread
+     *  exit
+     */
+    static bool & destroyed(void) {
+      static thread_local bool flag = false;
+      return flag;
+    }
+
+  private:
+    struct node {
+      node *next;
+    };
+
+    static const std::size_t classes = pool_max_shift - pool_min_shift + 1;
+
+    node *free_list[classes];
+    std::size_t cached[classes];
+
+    static std::size_t class_of(std::size_t bytes) {
+      std::size_t k = 0;
+      while((std::size_t(1) << (k+pool_min_shift)) < bytes)
+        ++k;
+
+      return k;
+    }
+
+    static std::size_t limit(std::size_t k) {
+      std::size_t n = pool_class_bytes >> (k+pool_min_shift);
+      return n > pool_class_blocks ? n : pool_class_blocks;
+    }
+};
+
+/** \internal The pool of the calling thread */
+inline size_class_pool & local_pool(void)
+{
+  static thread_local size_class_pool pool;
+  return pool;
+}
+
+}
+
+/** \brief Allocator recycling memory through per thread caches of power of
+ *    two size classes
+ *  \tparam T The value type
+ *
+ *  \par Discussion
+ *  Requests are rounded up to a power of two between 16 bytes and 1MiB and
+ *  served from a free list of the calling thread. Freed blocks return to
+ *  the free list of the freeing thread up to a limit of about 1MiB per size
+ *  class. Larger requests go directly to operator new. Once a workload has
+ *  warmed the caches, creating and dropping temporary channels no longer
+ *  reaches malloc.
+ *
+ *  A basic_channel instantiated with pool_allocator draws both its samples
+ *  and its container and reference count from the pool. The allocator is
+ *  stateless, so channels may be freely copied, moved and destroyed across
+ *  threads.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double,std::vector,pool_allocator>
+ *    pooled_channel;
+ *  \endcode
+ */
+template<typename T>
+class pool_allocator {
+  public:
+    typedef T value_type;
+    typedef T * pointer;
+    typedef const T * const_pointer;
+    typedef T & reference;
+    typedef const T & const_reference;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template<typename U>
+    struct rebind {
+      typedef pool_allocator<U> other;
+    };
+
+    pool_allocator(void) {}
+
+    template<typename U>
+    pool_allocator(const pool_allocator<U> &) {}
+
+    T * allocate(std::size_t n) {
+      BOOST_STATIC_ASSERT(alignof(T) <= alignof(std::max_align_t));
+
+      if(n > std::numeric_limits<std::size_t>::max()/sizeof(T))
+        throw std::bad_alloc();
+
+      std::size_t bytes = n*sizeof(T);
+      if(bytes > (std::size_t(1) << detail::pool_max_shift)
+        || detail::size_class_pool::destroyed())
+      {
+        return static_cast<T *>(::operator new(bytes));
+      }
+
+      return static_cast<T *>(detail::local_pool().allocate(bytes));
+    }
+
+    void deallocate(T *p, std::size_t n) {
+      // compare counts rather than bytes, which may wrap for a huge n
+      if(n > (std::size_t(1) << detail::pool_max_shift)/sizeof(T)
+        || detail::size_class_pool::destroyed())
+      {
+        ::operator delete(p);
+      }
+      else
+        detail::local_pool().deallocate(p,n*sizeof(T));
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const pool_allocator<T> &, const pool_allocator<U> &)
+{
+  return true;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const pool_allocator<T> &, const pool_allocator<U> &)
+{
+  return false;
+}
+
+}
+}
+
+#endif
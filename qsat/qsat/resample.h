@@ -0,0 +1,305 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_RESAMPLE_H
+#define LEMMA_QSAT_RESAMPLE_H
+
+#include "basic_channel.h"
+#include "detail/simd.h"
+#include "detail/value_cast.h"
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/type_traits/remove_const.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/mpl/bool.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <cmath>
+#include <cstddef>
+
+/** \file
+ *  \brief Sample rate conversion of channels
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+/** \internal The largest interpolation or decimation factor of a rate
+ *  ratio
+ */
+static const std::size_t resample_max_factor = 65536;
+
+/** \internal The largest relative error of an approximated rate ratio */
+static const double resample_ratio_tolerance = 1e-9;
+
+/** \brief Find the best rational approximation to \e x
+ *  \internal Walks the continued fraction of \e x and stops at the last
+ *  convergent whose numerator and denominator do not exceed \e max.
+ *  The result has a zero numerator or denominator if there is no such
+ *  convergent.
+ */
+inline std::pair<std::size_t,std::size_t>
+rational_approximation(double x, std::size_t max)
+{
+  std::size_t p0 = 0, q0 = 1;
+  std::size_t p1 = 1, q1 = 0;
+
+  double r = x;
+  for(int i=0; i<64; ++i) {
+    double a = std::floor(r);
+    if(a > double(max))
+      break;
+
+    std::size_t ai = static_cast<std::size_t>(a);
+
+    std::size_t q2 = ai*q1 + q0;
+    std::size_t p2 = ai*p1 + p0;
+    if(q2 > max || p2 > max)
+      break;
+
+    p0 = p1;
+    q0 = q1;
+    p1 = p2;
+    q1 = q2;
+
+    double frac = r - a;
+    if(frac < 1e-12)
+      break;
+
+    r = 1.0/frac;
+  }
+
+  return std::make_pair(p1,q1);
+}
+
+/** \brief Polyphase decomposition of a windowed-sinc lowpass filter
+ *  \internal
+ *  The prototype filter runs at \e up times the input rate with a cutoff at
+ *  the lower of the input and output Nyquist frequencies. It is split into
+ *  \e up phases of taps() coefficients each. Each phase is stored reversed
+ *  and contiguously so that an output sample is a single dot_product with a
+ *  contiguous run of input samples.
+ */
+template<typename V>
+class polyphase_filter {
+  public:
+    polyphase_filter(std::size_t up, std::size_t down,
+      std::size_t zero_crossings);
+
+    std::size_t up(void) const {
+      return _up;
+    }
+
+    std::size_t down(void) const {
+      return _down;
+    }
+
+    /** number of coefficients in each phase */
+    std::size_t taps(void) const {
+      return _taps;
+    }
+
+    /** group delay in samples at the upsampled rate */
+    std::size_t delay(void) const {
+      return _delay;
+    }
+
+    const V * phase(std::size_t p) const {
+      return &coefs[p*_taps];
+    }
+
+  private:
+    std::size_t _up;
+    std::size_t _down;
+    std::size_t _taps;
+    std::size_t _delay;
+    std::vector<V> coefs;
+};
+
+template<typename V>
+inline polyphase_filter<V>::polyphase_filter(std::size_t up,
+  std::size_t down, std::size_t zero_crossings) :_up(up), _down(down)
+{
+  const double pi = 3.14159265358979323846;
+
+  std::size_t ratio = up > down ? up : down;
+  std::size_t len = 2*zero_crossings*ratio+1;
+
+  _delay = zero_crossings*ratio;
+  _taps = (len+up-1)/up;
+  coefs.assign(_taps*up,V());
+
+  for(std::size_t p=0; p<up; ++p) {
+    double sum = 0;
+    for(std::size_t q=0; q<_taps; ++q) {
+      std::size_t n = p + (_taps-1-q)*up;
+      if(n >= len)
+        continue;
+
+      double x = (double(n)-double(_delay))/ratio;
+      double sinc = (n == _delay ? 1.0 : std::sin(pi*x)/(pi*x));
+      double w = 0.42 - 0.5*std::cos(2*pi*n/(len-1))
+        + 0.08*std::cos(4*pi*n/(len-1));
+
+      coefs[p*_taps+q] = V(sinc*w);
+      sum += sinc*w;
+    }
+
+    // unity gain at DC for every phase
+    if(sum != 0) {
+      for(std::size_t q=0; q<_taps; ++q)
+        coefs[p*_taps+q] = V(coefs[p*_taps+q]/sum);
+    }
+  }
+}
+
+}
+
+/** \brief Resample a channel to a new sample frequency
+ *  \tparam ChannelT A basic_channel or basic_subchannel with an arithmetic
+ *    magnitude_type
+ *  \param ch The channel to resample
+ *  \param freq The sample frequency of the result
+ *  \param zero_crossings The half width of the interpolation filter in
+ *    samples at the lower of the two rates. Larger values give a sharper
+ *    anti-aliasing filter at proportionally higher cost.
+ *  \return A new channel of the same type as \e ch (the underlying channel
+ *    type for a subchannel) sampled at \e freq with the same epoch as \e ch
+ *  \throws <CODE>std::invalid_argument</CODE> if either frequency is not
+ *    positive, \e zero_crossings is zero, or the ratio of the frequencies
+ *    is not representable as described below
+ *
+ *  \par Discussion
+ *  The ratio of \e freq to the frequency of \e ch is taken as a rational
+ *  number L/M with L and M no larger than 65536, eg 1/48 for 48kHz to
+ *  1kHz, 147/160 for 48kHz to 44.1kHz or 1/10000 for 1MHz to 100Hz. A
+ *  ratio that no such L/M matches to within a relative error of 1e-9 is
+ *  rejected rather than silently changing the output rate. The channel is
+ *  conceptually upsampled by L, lowpass filtered with a Blackman windowed
+ *  sinc at the lower Nyquist frequency, and downsampled by M. Only the
+ *  filter phases that produce output samples are evaluated so the cost is
+ *  proportional to the length of the result.
+ *
+ *  The samples of \e ch are read once, in order, so any Container is
+ *  efficient. Samples before the start and after the end of \e ch are
+ *  taken as zero. Integral magnitudes are rounded to nearest.
+ *
+ *  \code
+ *  basic_channel<float,double,double> ch(first,last,48000.0);
+ *  basic_channel<float,double,double> res = resample(ch,1000.0);
+ *  \endcode
+ */
+template<typename ChannelT>
+inline typename b::remove_const<typename ChannelT::channel_type>::type
+resample(const ChannelT &ch, const typename ChannelT::frequency_type &freq,
+  std::size_t zero_crossings=16)
+{
+  typedef typename b::remove_const<typename ChannelT::channel_type>::type
+    result_type;
+  typedef typename result_type::container_type container_type;
+  typedef typename ChannelT::magnitude_type magnitude_type;
+  typedef typename detail::simd_value_type<magnitude_type>::type
+    value_type;
+
+  BOOST_STATIC_ASSERT(b::is_arithmetic<magnitude_type>::value);
+
+  double in_freq =
+    detail::scalar_value<typename ChannelT::frequency_type>::get(
+      ch.frequency());
+  double out_freq =
+    detail::scalar_value<typename ChannelT::frequency_type>::get(freq);
+
+  if(!(in_freq > 0) || !(out_freq > 0))
+    throw std::invalid_argument("resample: frequency must be positive");
+
+  if(!zero_crossings)
+    throw std::invalid_argument("resample: zero_crossings must be positive");
+
+  double x = out_freq/in_freq;
+  std::pair<std::size_t,std::size_t> ratio =
+    detail::rational_approximation(x,detail::resample_max_factor);
+
+  if(!ratio.first || !ratio.second ||
+    std::fabs(double(ratio.first)/double(ratio.second) - x) >
+      detail::resample_ratio_tolerance*x)
+  {
+    throw std::invalid_argument("resample: frequency ratio is not "
+      "representable");
+  }
+
+  const std::size_t up = ratio.first;
+  const std::size_t down = ratio.second;
+
+  std::size_t in_size = ch.size();
+  if(!in_size)
+    return result_type(container_type(),freq,ch.epoch());
+
+  std::size_t out_size = (in_size*up + down - 1)/down;
+
+  detail::polyphase_filter<value_type> filter(up,down,zero_crossings);
+  const std::size_t taps = filter.taps();
+
+  // zero padded copy of the input so every dot_product is in bounds
+  std::size_t last_hi = ((out_size-1)*down + filter.delay())/up;
+  std::size_t padded = in_size+taps-1;
+  if(last_hi+taps > padded)
+    padded = last_hi+taps;
+
+  std::vector<value_type> buf(padded,value_type());
+  std::copy(ch.begin(),ch.end(),buf.begin()+(taps-1));
+
+  container_type seq(out_size);
+
+  std::size_t hi = filter.delay()/up;
+  std::size_t p = filter.delay()%up;
+  for(typename container_type::iterator out = seq.begin(); out != seq.end();
+    ++out)
+  {
+    value_type val = detail::dot_product(filter.phase(p),&buf[hi],taps);
+    *out = detail::sample_cast<magnitude_type>(val);
+
+    p += down;
+    hi += p/up;
+    p %= up;
+  }
+
+  return result_type(std::move(seq),freq,ch.epoch());
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,683 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_RING_CHANNEL_H
+#define LEMMA_QSAT_RING_CHANNEL_H
+
+#include "basic_channel.h"
+#include "detail/value_cast.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/iterator/iterator_facade.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <cstdint>
+
+/** \file
+ *  \brief Implementation of basic_ring_channel, a fixed capacity lock-free
+ *    single producer, single consumer channel
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+
+namespace detail {
+
+/** \brief Random access iterator over the samples of a basic_ring_channel
+ *  \internal The iterator holds the absolute index of a sample, ie the
+ *    number of samples pushed into the ring before it. Dereferencing yields
+ *    the sample by value. iterator_facade would categorize such an iterator
+ *    as an input iterator, so the category is declared here to keep
+ *    std::distance() and std::advance() constant time.
+ */
+template<typename RingT>
+class ring_iterator :public b::iterator_facade<ring_iterator<RingT>,
+  typename RingT::value_type, std::random_access_iterator_tag,
+  typename RingT::value_type>
+{
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename RingT::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef value_type reference;
+
+    ring_iterator(void) :ring(0), idx(0) {}
+
+    ring_iterator(const RingT *r, std::uint64_t i) :ring(r), idx(i) {}
+
+    /** Absolute index of the referenced sample */
+    std::uint64_t index(void) const {
+      return idx;
+    }
+
+  private:
+    friend class b::iterator_core_access;
+
+    value_type dereference(void) const {
+      return ring->load(idx);
+    }
+
+    bool equal(const ring_iterator &rhs) const {
+      return idx == rhs.idx;
+    }
+
+    void increment(void) {
+      ++idx;
+    }
+
+    void decrement(void) {
+      --idx;
+    }
+
+    void advance(difference_type n) {
+      idx += n;
+    }
+
+    difference_type distance_to(const ring_iterator &rhs) const {
+      return difference_type(rhs.idx - idx);
+    }
+
+    const RingT *ring;
+    std::uint64_t idx;
+};
+
+}
+
+/** \brief Fixed capacity channel backed by a lock-free single producer,
+ *    single consumer ring buffer
+ *  \tparam MagnitudeT The signal magnitude type, must be trivially copyable
+ *  \tparam FrequencyT The signal frequency type
+ *  \tparam TimeT The type used to represent the channels time quantum
+ *  \tparam Allocator The allocator used for the ring storage
+ *
+ *  Model of const std::sequence with Channel additions
+ *
+ *  \par Discussion
+ *  All storage is allocated at construction. push_back() is wait-free,
+ *  never allocates and never blocks, which makes basic_ring_channel suitable
+ *  for ingesting samples from an acquisition thread at a fixed rate. When
+ *  the ring is full, push_back() overwrites the oldest sample. The channel
+ *  then begins one sample later so epoch() advances by one sample period.
+ *  The consumer may also release samples it has processed with pop_front().
+ *  Samples are addressed by their absolute index, which is the number of
+ *  samples pushed before them, so <code>epoch() == initial epoch +
+ *  begin().index()/frequency()</code>.
+ *
+ *  \par Thread safety
+ *  push_back() and append() may be called by one producer thread. All other
+ *  members may be called by one consumer thread concurrently with the
+ *  producer. Iterators and subchannels refer to absolute sample positions
+ *  and remain usable while the producer runs, but a sample read through them
+ *  may have been overwritten by a newer sample in the meantime. Each slot is
+ *  an atomic object so reads are never torn; use expired() after reading to
+ *  discard samples that may have been overwritten, or use snapshot() which
+ *  does so.
+ *  \code
+ *  typedef basic_ring_channel<float,float,float> ring_type;
+ *
+ *  ring_type ring(1<<20,1.0e6f); // ~1s of history at 1MS/s
+ *
+ *  // acquisition thread
+ *  ring.push_back(sample);
+ *
+ *  // processing thread
+ *  ring_type::const_iterator first = ring.begin(), last = ring.end();
+ *  std::vector<float> block(first,last);
+ *  if(ring.expired(first))
+ *    ... // the beginning of block was overwritten while copying
+ *  \endcode
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator = std::allocator>
+class basic_ring_channel :private b::noncopyable {
+  private:
+    typedef std::atomic<MagnitudeT> slot_type;
+    typedef typename std::allocator_traits<Allocator<MagnitudeT> >::
+      template rebind_alloc<slot_type> slot_allocator;
+
+    static_assert(std::is_trivially_copyable<MagnitudeT>::value,
+      "basic_ring_channel requires a trivially copyable MagnitudeT");
+
+  public:
+    /** MagnitudeT by value */
+    typedef MagnitudeT reference;
+    /** MagnitudeT by value */
+    typedef MagnitudeT const_reference;
+    /** iterator type yielding MagnitudeT */
+    typedef detail::ring_iterator<basic_ring_channel> iterator;
+    /** iterator type yielding MagnitudeT */
+    typedef iterator const_iterator;
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** MagnitudeT */
+    typedef MagnitudeT value_type;
+    /** type modeling pointer to const MagnitudeT */
+    typedef const MagnitudeT * pointer;
+    /** type modeling pointer to const MagnitudeT */
+    typedef const MagnitudeT * const_pointer;
+    /** reverse_iterator type yielding MagnitudeT */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type yielding MagnitudeT */
+    typedef reverse_iterator const_reverse_iterator;
+
+    /** MagnitudeT */
+    typedef MagnitudeT magnitude_type;
+    /** FrequencyT */
+    typedef FrequencyT frequency_type;
+    /** TimeT */
+    typedef TimeT time_type;
+
+    /** Subchannel type representing an interval of the ring */
+    typedef basic_subchannel<const basic_ring_channel> const_subchannel_type;
+    /** Subchannel type representing an interval of the ring */
+    typedef const_subchannel_type subchannel_type;
+
+    /** Channel type returned by snapshot() */
+    typedef basic_channel<MagnitudeT,FrequencyT,TimeT,std::vector,Allocator>
+      snapshot_type;
+
+    /** \brief Constructor
+     *
+     *  \param n The minimum capacity of the ring. Rounded up to a power of
+     *    two.
+     *  \param freq A value of <code>basic_channel::frequency_type</code>
+     *    representing the sample frequency. Default is
+     *    <code>basic_channel::frequency_type(1)</code>.
+     *  \param start A value of <code>basic_channel::time_type</code>
+     *    representing the time of the first sample pushed. Default is
+     *    <code>basic_channel::time_type(0)</code>.
+     *  \throws <CODE>std::length_error</CODE> if <CODE>n == 0</CODE>
+     */
+    explicit basic_ring_channel(size_type n,
+      const FrequencyT &freq=detail::value_cast<FrequencyT>::construct(1),
+      const TimeT &start=detail::value_cast<TimeT>::construct(0));
+
+    /** \brief Add a new sample at the end of the channel
+     *
+     *  Producer thread only. Overwrites the oldest sample if the ring is
+     *  full.
+     *
+     *  \param val The value of the new sample
+     */
+    void push_back(const MagnitudeT &val);
+
+    /** \brief Add the samples in <code>[first,last)</code> at the end of the
+     *    channel
+     *
+     *  Producer thread only.
+     *
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to MagnitudeT
+     */
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    /** \brief Release the <em>n</em> oldest samples
+     *
+     *  Consumer thread only.
+     *
+     *  \param n The number of samples to release. Releasing more samples
+     *    than size() releases all of them.
+     */
+    void pop_front(size_type n = 1);
+
+    /** \brief Release all samples
+     *
+     *  Consumer thread only.
+     */
+    void clear(void);
+
+    /** \brief Obtain iterator to the oldest sample
+     *  \return iterator yielding MagnitudeT
+     */
+    const_iterator begin(void) const;
+
+    /** \brief Obtain iterator to one past the newest sample
+     *  \return iterator yielding MagnitudeT
+     */
+    const_iterator end(void) const;
+
+    /** \brief Obtain reverse_iterator to the newest sample
+     *  \return reverse_iterator yielding MagnitudeT
+     */
+    const_reverse_iterator rbegin(void) const;
+
+    /** \brief Obtain reverse_iterator to one before the oldest sample
+     *  \return reverse_iterator yielding MagnitudeT
+     */
+    const_reverse_iterator rend(void) const;
+
+    /** \brief Obtain the number of samples in the ring
+     *  \return channel size
+     */
+    size_type size(void) const;
+
+    /** \brief Obtain the maximum number of samples that can be held
+     *  \return capacity()
+     */
+    size_type max_size(void) const;
+
+    /** \brief Obtain the number of samples the ring holds before the oldest
+     *    sample is overwritten
+     *  \return ring capacity
+     */
+    size_type capacity(void) const;
+
+    /** \brief Obtain whether or not the ring contains any samples
+     *  \return <CODE>size() == 0</CODE>
+     */
+    bool empty(void) const;
+
+    /** \brief Obtain the value of the sample at location <EM>n</EM>
+     *  \param n The sample location relative to begin()
+     *  \return sample value
+     */
+    const_reference operator[](size_type n) const;
+
+    /** \brief Obtain the value of the sample at location <EM>n</EM>
+     *  \param n The sample location relative to begin()
+     *  \return sample value
+     *  \throws <CODE>std::out_of_range</CODE> if <CODE>n >= size()</CODE>
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain the oldest sample
+     *  \return sample value
+     */
+    const_reference front(void) const;
+
+    /** \brief Obtain the newest sample
+     *  \return sample value
+     */
+    const_reference back(void) const;
+
+    /** \brief Determine whether the sample at <em>pos</em> may have been
+     *    overwritten
+     *
+     *  Call after reading the sample(s) at and after <em>pos</em>. If the
+     *  result is <code>false</code>, every value read from <em>pos</em>
+     *  onwards before the call is the sample originally pushed at that
+     *  position.
+     *
+     *  \param pos iterator into the ring
+     *  \return <code>pos < begin()</code>
+     */
+    bool expired(const_iterator pos) const;
+
+    /** \brief Obtain the sample frequency
+     *
+     *  \return The sample frequency
+     */
+    const frequency_type & frequency(void) const;
+
+    /** \brief Obtain the sample epoch
+     *
+     *  The epoch advances by one sample period each time the oldest sample
+     *  is overwritten or released.
+     *
+     *  \return The time of the sample at begin()
+     */
+    time_type epoch(void) const;
+
+    /** \brief Obtain a constant subset of this channel
+     *
+     *  \par Discussion
+     *  The samples of the subchannel may be overwritten by the producer, see
+     *  expired().
+     *
+     *  \return A constant subset into this channel.
+     */
+    const_subchannel_type subchannel(const_iterator first,
+      const_iterator last) const;
+
+    /** \brief Copy the current contents of the ring into a basic_channel
+     *
+     *  Samples that are overwritten while being copied are excluded, the
+     *  epoch of the result is the time of its first sample.
+     *
+     *  \return A consistent copy of the ring contents
+     */
+    snapshot_type snapshot(void) const;
+
+  private:
+    friend class detail::ring_iterator<basic_ring_channel>;
+    friend struct detail::channel_position<basic_ring_channel>;
+
+    const FrequencyT _sample_frequency;
+    const TimeT _time_start;
+
+    std::vector<slot_type,slot_allocator> slots;
+    const std::uint64_t mask;
+
+    // written by the producer
+    alignas(64) std::atomic<std::uint64_t> head;
+    // advanced by the consumer, or the producer when overwriting
+    alignas(64) std::atomic<std::uint64_t> tail;
+
+    static size_type ring_length(size_type n);
+
+    MagnitudeT load(std::uint64_t idx) const;
+    time_type time_at(std::uint64_t idx) const;
+};
+
+namespace detail {
+
+/** \brief Subchannels of a ring record absolute sample positions
+ *  \internal The tail moves as samples are released or overwritten so an
+ *  offset relative to begin() would not remain valid.
+ */
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+struct channel_position<
+  basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator> >
+{
+  typedef basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>
+    channel_type;
+
+  static typename channel_type::size_type
+  offset(const channel_type &, typename channel_type::const_iterator pos) {
+    return pos.index();
+  }
+
+  static typename channel_type::time_type
+  time(const channel_type &ch, typename channel_type::size_type off) {
+    return ch.time_at(off);
+  }
+};
+
+}
+
+
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  basic_ring_channel(size_type n, const FrequencyT &freq, const TimeT &start)
+    :_sample_frequency(freq), _time_start(start), slots(ring_length(n)),
+      mask(slots.size()-1), head(0), tail(0)
+{
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  push_back(const MagnitudeT &val)
+{
+  std::uint64_t h = head.load(std::memory_order_relaxed);
+  std::uint64_t t = tail.load(std::memory_order_relaxed);
+
+  if(h-t > mask) {
+    // Full, drop the oldest sample. Failure means that the consumer has
+    // released samples in the meantime and the slot is free. The fence
+    // orders the new tail before the slot store so that a consumer
+    // observing the new value in the slot also observes the new tail.
+    tail.compare_exchange_strong(t,t+1,std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  slots[h & mask].store(val,std::memory_order_relaxed);
+  head.store(h+1,std::memory_order_release);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+template<typename InputIterator>
+inline void basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  append(InputIterator first, InputIterator last)
+{
+  while(first != last)
+    push_back(*first++);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  pop_front(size_type n)
+{
+  std::uint64_t t = tail.load(std::memory_order_relaxed);
+  std::uint64_t last;
+  do {
+    last = std::min<std::uint64_t>(t+n,head.load(std::memory_order_acquire));
+  } while(t < last &&
+    !tail.compare_exchange_weak(t,last,std::memory_order_relaxed));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline void basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  clear(void)
+{
+  pop_front(slots.size());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_iterator
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::begin(void) const
+{
+  return const_iterator(this,tail.load(std::memory_order_acquire));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_iterator
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::end(void) const
+{
+  return const_iterator(this,head.load(std::memory_order_acquire));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reverse_iterator
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::rbegin(void) const
+{
+  return const_reverse_iterator(end());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reverse_iterator
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::rend(void) const
+{
+  return const_reverse_iterator(begin());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size(void) const
+{
+  // tail first, it never passes head
+  std::uint64_t t = tail.load(std::memory_order_acquire);
+  std::uint64_t h = head.load(std::memory_order_acquire);
+
+  return std::min<std::uint64_t>(h-t,slots.size());
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::max_size(void) const
+{
+  return slots.size();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::capacity(void) const
+{
+  return slots.size();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline bool basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  empty(void) const
+{
+  return size() == 0;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  operator[](size_type n) const
+{
+  return begin()[n];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::at(size_type n) const
+{
+  if(n >= size())
+    throw std::out_of_range("basic_ring_channel::at");
+
+  return begin()[n];
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::front(void) const
+{
+  return *begin();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_reference
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::back(void) const
+{
+  return *--end();
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline bool basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  expired(const_iterator pos) const
+{
+  // pairs with the release fence in push_back()
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return pos.index() < tail.load(std::memory_order_relaxed);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline const typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency_type &
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::frequency(void) const
+{
+  return _sample_frequency;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::epoch(void) const
+{
+  return time_at(tail.load(std::memory_order_acquire));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::const_subchannel_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  subchannel(const_iterator first, const_iterator last) const
+{
+  return const_subchannel_type(*this,first,last);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::snapshot_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::snapshot(void) const
+{
+  const_iterator first = begin();
+  const_iterator last = end();
+  if(size_type(last-first) > slots.size())
+    first = last-slots.size();
+
+  std::vector<MagnitudeT> buf(first,last);
+
+  // discard the samples that were overwritten while copying, see expired()
+  std::atomic_thread_fence(std::memory_order_acquire);
+  std::uint64_t valid = std::min(last.index(),
+    std::max(first.index(),tail.load(std::memory_order_relaxed)));
+
+  return snapshot_type(buf.begin()+(valid-first.index()),buf.end(),
+    _sample_frequency,time_at(valid));
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::size_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::ring_length(size_type n)
+{
+  if(!n)
+    throw std::length_error("basic_ring_channel: zero capacity");
+
+  size_type len = 1;
+  while(len < n)
+    len <<= 1;
+
+  return len;
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline MagnitudeT basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  load(std::uint64_t idx) const
+{
+  return slots[idx & mask].load(std::memory_order_relaxed);
+}
+
+template<typename MagnitudeT, typename FrequencyT, typename TimeT,
+  template<typename T> class Allocator>
+inline typename basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::time_type
+basic_ring_channel<MagnitudeT,FrequencyT,TimeT,Allocator>::
+  time_at(std::uint64_t idx) const
+{
+  return _time_start + double(idx) / _sample_frequency;
+}
+
+}
+}
+
+
+#endif
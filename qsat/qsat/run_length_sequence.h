@@ -0,0 +1,1157 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LEMMA_QSAT_RUN_LENGTH_SEQUENCE_H
+#define LEMMA_QSAT_RUN_LENGTH_SEQUENCE_H
+
+#include <boost/mpl/bool.hpp>
+#include <boost/mpl/if.hpp>
+#include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_floating_point.hpp>
+#include <boost/type_traits/is_same.hpp>
+
+#include <memory>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <cstddef>
+#include <cstring>
+#include <cmath>
+
+/** \file
+ *  \brief Implementation of run_length_sequence, a sequence stored as runs
+ *    of equal values
+ */
+
+namespace lemma {
+namespace qsat {
+
+namespace b = boost;
+namespace mpl = boost::mpl;
+
+namespace detail {
+
+/** \internal A run ending one before \e end, either of copies of \e value
+ *  or, unless \e literal is the largest SizeT, a literal segment whose
+ *  elements are stored contiguously from index \e literal of the literal
+ *  pool
+ */
+template<typename T, typename SizeT>
+struct value_run {
+  T value;
+  SizeT end;
+  SizeT literal;
+};
+
+/** \internal Floating point values share a run only if their bits are
+ *    identical, so that -0.0 is not lost in a run of 0.0 and equal NaNs
+ *    form one run. Only float and double are compared bytewise, other
+ *    floating point types such as the x87 long double may have padding
+ *    bytes of indeterminate value and are compared by value and sign
+ *    instead, so that all of their NaNs share a run.
+ */
+template<typename T>
+inline bool same_run_value(const T &lhs, const T &rhs, mpl::true_)
+{
+  if(b::is_same<T,float>::value || b::is_same<T,double>::value)
+    return std::memcmp(&lhs,&rhs,sizeof(T)) == 0;
+
+  if(std::isnan(lhs) || std::isnan(rhs))
+    return std::isnan(lhs) && std::isnan(rhs);
+
+  return lhs == rhs && std::signbit(lhs) == std::signbit(rhs);
+}
+
+template<typename T>
+inline bool same_run_value(const T &lhs, const T &rhs, mpl::false_)
+{
+  return lhs == rhs;
+}
+
+/** \internal Determine if \e lhs and \e rhs may be stored in one run */
+template<typename T>
+inline bool same_run_value(const T &lhs, const T &rhs)
+{
+  return same_run_value(lhs,rhs,
+    typename mpl::bool_<b::is_floating_point<T>::value>::type());
+}
+
+/** \internal Orders an index before the runs that end after it */
+struct run_end_compare {
+  template<typename SizeT, typename RunT>
+  bool operator()(SizeT n, const RunT &run) const {
+    return n < run.end;
+  }
+};
+
+/** \brief Writable reference to an element of a run_length_sequence
+ *  \internal
+ *  Reads decode the run containing the element, assignment goes through
+ *  run_length_sequence::set().
+ */
+template<typename SequenceT>
+class run_length_reference {
+  public:
+    typedef typename SequenceT::value_type value_type;
+
+    run_length_reference(SequenceT *s, std::size_t p) :seq(s), pos(p) {}
+
+    operator value_type(void) const {
+      return static_cast<const SequenceT &>(*seq)[pos];
+    }
+
+    run_length_reference & operator=(const value_type &val) {
+      seq->set(pos,val);
+      return *this;
+    }
+
+    run_length_reference & operator=(const run_length_reference &rhs) {
+      return *this = value_type(rhs);
+    }
+
+  private:
+    SequenceT *seq;
+    std::size_t pos;
+};
+
+/** \brief Random access iterator over a run_length_sequence
+ *  \internal
+ *  Remembers the run of the last element dereferenced so that sequential
+ *  traversal finds each element in constant time. Any other seek is a
+ *  binary search over the run ends. Since the run is found again on each
+ *  access, the iterator remains valid over writes through set() that do
+ *  not change the size of the sequence.
+ */
+template<typename SequenceT, bool Constant>
+class run_length_iterator {
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef typename SequenceT::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type * pointer;
+    typedef typename mpl::if_c<Constant,value_type,
+      run_length_reference<SequenceT> >::type reference;
+
+    typedef typename mpl::if_c<Constant,const SequenceT *,
+      SequenceT *>::type sequence_pointer;
+
+    run_length_iterator(void) :seq(0), pos(0), run(0) {}
+
+    run_length_iterator(sequence_pointer s, std::size_t p) :seq(s), pos(p),
+      run(0) {}
+
+    run_length_iterator(const run_length_iterator<SequenceT,false> &rhs)
+      :seq(rhs.seq), pos(rhs.pos), run(rhs.run) {}
+
+    reference operator*(void) const {
+      return deref(mpl::bool_<Constant>());
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    run_length_iterator & operator++(void) {
+      ++pos;
+      return *this;
+    }
+
+    run_length_iterator operator++(int) {
+      run_length_iterator tmp(*this);
+      ++pos;
+      return tmp;
+    }
+
+    run_length_iterator & operator--(void) {
+      --pos;
+      return *this;
+    }
+
+    run_length_iterator operator--(int) {
+      run_length_iterator tmp(*this);
+      --pos;
+      return tmp;
+    }
+
+    run_length_iterator & operator+=(difference_type n) {
+      pos += n;
+      return *this;
+    }
+
+    run_length_iterator & operator-=(difference_type n) {
+      pos -= n;
+      return *this;
+    }
+
+    run_length_iterator operator+(difference_type n) const {
+      run_length_iterator tmp(*this);
+      return tmp += n;
+    }
+
+    run_length_iterator operator-(difference_type n) const {
+      run_length_iterator tmp(*this);
+      return tmp -= n;
+    }
+
+    difference_type operator-(const run_length_iterator &rhs) const {
+      return difference_type(pos) - difference_type(rhs.pos);
+    }
+
+    bool operator==(const run_length_iterator &rhs) const {
+      return pos == rhs.pos;
+    }
+
+    bool operator!=(const run_length_iterator &rhs) const {
+      return pos != rhs.pos;
+    }
+
+    bool operator<(const run_length_iterator &rhs) const {
+      return pos < rhs.pos;
+    }
+
+    bool operator>(const run_length_iterator &rhs) const {
+      return pos > rhs.pos;
+    }
+
+    bool operator<=(const run_length_iterator &rhs) const {
+      return pos <= rhs.pos;
+    }
+
+    bool operator>=(const run_length_iterator &rhs) const {
+      return pos >= rhs.pos;
+    }
+
+    /** the index of the element */
+    std::size_t index(void) const {
+      return pos;
+    }
+
+    /** the number of elements from this one to the end of its run, all of
+     *  which equal *this, one within a literal segment
+     */
+    std::size_t run_remaining(void) const {
+      run = seq->find_run(pos,run);
+      return seq->is_literal(run) ? 1 : seq->runs[run].end - pos;
+    }
+
+    /** the number of elements from this one to the end of its run or
+     *  literal segment
+     */
+    std::size_t segment_remaining(void) const {
+      run = seq->find_run(pos,run);
+      return seq->runs[run].end - pos;
+    }
+
+    /** pointer to this element within a literal segment, the following
+     *  segment_remaining() elements are contiguous from it. Null within a
+     *  run of equal values.
+     */
+    pointer literal(void) const {
+      run = seq->find_run(pos,run);
+      if(!seq->is_literal(run))
+        return 0;
+
+      return &seq->literals[seq->literal_index(run,pos)];
+    }
+
+    /** the value of the current element */
+    value_type value(void) const {
+      run = seq->find_run(pos,run);
+      return seq->element(run,pos);
+    }
+
+  private:
+    template<typename, bool> friend class run_length_iterator;
+
+    sequence_pointer seq;
+    std::size_t pos;
+    mutable std::size_t run;
+
+    reference deref(mpl::true_) const {
+      return value();
+    }
+
+    reference deref(mpl::false_) const {
+      return reference(seq,pos);
+    }
+};
+
+template<typename SequenceT, bool Constant>
+inline run_length_iterator<SequenceT,Constant>
+operator+(std::ptrdiff_t n, const run_length_iterator<SequenceT,Constant> &it)
+{
+  return it + n;
+}
+
+}
+
+/** \brief Sequence stored as runs of equal values
+ *  \tparam T The element type, must be EqualityComparable
+ *  \tparam A Allocator type, rebound for the runs
+ *
+ *  Model of std::sequence with optional members, except that elements are
+ *  not lvalues
+ *
+ *  \par Discussion
+ *  Consecutive equal elements are stored once along with the index one
+ *  past the end of their run so that memory is proportional to the number
+ *  of runs rather than the number of elements. Fill construction,
+ *  assign(n,val) and resize() with a value equal to the last element cost
+ *  constant time and memory regardless of \e n, which suits zero filled
+ *  channels that are later overlaid with data, padding, and long flat
+ *  segments. Floating point elements are equal only if their bits are, so
+ *  that -0.0 and 0.0 are kept apart and repeated NaNs share a run.
+ *
+ *  \par
+ *  Element access finds the run of the element with a binary search over
+ *  the run ends. Iterators remember their run so that sequential traversal
+ *  costs constant time per element. Kernels may consume a whole run at a
+ *  time by advancing an iterator by its run_remaining() elements.
+ *
+ *  \par
+ *  An element is written through a proxy reference or set(), splitting its
+ *  run into at most three. Only the written elements are materialized,
+ *  writing consecutive elements of a run from its start costs amortized
+ *  constant time. Insertion and erasure cost time proportional to the
+ *  number of runs following the position. Copies, and so the copy on
+ *  write detach of a shared basic_channel, copy the runs rather than the
+ *  elements.
+ *
+ *  \par
+ *  Each run costs its value, its end and a literal index, eg 24 bytes for
+ *  a float, so distinct elements written one at a time cost six times the
+ *  memory of a std::vector. A block of distinct samples is instead
+ *  written with set(pos,first,last), which stores it as one literal
+ *  segment: a run whose elements are held contiguously in a pool shared
+ *  by all segments. Writes into a literal segment, through set() or a
+ *  reference, overwrite it in place. Iterators expose a segment through
+ *  literal() and segment_remaining(). The storage of erased and
+ *  overwritten segments is reclaimed once it exceeds the live part of the
+ *  pool.
+ *
+ *  \code
+ *  typedef basic_channel<float,double,double,run_length_sequence>
+ *    channel_type;
+ *
+ *  // one run regardless of length
+ *  channel_type channel(1000000000,0.0f,1000.0);
+ *  channel[42] = 1.0f;
+ *
+ *  // one literal segment holding the 4096 samples
+ *  run_length_sequence<float> seq(1000000000,0.0f);
+ *  seq.set(1000,block,block+4096);
+ *  \endcode
+ */
+template<typename T, typename A = std::allocator<T> >
+class run_length_sequence {
+  public:
+    /** proxy reference assigning through set() */
+    typedef detail::run_length_reference<run_length_sequence> reference;
+    /** T, elements are returned by value */
+    typedef T const_reference;
+    /** iterator yielding reference */
+    typedef detail::run_length_iterator<run_length_sequence,false> iterator;
+    /** read only iterator yielding T */
+    typedef detail::run_length_iterator<run_length_sequence,true>
+      const_iterator;
+    /** unsigned integral type */
+    typedef std::size_t size_type;
+    /** signed integral type */
+    typedef std::ptrdiff_t difference_type;
+    /** T */
+    typedef T value_type;
+    /** Allocator */
+    typedef A allocator_type;
+    /** type modeling pointer to T */
+    typedef const T * pointer;
+    /** type modeling pointer to const T */
+    typedef const T * const_pointer;
+    /** reverse_iterator type yielding reference */
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    /** reverse_iterator type yielding T */
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    /** \brief Default Constructor
+     *  \param alloc The allocator
+     */
+    explicit run_length_sequence(const allocator_type &a = allocator_type())
+      :alloc(a), runs(run_allocator(a)), literals(literal_allocator(a)),
+      garbage(0) {}
+
+    /** \brief Fill Constructor
+     *  \param n The number of copies of \e value to make
+     *  \param value The value to copy
+     *  \param alloc The allocator
+     *  \post size() == \e n
+     *
+     *  Stores a single run regardless of \e n
+     */
+    explicit run_length_sequence(size_type n, const T &value = T(),
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Constructor
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \param alloc The allocator
+     *  \post size() == <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    run_length_sequence(InputIterator first, InputIterator last,
+      const allocator_type &alloc = allocator_type());
+
+    /** \brief Range Assignment Operator
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \post size() = <code>std::distance(first,last)</code>
+     */
+    template<typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /** \brief Fill Assignment Operator
+     *  \param n The number of <em>val</em> object to assign to this sequence
+     *  \param val The value of the objects that are assigned to this
+     *  \post size() = <em>n</em>
+     */
+    void assign(size_type n, const T &val);
+
+    /** \brief Obtain a copy of the allocator */
+    allocator_type get_allocator(void) const {
+      return alloc;
+    }
+
+    /** \brief Obtain iterator to sequence beginning */
+    iterator begin(void) {
+      return iterator(this,0);
+    }
+
+    /** \brief Obtain iterator to sequence beginning */
+    const_iterator begin(void) const {
+      return const_iterator(this,0);
+    }
+
+    /** \brief Obtain iterator to one past sequence end */
+    iterator end(void) {
+      return iterator(this,size());
+    }
+
+    /** \brief Obtain iterator to one past sequence end */
+    const_iterator end(void) const {
+      return const_iterator(this,size());
+    }
+
+    /** \brief Obtain reverse iterator to sequence end */
+    reverse_iterator rbegin(void) {
+      return reverse_iterator(end());
+    }
+
+    /** \brief Obtain reverse iterator to sequence end */
+    const_reverse_iterator rbegin(void) const {
+      return const_reverse_iterator(end());
+    }
+
+    /** \brief Obtain reverse iterator to one before sequence beginning */
+    reverse_iterator rend(void) {
+      return reverse_iterator(begin());
+    }
+
+    /** \brief Obtain reverse iterator to one before sequence beginning */
+    const_reverse_iterator rend(void) const {
+      return const_reverse_iterator(begin());
+    }
+
+    /** \brief Obtain the number of elements */
+    size_type size(void) const {
+      return runs.empty() ? 0 : runs.back().end;
+    }
+
+    /** \brief Obtain the largest possible number of elements */
+    size_type max_size(void) const {
+      return std::numeric_limits<difference_type>::max();
+    }
+
+    /** \brief Resize to \e sz elements, appending copies of \e val */
+    void resize(size_type sz, const T &val = T());
+
+    /** \brief Obtain the number of elements, elements are not preallocated
+     */
+    size_type capacity(void) const {
+      return size();
+    }
+
+    /** \brief Determine if the sequence is empty */
+    bool empty(void) const {
+      return runs.empty();
+    }
+
+    /** \brief Obtain the element at \e n \pre \e n < size() */
+    const_reference operator[](size_type n) const {
+      return element(find_run(n,0),n);
+    }
+
+    /** \brief Obtain a reference to the element at \e n \pre \e n < size()
+     */
+    reference operator[](size_type n) {
+      return reference(this,n);
+    }
+
+    /** \brief Obtain the element at \e n
+     *  \throws <CODE>std::out_of_range</CODE> if \e n >= size()
+     */
+    const_reference at(size_type n) const;
+
+    /** \brief Obtain a reference to the element at \e n
+     *  \throws <CODE>std::out_of_range</CODE> if \e n >= size()
+     */
+    reference at(size_type n);
+
+    /** \brief Obtain the first element \pre !empty() */
+    const_reference front(void) const {
+      return element(0,0);
+    }
+
+    /** \brief Obtain a reference to the first element \pre !empty() */
+    reference front(void) {
+      return reference(this,0);
+    }
+
+    /** \brief Obtain the last element \pre !empty() */
+    const_reference back(void) const {
+      return element(runs.size()-1,size()-1);
+    }
+
+    /** \brief Obtain a reference to the last element \pre !empty() */
+    reference back(void) {
+      return reference(this,size()-1);
+    }
+
+    /** \brief Append \e val, extending the last run if equal */
+    void push_back(const T &val) {
+      append_run(val,1);
+    }
+
+    /** \brief Remove the last element \pre !empty() */
+    void pop_back(void);
+
+    /** \brief Assign \e val to the element at \e n
+     *  \pre \e n < size()
+     *
+     *  Splits the run containing \e n into at most three, merging with the
+     *  neighboring runs when equal to \e val. Within a literal segment the
+     *  element is overwritten in place.
+     */
+    void set(size_type n, const T &val);
+
+    /** \brief Assign [\e first, \e last) to the elements from \e pos
+     *  \param pos The index of the first element to assign
+     *  \param first,last <code>InputIterator</code> range pointing to objects
+     *    convertable to T
+     *  \pre \e pos + <code>std::distance(first,last)</code> <= size()
+     *
+     *  Stores the range as one literal segment replacing the runs it
+     *  covers, or overwrites it in place if it lies within one literal
+     *  segment.
+     */
+    template<typename InputIterator>
+    void set(size_type pos, InputIterator first, InputIterator last);
+
+    /** \brief Insert \e val before \e position
+     *  \return iterator to the inserted element
+     */
+    iterator insert(iterator position, const T &val);
+
+    /** \brief Insert \e n copies of \e val before \e position */
+    void insert(iterator position, size_type n, const T &val);
+
+    /** \brief Insert [\e first, \e last) before \e position */
+    template<typename InputIterator>
+    void insert(iterator position, InputIterator first, InputIterator last);
+
+    /** \brief Erase the element at \e position
+     *  \return iterator to the element following the erased one
+     */
+    iterator erase(iterator position) {
+      return erase(position,position+1);
+    }
+
+    /** \brief Erase [\e first, \e last)
+     *  \return iterator to the element following the erased ones
+     */
+    iterator erase(iterator first, iterator last);
+
+    /** \brief Swap contents with \e rhs */
+    void swap(run_length_sequence &rhs);
+
+    /** \brief Remove all elements \post empty() */
+    void clear(void) {
+      runs.clear();
+      literals.clear();
+      garbage = 0;
+    }
+
+    /** \brief Obtain the number of runs of equal values */
+    size_type run_count(void) const {
+      return runs.size();
+    }
+
+  private:
+    friend class detail::run_length_iterator<run_length_sequence,false>;
+    friend class detail::run_length_iterator<run_length_sequence,true>;
+
+    typedef detail::value_run<T,size_type> run_type;
+    typedef typename std::allocator_traits<A>::template
+      rebind_alloc<run_type> run_allocator;
+    typedef std::vector<run_type,run_allocator> run_vector;
+    typedef typename std::allocator_traits<A>::template
+      rebind_alloc<T> literal_allocator;
+    typedef std::vector<T,literal_allocator> literal_vector;
+
+    static const size_type no_literal = size_type(-1);
+
+    allocator_type alloc;
+    run_vector runs;
+    literal_vector literals;
+    // elements of literals no longer referenced by a run
+    size_type garbage;
+
+    size_type run_begin(size_type r) const {
+      return r ? runs[r-1].end : 0;
+    }
+
+    bool is_literal(size_type r) const {
+      return runs[r].literal != no_literal;
+    }
+
+    size_type literal_index(size_type r, size_type n) const {
+      return runs[r].literal + (n - run_begin(r));
+    }
+
+    const_reference element(size_type r, size_type n) const {
+      return is_literal(r) ? literals[literal_index(r,n)] : runs[r].value;
+    }
+
+    void discard(size_type r_first, size_type r_last);
+
+    void compact(void);
+
+    void append_literal(const T *first, const T *last);
+
+    size_type find_run(size_type n, size_type hint) const;
+
+    size_type split(size_type n);
+
+    void merge(size_type r);
+
+    void shift(size_type r, size_type n, bool grow);
+
+    void append_run(const T &val, size_type n);
+
+    template<typename InputIterator>
+    void append(InputIterator first, InputIterator last);
+
+    template<bool Constant>
+    void append(detail::run_length_iterator<run_length_sequence,Constant> first,
+      detail::run_length_iterator<run_length_sequence,Constant> last);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void assign_thunk(InputIterator first, InputIterator last, mpl::false_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::true_);
+
+    template<typename InputIterator>
+    void insert_thunk(iterator position, InputIterator first,
+      InputIterator last, mpl::false_);
+};
+
+
+
+template<typename T, typename A>
+const typename run_length_sequence<T,A>::size_type
+  run_length_sequence<T,A>::no_literal;
+
+template<typename T, typename A>
+inline run_length_sequence<T,A>::run_length_sequence(size_type n,
+  const T &value, const allocator_type &a) :alloc(a), runs(run_allocator(a)),
+  literals(literal_allocator(a)), garbage(0)
+{
+  append_run(value,n);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline run_length_sequence<T,A>::run_length_sequence(InputIterator first,
+  InputIterator last, const allocator_type &a) :alloc(a),
+  runs(run_allocator(a)), literals(literal_allocator(a)), garbage(0)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::assign(InputIterator first,
+  InputIterator last)
+{
+  assign_thunk(first,last,typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::assign(size_type n, const T &val)
+{
+  clear();
+  append_run(val,n);
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::resize(size_type sz, const T &val)
+{
+  size_type count = size();
+  if(sz < count)
+    erase(iterator(this,sz),end());
+  else
+    append_run(val,sz-count);
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::const_reference
+run_length_sequence<T,A>::at(size_type n) const
+{
+  if(n >= size())
+    throw std::out_of_range("run_length_sequence: index out of range");
+
+  return (*this)[n];
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::reference
+run_length_sequence<T,A>::at(size_type n)
+{
+  if(n >= size())
+    throw std::out_of_range("run_length_sequence: index out of range");
+
+  return (*this)[n];
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::pop_back(void)
+{
+  size_type r = runs.size()-1;
+  if(is_literal(r)) {
+    if(literal_index(r,size()-1)+1 == literals.size())
+      literals.pop_back();
+    else
+      ++garbage;
+  }
+
+  if(--runs.back().end == run_begin(r))
+    runs.pop_back();
+
+  compact();
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::set(size_type n, const T &val)
+{
+  size_type r = find_run(n,0);
+  if(is_literal(r)) {
+    literals[literal_index(r,n)] = val;
+    return;
+  }
+
+  if(detail::same_run_value(runs[r].value,val))
+    return;
+
+  size_type first = run_begin(r);
+  if(runs[r].end - first == 1) {
+    runs[r].value = val;
+    if(r+1 < runs.size())
+      merge(r+1);
+    if(r)
+      merge(r);
+  }
+  else if(n == first) {
+    // the preceding run, if equal, grows into this one
+    if(r && !is_literal(r-1) && detail::same_run_value(runs[r-1].value,val))
+      ++runs[r-1].end;
+    else {
+      run_type head = {val,n+1,no_literal};
+      runs.insert(runs.begin()+r,head);
+    }
+  }
+  else if(n+1 == runs[r].end) {
+    // the following run, if equal, grows into this one
+    --runs[r].end;
+    if(r+1 == runs.size() || is_literal(r+1) ||
+      !detail::same_run_value(runs[r+1].value,val))
+    {
+      run_type tail = {val,n+1,no_literal};
+      runs.insert(runs.begin()+r+1,tail);
+    }
+  }
+  else {
+    run_type split_runs[2] = {{runs[r].value,n,no_literal},
+      {val,n+1,no_literal}};
+    runs.insert(runs.begin()+r,split_runs,split_runs+2);
+  }
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::set(size_type pos, InputIterator first,
+  InputIterator last)
+{
+  // copy the range into the pool first in case it refers to this sequence
+  size_type off = literals.size();
+  for(; first != last; ++first) {
+    T val = *first;
+    literals.push_back(val);
+  }
+
+  size_type n = literals.size() - off;
+  if(!n)
+    return;
+
+  size_type r = find_run(pos,0);
+  if(is_literal(r) && pos+n <= runs[r].end) {
+    // overwrite within the segment
+    std::copy(literals.begin()+off,literals.end(),
+      literals.begin()+literal_index(r,pos));
+    literals.erase(literals.begin()+off,literals.end());
+    return;
+  }
+
+  r = split(pos);
+  size_type r_last = split(pos+n);
+  discard(r,r_last);
+  runs.erase(runs.begin()+r+1,runs.begin()+r_last);
+  runs[r].end = pos+n;
+  runs[r].literal = off;
+
+  if(r+1 < runs.size())
+    merge(r+1);
+  if(r)
+    merge(r);
+
+  compact();
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::iterator
+run_length_sequence<T,A>::insert(iterator position, const T &val)
+{
+  size_type idx = position.index();
+  insert(position,size_type(1),val);
+  return iterator(this,idx);
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::insert(iterator position, size_type n,
+  const T &val)
+{
+  if(!n)
+    return;
+
+  size_type idx = position.index();
+  size_type r = split(idx);
+  run_type run = {val,idx+n,no_literal};
+  runs.insert(runs.begin()+r,run);
+  shift(r+1,n,true);
+
+  if(r+1 < runs.size())
+    merge(r+1);
+  if(r)
+    merge(r);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::insert(iterator position,
+  InputIterator first, InputIterator last)
+{
+  insert_thunk(position,first,last,
+    typename b::is_integral<InputIterator>::type());
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::iterator
+run_length_sequence<T,A>::erase(iterator first, iterator last)
+{
+  size_type idx = first.index();
+  size_type n = last.index() - idx;
+  if(!n)
+    return first;
+
+  size_type r = split(idx);
+  size_type r_last = split(idx+n);
+  discard(r,r_last);
+  runs.erase(runs.begin()+r,runs.begin()+r_last);
+  shift(r,n,false);
+
+  if(r && r < runs.size())
+    merge(r);
+
+  compact();
+  return iterator(this,idx);
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::swap(run_length_sequence &rhs)
+{
+  using std::swap;
+
+  swap(alloc,rhs.alloc);
+  runs.swap(rhs.runs);
+  literals.swap(rhs.literals);
+  swap(garbage,rhs.garbage);
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::size_type
+run_length_sequence<T,A>::find_run(size_type n, size_type hint) const
+{
+  if(hint < runs.size() && n < runs[hint].end && run_begin(hint) <= n)
+    return hint;
+
+  // sequential traversal steps into the next run
+  if(hint+1 < runs.size() && n < runs[hint+1].end && runs[hint].end <= n)
+    return hint+1;
+
+  return std::upper_bound(runs.begin(),runs.end(),n,
+    detail::run_end_compare()) - runs.begin();
+}
+
+template<typename T, typename A>
+inline typename run_length_sequence<T,A>::size_type
+run_length_sequence<T,A>::split(size_type n)
+{
+  if(n >= size())
+    return runs.size();
+
+  size_type r = find_run(n,0);
+  if(run_begin(r) == n)
+    return r;
+
+  run_type head = runs[r];
+  head.end = n;
+  if(is_literal(r))
+    runs[r].literal = literal_index(r,n);
+  runs.insert(runs.begin()+r,head);
+  return r+1;
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::merge(size_type r)
+{
+  // literal segments merge only if adjacent in the pool
+  bool adjacent = is_literal(r-1) ?
+    is_literal(r) && literal_index(r-1,runs[r-1].end) == runs[r].literal :
+    !is_literal(r) && detail::same_run_value(runs[r-1].value,runs[r].value);
+
+  if(adjacent) {
+    runs[r-1].end = runs[r].end;
+    runs.erase(runs.begin()+r);
+  }
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::shift(size_type r, size_type n,
+  bool grow)
+{
+  for(typename run_vector::iterator cur = runs.begin()+r; cur != runs.end();
+    ++cur)
+  {
+    if(grow)
+      cur->end += n;
+    else
+      cur->end -= n;
+  }
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::append_run(const T &val, size_type n)
+{
+  if(!n)
+    return;
+
+  if(!runs.empty() && !is_literal(runs.size()-1) &&
+    detail::same_run_value(runs.back().value,val))
+  {
+    runs.back().end += n;
+  }
+  else {
+    run_type run = {val,size()+n,no_literal};
+    runs.push_back(run);
+  }
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::append_literal(const T *first,
+  const T *last)
+{
+  size_type off = literals.size();
+  size_type n = last - first;
+  literals.insert(literals.end(),first,last);
+
+  if(!runs.empty() && is_literal(runs.size()-1) &&
+    literal_index(runs.size()-1,size()) == off)
+  {
+    runs.back().end += n;
+  }
+  else {
+    run_type run = {T(),size()+n,off};
+    runs.push_back(run);
+  }
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::discard(size_type r_first,
+  size_type r_last)
+{
+  for(size_type r=r_first; r<r_last; ++r) {
+    if(is_literal(r))
+      garbage += runs[r].end - run_begin(r);
+  }
+}
+
+template<typename T, typename A>
+inline void run_length_sequence<T,A>::compact(void)
+{
+  if(2*garbage <= literals.size())
+    return;
+
+  literal_vector live(literals.get_allocator());
+  live.reserve(literals.size() - garbage);
+  for(size_type r=0; r<runs.size(); ++r) {
+    if(is_literal(r)) {
+      typename literal_vector::iterator first =
+        literals.begin() + runs[r].literal;
+      runs[r].literal = live.size();
+      live.insert(live.end(),first,first + (runs[r].end - run_begin(r)));
+    }
+  }
+
+  literals.swap(live);
+  garbage = 0;
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::append(InputIterator first,
+  InputIterator last)
+{
+  for(; first != last; ++first)
+    push_back(*first);
+}
+
+template<typename T, typename A>
+template<bool Constant>
+inline void run_length_sequence<T,A>::append(
+  detail::run_length_iterator<run_length_sequence,Constant> first,
+  detail::run_length_iterator<run_length_sequence,Constant> last)
+{
+  // copy whole runs and literal segments
+  while(first != last) {
+    size_type n = std::min<size_type>(first.segment_remaining(),last-first);
+    if(const T *lit = first.literal())
+      append_literal(lit,lit+n);
+    else
+      append_run(first.value(),n);
+    first += n;
+  }
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::true_)
+{
+  assign(size_type(first),T(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::assign_thunk(InputIterator first,
+  InputIterator last, mpl::false_)
+{
+  // build aside in case the range refers to this sequence
+  run_length_sequence tmp(alloc);
+  tmp.append(first,last);
+  swap(tmp);
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::true_)
+{
+  insert(position,size_type(first),T(last));
+}
+
+template<typename T, typename A>
+template<typename InputIterator>
+inline void run_length_sequence<T,A>::insert_thunk(iterator position,
+  InputIterator first, InputIterator last, mpl::false_)
+{
+  // encode the range first in case it refers to this sequence
+  run_length_sequence range(alloc);
+  range.append(first,last);
+  if(range.empty())
+    return;
+
+  size_type idx = position.index();
+  size_type n = range.size();
+  size_type r = split(idx);
+  size_type nruns = range.runs.size();
+  shift(r,n,true);
+  range.shift(0,idx,true);
+
+  // move the literal segments of the range into this pool
+  for(typename run_vector::iterator cur = range.runs.begin();
+    cur != range.runs.end(); ++cur)
+  {
+    if(cur->literal != no_literal)
+      cur->literal += literals.size();
+  }
+  literals.insert(literals.end(),range.literals.begin(),range.literals.end());
+  runs.insert(runs.begin()+r,range.runs.begin(),range.runs.end());
+
+  if(r+nruns < runs.size())
+    merge(r+nruns);
+  if(r)
+    merge(r);
+}
+
+}
+}
+
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/aligned_allocator.h>
+
+#include <vector>
+
+/** \file
+ *  \brief Unit tests for aligned_allocator and basic_channel using it
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<float,float,float,std::vector,aligned_allocator>
+  float_aligned_channel;
+
+/** \test Check alignment of small and huge page blocks
+ */
+BOOST_AUTO_TEST_CASE( aligned_allocator_alignment_test )
+{
+  aligned_allocator<char> a;
+  BOOST_CHECK_EQUAL( a.node(), -1 );
+
+  for(std::size_t n=1; n<1000; n += 37) {
+    char *p = a.allocate(n);
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::size_t>(p) % 64, std::size_t(0) );
+    p[n-1] = 1;
+    a.deallocate(p,n);
+  }
+
+  std::size_t n = 3*1024*1024 + 5;
+  char *p = a.allocate(n);
+  BOOST_CHECK_EQUAL( reinterpret_cast<std::size_t>(p) % (2*1024*1024),
+    std::size_t(0) );
+  p[0] = 1;
+  p[n-1] = 1;
+  a.deallocate(p,n);
+
+  aligned_allocator<double> b(a);
+  BOOST_CHECK( a == b );
+}
+
+/** \test Check channels using aligned storage
+ */
+BOOST_AUTO_TEST_CASE( aligned_channel_test )
+{
+  float_aligned_channel ch1(mags,mags+5,.5,-.2);
+  const float_aligned_channel &cch1 = ch1;
+  BOOST_CHECK_EQUAL( reinterpret_cast<std::size_t>(&cch1.front()) % 64,
+    std::size_t(0) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+
+  float_aligned_channel ch2(ch1);
+  ch2.push_back(6);
+  BOOST_CHECK_EQUAL( ch1.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( ch2.size(), std::size_t(6) );
+
+  float_aligned_channel big(1024*1024,.2f);
+  const float_aligned_channel &cbig = big;
+  BOOST_CHECK_EQUAL( reinterpret_cast<std::size_t>(&cbig.front())
+    % (2*1024*1024), std::size_t(0) );
+  BOOST_CHECK_EQUAL( cbig.back(), .2f );
+}
+
+/** \test Check NUMA node selection
+ */
+BOOST_AUTO_TEST_CASE( aligned_allocator_numa_test )
+{
+  {
+    scoped_numa_node bind(0);
+    aligned_allocator<float> a;
+    BOOST_CHECK_EQUAL( a.node(), 0 );
+
+    // node 0 exists wherever NUMA is supported at all
+    float_aligned_channel big(1024*1024,1.0f);
+    BOOST_CHECK_EQUAL( big.size(), std::size_t(1024*1024) );
+  }
+
+  BOOST_CHECK_EQUAL( aligned_allocator<float>().node(), -1 );
+  BOOST_CHECK_THROW( scoped_numa_node(-2), std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,193 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/arena_allocator.h>
+
+#include <vector>
+#include <list>
+#include <limits>
+#include <new>
+
+/** \file
+ *  \brief Unit tests for monotonic_arena, arena_allocator and basic_channel
+ *    using it
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<float,float,float,std::vector,arena_allocator>
+  float_arena_channel;
+
+typedef basic_channel<float,float,float,std::list,arena_allocator>
+  float_arena_list_channel;
+
+/** \test Check allocation, alignment and reclaiming the last allocation
+ */
+BOOST_AUTO_TEST_CASE( monotonic_arena_allocate_test )
+{
+  monotonic_arena arena(256);
+  BOOST_CHECK_EQUAL( arena.capacity(), std::size_t(0) );
+
+  char *c = static_cast<char *>(arena.allocate(1,1));
+  double *d = static_cast<double *>(arena.allocate(sizeof(double),
+    alignof(double)));
+  BOOST_CHECK_EQUAL( reinterpret_cast<std::size_t>(d) % alignof(double),
+    std::size_t(0) );
+  BOOST_CHECK( reinterpret_cast<char *>(d) > c );
+
+  std::size_t used = arena.used();
+  void *p = arena.allocate(64,8);
+  BOOST_CHECK( arena.used() > used );
+  arena.deallocate(p,64);
+  BOOST_CHECK_EQUAL( arena.used(), used );
+  BOOST_CHECK_EQUAL( arena.allocate(64,8), p );
+
+  // larger than a chunk
+  void *big = arena.allocate(4096,16);
+  BOOST_CHECK( big != 0 );
+  BOOST_CHECK( arena.capacity() > std::size_t(4096) );
+}
+
+/** \test Check that sizes whose chunk cannot be represented throw rather
+ *  than overflow
+ */
+BOOST_AUTO_TEST_CASE( monotonic_arena_overflow_test )
+{
+  const std::size_t max = std::numeric_limits<std::size_t>::max();
+
+  monotonic_arena arena(256);
+  BOOST_CHECK_THROW( arena.allocate(max,16), std::bad_alloc );
+  BOOST_CHECK_THROW( arena.allocate(max-8,8), std::bad_alloc );
+  BOOST_CHECK_THROW( arena.allocate(max/2+1,8), std::bad_alloc );
+  BOOST_CHECK_EQUAL( arena.capacity(), std::size_t(0) );
+
+  arena_allocator<double> alloc(arena);
+  BOOST_CHECK_THROW( alloc.allocate(max/4), std::bad_alloc );
+
+  // the arena remains usable
+  void *p = arena.allocate(64,8);
+  BOOST_CHECK( p != 0 );
+  BOOST_CHECK_THROW( arena.allocate(max-4,8), std::bad_alloc );
+  BOOST_CHECK_EQUAL( arena.allocate(8,8),
+    static_cast<void *>(static_cast<char *>(p)+64) );
+}
+
+/** \test Check that reset coalesces chunks and reuses the memory
+ */
+BOOST_AUTO_TEST_CASE( monotonic_arena_reset_test )
+{
+  monotonic_arena arena(256);
+  for(int i=0; i<100; ++i)
+    arena.allocate(100,8);
+
+  std::size_t cap = arena.capacity();
+  BOOST_CHECK( cap >= std::size_t(100*100) );
+
+  arena.reset();
+  BOOST_CHECK_EQUAL( arena.used(), std::size_t(0) );
+  BOOST_CHECK_EQUAL( arena.capacity(), cap );
+
+  // the batch now fits in the single coalesced chunk
+  for(int i=0; i<100; ++i)
+    arena.allocate(100,8);
+
+  BOOST_CHECK_EQUAL( arena.capacity(), cap );
+
+  arena.release();
+  BOOST_CHECK_EQUAL( arena.capacity(), std::size_t(0) );
+  BOOST_CHECK_EQUAL( arena.used(), std::size_t(0) );
+}
+
+/** \test Check that channels allocate from the scoped arena, including the
+ *    shared container
+ */
+BOOST_AUTO_TEST_CASE( arena_channel_test )
+{
+  monotonic_arena arena;
+
+  {
+    scoped_arena scope(arena);
+
+    float_arena_channel ch1(mags,mags+5,.5,-.2);
+    BOOST_CHECK( arena.used() > 5*sizeof(float) );
+    BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+
+    float_arena_channel ch2(ch1);
+    ch2.push_back(6);
+    BOOST_CHECK_EQUAL( ch1.size(), std::size_t(5) );
+    BOOST_CHECK_EQUAL( ch2.size(), std::size_t(6) );
+    BOOST_CHECK_EQUAL_COLLECTIONS( ch2.begin(),ch2.end()-1,mags,mags+5 );
+
+    float_arena_list_channel lc(mags,mags+5);
+    lc.erase(lc.begin());
+    BOOST_CHECK_EQUAL_COLLECTIONS( lc.begin(),lc.end(),mags+1,mags+5 );
+  }
+
+  BOOST_CHECK_EQUAL( arena.used(), std::size_t(0) );
+  BOOST_CHECK( arena.capacity() > std::size_t(0) );
+
+  // no arena installed, memory comes from operator new
+  float_arena_channel ch3(fill,fill+5);
+  BOOST_CHECK_EQUAL( arena.used(), std::size_t(0) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch3.begin(),ch3.end(),fill,fill+5 );
+}
+
+/** \test Check that nested scopes reinstate the outer arena
+ */
+BOOST_AUTO_TEST_CASE( scoped_arena_nesting_test )
+{
+  monotonic_arena outer;
+  monotonic_arena inner;
+
+  scoped_arena s1(outer);
+  BOOST_CHECK_EQUAL( arena_allocator<float>().resource(), &outer );
+
+  {
+    scoped_arena s2(inner);
+    BOOST_CHECK_EQUAL( arena_allocator<float>().resource(), &inner );
+
+    arena_allocator<double> a;
+    arena_allocator<float> b(a);
+    BOOST_CHECK( a == b );
+    BOOST_CHECK( a != arena_allocator<double>(outer) );
+  }
+
+  BOOST_CHECK_EQUAL( arena_allocator<float>().resource(), &outer );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -26,11 +26,16 @@
  */
 
 #include <boost/test/unit_test.hpp>
+#include <boost/static_assert.hpp>
 
 #include "test_types.h"
 
 #include <qsat/basic_channel.h>
 
+#include <vector>
+#include <list>
+#include <type_traits>
+
 /** \file
  *  \brief Unit tests for basic_channel as model of Channel and std::sequence
  */
@@ -540,6 +545,60 @@ BOOST_AUTO_TEST_CASE( basic_channel_list_access_test )
   BOOST_CHECK( &cbc1.front() != &cbc2.front() );
 }
 
+/** \test Check write lease
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_lease_test )
+{
+  float_basic_channel bc1(mags,mags+5,.5,-.2);
+  const float_basic_channel &cbc1 = bc1;
+  float_basic_channel bc2 = bc1;
+  const float_basic_channel &cbc2 = bc2;
+
+  //check shared base
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+
+  float_basic_channel::lease_type lease = bc2.lease();
+  BOOST_CHECK( &cbc1.front() != &cbc2.front() );
+  BOOST_CHECK_EQUAL( lease.size(), std::size_t(5) );
+  BOOST_CHECK( !lease.empty() );
+  BOOST_CHECK_EQUAL( &lease.front(), &cbc2.front() );
+  BOOST_CHECK_EQUAL( &lease.back(), &cbc2.back() );
+
+  for(std::size_t i=0; i<lease.size(); ++i)
+    lease[i] *= 2;
+
+  float doubled[] = {2.0,4.0,6.0,8.0,10.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS( cbc2.begin(),cbc2.end(),doubled,doubled+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cbc1.begin(),cbc1.end(),mags,mags+5 );
+
+  //already detached, no further copy
+  const float *loc = &cbc2.front();
+  bc2.lease();
+  BOOST_CHECK_EQUAL( loc, &cbc2.front() );
+}
+
+/** \test Check write lease (list)
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_list_lease_test )
+{
+  float_list_channel bc1(mags,mags+5,.5,-.2);
+  const float_list_channel &cbc1 = bc1;
+  float_list_channel bc2 = bc1;
+  const float_list_channel &cbc2 = bc2;
+
+  //check shared base
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+
+  float_list_channel::lease_type lease = bc2.lease();
+  BOOST_CHECK( &cbc1.front() != &cbc2.front() );
+  BOOST_CHECK_EQUAL( lease.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( &lease.back(), &cbc2.back() );
+
+  std::fill(lease.begin(),lease.end(),.2f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cbc2.begin(),cbc2.end(),fill,fill+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cbc1.begin(),cbc1.end(),mags,mags+5 );
+}
+
 /** \test Check resize
  */
 BOOST_AUTO_TEST_CASE( basic_channel_resize_test )
@@ -1266,6 +1325,207 @@ BOOST_AUTO_TEST_CASE( basic_channel_equality_test )
   BOOST_CHECK( bc2 != bc3 );
 }
 
+/** \test Check move construction and assignment
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_move_test )
+{
+  float_basic_channel bc1(mags,mags+5,.5,-.2);
+  const float *data = &static_cast<const float_basic_channel &>(bc1).front();
+
+  float_basic_channel bc2(std::move(bc1));
+  BOOST_CHECK( bc1.empty() );
+  BOOST_CHECK_EQUAL( bc2.frequency(), .5f );
+  BOOST_CHECK_EQUAL( bc2.epoch(), -.2f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),mags,mags+5 );
+
+  // the samples were taken over, not copied
+  const float_basic_channel &cbc2 = bc2;
+  BOOST_CHECK_EQUAL( &cbc2.front(), data );
+
+  float_basic_channel bc3(fill,fill+5);
+  bc3 = std::move(bc2);
+  BOOST_CHECK_EQUAL( &static_cast<const float_basic_channel &>(bc3).front(),
+    data );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),fill,fill+5 );
+
+  std::vector<float> seq(mags,mags+5);
+  data = &seq[0];
+
+  float_basic_channel bc4(std::move(seq),2,3);
+  BOOST_CHECK_EQUAL( &static_cast<const float_basic_channel &>(bc4).front(),
+    data );
+  BOOST_CHECK_EQUAL( bc4.frequency(), 2 );
+  BOOST_CHECK_EQUAL( bc4.epoch(), 3 );
+}
+
+/** \test Check that moving never throws, so that containers of channels
+ *  move rather than copy them, and that a moved-from channel remains usable
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_nothrow_move_test )
+{
+  BOOST_STATIC_ASSERT(
+    std::is_nothrow_move_constructible<float_basic_channel>::value );
+  BOOST_STATIC_ASSERT(
+    std::is_nothrow_move_constructible<float_list_channel>::value );
+  BOOST_STATIC_ASSERT(
+    std::is_nothrow_move_constructible<float_intrusive_channel>::value );
+
+  std::vector<float_basic_channel> channels;
+  channels.push_back(float_basic_channel(mags,mags+5));
+  const float *data =
+    &static_cast<const float_basic_channel &>(channels[0]).front();
+
+  channels.resize(channels.capacity()+1);
+  BOOST_CHECK_EQUAL(
+    &static_cast<const float_basic_channel &>(channels[0]).front(), data );
+  BOOST_CHECK_EQUAL_COLLECTIONS( channels[0].begin(),channels[0].end(),
+    mags,mags+5 );
+
+  float_basic_channel bc1(channels[0]);
+  float_basic_channel bc2(std::move(bc1));
+  const float_basic_channel &cbc1 = bc1;
+  BOOST_CHECK( cbc1.empty() );
+  BOOST_CHECK_EQUAL( cbc1.size(), std::size_t(0) );
+  BOOST_CHECK( cbc1.begin() == cbc1.end() );
+  BOOST_CHECK( bc1 == float_basic_channel() );
+
+  bc1.push_back(1);
+  bc1.append(mags+1,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),mags,mags+5 );
+
+  float_intrusive_channel ic1(mags,mags+5);
+  float_intrusive_channel ic2(std::move(ic1));
+  BOOST_CHECK( ic1.empty() );
+  ic1.assign(fill,fill+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ic1.begin(),ic1.end(),fill,fill+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ic2.begin(),ic2.end(),mags,mags+5 );
+}
+
+/** \test Check emplace and rvalue insertion on unique and shared channels
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_emplace_test )
+{
+  float_basic_channel bc1(mags,mags+3);
+  float_basic_channel bc2(bc1);
+
+  bc1.emplace_back(4);
+  float val = 5;
+  bc1.push_back(std::move(val));
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),mags,mags+3 );
+
+  float_basic_channel::iterator pos = bc1.emplace(bc1.begin(),0);
+  BOOST_CHECK_EQUAL( *pos, 0.0f );
+  pos = bc1.insert(bc1.begin()+1,.5f);
+  BOOST_CHECK_EQUAL( *pos, .5f );
+  BOOST_CHECK_EQUAL( bc1.size(), std::size_t(7) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin()+2,bc1.end(),mags,mags+5 );
+
+  float_list_channel lc1(mags,mags+4);
+  float_list_channel lc2(lc1);
+  lc2.emplace_back(5);
+  BOOST_CHECK_EQUAL( lc1.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( lc2.begin(),lc2.end(),mags,mags+5 );
+}
+
+/** \test Check append on unique and shared channels
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_append_test )
+{
+  float_basic_channel bc1(mags,mags+2,.5,-.2);
+  float_basic_channel bc2(bc1);
+
+  bc1.append(mags+2,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( bc1.frequency(), .5f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),mags,mags+2 );
+
+  // detaching leaves room to keep appending without copying again
+  float_basic_channel bc3(bc1);
+  bc3.append(mags,mags+1);
+  BOOST_CHECK( bc3.capacity() >= std::size_t(10) );
+
+  std::vector<float> block(fill,fill+5);
+  bc2.append(block);
+  bc2.append(fill);
+  BOOST_CHECK_EQUAL( bc2.size(), std::size_t(12) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin()+2,bc2.begin()+7,fill,fill+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin()+7,bc2.end(),fill,fill+5 );
+
+  float_list_channel lc1(mags,mags+2);
+  float_list_channel lc2(lc1);
+  std::list<float> lst(mags+2,mags+5);
+  lc2.append(lst);
+  BOOST_CHECK_EQUAL( lc1.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( lc2.begin(),lc2.end(),mags,mags+5 );
+}
+
+struct counter {
+  float next;
+
+  float operator()(void) {
+    return next++;
+  }
+};
+
+/** \test Check append_n on unique and shared channels
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_append_n_test )
+{
+  float_basic_channel bc1(mags,mags+1);
+  float_basic_channel bc2(bc1);
+
+  counter c = {2};
+  bc1.append_n(4,c);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( bc2.size(), std::size_t(1) );
+
+  bc1.append_n(0,c);
+  BOOST_CHECK_EQUAL( bc1.size(), std::size_t(5) );
+
+  float_list_channel lc1(mags,mags+1);
+  float_list_channel lc2(lc1);
+  lc1.append_n(4,c);
+  BOOST_CHECK_EQUAL( lc1.back(), 5.0f );
+  BOOST_CHECK_EQUAL( lc2.size(), std::size_t(1) );
+}
+
+/** \test Check insert and erase through iterators obtained before the
+ *    sequence became shared
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_shared_modify_test )
+{
+  static const float ins[] = {1.0,1.0,2.0,3.0,4.0,5.0};
+
+  float_basic_channel bc1(mags,mags+5);
+  float_basic_channel::iterator pos = bc1.begin()+1;
+  float_basic_channel bc2(bc1);
+  bc1.insert(pos,mags,mags+1);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),ins,ins+6 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc2.begin(),bc2.end(),mags,mags+5 );
+
+  pos = bc1.begin();
+  float_basic_channel bc3(bc1);
+  pos = bc1.erase(pos);
+  BOOST_CHECK_EQUAL( *pos, 1.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( bc1.begin(),bc1.end(),mags,mags+5 );
+
+  pos = bc1.begin()+1;
+  float_basic_channel bc4(bc1);
+  pos = bc1.erase(pos,pos+3);
+  BOOST_CHECK_EQUAL( *pos, 5.0f );
+  BOOST_CHECK_EQUAL( bc1.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( bc4.size(), std::size_t(5) );
+
+  float_list_channel lc1(mags+1,mags+5);
+  float_list_channel::iterator lpos = lc1.begin();
+  float_list_channel lc2(lc1);
+  lc1.insert(lpos,1.0f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( lc1.begin(),lc1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( lc2.size(), std::size_t(4) );
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
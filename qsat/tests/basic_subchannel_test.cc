@@ -331,6 +331,156 @@ BOOST_AUTO_TEST_CASE( basic_channel_list_subchannel_subchannel_test )
   BOOST_CHECK(sub == sub2);
 }
 
+/** \test subchannel write lease check
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_subchannel_lease_test )
+{
+  float_basic_channel bc1(mags,mags+sizeof(mags)/sizeof(float),.5,-.2);
+  const float_basic_channel &cbc1 = bc1;
+  float_basic_channel bc2 = bc1;
+
+  float_basic_channel::iterator start = bc2.begin();
+  std::advance(start,2);
+  float_basic_channel::iterator stop = bc2.begin();
+  std::advance(stop,4);
+  float_basic_channel::subchannel_type sub = bc2.subchannel(start,stop);
+
+  float_basic_channel::subchannel_type::lease_type lease = sub.lease();
+  BOOST_CHECK(lease.begin() == sub.begin());
+  BOOST_CHECK(lease.end() == sub.end());
+  BOOST_CHECK_EQUAL(lease.size(), sub.size());
+
+  for(std::size_t i=0; i<lease.size(); ++i)
+    lease[i] = -1;
+
+  float values[] = {1,2,-1,-1,5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(bc2.begin(),bc2.end(),values,values+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS(cbc1.begin(),cbc1.end(),
+    mags,mags+sizeof(mags)/sizeof(float));
+}
+
+/** \test time based subchannel selection and index mapping
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_time_subchannel_test )
+{
+  float_basic_channel bc1(mags,mags+sizeof(mags)/sizeof(float),10,-.2);
+  const float_basic_channel &cbc1 = bc1;
+
+  BOOST_CHECK_EQUAL(cbc1.index_at(-1.0f), 0u);
+  BOOST_CHECK_EQUAL(cbc1.index_at(-.2f), 0u);
+  BOOST_CHECK_EQUAL(cbc1.index_at(-.15f), 1u);
+  BOOST_CHECK_EQUAL(cbc1.index_at(0.0f), 2u);
+  BOOST_CHECK_EQUAL(cbc1.index_at(1.0f), cbc1.size());
+  for(std::size_t i=0; i<cbc1.size(); ++i) {
+    BOOST_CHECK_SMALL(cbc1.time_at(i)-(-.2f+float(i)/10), .0000001f);
+    BOOST_CHECK_EQUAL(cbc1.index_at(cbc1.time_at(i)), i);
+  }
+
+  float_basic_channel::const_subchannel_type sub = cbc1.subchannel(-.1f,.1f);
+  BOOST_CHECK_EQUAL(sub.offset(), 1u);
+  BOOST_CHECK_EQUAL_COLLECTIONS(sub.begin(),sub.end(),mags+1,mags+3);
+  BOOST_CHECK_SMALL(sub.epoch()-(-.1f), .0000001f);
+  BOOST_CHECK_EQUAL(sub.index_at(0.0f), 1u);
+  BOOST_CHECK_SMALL(sub.time_at(1)-cbc1.time_at(2), .0000001f);
+
+  float_basic_channel::const_subchannel_type sub2 = sub.subchannel(0.0f,1.0f);
+  BOOST_CHECK_EQUAL(sub2.offset(), 2u);
+  BOOST_CHECK_EQUAL_COLLECTIONS(sub2.begin(),sub2.end(),mags+2,mags+3);
+
+  BOOST_CHECK(cbc1.subchannel(.1f,-.1f).empty());
+  BOOST_CHECK(cbc1.subchannel(5.0f,6.0f).empty());
+
+  float_basic_channel bc2 = bc1;
+  float_basic_channel::subchannel_type msub = bc2.subchannel(0.0f,1.0f);
+  msub[0] = -1;
+  float values[] = {1,2,-1,4,5};
+  BOOST_CHECK_EQUAL_COLLECTIONS(bc2.begin(),bc2.end(),values,values+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS(cbc1.begin(),cbc1.end(),
+    mags,mags+sizeof(mags)/sizeof(float));
+}
+
+/** \test time based subchannel selection and epoch (list)
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_list_time_subchannel_test )
+{
+  float_list_channel bc1(mags,mags+sizeof(mags)/sizeof(float),10,-.2);
+  const float_list_channel &cbc1 = bc1;
+
+  float_list_channel::const_subchannel_type sub = cbc1.subchannel(0.0f,.2f);
+  BOOST_CHECK_EQUAL(sub.offset(), 2u);
+  BOOST_CHECK_EQUAL_COLLECTIONS(sub.begin(),sub.end(),mags+2,mags+4);
+  BOOST_CHECK_SMALL(sub.epoch(), .0000001f);
+
+  float_list_channel::const_iterator start = cbc1.begin();
+  std::advance(start,3);
+  float_list_channel::const_subchannel_type sub2 =
+    cbc1.subchannel(start,cbc1.end());
+  BOOST_CHECK_EQUAL(sub2.offset(), 3u);
+
+  sub2.begin(cbc1.begin());
+  BOOST_CHECK_EQUAL(sub2.offset(), 0u);
+  BOOST_CHECK_SMALL(sub2.epoch()-cbc1.epoch(), .0000001f);
+}
+
+/** \test Check that the time mapping of a subchannel of a list follows
+ *  insertions and erasures before it
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_list_subchannel_insert_test )
+{
+  float_list_channel bc1(mags,mags+sizeof(mags)/sizeof(float),10,-.2);
+
+  float_list_channel::iterator start = bc1.begin();
+  std::advance(start,2);
+  float_list_channel::iterator stop = start;
+  std::advance(stop,2);
+  float_list_channel::subchannel_type sub = bc1.subchannel(start,stop);
+  BOOST_CHECK_EQUAL(sub.offset(), 2u);
+
+  bc1.insert(bc1.begin(),2,1.0f);
+  BOOST_CHECK_CLOSE(sub.epoch(), .2f, .0001f);
+  BOOST_CHECK_EQUAL(sub.offset(), 4u);
+  BOOST_CHECK_CLOSE(sub.time_at(1), .3f, .0001f);
+  BOOST_CHECK_EQUAL_COLLECTIONS(sub.begin(),sub.end(),mags+2,mags+4);
+
+  float_list_channel::subchannel_type sub2 = sub.subchannel(.3f,.4f);
+  BOOST_CHECK_EQUAL(sub2.offset(), 5u);
+
+  bc1.erase(bc1.begin());
+  BOOST_CHECK_EQUAL(sub.offset(), 3u);
+  BOOST_CHECK_EQUAL(sub2.offset(), 4u);
+
+  // appending does not move the subchannel
+  bc1.push_back(6.0f);
+  BOOST_CHECK_CLOSE(sub.epoch(), .1f, .0001f);
+
+  float_list_channel::subchannel_type sub3 = sub;
+  bc1.insert(bc1.begin(),3,1.0f);
+  BOOST_CHECK_CLOSE(sub3.epoch(), .4f, .0001f);
+  BOOST_CHECK_CLOSE(sub.epoch(), .4f, .0001f);
+  BOOST_CHECK_EQUAL(sub.offset(), 6u);
+}
+
+/** \test time to index mapping at large indices and large epochs
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_time_index_large_test )
+{
+  const std::size_t big = 1000000000;
+
+  // snapping to a sample must not grow with the index
+  BOOST_CHECK_EQUAL(detail::time_index(0.0,1.0,1e8+0.05,big),
+    std::size_t(100000001));
+  BOOST_CHECK_EQUAL(detail::time_index(0.0,1.0,1e8,big),
+    std::size_t(100000000));
+  BOOST_CHECK_EQUAL(detail::time_index(0.0,48000.0,1e4+1e-6,big),
+    std::size_t(480000001));
+
+  // times computed from a large epoch still map back to their sample
+  typedef basic_channel<float,double,double> double_time_channel;
+  const double_time_channel ch(1000,0.0f,48000.0,1.7e9);
+  for(std::size_t i=0; i<ch.size(); ++i)
+    BOOST_CHECK_EQUAL(ch.index_at(ch.time_at(i)), i);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
@@ -0,0 +1,345 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/channel_base.h>
+
+#include <boost/mpl/vector.hpp>
+
+#include <vector>
+#include <list>
+
+/** \file
+ *  \brief Unit tests for channel_base
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef channel_base<double,double,double,mpl::vector<short,float,double> >
+  adaptive_channel_base;
+
+typedef channel_base<double,double,double,mpl::vector<short,float,double>,
+  std::list> adaptive_list_channel_base;
+
+/** \brief Store \e val at every sample
+ */
+struct fill_span {
+  double val;
+
+  template<typename Pointer>
+  void operator()(Pointer first, Pointer last) const {
+    for(; first != last; ++first)
+      *first = val;
+  }
+};
+
+/** \brief Record the blocks passed by for_each_block()
+ */
+struct record_blocks {
+  std::vector<std::size_t> sizes;
+  std::vector<std::size_t> widths;
+  std::vector<double> values;
+
+  template<typename P>
+  void operator()(const P *first, const P *last) {
+    sizes.push_back(last-first);
+    widths.push_back(sizeof(P));
+    values.insert(values.end(),first,last);
+  }
+};
+
+/** \test Check that values written with push_back() are read back exactly,
+ *  promoting the precision as needed and never narrowing it
+ */
+BOOST_AUTO_TEST_CASE( channel_base_adaptive_push_back_test )
+{
+  const double vals[] = {1, -2, 2.5, 3, 0.1, 4};
+  const std::size_t precisions[] = {0, 0, 1, 1, 2, 2};
+
+  adaptive_channel_base cb;
+  BOOST_CHECK_EQUAL( cb.adaptive_precision(true), false );
+
+  for(std::size_t i=0; i<6; ++i) {
+    cb.push_back(vals[i]);
+    BOOST_CHECK_EQUAL( cb.precision(), precisions[i] );
+  }
+
+  std::vector<double> result(cb.size());
+  cb.copy_to(&result[0]);
+  BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(),result.end(),vals,vals+6 );
+
+  // without adaptation push_back() converts to the current precision
+  adaptive_channel_base fixed;
+  fixed.push_back(3);
+  BOOST_CHECK_THROW( fixed.push_back(1e6), b::numeric::bad_numeric_cast );
+  BOOST_CHECK_EQUAL( fixed.precision(), 0 );
+}
+
+/** \test Check that copies, assignment, and clear() keep the precision and
+ *  the adaptive setting, so later writes still read back exactly
+ */
+BOOST_AUTO_TEST_CASE( channel_base_adaptive_copy_test )
+{
+  adaptive_channel_base cb;
+  cb.adaptive_precision(true);
+  cb.push_back(1.5);
+  BOOST_CHECK_EQUAL( cb.precision(), 1 );
+
+  adaptive_channel_base copy(cb);
+  BOOST_CHECK_EQUAL( copy.precision(), 1 );
+  BOOST_CHECK( copy.adaptive_precision() );
+  copy.push_back(0.1);
+  BOOST_CHECK_EQUAL( copy.precision(), 2 );
+  BOOST_CHECK_EQUAL( cb.precision(), 1 );
+
+  adaptive_channel_base assigned;
+  assigned = copy;
+  BOOST_CHECK_EQUAL( assigned.precision(), 2 );
+  BOOST_CHECK( assigned.adaptive_precision() );
+
+  assigned.clear();
+  BOOST_CHECK( assigned.empty() );
+  BOOST_CHECK_EQUAL( assigned.precision(), 2 );
+  assigned.push_back(0.3);
+
+  double result[3];
+  copy.copy_to(result);
+  BOOST_CHECK_EQUAL( result[0], 1.5 );
+  BOOST_CHECK_EQUAL( result[1], 0.1 );
+  assigned.copy_to(result+2);
+  BOOST_CHECK_EQUAL( result[2], 0.3 );
+
+  cb.adaptive_precision(false);
+  adaptive_channel_base moved(std::move(cb));
+  BOOST_CHECK_EQUAL( moved.precision(), 1 );
+  BOOST_CHECK( !moved.adaptive_precision() );
+}
+
+/** \test Check that assign() and resize() promote the precision as
+ *  push_back() does, and reserve() and pop_back()
+ */
+BOOST_AUTO_TEST_CASE( channel_base_adaptive_assign_test )
+{
+  const double vals[] = {1, 2.5, 0.1};
+  double result[6];
+
+  adaptive_channel_base cb;
+  cb.adaptive_precision(true);
+  cb.assign(vals,vals+2);
+  BOOST_CHECK_EQUAL( cb.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( cb.precision(), 1 );
+  cb.copy_to(result);
+  BOOST_CHECK_EQUAL_COLLECTIONS( result,result+2,vals,vals+2 );
+
+  cb.assign(vals,vals+3,48000.0,1.5);
+  BOOST_CHECK_EQUAL( cb.precision(), 2 );
+  BOOST_CHECK_EQUAL( cb.frequency(), 48000.0 );
+  BOOST_CHECK_EQUAL( cb.epoch(), 1.5 );
+  cb.copy_to(result);
+  BOOST_CHECK_EQUAL_COLLECTIONS( result,result+3,vals,vals+3 );
+
+  adaptive_channel_base fill;
+  fill.adaptive_precision(true);
+  fill.assign(3,7.0);
+  BOOST_CHECK_EQUAL( fill.precision(), 0 );
+  fill.assign(4,2.5,100.0,2.0);
+  BOOST_CHECK_EQUAL( fill.precision(), 1 );
+  BOOST_CHECK_EQUAL( fill.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL( fill.frequency(), 100.0 );
+  BOOST_CHECK_EQUAL( fill.epoch(), 2.0 );
+
+  // integral arguments select the fill overload
+  fill.assign(2,3);
+  BOOST_CHECK_EQUAL( fill.size(), std::size_t(2) );
+  fill.copy_to(result);
+  BOOST_CHECK_EQUAL( result[1], 3.0 );
+
+  // shrinking never checks the fill value
+  fill.resize(1,0.1);
+  BOOST_CHECK_EQUAL( fill.precision(), 1 );
+  fill.resize(3,0.1);
+  BOOST_CHECK_EQUAL( fill.precision(), 2 );
+  fill.copy_to(result);
+  BOOST_CHECK_EQUAL( result[0], 3.0 );
+  BOOST_CHECK_EQUAL( result[2], 0.1 );
+
+  fill.reserve(100);
+  BOOST_CHECK_EQUAL( fill.size(), std::size_t(3) );
+  fill.pop_back();
+  BOOST_CHECK_EQUAL( fill.size(), std::size_t(2) );
+  fill.copy_to(result);
+  BOOST_CHECK_EQUAL( result[1], 0.1 );
+
+  // without adaptation values are converted to the current precision
+  adaptive_channel_base fixed;
+  fixed.assign(vals,vals+2);
+  BOOST_CHECK_EQUAL( fixed.precision(), 0 );
+  fixed.copy_to(result);
+  BOOST_CHECK_EQUAL( result[1], 2.0 );
+  BOOST_CHECK_THROW( fixed.assign(2,1e6), b::numeric::bad_numeric_cast );
+  BOOST_CHECK_THROW( fixed.resize(3,1e6), b::numeric::bad_numeric_cast );
+}
+
+/** \test Check for_each_block() over a Container that is not contiguous,
+ *  before and after a precision promotion
+ */
+BOOST_AUTO_TEST_CASE( channel_base_list_block_test )
+{
+  adaptive_list_channel_base cb;
+  cb.adaptive_precision(true);
+
+  std::vector<double> expected;
+  for(std::size_t i=0; i<10; ++i) {
+    cb.push_back(double(i));
+    expected.push_back(double(i));
+  }
+  BOOST_CHECK_EQUAL( cb.precision(), 0 );
+
+  record_blocks shorts;
+  cb.for_each_block(shorts,4);
+  const std::size_t sizes[] = {4,4,2};
+  BOOST_CHECK_EQUAL_COLLECTIONS( shorts.sizes.begin(),shorts.sizes.end(),
+    sizes,sizes+3 );
+  BOOST_CHECK_EQUAL( shorts.widths.front(), sizeof(short) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( shorts.values.begin(),shorts.values.end(),
+    expected.begin(),expected.end() );
+
+  cb.push_back(0.1);
+  cb.push_back(2.5);
+  expected.push_back(0.1);
+  expected.push_back(2.5);
+  BOOST_CHECK_EQUAL( cb.precision(), 2 );
+
+  record_blocks doubles;
+  cb.for_each_block(doubles,4);
+  BOOST_CHECK_EQUAL( doubles.sizes.size(), std::size_t(3) );
+  BOOST_CHECK_EQUAL( doubles.sizes.back(), std::size_t(4) );
+  for(std::size_t i=0; i<doubles.widths.size(); ++i)
+    BOOST_CHECK_EQUAL( doubles.widths[i], sizeof(double) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( doubles.values.begin(),doubles.values.end(),
+    expected.begin(),expected.end() );
+
+  // a block of zero takes the default and a block larger than the channel
+  // passes every sample at once
+  record_blocks whole;
+  cb.for_each_block(whole,0);
+  BOOST_CHECK_EQUAL( whole.sizes.size(), std::size_t(1) );
+  cb.for_each_block(whole,100);
+  BOOST_CHECK_EQUAL( whole.sizes.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( whole.sizes.back(), std::size_t(12) );
+
+  record_blocks none;
+  adaptive_list_channel_base().for_each_block(none);
+  BOOST_CHECK( none.sizes.empty() );
+}
+
+/** \test Check that values written through visit_span() are stored in the
+ *  current precision without promotion, and that shrink_precision()
+ *  narrows to a precision holding them
+ */
+BOOST_AUTO_TEST_CASE( channel_base_adaptive_span_test )
+{
+  adaptive_channel_base cb(4,0.0);
+  cb.adaptive_precision(true);
+
+  fill_span half = {2.5};
+  cb.visit_span(half);
+  BOOST_CHECK_EQUAL( cb.precision(), 0 );
+
+  double result[5];
+  cb.copy_to(result);
+  BOOST_CHECK_EQUAL( result[0], 2.0 );
+  BOOST_CHECK_EQUAL( result[3], 2.0 );
+
+  // promote first so that the span is written in a wide enough precision
+  cb.push_back(0.1);
+  BOOST_CHECK_EQUAL( cb.precision(), 2 );
+  cb.visit_span(half);
+  cb.copy_to(result);
+  BOOST_CHECK_EQUAL( result[0], 2.5 );
+  BOOST_CHECK_EQUAL( result[3], 2.5 );
+
+  cb.shrink_precision();
+  BOOST_CHECK_EQUAL( cb.precision(), 1 );
+  cb.copy_to(result);
+  BOOST_CHECK_EQUAL( result[1], 2.5 );
+}
+
+/** \test Check copying from a channel_base with other precisions, keeping
+ *  the precision of the samples where possible
+ */
+BOOST_AUTO_TEST_CASE( channel_base_converting_copy_test )
+{
+  typedef channel_base<double,double,double,mpl::vector<float,double> >
+    wide_channel_base;
+
+  adaptive_channel_base cb(3,2.0,48000.0,1.5);
+  cb.adaptive_precision(true);
+  cb.push_back(2.5);
+  BOOST_CHECK_EQUAL( cb.precision(), 1 );
+
+  wide_channel_base wide(cb);
+  BOOST_CHECK_EQUAL( wide.precision(), 0 );
+  BOOST_CHECK_EQUAL( wide.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL( wide.frequency(), 48000.0 );
+  BOOST_CHECK_EQUAL( wide.epoch(), 1.5 );
+  BOOST_CHECK( wide.adaptive_precision() );
+
+  double result[5];
+  wide.copy_to(result);
+  BOOST_CHECK_EQUAL( result[0], 2.0 );
+  BOOST_CHECK_EQUAL( result[3], 2.5 );
+
+  wide.push_back(0.1);
+  BOOST_CHECK_EQUAL( wide.precision(), 1 );
+
+  // short samples are not representable here and take the first precision
+  adaptive_channel_base narrow(3,7.0);
+  BOOST_CHECK_EQUAL( narrow.precision(), 0 );
+  wide_channel_base converted(narrow);
+  BOOST_CHECK_EQUAL( converted.precision(), 0 );
+  converted.copy_to(result);
+  BOOST_CHECK_EQUAL( result[2], 7.0 );
+
+  adaptive_channel_base back(wide);
+  BOOST_CHECK_EQUAL( back.precision(), 2 );
+  back.copy_to(result);
+  BOOST_CHECK_EQUAL( result[3], 2.5 );
+  BOOST_CHECK_EQUAL( result[4], 0.1 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,166 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/channel_expression.h>
+
+#include <vector>
+#include <stdexcept>
+
+/** \file
+ *  \brief Unit tests for lazy channel arithmetic
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+/** \test Check a compound expression of contiguous channels and constants
+ */
+BOOST_AUTO_TEST_CASE( channel_expression_basic_test )
+{
+  float_basic_channel a(mags,mags+5,2.0,10.0);
+  float_basic_channel b(fill,fill+5,2.0,10.0);
+  float_basic_channel c(5,1.0f,2.0,10.0);
+
+  float_basic_channel d = a + b * 2.0f - c;
+
+  BOOST_REQUIRE_EQUAL( d.size(), 5 );
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_CLOSE( d[i], mags[i] + fill[i]*2.0f - 1.0f, 1e-4 );
+
+  BOOST_CHECK_EQUAL( d.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( d.epoch(), 10.0 );
+
+  d = 2.0f * a / (-b);
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_CLOSE( d[i], 2.0f*mags[i] / -fill[i], 1e-4 );
+}
+
+/** \test Check expressions over non random access channels and subchannels
+ */
+BOOST_AUTO_TEST_CASE( channel_expression_list_test )
+{
+  float_list_channel a(mags,mags+5,2.0,10.0);
+  float_basic_channel b(mags,mags+5,2.0,10.0);
+
+  float_list_channel c = a * b + 1.0f;
+
+  std::vector<float> result(c.begin(),c.end());
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( result[i], mags[i]*mags[i] + 1.0f );
+
+  float_basic_channel::subchannel_type sub = b.subchannel(11.0f,12.5f);
+  float_basic_channel::const_subchannel_type csub =
+    static_cast<const float_basic_channel &>(b).subchannel(11.0f,12.5f);
+
+  float_basic_channel d = sub - csub * 0.5f;
+  BOOST_REQUIRE_EQUAL( d.size(), 3 );
+  BOOST_CHECK_EQUAL( d.epoch(), 11.0 );
+  for(std::size_t i=0; i<3; ++i)
+    BOOST_CHECK_EQUAL( d[i], mags[i+2]*0.5f );
+}
+
+/** \test Check mismatched timebases are rejected when the expression is built
+ */
+BOOST_AUTO_TEST_CASE( channel_expression_mismatch_test )
+{
+  float_basic_channel a(mags,mags+5,2.0,10.0);
+  float_basic_channel freq(mags,mags+5,4.0,10.0);
+  float_basic_channel epoch(mags,mags+5,2.0,11.0);
+  float_basic_channel size(mags,mags+4,2.0,10.0);
+
+  BOOST_CHECK_THROW( a + freq, std::invalid_argument );
+  BOOST_CHECK_THROW( a * 2.0f - epoch, std::invalid_argument );
+  BOOST_CHECK_THROW( size / a, std::invalid_argument );
+}
+
+/** \test Check assignment in place and into shared channels
+ */
+BOOST_AUTO_TEST_CASE( channel_expression_assign_test )
+{
+  float_basic_channel a(mags,mags+5,2.0,10.0);
+  float_basic_channel b(a);
+
+  // shared, must not write through to b
+  a = a * 2.0f;
+  BOOST_CHECK_EQUAL_COLLECTIONS( b.begin(),b.end(),mags,mags+5 );
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( a[i], mags[i]*2.0f );
+
+  // unique, overwritten in place
+  const float *data = &*static_cast<const float_basic_channel &>(a).begin();
+  a = a + b;
+  BOOST_CHECK_EQUAL( &*static_cast<const float_basic_channel &>(a).begin(),
+    data );
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( a[i], mags[i]*3.0f );
+
+  // resized and retimed
+  float_basic_channel c(fill,fill+2,1.0,0.0);
+  c = b - 1.0f;
+  BOOST_REQUIRE_EQUAL( c.size(), 5 );
+  BOOST_CHECK_EQUAL( c.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( c.epoch(), 10.0 );
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( c[i], mags[i]-1.0f );
+}
+
+/** \test Check an expression can be consumed as a range
+ */
+BOOST_AUTO_TEST_CASE( channel_expression_iterator_test )
+{
+  float_basic_channel a(mags,mags+5,2.0,10.0);
+  float_basic_channel b(5,0.0f,2.0,10.0);
+
+  std::vector<float> result(begin(a + 1.0f),end(a + 1.0f));
+  BOOST_REQUIRE_EQUAL( result.size(), 5 );
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( result[i], mags[i]+1.0f );
+
+  float_basic_channel::subchannel_type sub = b.subchannel(b.begin()+1,
+    b.begin()+3);
+  float_basic_channel::const_subchannel_type src =
+    static_cast<const float_basic_channel &>(a).subchannel(11.0f,12.0f);
+  sub.assign(begin(-src),end(-src));
+
+  BOOST_CHECK_EQUAL( b[0], 0.0f );
+  BOOST_CHECK_EQUAL( b[1], -3.0f );
+  BOOST_CHECK_EQUAL( b[2], -4.0f );
+  BOOST_CHECK_EQUAL( b[3], 0.0f );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
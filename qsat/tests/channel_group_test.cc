@@ -0,0 +1,294 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/channel_group.h>
+
+#include <vector>
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+
+/** \file
+ *  \brief Unit tests for basic_channel_group
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel_group<float,float,float> float_channel_group;
+
+/** \test Check construction, planar layout, and alignment
+ */
+BOOST_AUTO_TEST_CASE( channel_group_layout_test )
+{
+  float_channel_group group(3,5,2.0,10.0,.2f);
+  BOOST_CHECK_EQUAL( group.channels(), std::size_t(3) );
+  BOOST_CHECK_EQUAL( group.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( group.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( group.epoch(), 10.0 );
+  BOOST_CHECK( group.stride() >= group.size() );
+
+  for(std::size_t i=0; i<group.channels(); ++i) {
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>(group.data(i)) %
+      float_channel_group::alignment, 0u );
+    BOOST_CHECK_EQUAL_COLLECTIONS( group[i].begin(),group[i].end(),
+      fill,fill+5 );
+    BOOST_CHECK_EQUAL( group[i].index(), i );
+    BOOST_CHECK_EQUAL( &group[i].frequency(), &group.frequency() );
+  }
+
+  BOOST_CHECK_EQUAL( group.data(1)-group.data(0),
+    std::ptrdiff_t(group.stride()) );
+  BOOST_CHECK_THROW( group.at(3), std::out_of_range );
+
+  std::copy(mags,mags+5,group[1].begin());
+  BOOST_CHECK_EQUAL_COLLECTIONS( group[1].begin(),group[1].end(),
+    mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( group[0].begin(),group[0].end(),
+    fill,fill+5 );
+
+  float_basic_channel ch = group.extract(1);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ch.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( ch.epoch(), 10.0 );
+}
+
+/** \test Check row access and appending rows
+ */
+BOOST_AUTO_TEST_CASE( channel_group_row_test )
+{
+  float_channel_group group(5,0,2.0,10.0);
+  BOOST_CHECK( group.empty() );
+
+  for(std::size_t n=0; n<100; ++n) {
+    float row[5];
+    for(std::size_t i=0; i<5; ++i)
+      row[i] = float(i*1000+n);
+
+    group.push_back(row,row+5);
+  }
+
+  BOOST_CHECK_EQUAL( group.size(), std::size_t(100) );
+  BOOST_CHECK( group.capacity() >= group.size() );
+  for(std::size_t i=0; i<5; ++i) {
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>(group.data(i)) %
+      float_channel_group::alignment, 0u );
+    for(std::size_t n=0; n<100; ++n)
+      BOOST_CHECK_EQUAL( group[i][n], float(i*1000+n) );
+  }
+
+  float_channel_group::row_type row = group.row(42);
+  BOOST_CHECK_EQUAL( row.size(), std::size_t(5) );
+  const float expect[] = {42,1042,2042,3042,4042};
+  BOOST_CHECK_EQUAL_COLLECTIONS( row.begin(),row.end(),expect,expect+5 );
+  BOOST_CHECK_EQUAL( row.end()-row.begin(), 5 );
+
+  row[2] = -1;
+  BOOST_CHECK_EQUAL( group[2][42], -1.0f );
+
+  const float_channel_group &cgroup = group;
+  float_channel_group::const_row_type crow = cgroup.row(99);
+  BOOST_CHECK_EQUAL( crow[4], 4099.0f );
+
+  BOOST_CHECK_THROW( group.push_back(mags,mags+4), std::invalid_argument );
+  BOOST_CHECK_EQUAL( group.size(), std::size_t(100) );
+
+  group.pop_back();
+  BOOST_CHECK_EQUAL( group.size(), std::size_t(99) );
+  group.clear();
+  BOOST_CHECK( group.empty() );
+  BOOST_CHECK( group[0].empty() );
+}
+
+/** \test Check subchannels of group channels and group copies
+ */
+BOOST_AUTO_TEST_CASE( channel_group_subchannel_test )
+{
+  float_channel_group group(2,5,10.0,-.2);
+  std::copy(mags,mags+5,group[0].begin());
+
+  typedef float_channel_group::channel_type channel_type;
+  channel_type::subchannel_type sub =
+    group[0].subchannel(group[0].begin()+2,group[0].end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),mags+2,mags+5 );
+  BOOST_CHECK_EQUAL( sub.offset(), 2u );
+  BOOST_CHECK_SMALL( sub.epoch()-0.0f, .0000001f );
+
+  const float_channel_group &cgroup = group;
+  channel_type::const_subchannel_type csub = cgroup[0].subchannel(
+    cgroup[0].begin(),cgroup[0].begin()+2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( csub.begin(),csub.end(),mags,mags+2 );
+
+  float_channel_group dup = group;
+  dup[0][0] = -1;
+  BOOST_CHECK_EQUAL( group[0][0], mags[0] );
+  BOOST_CHECK( &dup[0].epoch() == &dup.epoch() );
+  BOOST_CHECK( dup[1] == group[1] );
+
+  float_channel_group moved(std::move(dup));
+  BOOST_CHECK_EQUAL( moved[0][0], -1.0f );
+  BOOST_CHECK_EQUAL( moved[0].size(), std::size_t(5) );
+
+  group = moved;
+  BOOST_CHECK_EQUAL( group[0][0], -1.0f );
+  BOOST_CHECK( group[0].begin() != moved[0].begin() );
+
+  // channels of a group survive assignment from a larger group
+  channel_type &first = group[0];
+
+  float_channel_group wide(40,7,10.0,-.2,1.0f);
+  group = wide;
+  BOOST_CHECK_EQUAL( group.channels(), std::size_t(40) );
+  BOOST_CHECK_EQUAL( &first, &group[0] );
+  BOOST_CHECK_EQUAL( first.size(), std::size_t(7) );
+  BOOST_CHECK_EQUAL( group[39].index(), std::size_t(39) );
+  BOOST_CHECK_EQUAL( group[39][6], 1.0f );
+}
+
+namespace {
+
+struct triple {
+  float v[3];
+};
+
+}
+
+/** \test Check every channel is aligned when the alignment is not a
+ *  multiple of the sample size
+ */
+BOOST_AUTO_TEST_CASE( channel_group_alignment_test )
+{
+  typedef basic_channel_group<triple,float,float> triple_channel_group;
+
+  triple_channel_group group(5,3);
+  for(std::size_t n=0; n<100; ++n) {
+    triple row[5];
+    for(std::size_t i=0; i<5; ++i)
+      row[i].v[0] = float(i*1000+n);
+
+    group.push_back(row,row+5);
+  }
+
+  for(std::size_t i=0; i<group.channels(); ++i) {
+    BOOST_CHECK_EQUAL( reinterpret_cast<std::uintptr_t>(group.data(i)) %
+      triple_channel_group::alignment, 0u );
+    BOOST_CHECK_EQUAL( group[i][102].v[0], float(i*1000+99) );
+  }
+}
+
+namespace {
+
+/** Outstanding allocations of each tagged_allocator, by tag */
+std::size_t tagged_outstanding[4];
+std::size_t tagged_next;
+
+/** Stateful allocator propagated on swap, each default constructed
+ *  instance comparing unequal to the others
+ */
+template<typename T>
+struct tagged_allocator {
+  typedef T value_type;
+  typedef std::true_type propagate_on_container_swap;
+
+  tagged_allocator(void) :tag(tagged_next++ % 4) {}
+
+  template<typename U>
+  tagged_allocator(const tagged_allocator<U> &rhs) :tag(rhs.tag) {}
+
+  T * allocate(std::size_t n) {
+    tagged_outstanding[tag] += n;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T *p, std::size_t n) {
+    BOOST_REQUIRE( tagged_outstanding[tag] >= n );
+    tagged_outstanding[tag] -= n;
+    std::allocator<T>().deallocate(p,n);
+  }
+
+  std::size_t tag;
+};
+
+template<typename T, typename U>
+bool operator==(const tagged_allocator<T> &lhs, const tagged_allocator<U> &rhs)
+{
+  return lhs.tag == rhs.tag;
+}
+
+template<typename T, typename U>
+bool operator!=(const tagged_allocator<T> &lhs, const tagged_allocator<U> &rhs)
+{
+  return !(lhs == rhs);
+}
+
+}
+
+/** \test Check that swap() exchanges allocators that propagate on swap, so
+ *  storage is always returned to the allocator it came from
+ */
+BOOST_AUTO_TEST_CASE( channel_group_swap_allocator_test )
+{
+  typedef basic_channel_group<float,float,float,tagged_allocator>
+    tagged_channel_group;
+
+  {
+    tagged_channel_group a(2,10,1.0,0.0,1.0f);
+    tagged_channel_group b(3,100,2.0,0.0,2.0f);
+
+    a.swap(b);
+    BOOST_CHECK_EQUAL( a.channels(), std::size_t(3) );
+    BOOST_CHECK_EQUAL( a[2][99], 2.0f );
+    BOOST_CHECK_EQUAL( b[1][9], 1.0f );
+
+    // growing allocates from the allocator that now owns the storage
+    b.resize(1000,3.0f);
+    a = b;
+    BOOST_CHECK_EQUAL( a[1][999], 3.0f );
+  }
+
+  for(std::size_t i=0; i<4; ++i)
+    BOOST_CHECK_EQUAL( tagged_outstanding[i], std::size_t(0) );
+
+  float_channel_group a(1,5,1.0,0.0,1.0f);
+  float_channel_group b(2,5,1.0,0.0,2.0f);
+  a.swap(b);
+  BOOST_CHECK_EQUAL( a.channels(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( b[0][4], 1.0f );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
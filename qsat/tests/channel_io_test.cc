@@ -0,0 +1,250 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/channel_io.h>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+/** \file
+ *  \brief Unit tests for reading and writing channel files
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<float,float,float,mapped_sequence> float_mapped_channel;
+
+/** Unique temporary file removed on destruction */
+struct channel_file {
+  channel_file(void) {
+    char name[] = "/tmp/qsat_channel_XXXXXX";
+    int fd = ::mkstemp(name);
+    BOOST_REQUIRE( fd >= 0 );
+    ::close(fd);
+    path = name;
+  }
+
+  ~channel_file(void) {
+    ::unlink(path.c_str());
+  }
+
+  std::string path;
+};
+
+/** \test Check the header written for a channel
+ */
+BOOST_AUTO_TEST_CASE( channel_io_header_test )
+{
+  channel_file file;
+
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+  write_channel(file.path,ch);
+
+  channel_file_header hdr = read_channel_header(file.path);
+  BOOST_CHECK_EQUAL( hdr.type_code, 9u );
+  BOOST_CHECK_EQUAL( hdr.sample_size, sizeof(float) );
+  BOOST_CHECK_EQUAL( hdr.count, 5u );
+  BOOST_CHECK_EQUAL( hdr.frequency, 2.0 );
+  BOOST_CHECK_EQUAL( hdr.epoch, 10.0 );
+  BOOST_CHECK_EQUAL( hdr.data_offset % hdr.alignment, 0u );
+
+  std::ifstream in(file.path.c_str(),std::ios::binary | std::ios::ate);
+  BOOST_CHECK_EQUAL( std::size_t(in.tellg()),
+    hdr.data_offset + 5*sizeof(float) );
+}
+
+/** \test Check writing and reading channels with differing containers
+ */
+BOOST_AUTO_TEST_CASE( channel_io_round_trip_test )
+{
+  channel_file file;
+
+  float_list_channel lch(mags,mags+5,2.0,10.0);
+  write_channel(file.path,lch);
+
+  float_basic_channel bch = read_channel<float_basic_channel>(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bch.begin(),bch.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( bch.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( bch.epoch(), 10.0 );
+
+  float_intrusive_channel ich(fill,fill+5,4.0,1.0);
+  write_channel(file.path,ich);
+
+  float_chunked_channel cch = read_channel<float_chunked_channel>(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cch.begin(),cch.end(),fill,fill+5 );
+  BOOST_CHECK_EQUAL( cch.frequency(), 4.0 );
+  BOOST_CHECK_EQUAL( cch.epoch(), 1.0 );
+
+  float_basic_channel empty;
+  write_channel(file.path,empty);
+  BOOST_CHECK( read_channel<float_basic_channel>(file.path).empty() );
+}
+
+/** \test Check that a loaded channel maps the file and is independent of it
+ */
+BOOST_AUTO_TEST_CASE( channel_io_load_test )
+{
+  channel_file file;
+
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+  write_channel(file.path,ch);
+
+  float_mapped_channel mch = load_channel<float,float,float>(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( mch.begin(),mch.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( mch.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( mch.epoch(), 10.0 );
+
+  // modifying the loaded channel leaves the file unchanged
+  mch.push_back(6.0);
+  mch[0] = 0.0;
+
+  float_basic_channel bch = read_channel<float_basic_channel>(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bch.begin(),bch.end(),mags,mags+5 );
+}
+
+/** \test Check that a loaded channel may be saved back to its own file
+ */
+BOOST_AUTO_TEST_CASE( channel_io_save_in_place_test )
+{
+  channel_file file;
+
+  std::vector<float> data;
+  for(std::size_t i=0; i<10000; ++i)
+    data.push_back(float(i)/7);
+
+  float_basic_channel ch(data.begin(),data.end(),2.0,10.0);
+  write_channel(file.path,ch);
+
+  // unmodified, written directly from the mapping
+  {
+    float_mapped_channel mch = load_channel<float,float,float>(file.path);
+    write_channel(file.path,mch);
+    BOOST_CHECK_EQUAL_COLLECTIONS( mch.begin(),mch.end(),
+      data.begin(),data.end() );
+  }
+
+  float_basic_channel bch = read_channel<float_basic_channel>(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bch.begin(),bch.end(),
+    data.begin(),data.end() );
+
+  // modified
+  {
+    float_mapped_channel mch = load_channel<float,float,float>(file.path);
+    mch[0] = -1.0f;
+    mch.push_back(42.0f);
+    write_channel(file.path,mch);
+  }
+
+  data[0] = -1.0f;
+  data.push_back(42.0f);
+
+  float_mapped_channel result = load_channel<float,float,float>(file.path);
+  BOOST_CHECK_EQUAL( result.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( result.epoch(), 10.0 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( result.begin(),result.end(),
+    data.begin(),data.end() );
+}
+
+/** \test Check that malformed files are rejected
+ */
+BOOST_AUTO_TEST_CASE( channel_io_error_test )
+{
+  channel_file file;
+
+  BOOST_CHECK_THROW( read_channel_header("/nonexistent/qsat_channel"),
+    std::system_error );
+
+  {
+    std::ofstream out(file.path.c_str(),std::ios::binary);
+    out << "not a channel file";
+  }
+  BOOST_CHECK_THROW( read_channel_header(file.path), std::runtime_error );
+
+  {
+    std::ofstream out(file.path.c_str(),std::ios::binary);
+    out << std::string(64,'x');
+  }
+  BOOST_CHECK_THROW( read_channel_header(file.path), std::runtime_error );
+
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+  write_channel(file.path,ch);
+  BOOST_CHECK_THROW( (load_channel<double,float,float>(file.path)),
+    std::runtime_error );
+}
+
+/** \test Check that an invalid alignment or a truncated file is rejected
+ */
+BOOST_AUTO_TEST_CASE( channel_io_alignment_test )
+{
+  channel_file file;
+
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+
+  const unsigned char bad_alignments[][2] = {{0,0}, {3,0}, {128,0}, {2,0}};
+  for(std::size_t i=0; i<4; ++i) {
+    write_channel(file.path,ch);
+    {
+      std::fstream out(file.path.c_str(),
+        std::ios::binary | std::ios::in | std::ios::out);
+      out.seekp(14);
+      out.write(reinterpret_cast<const char*>(bad_alignments[i]),2);
+    }
+
+    // 2 is a valid alignment, just not for float samples
+    if(i < 3) {
+      BOOST_CHECK_THROW( read_channel_header(file.path),
+        std::runtime_error );
+    }
+    BOOST_CHECK_THROW( (load_channel<float,float,float>(file.path)),
+      std::runtime_error );
+  }
+
+  write_channel(file.path,ch);
+  BOOST_REQUIRE( ::truncate(file.path.c_str(),64+4*sizeof(float)) == 0 );
+  BOOST_CHECK_THROW( (load_channel<float,float,float>(file.path)),
+    std::invalid_argument );
+  BOOST_CHECK_THROW( read_channel<float_basic_channel>(file.path),
+    std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
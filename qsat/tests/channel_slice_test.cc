@@ -0,0 +1,195 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/channel_slice.h>
+
+#include <numeric>
+#include <thread>
+
+/** \file
+ *  \brief Unit tests for basic_channel_slice
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel_slice<float_basic_channel> float_slice;
+typedef basic_channel_slice<float_list_channel> float_list_slice;
+
+/** \test Check construction, element access and timing
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_construction_test )
+{
+  float_basic_channel ch(mags,mags+5,2,1);
+
+  float_slice s1;
+  BOOST_CHECK( s1.empty() );
+
+  float_slice s2(ch);
+  BOOST_CHECK_EQUAL( s2.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( s2.epoch(), 1.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( s2.begin(),s2.end(),mags,mags+5 );
+
+  float_slice s3 = slice(ch,1,3);
+  BOOST_CHECK_EQUAL( s3.size(), std::size_t(3) );
+  BOOST_CHECK_EQUAL( s3.offset(), std::size_t(1) );
+  BOOST_CHECK_EQUAL( s3.frequency(), 2.0f );
+  BOOST_CHECK_EQUAL( s3.epoch(), 1.5f );
+  BOOST_CHECK_EQUAL( s3.time_at(2), 2.5f );
+  BOOST_CHECK_EQUAL( s3.index_at(2.5f), std::size_t(2) );
+  BOOST_CHECK_EQUAL( s3.front(), 2.0f );
+  BOOST_CHECK_EQUAL( s3.back(), 4.0f );
+  BOOST_CHECK_EQUAL( s3[1], 3.0f );
+  BOOST_CHECK_EQUAL( s3.at(2), 4.0f );
+  BOOST_CHECK_THROW( s3.at(3), std::out_of_range );
+  BOOST_CHECK_EQUAL_COLLECTIONS( s3.rbegin(),s3.rend(),
+    std::reverse_iterator<const float *>(mags+4),
+    std::reverse_iterator<const float *>(mags+1) );
+
+  // clipped to the end of the channel
+  BOOST_CHECK_EQUAL( slice(ch,3,10).size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( slice(ch,5,1).size(), std::size_t(0) );
+  BOOST_CHECK_THROW( slice(ch,6,1), std::out_of_range );
+
+  // no samples were copied
+  const float_basic_channel &cch = ch;
+  BOOST_CHECK_EQUAL( &s3.front(), &cch[1] );
+}
+
+/** \test Check that a slice outlives and is isolated from its channel
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_ownership_test )
+{
+  float_slice s1;
+  float_list_slice s2;
+
+  {
+    float_basic_channel ch(mags,mags+5);
+    float_list_channel lc(mags,mags+5);
+    s1 = slice(ch,1,3);
+    s2 = float_list_slice(lc,2,3);
+
+    ch[1] = 10;
+    ch.push_back(6);
+    lc.clear();
+
+    BOOST_CHECK_EQUAL( ch[1], 10.0f );
+  }
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( s1.begin(),s1.end(),mags+1,mags+4 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( s2.begin(),s2.end(),mags+2,mags+5 );
+  BOOST_CHECK_EQUAL( s2[2], 5.0f );
+}
+
+/** \test Check narrowing by offset and by time
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_narrow_test )
+{
+  float_basic_channel ch(mags,mags+5,1,10);
+
+  float_slice s1 = slice(ch,1,4);
+  float_slice s2 = s1.slice(1,2);
+  BOOST_CHECK_EQUAL( s2.offset(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( s2.epoch(), 12.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( s2.begin(),s2.end(),mags+2,mags+4 );
+  BOOST_CHECK_THROW( s1.slice(5,1), std::out_of_range );
+
+  float_slice s3 = time_slice(ch,11.0f,13.0f);
+  BOOST_CHECK_EQUAL( s3.epoch(), 11.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( s3.begin(),s3.end(),mags+1,mags+3 );
+
+  float_slice s4 = s1.time_slice(12.0f,100.0f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( s4.begin(),s4.end(),mags+2,mags+5 );
+
+  float_list_channel lc(mags,mags+5,1,10);
+  float_list_slice s5 = float_list_slice(lc).slice(3,5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( s5.begin(),s5.end(),mags+3,mags+5 );
+}
+
+/** \test Check promotion to a channel
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_to_channel_test )
+{
+  float_basic_channel ch(mags,mags+5,2,1);
+  const float_basic_channel &cch = ch;
+
+  float_basic_channel whole = float_slice(ch).to_channel();
+  BOOST_CHECK( whole == ch );
+  BOOST_CHECK_EQUAL( &static_cast<const float_basic_channel &>(whole)[0],
+    &cch[0] );
+
+  float_basic_channel part = slice(ch,2,2).to_channel();
+  BOOST_CHECK_EQUAL( part.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( part.frequency(), 2.0f );
+  BOOST_CHECK_EQUAL( part.epoch(), 2.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( part.begin(),part.end(),mags+2,mags+4 );
+}
+
+/** \test Check slices as channel expression operands
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_expression_test )
+{
+  float_basic_channel ch(mags,mags+5,2,1);
+  float_basic_channel twice = slice(ch,0,5) * 2.0f;
+  for(std::size_t i=0; i<5; ++i)
+    BOOST_CHECK_EQUAL( twice[i], 2*mags[i] );
+
+  float_basic_channel sum = slice(ch,0,3) + slice(ch,0,3);
+  BOOST_CHECK_EQUAL( sum.size(), std::size_t(3) );
+  BOOST_CHECK_EQUAL( sum[2], 6.0f );
+}
+
+/** \test Check handing a slice to another thread while the channel changes
+ */
+BOOST_AUTO_TEST_CASE( channel_slice_thread_test )
+{
+  float_basic_channel ch(1000,1.0f);
+  float_slice s = slice(ch,100,500);
+
+  float total = 0;
+  std::thread t([s,&total]() {
+    total = std::accumulate(s.begin(),s.end(),0.0f);
+  });
+
+  for(std::size_t i=0; i<ch.size(); ++i)
+    ch[i] = 2;
+
+  t.join();
+  BOOST_CHECK_EQUAL( total, 500.0f );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
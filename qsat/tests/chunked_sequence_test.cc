@@ -0,0 +1,204 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/chunked_sequence.h>
+
+/** \file
+ *  \brief Unit tests for chunked_sequence and basic_channel using it as the
+ *    underlying container
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef chunked_sequence<float> float_chunked_sequence;
+
+/** \test Check construction as a model of std::sequence
+ */
+BOOST_AUTO_TEST_CASE( chunked_sequence_construction_test )
+{
+  float_chunked_sequence cs1;
+  BOOST_CHECK( cs1.empty() );
+  BOOST_CHECK_EQUAL( cs1.chunk_count(), std::size_t(0) );
+
+  float_chunked_sequence cs2(5,.2f);
+  BOOST_CHECK_EQUAL( cs2.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs2.begin(),cs2.end(),fill,fill+5 );
+
+  float_chunked_sequence cs3(mags,mags+5);
+  BOOST_CHECK_EQUAL( cs3.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs3.begin(),cs3.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs3.rbegin(),cs3.rend(),
+    std::reverse_iterator<const float*>(mags+5),
+    std::reverse_iterator<const float*>(mags) );
+
+  float_chunked_sequence cs4(5,2);
+  BOOST_CHECK_EQUAL( cs4.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( cs4.back(), 2.0f );
+}
+
+/** \test Check that copies share chunks until written to
+ */
+BOOST_AUTO_TEST_CASE( chunked_sequence_sharing_test )
+{
+  const std::size_t len = float_chunked_sequence::chunk_length*3 + 7;
+
+  float_chunked_sequence cs1;
+  for(std::size_t i=0; i<len; ++i)
+    cs1.push_back(float(i));
+
+  BOOST_CHECK_EQUAL( cs1.size(), len );
+  BOOST_CHECK_EQUAL( cs1.chunk_count(), std::size_t(4) );
+
+  float_chunked_sequence cs2(cs1);
+  const float_chunked_sequence &ccs1 = cs1;
+  const float_chunked_sequence &ccs2 = cs2;
+
+  for(std::size_t i=0; i<cs2.chunk_count(); ++i)
+    BOOST_CHECK( cs2.chunk_shared(i) );
+
+  BOOST_CHECK_EQUAL( &ccs1[len/2], &ccs2[len/2] );
+  BOOST_CHECK( cs1 == cs2 );
+
+  // write into the second chunk only
+  cs2[float_chunked_sequence::chunk_length+1] = -1;
+  BOOST_CHECK( cs2.chunk_shared(0) );
+  BOOST_CHECK( !cs2.chunk_shared(1) );
+  BOOST_CHECK( cs2.chunk_shared(2) );
+  BOOST_CHECK( cs2.chunk_shared(3) );
+  BOOST_CHECK_EQUAL( &ccs1[0], &ccs2[0] );
+  BOOST_CHECK( &ccs1[float_chunked_sequence::chunk_length] !=
+    &ccs2[float_chunked_sequence::chunk_length] );
+
+  BOOST_CHECK_EQUAL( ccs1[float_chunked_sequence::chunk_length+1],
+    float(float_chunked_sequence::chunk_length+1) );
+  BOOST_CHECK_EQUAL( ccs2[float_chunked_sequence::chunk_length+1], -1.0f );
+  BOOST_CHECK( cs1 != cs2 );
+
+  // append only touches the last chunk
+  cs2.push_back(42);
+  BOOST_CHECK( cs2.chunk_shared(2) );
+  BOOST_CHECK( !cs2.chunk_shared(3) );
+  BOOST_CHECK_EQUAL( cs1.size(), len );
+  BOOST_CHECK_EQUAL( cs2.size(), len+1 );
+  BOOST_CHECK_EQUAL( ccs2.back(), 42.0f );
+}
+
+/** \test Check insertion, erasure and resizing across chunk boundaries
+ */
+BOOST_AUTO_TEST_CASE( chunked_sequence_modifier_test )
+{
+  const std::size_t len = float_chunked_sequence::chunk_length + 3;
+
+  std::vector<float> ref;
+  for(std::size_t i=0; i<len; ++i)
+    ref.push_back(float(i));
+
+  float_chunked_sequence cs1(ref.begin(),ref.end());
+  float_chunked_sequence cs2(cs1);
+
+  ref.insert(ref.begin()+2,mags,mags+5);
+  cs1.insert(cs1.begin()+2,mags,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+
+  ref.insert(ref.begin()+len-1,3,.2f);
+  cs1.insert(cs1.begin()+len-1,3,.2f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+
+  BOOST_CHECK( *cs1.insert(cs1.begin(),-1.0f) == -1.0f );
+  ref.insert(ref.begin(),-1.0f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+
+  ref.erase(ref.begin()+1,ref.begin()+9);
+  cs1.erase(cs1.begin()+1,cs1.begin()+9);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+
+  ref.erase(ref.end()-1);
+  cs1.erase(cs1.end()-1);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+
+  ref.resize(3);
+  cs1.resize(3);
+  BOOST_CHECK_EQUAL_COLLECTIONS( cs1.begin(),cs1.end(),ref.begin(),ref.end() );
+  BOOST_CHECK_EQUAL( cs1.chunk_count(), std::size_t(1) );
+
+  cs1.pop_back();
+  BOOST_CHECK_EQUAL( cs1.size(), std::size_t(2) );
+
+  // the original copy is unaffected
+  BOOST_CHECK_EQUAL( cs2.size(), len );
+  for(std::size_t i=0; i<len; ++i)
+    BOOST_CHECK_EQUAL( cs2[i], float(i) );
+
+  BOOST_CHECK_THROW( cs1.at(2), std::out_of_range );
+}
+
+/** \test Check basic_channel copy-on-write with chunked_sequence
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_chunked_test )
+{
+  const std::size_t len = float_chunked_sequence::chunk_length*2;
+
+  float_chunked_channel bc1(len,.2f,.5,-.2);
+  const float_chunked_channel &cbc1 = bc1;
+  float_chunked_channel bc2 = bc1;
+  const float_chunked_channel &cbc2 = bc2;
+
+  //check shared base
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+
+  bc2[len-1] = 42;
+
+  //only the last chunk was copied
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+  BOOST_CHECK( &cbc1.back() != &cbc2.back() );
+  BOOST_CHECK_EQUAL( cbc1.back(), .2f );
+  BOOST_CHECK_EQUAL( cbc2.back(), 42.0f );
+
+  bc1 = bc2;
+  bc2.push_back(1);
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+  BOOST_CHECK_EQUAL( bc1.size(), len );
+  BOOST_CHECK_EQUAL( bc2.size(), len+1 );
+
+  bc2.reserve(len*4);
+  BOOST_CHECK_EQUAL( &cbc1.front(), &cbc2.front() );
+  BOOST_CHECK( bc2.capacity() >= len*4 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,250 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/compressed_sequence.h>
+
+#include <vector>
+#include <limits>
+#include <stdexcept>
+#include <cmath>
+#include <cstdint>
+
+/** \file
+ *  \brief Unit tests for compressed_sequence
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<double,double,double,compressed_sequence>
+  double_compressed_channel;
+
+/** \test Check floating point values round trip exactly, including
+ *  special values, and that slowly varying values compress
+ */
+BOOST_AUTO_TEST_CASE( compressed_sequence_float_test )
+{
+  std::vector<double> data;
+  for(std::size_t i=0; i<10000; ++i)
+    data.push_back(std::floor(100*std::sin(i/500.0))/4);
+
+  data[17] = std::numeric_limits<double>::infinity();
+  data[18] = -0.0;
+  data[19] = std::numeric_limits<double>::denorm_min();
+  data[20] = 1e300;
+
+  compressed_sequence<double> seq(data.begin(),data.end());
+  BOOST_REQUIRE_EQUAL( seq.size(), data.size() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+  BOOST_CHECK( std::signbit(seq[18]) );
+
+  BOOST_CHECK_LT( seq.compressed_size()*5, data.size()*sizeof(double) );
+
+  std::vector<float> fdata;
+  for(std::size_t i=0; i<1000; ++i)
+    fdata.push_back(float(i%17)*0.37f - float(i)*1e-3f);
+
+  compressed_sequence<float> fseq(fdata.begin(),fdata.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( fseq.begin(),fseq.end(),
+    fdata.begin(),fdata.end() );
+}
+
+/** \test Check floating point types wider than double round trip exactly
+ */
+BOOST_AUTO_TEST_CASE( compressed_sequence_long_double_test )
+{
+  std::vector<long double> data;
+  for(std::size_t i=0; i<3000; ++i)
+    data.push_back((i/7)*0.1L + 1e-19L*i);
+
+  data[5] = std::numeric_limits<long double>::infinity();
+  data[6] = -0.0L;
+  data[7] = std::numeric_limits<long double>::max();
+  data[8] = std::numeric_limits<long double>::denorm_min();
+
+  compressed_sequence<long double> seq(data.begin(),data.end());
+  BOOST_REQUIRE_EQUAL( seq.size(), data.size() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+  BOOST_CHECK( std::signbit(seq[6]) );
+  BOOST_CHECK_EQUAL( seq[2999], data[2999] );
+  BOOST_CHECK_EQUAL( seq[1234], data[1234] );
+
+  seq.push_back(std::numeric_limits<long double>::quiet_NaN());
+  BOOST_CHECK( std::isnan(seq.back()) );
+}
+
+/** \test Check integral values round trip across the full range and that
+ *  regular ramps compress to about a bit per element
+ */
+BOOST_AUTO_TEST_CASE( compressed_sequence_integral_test )
+{
+  std::vector<std::int64_t> data;
+  for(std::int64_t i=0; i<5000; ++i)
+    data.push_back(1000000 + 3*i);
+
+  compressed_sequence<std::int64_t> seq(data.begin(),data.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+  BOOST_CHECK_LT( seq.compressed_size(), data.size()/4 );
+
+  std::vector<std::int64_t> extremes;
+  extremes.push_back(std::numeric_limits<std::int64_t>::max());
+  extremes.push_back(std::numeric_limits<std::int64_t>::min());
+  extremes.push_back(0);
+  extremes.push_back(-1);
+  extremes.push_back(std::numeric_limits<std::int64_t>::max());
+  extremes.push_back(12345);
+
+  compressed_sequence<std::int64_t> ext(extremes.begin(),extremes.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( ext.begin(),ext.end(),
+    extremes.begin(),extremes.end() );
+
+  const short shorts[] = {-32768,32767,-1,0,5,-7};
+  compressed_sequence<short> sseq(shorts,shorts+6);
+  BOOST_CHECK_EQUAL_COLLECTIONS( sseq.begin(),sseq.end(),shorts,shorts+6 );
+
+  compressed_sequence<int> fill(5,7);
+  BOOST_CHECK_EQUAL( fill.size(), 5 );
+  BOOST_CHECK_EQUAL( fill.back(), 7 );
+}
+
+/** \test Check random access seeks across blocks in both directions
+ */
+BOOST_AUTO_TEST_CASE( compressed_sequence_seek_test )
+{
+  std::vector<double> data;
+  for(std::size_t i=0; i<3000; ++i)
+    data.push_back(i*0.5 + (i%3));
+
+  compressed_sequence<double> seq(data.begin(),data.end());
+
+  for(std::size_t i=0; i<data.size(); i += 97)
+    BOOST_REQUIRE_EQUAL( seq[i], data[i] );
+
+  compressed_sequence<double>::const_iterator cur = seq.begin() + 2999;
+  BOOST_CHECK_EQUAL( *cur, data[2999] );
+  cur -= 1000;
+  BOOST_CHECK_EQUAL( *cur, data[1999] );
+  --cur;
+  BOOST_CHECK_EQUAL( *cur, data[1998] );
+  cur += 3;
+  BOOST_CHECK_EQUAL( *cur, data[2001] );
+  BOOST_CHECK_EQUAL( cur[-2001], data[0] );
+  BOOST_CHECK_EQUAL( seq.end() - cur, 999 );
+
+  std::vector<double> reversed(seq.rbegin(),seq.rend());
+  BOOST_CHECK_EQUAL_COLLECTIONS( reversed.begin(),reversed.end(),
+    data.rbegin(),data.rend() );
+
+  BOOST_CHECK_THROW( seq.at(3000), std::out_of_range );
+}
+
+/** \test Check modification within and across blocks
+ */
+BOOST_AUTO_TEST_CASE( compressed_sequence_modify_test )
+{
+  std::vector<double> data;
+  for(std::size_t i=0; i<1000; ++i)
+    data.push_back(std::sqrt(double(i)));
+
+  compressed_sequence<double> seq(data.begin(),data.end());
+
+  seq.insert(seq.begin()+300,mags,mags+5);
+  data.insert(data.begin()+300,mags,mags+5);
+  seq.insert(seq.begin()+5,2,-1.0);
+  data.insert(data.begin()+5,2,-1.0);
+  BOOST_CHECK_EQUAL( *seq.insert(seq.end(),9.0), 9.0 );
+  data.push_back(9.0);
+
+  BOOST_CHECK_EQUAL( *seq.erase(seq.begin()+10,seq.begin()+600),
+    data[600] );
+  data.erase(data.begin()+10,data.begin()+600);
+  seq.erase(seq.begin());
+  data.erase(data.begin());
+
+  seq.pop_back();
+  data.pop_back();
+  seq.resize(600,2.5);
+  data.resize(600,2.5);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  seq.resize(100);
+  data.resize(100);
+  seq.push_back(42.0);
+  data.push_back(42.0);
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  compressed_sequence<double> other;
+  other.swap(seq);
+  BOOST_CHECK( seq.empty() );
+  BOOST_CHECK_EQUAL( other.size(), 101 );
+  other.clear();
+  BOOST_CHECK( other.empty() );
+}
+
+/** \test Check a basic_channel over a compressed_sequence
+ */
+BOOST_AUTO_TEST_CASE( compressed_channel_test )
+{
+  std::vector<double> data;
+  for(std::size_t i=0; i<2000; ++i)
+    data.push_back(std::floor(i/10.0));
+
+  double_compressed_channel ch(data.begin(),data.end(),100.0,5.0);
+  ch.push_back(200.0);
+  data.push_back(200.0);
+
+  BOOST_REQUIRE_EQUAL( ch.size(), data.size() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),
+    data.begin(),data.end() );
+
+  const double_compressed_channel &cch = ch;
+  double_compressed_channel::const_subchannel_type sub =
+    cch.subchannel(15.0,15.5);
+  BOOST_REQUIRE_EQUAL( sub.size(), 50 );
+  BOOST_CHECK_EQUAL( sub.epoch(), 15.0 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),
+    data.begin()+1000,data.begin()+1050 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
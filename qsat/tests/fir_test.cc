@@ -0,0 +1,198 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/fir.h>
+
+#include <vector>
+#include <iterator>
+#include <limits>
+#include <cmath>
+
+/** \file
+ *  \brief Unit tests for fir_filter and convolve
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<double,double,double> double_basic_channel;
+
+/** Deterministic test signal */
+static std::vector<double> test_signal(std::size_t n)
+{
+  std::vector<double> sig(n);
+  for(std::size_t i=0; i<n; ++i)
+    sig[i] = std::sin(0.37*i) + 0.5*std::cos(1.91*i+0.3);
+
+  return sig;
+}
+
+/** Direct evaluation of the filter definition */
+static std::vector<double> reference(const std::vector<double> &x,
+  const std::vector<double> &h)
+{
+  std::vector<double> y(x.size(),0.0);
+  for(std::size_t n=0; n<x.size(); ++n) {
+    for(std::size_t k=0; k<h.size() && k<=n; ++k)
+      y[n] += h[k]*x[n-k];
+  }
+
+  return y;
+}
+
+/** \test Check direct and FFT filtering against the filter definition
+ */
+BOOST_AUTO_TEST_CASE( fir_filter_value_test )
+{
+  std::vector<double> x = test_signal(1000);
+
+  std::size_t sizes[] = {1,3,17,64,200};
+  for(std::size_t s=0; s<5; ++s) {
+    std::vector<double> h = test_signal(sizes[s]);
+    std::vector<double> ref = reference(x,h);
+
+    fir_filter<double> dfilt(h.begin(),h.end(),fir_filter<double>::direct);
+    BOOST_CHECK_EQUAL( dfilt.taps(), sizes[s] );
+
+    std::vector<double> dres;
+    dfilt.process(x.begin(),x.end(),std::back_inserter(dres));
+    BOOST_REQUIRE_EQUAL( dres.size(), x.size() );
+    for(std::size_t i=0; i<x.size(); ++i)
+      BOOST_CHECK_SMALL( dres[i]-ref[i], 1e-9 );
+
+    fir_filter<double> ffilt(h.begin(),h.end(),fir_filter<double>::fft);
+    std::vector<double> fres;
+    ffilt.process(x.begin(),x.end(),std::back_inserter(fres));
+    BOOST_REQUIRE_EQUAL( fres.size(), x.size() );
+    for(std::size_t i=0; i<x.size(); ++i)
+      BOOST_CHECK_SMALL( fres[i]-ref[i], 1e-9 );
+
+    std::vector<float> xf(x.begin(),x.end());
+    fir_filter<float> sfilt(h.begin(),h.end());
+    std::vector<float> sres;
+    sfilt.process(xf.begin(),xf.end(),std::back_inserter(sres));
+    for(std::size_t i=0; i<x.size(); ++i)
+      BOOST_CHECK_SMALL( sres[i]-ref[i], 1e-3 );
+  }
+
+  fir_filter<float> shortf(mags,mags+5);
+  BOOST_CHECK( shortf.method() == fir_filter<float>::direct );
+
+  std::vector<double> h = test_signal(100);
+  fir_filter<double> longf(h.begin(),h.end());
+  BOOST_CHECK( longf.method() == fir_filter<double>::fft );
+}
+
+/** \test Check that filtering consecutive subchannels matches filtering the
+ *  whole channel
+ */
+BOOST_AUTO_TEST_CASE( fir_filter_stream_test )
+{
+  std::vector<double> x = test_signal(1000);
+  double_basic_channel ch(x.begin(),x.end(),100.0,2.0);
+
+  for(int m=0; m<2; ++m) {
+    std::vector<double> h = test_signal(m ? 150 : 9);
+
+    fir_filter<double> whole(h.begin(),h.end());
+    double_basic_channel ref = whole(ch);
+    BOOST_CHECK_EQUAL( ref.size(), ch.size() );
+    BOOST_CHECK_EQUAL( ref.frequency(), 100.0 );
+    BOOST_CHECK_EQUAL( ref.epoch(), 2.0 );
+
+    fir_filter<double> pieces(h.begin(),h.end());
+    std::size_t bounds[] = {0,1,7,300,301,1000};
+    for(std::size_t i=0; i<5; ++i) {
+      double_basic_channel::subchannel_type sub =
+        ch.subchannel(ch.begin()+bounds[i],ch.begin()+bounds[i+1]);
+
+      double_basic_channel res = pieces(sub);
+      BOOST_REQUIRE_EQUAL( res.size(), bounds[i+1]-bounds[i] );
+      BOOST_CHECK_CLOSE( res.epoch(), 2.0+bounds[i]/100.0, 1e-9 );
+      for(std::size_t j=0; j<res.size(); ++j)
+        BOOST_CHECK_SMALL( res[j]-ref[bounds[i]+j], 1e-9 );
+    }
+
+    pieces.reset();
+    double_basic_channel again = pieces(ch);
+    for(std::size_t j=0; j<again.size(); ++j)
+      BOOST_CHECK_SMALL( again[j]-ref[j], 1e-9 );
+  }
+}
+
+/** \test Check convolve over differing containers
+ */
+BOOST_AUTO_TEST_CASE( convolve_test )
+{
+  const float kernel[] = {1.0,-1.0};
+  const float diff[] = {1.0,1.0,1.0,1.0,1.0};
+
+  float_list_channel lch(mags,mags+5,2.0,10.0);
+  float_list_channel lres = convolve(lch,kernel,kernel+2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( lres.begin(),lres.end(),diff,diff+5 );
+  BOOST_CHECK_EQUAL( lres.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( lres.epoch(), 10.0 );
+
+  float_basic_channel bch(mags,mags+5,2.0,10.0);
+  float_basic_channel bres = convolve(bch,kernel,kernel+2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( bres.begin(),bres.end(),diff,diff+5 );
+
+  BOOST_CHECK_THROW( convolve(bch,kernel,kernel), std::invalid_argument );
+}
+
+/** \test Check that computed values round and saturate to integral samples
+ *  and that NaN throws
+ */
+BOOST_AUTO_TEST_CASE( sample_cast_test )
+{
+  BOOST_CHECK_EQUAL( detail::sample_cast<short>(2.5), short(3) );
+  BOOST_CHECK_EQUAL( detail::sample_cast<short>(-2.4), short(-2) );
+  BOOST_CHECK_EQUAL( detail::sample_cast<short>(1e6),
+    std::numeric_limits<short>::max() );
+  BOOST_CHECK_EQUAL( detail::sample_cast<short>(-1e6),
+    std::numeric_limits<short>::min() );
+  BOOST_CHECK_EQUAL( detail::sample_cast<float>(2.5), 2.5f );
+
+  BOOST_CHECK_THROW( detail::sample_cast<int>(std::nan("")),
+    boost::numeric::bad_numeric_cast );
+  BOOST_CHECK_THROW( detail::sample_cast<short>(std::nan("")),
+    boost::numeric::bad_numeric_cast );
+  BOOST_CHECK( std::isnan(detail::sample_cast<float>(std::nan(""))) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
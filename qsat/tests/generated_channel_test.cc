@@ -0,0 +1,271 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/generated_channel.h>
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+/** \file
+ *  \brief Unit tests for basic_generated_channel and the generators
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<double,double,double> double_basic_channel;
+
+/** \test Check samples are computed from the time and index of each
+ *  sample, and that very long channels store nothing
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_sine_test )
+{
+  const double pi = 3.14159265358979323846;
+
+  basic_generated_channel<double_basic_channel,sine_generator<double> > tone =
+    generate_channel<double_basic_channel>(
+      sine_generator<double>(2.0,5.0,0.5,1.0),1000,100.0,3.0);
+
+  BOOST_REQUIRE_EQUAL( tone.size(), 1000 );
+  BOOST_CHECK_EQUAL( tone.frequency(), 100.0 );
+  BOOST_CHECK_EQUAL( tone.epoch(), 3.0 );
+  BOOST_CHECK_EQUAL( tone.index_at(4.0), 100 );
+
+  for(std::size_t i=0; i<tone.size(); i += 37) {
+    double t = 3.0 + i/100.0;
+    BOOST_CHECK_CLOSE( tone[i], 2*std::sin(2*pi*5*t + 0.5) + 1, 1e-9 );
+  }
+
+  std::vector<double> reversed(tone.rbegin(),tone.rend());
+  BOOST_CHECK_EQUAL( reversed.front(), tone.back() );
+  BOOST_CHECK_EQUAL( reversed.back(), tone.front() );
+  BOOST_CHECK_EQUAL( tone.end() - tone.begin(), 1000 );
+  BOOST_CHECK_THROW( tone.at(1000), std::out_of_range );
+
+  basic_generated_channel<double_basic_channel,sine_generator<double> >
+    day(sine_generator<double>(),48000ULL*3600*24,48000.0);
+  BOOST_CHECK_EQUAL( day.size(), 48000ULL*3600*24 );
+  BOOST_CHECK_LT( sizeof(day), 128 );
+  BOOST_CHECK_CLOSE( day.time_at(day.size()), 3600.0*24, 1e-9 );
+}
+
+/** \test Check slices compute the same samples as the channel they were
+ *  taken from, and materialization
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_slice_test )
+{
+  basic_generated_channel<double_basic_channel,noise_generator<double> >
+    noise(noise_generator<double>(1.0,42),10000,1000.0,1.0);
+
+  basic_generated_channel<double_basic_channel,noise_generator<double> >
+    sub = noise.time_slice(3.0,4.0);
+  BOOST_REQUIRE_EQUAL( sub.size(), 1000 );
+  BOOST_CHECK_EQUAL( sub.epoch(), 3.0 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),
+    noise.begin()+2000,noise.begin()+3000 );
+
+  basic_generated_channel<double_basic_channel,noise_generator<double> >
+    narrow = sub.slice(10,20);
+  BOOST_CHECK_EQUAL( narrow.front(), noise[2010] );
+  BOOST_CHECK_EQUAL( sub.slice(990,20).size(), 10 );
+  BOOST_CHECK_THROW( sub.slice(1001,1), std::out_of_range );
+
+  double_basic_channel ch = sub.to_channel();
+  BOOST_REQUIRE_EQUAL( ch.size(), 1000 );
+  BOOST_CHECK_EQUAL( ch.frequency(), 1000.0 );
+  BOOST_CHECK_EQUAL( ch.epoch(), 3.0 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),sub.begin(),sub.end() );
+
+  ch[0] = 7.0;
+  BOOST_CHECK_EQUAL( ch[0], 7.0 );
+  BOOST_CHECK_NE( sub[0], 7.0 );
+}
+
+/** \test Check that sample times are those of a basic_channel and of its
+ *  subchannels
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_time_test )
+{
+  basic_generated_channel<double_basic_channel,sine_generator<double> > tone(
+    sine_generator<double>(),100000,48000.0/7,1234.567);
+
+  double_basic_channel ch = tone.to_channel();
+  double_basic_channel::const_subchannel_type sub =
+    static_cast<const double_basic_channel &>(ch).subchannel(
+      ch.begin()+54321,ch.end());
+
+  basic_generated_channel<double_basic_channel,sine_generator<double> >
+    gsub = tone.slice(54321,tone.size());
+
+  for(std::size_t n=0; n<tone.size(); n += 997) {
+    BOOST_CHECK_EQUAL( tone.time_at(n), ch.time_at(n) );
+    BOOST_CHECK_EQUAL( tone.index_at(ch.time_at(n)), n );
+  }
+
+  for(std::size_t n=0; n<gsub.size(); n += 331)
+    BOOST_CHECK_EQUAL( gsub.time_at(n), sub.time_at(n) );
+}
+
+/** \test Check blocks cover every sample once in order
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_block_test )
+{
+  basic_generated_channel<double_basic_channel,sine_generator<double> > tone(
+    sine_generator<double>(1.0,3.0),10000,1000.0);
+
+  std::vector<double> blocks;
+  std::size_t calls = 0;
+  tone.slice(5,9000).for_each_block(
+    [&](const double *first, const double *last) {
+      BOOST_CHECK_LE( last-first, 4096 );
+      blocks.insert(blocks.end(),first,last);
+      ++calls;
+    });
+
+  BOOST_CHECK_EQUAL( calls, 3 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( blocks.begin(),blocks.end(),
+    tone.begin()+5,tone.begin()+9005 );
+
+  calls = 0;
+  tone.for_each_block([&](const double *, const double *) { ++calls; },100);
+  BOOST_CHECK_EQUAL( calls, 100 );
+}
+
+/** \test Check the chirp, noise and piecewise linear generators
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_generator_test )
+{
+  const double pi = 3.14159265358979323846;
+
+  chirp_generator<double> chirp(1.0,10.0,20.0,2.0,1.0);
+  BOOST_CHECK_SMALL( chirp(0,1.0), 1e-12 );
+  BOOST_CHECK_CLOSE( chirp(0,1.01), std::sin(2*pi*(10*0.01 + 2.5*0.0001)),
+    1e-9 );
+  BOOST_CHECK_THROW( chirp_generator<double>(1.0,10.0,20.0,0.0),
+    std::invalid_argument );
+
+  noise_generator<double> noise(0.5,7);
+  double sum = 0;
+  for(std::size_t i=0; i<100000; ++i) {
+    double x = noise(i,0.0);
+    BOOST_REQUIRE( x >= -0.5 && x < 0.5 );
+    sum += x;
+  }
+  BOOST_CHECK_SMALL( sum/100000, 0.01 );
+  BOOST_CHECK_EQUAL( noise(12345,0.0),
+    noise_generator<double>(0.5,7)(12345,1.0) );
+  BOOST_CHECK_NE( noise(12345,0.0),
+    noise_generator<double>(0.5,8)(12345,0.0) );
+
+  std::vector<std::pair<double,double> > points;
+  points.push_back(std::make_pair(1.0,0.0));
+  points.push_back(std::make_pair(2.0,10.0));
+  points.push_back(std::make_pair(4.0,0.0));
+
+  basic_generated_channel<double_basic_channel,
+    piecewise_linear_generator<double> > ramp =
+      generate_channel<double_basic_channel>(
+        piecewise_linear_generator<double>(points.begin(),points.end()),
+        6,1.0);
+
+  const double expected[] = {0.0,0.0,10.0,5.0,0.0,0.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS( ramp.begin(),ramp.end(),expected,
+    expected+6 );
+  BOOST_CHECK_EQUAL( piecewise_linear_generator<double>()(0,1.0), 0.0 );
+
+  std::reverse(points.begin(),points.end());
+  BOOST_CHECK_THROW(
+    piecewise_linear_generator<double>(points.begin(),points.end()),
+    std::invalid_argument );
+}
+
+/** \test Check that integral samples are rounded and saturate rather than
+ *  being truncated
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_integral_test )
+{
+  const double pi = 3.14159265358979323846;
+
+  sine_generator<short> tone(1000,1.0);
+  BOOST_CHECK_EQUAL( tone(0,std::asin(0.9997)/(2*pi)), 1000 );
+  BOOST_CHECK_EQUAL( tone(0,-std::asin(0.0006)/(2*pi)), -1 );
+
+  sine_generator<short> loud(32767,1.0,0,100);
+  BOOST_CHECK_EQUAL( loud(0,0.25), 32767 );
+  BOOST_CHECK_EQUAL( loud(0,0.75), -32667 );
+
+  chirp_generator<short> chirp(1000,1.0,1.0,1.0);
+  BOOST_CHECK_EQUAL( chirp(0,std::asin(0.9997)/(2*pi)), 1000 );
+
+  noise_generator<short> noise(3,7);
+  bool extremes[2] = {false,false};
+  for(std::size_t i=0; i<1000; ++i) {
+    short x = noise(i,0.0);
+    BOOST_REQUIRE( x >= -3 && x <= 3 );
+    extremes[0] = extremes[0] || x == -3;
+    extremes[1] = extremes[1] || x == 3;
+  }
+  BOOST_CHECK( extremes[0] && extremes[1] );
+
+  std::vector<std::pair<double,short> > points;
+  points.push_back(std::make_pair(0.0,short(0)));
+  points.push_back(std::make_pair(4.0,short(3)));
+  piecewise_linear_generator<short> ramp(points.begin(),points.end());
+  BOOST_CHECK_EQUAL( ramp(0,1.0), 1 );
+  BOOST_CHECK_EQUAL( ramp(0,3.0), 2 );
+}
+
+/** \test Check generated channels as channel expression operands
+ */
+BOOST_AUTO_TEST_CASE( generated_channel_expression_test )
+{
+  basic_generated_channel<double_basic_channel,sine_generator<double> > tone(
+    sine_generator<double>(1.0,3.0),500,100.0,2.0);
+  basic_generated_channel<double_basic_channel,noise_generator<double> >
+    noise(noise_generator<double>(0.1,1),500,100.0,2.0);
+
+  double_basic_channel mixed = tone + noise*2.0;
+  BOOST_REQUIRE_EQUAL( mixed.size(), 500 );
+  BOOST_CHECK_EQUAL( mixed.epoch(), 2.0 );
+  for(std::size_t i=0; i<mixed.size(); i += 50)
+    BOOST_CHECK_CLOSE( mixed[i], tone[i] + noise[i]*2.0, 1e-9 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
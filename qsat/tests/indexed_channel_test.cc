@@ -0,0 +1,232 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/indexed_channel.h>
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+/** \file
+ *  \brief Unit tests for basic_indexed_channel
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_indexed_channel<float_basic_channel> float_indexed_channel;
+typedef basic_indexed_channel<float_list_channel> float_indexed_list_channel;
+
+/** Deterministic, irregular sample value */
+static float sample_value(std::size_t i)
+{
+  return float((i*7919u) % 1013u) - 500.0f;
+}
+
+/** Compare every summary against a scan of the samples */
+template<typename IndexedT>
+static void check_summaries(const IndexedT &ich)
+{
+  std::vector<float> vals(ich.begin(),ich.end());
+
+  for(std::size_t first=0; first<=vals.size(); first += 7) {
+    for(std::size_t last=first; last<=vals.size(); last += 13) {
+      sample_summary<float> res = ich.summary(first,last);
+      BOOST_REQUIRE_EQUAL( res.count, last-first );
+      if(first == last)
+        continue;
+
+      double sum = 0;
+      for(std::size_t i=first; i<last; ++i)
+        sum += vals[i];
+
+      BOOST_CHECK_EQUAL( res.min,
+        *std::min_element(vals.begin()+first,vals.begin()+last) );
+      BOOST_CHECK_EQUAL( res.max,
+        *std::max_element(vals.begin()+first,vals.begin()+last) );
+      BOOST_CHECK_CLOSE( res.mean, sum/(last-first), 1e-6 );
+    }
+  }
+}
+
+/** \test Check summaries while appending samples
+ */
+BOOST_AUTO_TEST_CASE( indexed_channel_append_test )
+{
+  float_indexed_channel ich(float_basic_channel(mags,mags+5,2.0,10.0),2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ich.begin(),ich.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ich.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( ich.epoch(), 10.0 );
+  check_summaries(ich);
+
+  for(std::size_t i=0; i<300; ++i)
+    ich.push_back(sample_value(i));
+
+  BOOST_CHECK_EQUAL( ich.size(), std::size_t(305) );
+  BOOST_CHECK( ich.levels() > 4 );
+  check_summaries(ich);
+
+  std::vector<float> more;
+  for(std::size_t i=300; i<377; ++i)
+    more.push_back(sample_value(i));
+
+  ich.append(more.begin(),more.end());
+  check_summaries(ich);
+
+  BOOST_CHECK_THROW( ich.summary(10,1000), std::out_of_range );
+  BOOST_CHECK_THROW( ich.summary(10,5), std::out_of_range );
+}
+
+/** \test Check summaries after modifying samples
+ */
+BOOST_AUTO_TEST_CASE( indexed_channel_modify_test )
+{
+  float_indexed_channel ich(float_basic_channel(),2);
+  for(std::size_t i=0; i<257; ++i)
+    ich.push_back(sample_value(i));
+
+  ich.set(100,1000.0f);
+  ich.set(0,-1000.0f);
+  check_summaries(ich);
+  BOOST_CHECK_EQUAL( ich.summary(0,ich.size()).max, 1000.0f );
+  BOOST_CHECK_EQUAL( ich.summary(0,ich.size()).min, -1000.0f );
+
+  ich.insert(37,2000.0f);
+  BOOST_CHECK_EQUAL( ich[37], 2000.0f );
+  check_summaries(ich);
+
+  ich.insert(5,mags,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ich.begin()+5,ich.begin()+10,mags,mags+5 );
+  check_summaries(ich);
+
+  ich.erase(38);
+  check_summaries(ich);
+
+  ich.erase(10,150);
+  BOOST_CHECK_EQUAL( ich.size(), std::size_t(122) );
+  check_summaries(ich);
+
+  ich.pop_back();
+  check_summaries(ich);
+
+  ich.clear();
+  BOOST_CHECK( ich.empty() );
+  BOOST_CHECK_EQUAL( ich.summary(0,0).count, 0u );
+}
+
+/** \test Check bucketed summaries by index and time, and a list backend
+ */
+BOOST_AUTO_TEST_CASE( indexed_channel_summarize_test )
+{
+  float_list_channel lch(0,0.0f,10.0,-1.0);
+  for(std::size_t i=0; i<1000; ++i)
+    lch.push_back(sample_value(i));
+
+  float_indexed_list_channel ich(lch,3);
+  check_summaries(ich);
+
+  std::vector<sample_summary<float> > buckets;
+  ich.summarize(std::size_t(0),ich.size(),7,std::back_inserter(buckets));
+  BOOST_REQUIRE_EQUAL( buckets.size(), std::size_t(7) );
+
+  std::size_t total = 0;
+  for(std::size_t i=0; i<buckets.size(); ++i) {
+    std::size_t first = (i*1000)/7;
+    std::size_t last = ((i+1)*1000)/7;
+    sample_summary<float> ref = ich.summary(first,last);
+
+    BOOST_CHECK_EQUAL( buckets[i].count, last-first );
+    BOOST_CHECK_EQUAL( buckets[i].min, ref.min );
+    BOOST_CHECK_EQUAL( buckets[i].max, ref.max );
+    total += buckets[i].count;
+  }
+  BOOST_CHECK_EQUAL( total, std::size_t(1000) );
+
+  // [0s,10s) at 10Hz starting at -1s is samples [10,110)
+  std::vector<sample_summary<float> > tbuckets;
+  ich.summarize(0.0f,10.0f,4,std::back_inserter(tbuckets));
+  BOOST_REQUIRE_EQUAL( tbuckets.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL( tbuckets[0].min, ich.summary(10,35).min );
+  BOOST_CHECK_EQUAL( tbuckets[3].max, ich.summary(85,110).max );
+
+  // more buckets than samples leaves some empty
+  std::vector<sample_summary<float> > sparse;
+  ich.summarize(std::size_t(0),std::size_t(3),6,std::back_inserter(sparse));
+  BOOST_CHECK_EQUAL( sparse[0].count, 0u );
+  BOOST_CHECK_EQUAL( sparse[1].count, 1u );
+}
+
+/** \test Check consecutive buckets, which carry the pyramid level from one
+ *  to the next, against a scan of the samples
+ */
+BOOST_AUTO_TEST_CASE( indexed_channel_bucket_scan_test )
+{
+  float_basic_channel bch(0,0.0f,10.0);
+  for(std::size_t i=0; i<3000; ++i)
+    bch.push_back(sample_value(i));
+
+  std::vector<float> vals(bch.begin(),bch.end());
+  std::size_t shifts[] = {0,2,5};
+  std::size_t counts[] = {1,3,64,333,1000,2999};
+  for(std::size_t s=0; s<3; ++s) {
+    float_indexed_channel ich(bch,shifts[s]);
+
+    for(std::size_t c=0; c<6; ++c) {
+      std::size_t first = 17;
+      std::size_t n = vals.size()-first-5;
+      std::vector<sample_summary<float> > buckets;
+      ich.summarize(first,first+n,counts[c],std::back_inserter(buckets));
+      BOOST_REQUIRE_EQUAL( buckets.size(), counts[c] );
+
+      for(std::size_t i=0; i<counts[c]; ++i) {
+        std::size_t lo = first+(i*n)/counts[c];
+        std::size_t hi = first+((i+1)*n)/counts[c];
+        BOOST_REQUIRE_EQUAL( buckets[i].count, hi-lo );
+        if(lo == hi)
+          continue;
+
+        BOOST_CHECK_EQUAL( buckets[i].min,
+          *std::min_element(vals.begin()+lo,vals.begin()+hi) );
+        BOOST_CHECK_EQUAL( buckets[i].max,
+          *std::max_element(vals.begin()+lo,vals.begin()+hi) );
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,187 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/intrusive_sequence.h>
+
+#include <list>
+
+/** \file
+ *  \brief Unit tests for basic_intrusive_sequence and basic_channel using it
+ *    as the underlying container
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef intrusive_sequence<float> float_intrusive_sequence;
+
+/** \test Check construction as a model of std::sequence
+ */
+BOOST_AUTO_TEST_CASE( intrusive_sequence_construction_test )
+{
+  float_intrusive_sequence is1;
+  BOOST_CHECK( is1.empty() );
+  BOOST_CHECK_EQUAL( is1.capacity(), std::size_t(0) );
+  BOOST_CHECK_EQUAL( is1.use_count(), std::size_t(0) );
+
+  float_intrusive_sequence is2(5,.2f);
+  BOOST_CHECK_EQUAL( is2.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( is2.begin(),is2.end(),fill,fill+5 );
+
+  float_intrusive_sequence is3(mags,mags+5);
+  BOOST_CHECK_EQUAL( is3.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( is3.use_count(), std::size_t(1) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( is3.begin(),is3.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( is3.rbegin(),is3.rend(),
+    std::reverse_iterator<const float*>(mags+5),
+    std::reverse_iterator<const float*>(mags) );
+
+  std::list<float> lst(mags,mags+5);
+  float_intrusive_sequence is4(lst.begin(),lst.end());
+  BOOST_CHECK( is4 == is3 );
+
+  float_intrusive_sequence is5(5,2);
+  BOOST_CHECK_EQUAL( is5.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( is5.back(), 2.0f );
+
+  // copies are deep
+  float_intrusive_sequence is6(is3);
+  BOOST_CHECK( is6 == is3 );
+  BOOST_CHECK( is6.begin() != is3.begin() );
+  BOOST_CHECK_EQUAL( is3.use_count(), std::size_t(1) );
+
+  float_intrusive_sequence is7(std::move(is6));
+  BOOST_CHECK( is6.empty() );
+  BOOST_CHECK( is7 == is3 );
+}
+
+/** \test Check the modifiers of std::sequence
+ */
+BOOST_AUTO_TEST_CASE( intrusive_sequence_modifier_test )
+{
+  float_intrusive_sequence is1;
+  for(std::size_t i=0; i<5; ++i)
+    is1.push_back(mags[i]);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is1.begin(),is1.end(),mags,mags+5 );
+  BOOST_CHECK( is1.capacity() >= std::size_t(5) );
+
+  // aliasing push_back across reallocation
+  float_intrusive_sequence is2(mags,mags+1);
+  is2.push_back(is2.front());
+  BOOST_CHECK_EQUAL( is2.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( is2.back(), mags[0] );
+
+  float_intrusive_sequence is3(mags+1,mags+4);
+  BOOST_CHECK( *is3.insert(is3.begin(),mags[0]) == mags[0] );
+  is3.insert(is3.end(),mags[4]);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is3.begin(),is3.end(),mags,mags+5 );
+
+  float_intrusive_sequence is4(mags,mags+1);
+  is4.insert(is4.end(),mags+1,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is4.begin(),is4.end(),mags,mags+5 );
+
+  float_intrusive_sequence is5(mags+3,mags+5);
+  is5.insert(is5.begin(),mags,mags+3);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is5.begin(),is5.end(),mags,mags+5 );
+
+  float_intrusive_sequence is6;
+  is6.insert(is6.begin(),5,.2f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is6.begin(),is6.end(),fill,fill+5 );
+
+  is5.erase(is5.begin()+1);
+  BOOST_CHECK_EQUAL( is5.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL( is5[1], mags[2] );
+  BOOST_CHECK( is5.erase(is5.begin(),is5.begin()+2) == is5.begin() );
+  BOOST_CHECK_EQUAL_COLLECTIONS( is5.begin(),is5.end(),mags+3,mags+5 );
+
+  is5.resize(5,.2f);
+  BOOST_CHECK_EQUAL( is5.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( is5.back(), .2f );
+  is5.resize(1);
+  BOOST_CHECK_EQUAL( is5.size(), std::size_t(1) );
+  BOOST_CHECK_THROW( is5.at(1), std::out_of_range );
+
+  std::size_t cap = is4.capacity();
+  is4.clear();
+  BOOST_CHECK( is4.empty() );
+  BOOST_CHECK_EQUAL( is4.capacity(), cap );
+
+  is4.assign(mags,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is4.begin(),is4.end(),mags,mags+5 );
+  is4.assign(5,.2f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( is4.begin(),is4.end(),fill,fill+5 );
+
+  is4.reserve(100);
+  BOOST_CHECK_EQUAL( is4.capacity(), std::size_t(100) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( is4.begin(),is4.end(),fill,fill+5 );
+}
+
+/** \test Check that channels share intrusive storage and detach on write
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_intrusive_test )
+{
+  float_intrusive_channel ch1(mags,mags+5,2.0f,1.0f);
+  float_intrusive_channel ch2(ch1);
+  BOOST_CHECK( ch1 == ch2 );
+  BOOST_CHECK( &*static_cast<const float_intrusive_channel &>(ch1).begin() ==
+    &*static_cast<const float_intrusive_channel &>(ch2).begin() );
+
+  ch2[0] = 0;
+  BOOST_CHECK( ch1 != ch2 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ch2[0], 0.0f );
+
+  float_intrusive_channel ch3(ch1);
+  ch3.push_back(6.0f);
+  BOOST_CHECK_EQUAL( ch1.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( ch3.size(), std::size_t(6) );
+
+  float_intrusive_channel ch4;
+  float_intrusive_channel ch5(ch4);
+  ch5.push_back(1.0f);
+  BOOST_CHECK( ch4.empty() );
+  BOOST_CHECK_EQUAL( ch5.size(), std::size_t(1) );
+
+  float_local_intrusive_channel lch1(mags,mags+5);
+  float_local_intrusive_channel lch2(lch1);
+  lch2.pop_back();
+  BOOST_CHECK_EQUAL_COLLECTIONS( lch1.begin(),lch1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( lch2.begin(),lch2.end(),mags,mags+4 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,203 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/irregular_channel.h>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cmath>
+
+/** \file
+ *  \brief Unit tests for irregularly sampled channels
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_irregular_channel<float,double> float_irregular_channel;
+typedef basic_channel<float,double,double> double_time_channel;
+
+/** \test Check construction, element access, and rejection of
+ *  decreasing timestamps
+ */
+BOOST_AUTO_TEST_CASE( irregular_channel_construct_test )
+{
+  const double times[] = {0.0,0.5,0.7,0.7,2.0};
+
+  float_irregular_channel ch(times,times+5,mags);
+  BOOST_REQUIRE_EQUAL( ch.size(), 5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.time_begin(),ch.time_end(),
+    times,times+5 );
+  BOOST_CHECK_EQUAL( ch.epoch(), 0.0 );
+  BOOST_CHECK_EQUAL( ch.time_at(4), 2.0 );
+  BOOST_CHECK_EQUAL( ch.at(2), 3.0f );
+  BOOST_CHECK_THROW( ch.at(5), std::out_of_range );
+
+  BOOST_CHECK_THROW( ch.push_back(1.0,0.0f), std::invalid_argument );
+  BOOST_CHECK_EQUAL( ch.size(), 5 );
+
+  const double bad[] = {0.0,1.0,0.5};
+  BOOST_CHECK_THROW( float_irregular_channel(bad,bad+3,mags),
+    std::invalid_argument );
+
+  ch.clear();
+  BOOST_CHECK( ch.empty() );
+  BOOST_CHECK_EQUAL( ch.index_at(1.0), 0 );
+}
+
+/** \test Check index_at against std::lower_bound across index rebuilds
+ */
+BOOST_AUTO_TEST_CASE( irregular_channel_index_test )
+{
+  float_irregular_channel ch;
+  std::vector<double> times;
+
+  // jittered timestamps with gaps and repeats
+  double t = 0;
+  for(std::size_t i=0; i<20000; ++i) {
+    t += (i % 97 == 0) ? 5.0 : ((i % 7 == 0) ? 0.0 : 0.001*(1 + i%3));
+    times.push_back(t);
+    ch.push_back(t,float(i));
+
+    if(i % 1013 == 0 || i == 19999) {
+      for(std::size_t j=0; j<=i; j += 1 + j/3) {
+        double q = times[j];
+        std::size_t expect =
+          std::lower_bound(times.begin(),times.end(),q) - times.begin();
+        BOOST_REQUIRE_EQUAL( ch.index_at(q), expect );
+
+        expect = std::lower_bound(times.begin(),times.end(),q+0.0005) -
+          times.begin();
+        BOOST_REQUIRE_EQUAL( ch.index_at(q+0.0005), expect );
+      }
+    }
+  }
+
+  BOOST_CHECK_EQUAL( ch.index_at(-1.0), 0 );
+  BOOST_CHECK_EQUAL( ch.index_at(t+1.0), ch.size() );
+
+  float_irregular_channel copy(times.begin(),times.end(),ch.begin());
+  for(std::size_t j=0; j<times.size(); j += 37) {
+    std::size_t expect = std::lower_bound(times.begin(),times.end(),
+      times[j]-0.0001) - times.begin();
+    BOOST_REQUIRE_EQUAL( copy.index_at(times[j]-0.0001), expect );
+  }
+}
+
+/** \test Check time based subchannels
+ */
+BOOST_AUTO_TEST_CASE( irregular_subchannel_test )
+{
+  const double times[] = {0.0,0.5,0.7,1.1,2.0};
+  float_irregular_channel ch(times,times+5,mags);
+
+  float_irregular_channel::const_subchannel_type sub =
+    ch.subchannel(0.5,1.5);
+  BOOST_REQUIRE_EQUAL( sub.size(), 3 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),mags+1,mags+4 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.time_begin(),sub.time_end(),
+    times+1,times+4 );
+  BOOST_CHECK_EQUAL( sub.epoch(), 0.5 );
+  BOOST_CHECK_EQUAL( sub.offset(), 1 );
+  BOOST_CHECK_EQUAL( sub[2], 4.0f );
+
+  float_irregular_channel::const_subchannel_type sub2 =
+    sub.subchannel(0.6,10.0);
+  BOOST_REQUIRE_EQUAL( sub2.size(), 2 );
+  BOOST_CHECK_EQUAL( sub2.time_at(0), 0.7 );
+  BOOST_CHECK_EQUAL( sub2.index_at(0.0), 0 );
+  BOOST_CHECK_EQUAL( sub2.index_at(1.0), 1 );
+
+  BOOST_CHECK( ch.subchannel(1.5,0.5).empty() );
+}
+
+/** \test Check conversion to a uniform channel by interpolation and by
+ *  resampling
+ */
+BOOST_AUTO_TEST_CASE( irregular_to_channel_test )
+{
+  // a ramp sampled irregularly converts exactly by interpolation
+  const double times[] = {1.0,1.3,1.4,2.0,3.0};
+  const float ramp[] = {0.0f,3.0f,4.0f,10.0f,20.0f};
+  float_irregular_channel ch(times,times+5,ramp);
+
+  double_time_channel up = to_channel<double_time_channel>(ch,10.0);
+  BOOST_REQUIRE_EQUAL( up.size(), 21 );
+  BOOST_CHECK_EQUAL( up.frequency(), 10.0 );
+  BOOST_CHECK_EQUAL( up.epoch(), 1.0 );
+  for(std::size_t i=0; i<up.size(); ++i)
+    BOOST_CHECK_CLOSE( up[i] + 1.0f, float(i) + 1.0f, 1e-3 );
+
+  // a dense, slowly varying signal is resampled down
+  float_irregular_channel dense;
+  const double pi = 3.14159265358979323846;
+  double t = 0;
+  for(std::size_t i=0; i<4000; ++i) {
+    dense.push_back(t,float(std::sin(2*pi*t)));
+    t += (i%2) ? 0.0009 : 0.0011;
+  }
+
+  double_time_channel down = to_channel<double_time_channel>(dense,50.0);
+  BOOST_CHECK_EQUAL( down.frequency(), 50.0 );
+  BOOST_CHECK_EQUAL( down.size(),
+    std::size_t(std::floor(dense.time_at(3999)*50.0 + 1e-9))+1 );
+  for(std::size_t i=20; i+20<down.size(); ++i)
+    BOOST_CHECK_SMALL( down[i] - float(std::sin(2*pi*i/50.0)), 0.01f );
+
+  // a dense ramp brought down to a rate far below its own
+  float_irregular_channel fine;
+  for(std::size_t i=0; i<=1000000; ++i) {
+    double ti = i*1e-4 + ((i%3) ? 2e-5 : 0.0);
+    fine.push_back(ti,float(ti));
+  }
+
+  double_time_channel slow = to_channel<double_time_channel>(fine,1.0);
+  BOOST_REQUIRE_EQUAL( slow.size(), 101 );
+  BOOST_CHECK_EQUAL( slow.frequency(), 1.0 );
+  for(std::size_t i=20; i<=80; ++i)
+    BOOST_CHECK_CLOSE( slow[i], float(i), 0.1 );
+
+  BOOST_CHECK( to_channel<double_time_channel>(
+    float_irregular_channel(),10.0).empty() );
+  BOOST_CHECK_THROW( to_channel<double_time_channel>(ch,0.0),
+    std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,155 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/live_channel.h>
+
+#include <thread>
+#include <atomic>
+
+/** \file
+ *  \brief Unit tests for basic_live_channel and basic_channel_snapshot
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_live_channel<float,float,float> float_live_channel;
+
+/** \test Check that snapshots hold exactly the samples published before they
+ *  were taken
+ */
+BOOST_AUTO_TEST_CASE( live_channel_snapshot_test )
+{
+  float_live_channel live(10.0f,2.0f,2);
+  BOOST_CHECK_EQUAL( live.frequency(), 10.0f );
+  BOOST_CHECK_EQUAL( live.epoch(), 2.0f );
+
+  float_live_channel::snapshot_type snap1 = live.snapshot();
+  BOOST_CHECK( snap1.empty() );
+  BOOST_CHECK( snap1.begin() == snap1.end() );
+
+  live.push_back(mags[0]);
+  live.push_back(mags[1]);
+  float_live_channel::snapshot_type snap2 = live.snapshot();
+
+  // forces reallocation
+  live.append(mags+2,mags+5);
+  BOOST_CHECK_EQUAL( live.size(), std::size_t(5) );
+  BOOST_CHECK( live.capacity() >= std::size_t(5) );
+  float_live_channel::snapshot_type snap3 = live.snapshot();
+
+  BOOST_CHECK( snap1.empty() );
+  BOOST_CHECK_EQUAL( snap2.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( snap2.begin(),snap2.end(),mags,mags+2 );
+  BOOST_CHECK_EQUAL( snap3.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( snap3.begin(),snap3.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( snap3.rbegin(),snap3.rend(),
+    std::reverse_iterator<const float*>(mags+5),
+    std::reverse_iterator<const float*>(mags) );
+  BOOST_CHECK_EQUAL( snap3.front(), mags[0] );
+  BOOST_CHECK_EQUAL( snap3.back(), mags[4] );
+  BOOST_CHECK_EQUAL( snap3[3], mags[3] );
+  BOOST_CHECK_EQUAL( snap3.at(4), mags[4] );
+  BOOST_CHECK_THROW( snap3.at(5), std::out_of_range );
+  BOOST_CHECK_EQUAL( snap3.frequency(), 10.0f );
+  BOOST_CHECK_EQUAL( snap3.epoch(), 2.0f );
+
+  float_live_channel::snapshot_type::const_subchannel_type sub =
+    snap3.subchannel(snap3.begin()+1,snap3.end()-1);
+  BOOST_CHECK_EQUAL( sub.size(), std::size_t(3) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),mags+1,mags+4 );
+
+  float_basic_channel ch = snap3.channel();
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ch.frequency(), 10.0f );
+  BOOST_CHECK_EQUAL( ch.epoch(), 2.0f );
+}
+
+/** \test Check that snapshots outlive the live channel
+ */
+BOOST_AUTO_TEST_CASE( live_channel_snapshot_lifetime_test )
+{
+  float_live_channel::snapshot_type snap;
+  {
+    float_live_channel live;
+    live.append(mags,mags+5);
+    snap = live.snapshot();
+  }
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( snap.begin(),snap.end(),mags,mags+5 );
+}
+
+/** \test Check that readers never observe unpublished or torn samples while
+ *  a writer is appending
+ */
+BOOST_AUTO_TEST_CASE( live_channel_concurrent_test )
+{
+  typedef basic_live_channel<double,double,double> double_live_channel;
+
+  const std::size_t len = 200000;
+
+  double_live_channel live(1.0,0.0,16);
+  std::atomic<bool> done(false);
+  std::atomic<std::size_t> errors(0);
+
+  std::thread reader([&]() {
+    std::size_t last = 0;
+    while(!done.load()) {
+      double_live_channel::snapshot_type snap = live.snapshot();
+      if(snap.size() < last)
+        ++errors;
+      last = snap.size();
+
+      for(std::size_t i=0; i<snap.size(); ++i) {
+        if(snap[i] != double(i))
+          ++errors;
+      }
+    }
+  });
+
+  for(std::size_t i=0; i<len; ++i)
+    live.push_back(double(i));
+
+  done.store(true);
+  reader.join();
+
+  BOOST_CHECK_EQUAL( errors.load(), std::size_t(0) );
+  BOOST_CHECK_EQUAL( live.snapshot().size(), len );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,354 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/mapped_sequence.h>
+
+#include <fstream>
+#include <string>
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** \file
+ *  \brief Unit tests for mapped_sequence and basic_channel using it as the
+ *    underlying container
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef mapped_sequence<float> float_mapped_sequence;
+typedef basic_channel<float,float,float,mapped_sequence> float_mapped_channel;
+
+/** Unique temporary file removed on destruction */
+struct temp_file {
+  temp_file(void) {
+    char name[] = "/tmp/qsat_mapped_XXXXXX";
+    int fd = ::mkstemp(name);
+    BOOST_REQUIRE( fd >= 0 );
+    ::close(fd);
+    path = name;
+  }
+
+  ~temp_file(void) {
+    ::unlink(path.c_str());
+  }
+
+  std::size_t size(void) const {
+    struct stat st;
+    return ::stat(path.c_str(),&st) == 0 ? st.st_size : 0;
+  }
+
+  std::string path;
+};
+
+/** \test Check the anonymous sequence as a model of std::sequence
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_anonymous_test )
+{
+  float_mapped_sequence ms1;
+  BOOST_CHECK( ms1.empty() );
+  BOOST_CHECK( !ms1.file_backed() );
+  BOOST_CHECK_EQUAL( ms1.capacity(), std::size_t(0) );
+
+  float_mapped_sequence ms2(5,.2f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms2.begin(),ms2.end(),fill,fill+5 );
+
+  float_mapped_sequence ms3(mags,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms3.begin(),ms3.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms3.rbegin(),ms3.rend(),
+    std::reverse_iterator<const float*>(mags+5),
+    std::reverse_iterator<const float*>(mags) );
+
+  float_mapped_sequence ms4(ms3);
+  BOOST_CHECK( ms4 == ms3 );
+  BOOST_CHECK( ms4.begin() != ms3.begin() );
+
+  for(std::size_t i=0; i<5; ++i)
+    ms1.push_back(mags[i]);
+  BOOST_CHECK( ms1 == ms3 );
+
+  ms1.insert(ms1.begin()+1,2,.2f);
+  ms1.erase(ms1.begin()+1,ms1.begin()+3);
+  BOOST_CHECK( ms1 == ms3 );
+
+  ms1.insert(ms1.begin(),mags,mags+2);
+  BOOST_CHECK_EQUAL( ms1.size(), std::size_t(7) );
+  BOOST_CHECK_EQUAL( ms1[2], mags[0] );
+  BOOST_CHECK_THROW( ms1.at(7), std::out_of_range );
+
+  ms1.resize(2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms1.begin(),ms1.end(),mags,mags+2 );
+}
+
+/** \test Check inserting and assigning ranges of a sequence into itself
+ *  when that grows, and so remaps, the sequence
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_self_insert_test )
+{
+  std::vector<float> data(mags,mags+5);
+  float_mapped_sequence ms(mags,mags+5);
+  BOOST_CHECK_EQUAL( ms.capacity(), ms.size() );
+
+  ms.insert(ms.end(),ms.begin(),ms.end());
+  data.insert(data.end(),mags,mags+5);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),
+    data.begin(),data.end() );
+
+  std::vector<float> range(data.rbegin(),data.rbegin()+4);
+  BOOST_CHECK_EQUAL( ms.capacity(), ms.size() );
+  ms.insert(ms.begin()+1,ms.rbegin(),ms.rbegin()+4);
+  data.insert(data.begin()+1,range.begin(),range.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),
+    data.begin(),data.end() );
+
+  ms.assign(ms.begin()+2,ms.begin()+9);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),
+    data.begin()+2,data.begin()+9 );
+
+  temp_file file;
+  float_mapped_sequence fms(file.path,float_mapped_sequence::read_write);
+  fms.assign(mags,mags+5);
+  for(std::size_t i=0; i<12; ++i)
+    fms.insert(fms.end(),fms.begin(),fms.end());
+  BOOST_CHECK_EQUAL( fms.size(), std::size_t(5) << 12 );
+  for(std::size_t i=0; i<fms.size(); i+=997)
+    BOOST_CHECK_EQUAL( fms[i], mags[i % 5] );
+}
+
+/** \test Check that read_write sequences write through to and grow the file
+ *  and that read_only sequences never modify it
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_file_test )
+{
+  temp_file file;
+
+  {
+    float_mapped_sequence ms(file.path,float_mapped_sequence::read_write);
+    BOOST_CHECK( ms.file_backed() );
+    BOOST_CHECK( ms.empty() );
+
+    ms.assign(mags,mags+5);
+    ms.reserve(4096);
+    BOOST_CHECK_EQUAL( ms.capacity(), std::size_t(4096) );
+    BOOST_CHECK_EQUAL( file.size(), 4096*sizeof(float) );
+    BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),mags,mags+5 );
+    ms.flush();
+  }
+
+  // truncated to the last element
+  BOOST_CHECK_EQUAL( file.size(), 5*sizeof(float) );
+
+  {
+    float_mapped_sequence ms(file.path);
+    BOOST_CHECK_EQUAL( ms.mode(), float_mapped_sequence::read_only );
+    BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),mags,mags+5 );
+
+    ms[0] = 0;
+    ms.push_back(6.0f);
+    BOOST_CHECK_EQUAL( ms.size(), std::size_t(6) );
+    BOOST_CHECK( !ms.file_backed() );
+  }
+
+  float_mapped_sequence ms(file.path);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),mags,mags+5 );
+
+  BOOST_CHECK_THROW( float_mapped_sequence(file.path,
+    float_mapped_sequence::read_only,0,6), std::invalid_argument );
+  BOOST_CHECK_THROW( float_mapped_sequence("/nonexistent/qsat/file"),
+    std::system_error );
+}
+
+/** \test Check that a read_write sequence shorter than its file leaves the
+ *  rest of the file in place
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_partial_file_test )
+{
+  temp_file file;
+
+  {
+    std::vector<float> data(1000);
+    for(std::size_t i=0; i<data.size(); ++i)
+      data[i] = float(i);
+    std::ofstream out(file.path.c_str(),std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&data[0]),
+      data.size()*sizeof(float));
+  }
+
+  {
+    float_mapped_sequence ms(file.path,float_mapped_sequence::read_write,0,
+      10);
+    BOOST_CHECK_EQUAL( ms.size(), std::size_t(10) );
+    ms[0] = -1.0f;
+  }
+
+  BOOST_CHECK_EQUAL( file.size(), 1000*sizeof(float) );
+
+  {
+    float_mapped_sequence ms(file.path,float_mapped_sequence::read_write);
+    BOOST_CHECK_EQUAL( ms.size(), std::size_t(1000) );
+    BOOST_CHECK_EQUAL( ms[0], -1.0f );
+    BOOST_CHECK_EQUAL( ms[999], 999.0f );
+
+    ms.erase(ms.begin()+500,ms.end());
+    ms.clear();
+  }
+
+  BOOST_CHECK_EQUAL( file.size(), 1000*sizeof(float) );
+
+  // growing a sequence shorter than its file never shortens the file
+  {
+    float_mapped_sequence ms(file.path,float_mapped_sequence::read_write,0,
+      10);
+    ms.push_back(-2.0f);
+    BOOST_CHECK_EQUAL( ms.size(), std::size_t(11) );
+    BOOST_CHECK_EQUAL( file.size(), 1000*sizeof(float) );
+  }
+
+  BOOST_CHECK_EQUAL( file.size(), 1000*sizeof(float) );
+
+  {
+    float_mapped_sequence ms(file.path);
+    BOOST_CHECK_EQUAL( ms.size(), std::size_t(1000) );
+    BOOST_CHECK_EQUAL( ms[0], -1.0f );
+    BOOST_CHECK_EQUAL( ms[10], -2.0f );
+    BOOST_CHECK_EQUAL( ms[11], 11.0f );
+    BOOST_CHECK_EQUAL( ms[999], 999.0f );
+  }
+
+  // capacity added beyond the original end is still dropped
+  {
+    float_mapped_sequence ms(file.path,float_mapped_sequence::read_write);
+    ms.push_back(1000.0f);
+    BOOST_CHECK( ms.capacity() > std::size_t(1001) );
+  }
+
+  BOOST_CHECK_EQUAL( file.size(), 1001*sizeof(float) );
+}
+
+/** \test Check that a file sequence whose remap fails keeps its mapping
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_remap_failure_test )
+{
+  temp_file file;
+
+  {
+    std::ofstream out(file.path.c_str(),std::ios::binary);
+    out.write(reinterpret_cast<const char*>(mags),sizeof(mags));
+  }
+
+  float_mapped_sequence ms(file.path,float_mapped_sequence::read_write);
+  BOOST_REQUIRE_EQUAL( ms.size(), std::size_t(5) );
+
+  // limit the address space so that mapping a large extent fails
+  struct rlimit old_limit;
+  BOOST_REQUIRE( ::getrlimit(RLIMIT_AS,&old_limit) == 0 );
+
+  struct rlimit limit = old_limit;
+  std::size_t vm_pages = 0;
+  {
+    std::ifstream statm("/proc/self/statm");
+    statm >> vm_pages;
+  }
+  if(vm_pages) {
+    limit.rlim_cur = vm_pages*::sysconf(_SC_PAGESIZE) + (64 << 20);
+    BOOST_REQUIRE( ::setrlimit(RLIMIT_AS,&limit) == 0 );
+
+    BOOST_CHECK_THROW( ms.reserve(std::size_t(1) << 30), std::system_error );
+    BOOST_CHECK( ::setrlimit(RLIMIT_AS,&old_limit) == 0 );
+  }
+
+  BOOST_CHECK_EQUAL( ms.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms.begin(),ms.end(),mags,mags+5 );
+  ms.push_back(6.0f);
+  BOOST_CHECK_EQUAL( ms.back(), 6.0f );
+}
+
+/** \test Check mapping samples that follow a header
+ */
+BOOST_AUTO_TEST_CASE( mapped_sequence_offset_test )
+{
+  temp_file file;
+
+  {
+    std::ofstream out(file.path.c_str(),std::ios::binary);
+    out.write("qsatqsat",8);
+    out.write(reinterpret_cast<const char*>(mags),sizeof(mags));
+  }
+
+  float_mapped_sequence ms1(file.path,float_mapped_sequence::read_only,8);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms1.begin(),ms1.end(),mags,mags+5 );
+
+  float_mapped_sequence ms2(file.path,float_mapped_sequence::read_only,8,2);
+  BOOST_CHECK_EQUAL_COLLECTIONS( ms2.begin(),ms2.end(),mags,mags+2 );
+
+  BOOST_CHECK_THROW( float_mapped_sequence(file.path,
+    float_mapped_sequence::read_only,2), std::invalid_argument );
+}
+
+/** \test Check basic_channel over a mapped file
+ */
+BOOST_AUTO_TEST_CASE( basic_channel_mapped_test )
+{
+  temp_file file;
+
+  {
+    float_mapped_channel ch(float_mapped_sequence(file.path,
+      float_mapped_sequence::read_write),2.0f,1.0f);
+    ch.assign(mags,mags+5);
+    ch.push_back(6.0f);
+    ch.resize(5);
+  }
+
+  BOOST_CHECK_EQUAL( file.size(), 5*sizeof(float) );
+
+  const float_mapped_channel ch1(float_mapped_sequence(file.path),2.0f,1.0f);
+  BOOST_CHECK_EQUAL( ch1.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL( ch1.epoch(), 1.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+
+  float_mapped_channel ch2(ch1);
+  ch2[0] = 0;
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ch2[0], 0.0f );
+  BOOST_CHECK_EQUAL( ch2[4], mags[4] );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
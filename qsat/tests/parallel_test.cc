@@ -0,0 +1,226 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/parallel.h>
+
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+
+/** \file
+ *  \brief Unit tests for parallel algorithms over channels
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<int,float,float> int_basic_channel;
+typedef basic_channel<int,float,float,std::list> int_list_channel;
+
+/** \test Check every index of a job is run exactly once
+ */
+BOOST_AUTO_TEST_CASE( thread_pool_run_test )
+{
+  thread_pool pool(3);
+  BOOST_CHECK_EQUAL( pool.size(), 3 );
+
+  std::vector<std::atomic<int> > count(1000);
+  pool.run(count.size(),[&](std::size_t i) { ++count[i]; });
+
+  for(std::size_t i=0; i<count.size(); ++i)
+    BOOST_CHECK_EQUAL( count[i].load(), 1 );
+
+  // nested jobs and a pool without workers complete
+  std::atomic<int> total(0);
+  pool.run(8,[&](std::size_t) {
+    pool.run(8,[&](std::size_t) { ++total; });
+  });
+  BOOST_CHECK_EQUAL( total.load(), 64 );
+
+  thread_pool empty(0);
+  empty.run(10,[&](std::size_t) { ++total; });
+  BOOST_CHECK_EQUAL( total.load(), 74 );
+}
+
+/** \test Check an exception thrown by a job is propagated to the caller
+ */
+BOOST_AUTO_TEST_CASE( thread_pool_exception_test )
+{
+  thread_pool pool(4);
+
+  BOOST_CHECK_THROW( pool.run(100,[](std::size_t i) {
+    if(i == 42)
+      throw std::runtime_error("job failed");
+  }), std::runtime_error );
+
+  // the pool is still usable
+  std::atomic<int> total(0);
+  pool.run(100,[&](std::size_t) { ++total; });
+  BOOST_CHECK_EQUAL( total.load(), 100 );
+}
+
+/** \test Check parallel_for_each modifies every sample and detaches once
+ */
+BOOST_AUTO_TEST_CASE( parallel_for_each_test )
+{
+  thread_pool pool(4);
+
+  std::vector<int> data(100003);
+  for(std::size_t i=0; i<data.size(); ++i)
+    data[i] = int(i);
+
+  int_basic_channel ch(data.begin(),data.end());
+  int_basic_channel copy(ch);
+
+  parallel_for_each(ch,[](int &x) { x *= 2; },pool);
+
+  BOOST_REQUIRE_EQUAL( ch.size(), data.size() );
+  for(std::size_t i=0; i<data.size(); ++i) {
+    BOOST_REQUIRE_EQUAL( ch[i], 2*data[i] );
+    BOOST_REQUIRE_EQUAL( copy[i], data[i] );
+  }
+
+  int_list_channel lst(data.begin(),data.end());
+  parallel_for_each(lst,[](int &x) { x += 1; },pool);
+
+  std::size_t i = 0;
+  for(int_list_channel::const_iterator cur = lst.begin(); cur != lst.end();
+    ++cur, ++i)
+  {
+    BOOST_REQUIRE_EQUAL( *cur, data[i]+1 );
+  }
+}
+
+/** \test Check parallel_for_each and parallel_transform on a chunked
+ *  channel sharing its chunks with a snapshot, where partitions cut
+ *  through chunks
+ */
+BOOST_AUTO_TEST_CASE( parallel_chunked_test )
+{
+  thread_pool pool(8);
+
+  std::vector<float> data(100000);
+  for(std::size_t i=0; i<data.size(); ++i)
+    data[i] = float(i);
+
+  for(std::size_t run=0; run<20; ++run) {
+    float_chunked_channel ch(data.begin(),data.end());
+    float_chunked_channel snapshot(ch);
+
+    parallel_for_each(ch,[](float &x) { x += 1; },pool);
+
+    BOOST_REQUIRE_EQUAL( ch.size(), data.size() );
+    for(std::size_t i=0; i<data.size(); ++i) {
+      BOOST_REQUIRE_EQUAL( ch[i], data[i]+1 );
+      BOOST_REQUIRE_EQUAL( snapshot[i], data[i] );
+    }
+
+    float_chunked_channel out(snapshot);
+    float_chunked_channel::subchannel_type sub =
+      out.subchannel(out.begin()+1000,out.end());
+    const float_chunked_channel &csnapshot = snapshot;
+    float_chunked_channel::const_subchannel_type in =
+      csnapshot.subchannel(csnapshot.begin(),csnapshot.end()-1000);
+    parallel_transform(in,sub,[](float x) { return -x; },pool);
+
+    for(std::size_t i=0; i<1000; ++i)
+      BOOST_REQUIRE_EQUAL( out[i], data[i] );
+    for(std::size_t i=1000; i<data.size(); ++i)
+      BOOST_REQUIRE_EQUAL( out[i], -data[i-1000] );
+    for(std::size_t i=0; i<data.size(); ++i)
+      BOOST_REQUIRE_EQUAL( snapshot[i], data[i] );
+  }
+}
+
+/** \test Check parallel_transform between and within channels
+ */
+BOOST_AUTO_TEST_CASE( parallel_transform_test )
+{
+  thread_pool pool(4);
+
+  std::vector<int> data(50000);
+  for(std::size_t i=0; i<data.size(); ++i)
+    data[i] = int(i);
+
+  int_basic_channel in(data.begin(),data.end());
+  int_basic_channel out(data.size());
+
+  parallel_transform(in,out,[](int x) { return x+7; },pool);
+  for(std::size_t i=0; i<data.size(); ++i)
+    BOOST_REQUIRE_EQUAL( out[i], data[i]+7 );
+
+  int_basic_channel shared(in);
+  parallel_transform(in,in,[](int x) { return -x; },pool);
+  for(std::size_t i=0; i<data.size(); ++i) {
+    BOOST_REQUIRE_EQUAL( in[i], -data[i] );
+    BOOST_REQUIRE_EQUAL( shared[i], data[i] );
+  }
+
+  int_basic_channel small(10);
+  BOOST_CHECK_THROW( parallel_transform(in,small,[](int x) { return x; },
+    pool), std::invalid_argument );
+}
+
+/** \test Check parallel_reduce with one and two operations
+ */
+BOOST_AUTO_TEST_CASE( parallel_reduce_test )
+{
+  thread_pool pool(4);
+
+  std::vector<int> data(100000);
+  for(std::size_t i=0; i<data.size(); ++i)
+    data[i] = int(i%100);
+
+  int_basic_channel ch(data.begin(),data.end());
+
+  long sum = parallel_reduce(ch,0L,std::plus<long>(),pool);
+  BOOST_CHECK_EQUAL( sum, 1000L*4950 );
+
+  long energy = parallel_reduce(ch,0L,
+    [](long acc, int x) { return acc + long(x)*x; },std::plus<long>(),pool);
+  BOOST_CHECK_EQUAL( energy, 1000L*328350 );
+
+  float_basic_channel fch(mags,mags+5);
+  BOOST_CHECK_EQUAL( parallel_reduce(fch,0.0f,std::plus<float>()), 15.0f );
+
+  int_basic_channel empty;
+  BOOST_CHECK_EQUAL( parallel_reduce(empty,3L,std::plus<long>(),pool), 3L );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
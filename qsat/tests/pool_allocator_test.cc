@@ -0,0 +1,136 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/pool_allocator.h>
+
+#include <vector>
+#include <list>
+#include <thread>
+#include <limits>
+#include <new>
+
+/** \file
+ *  \brief Unit tests for pool_allocator and basic_channel using it
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<float,float,float,std::vector,pool_allocator>
+  float_pool_channel;
+
+typedef basic_channel<float,float,float,std::list,pool_allocator>
+  float_pool_list_channel;
+
+/** \test Check that freed blocks are reused for requests of the same size
+ *    class
+ */
+BOOST_AUTO_TEST_CASE( pool_allocator_reuse_test )
+{
+  pool_allocator<float> a;
+
+  float *p = a.allocate(100);
+  a.deallocate(p,100);
+
+  // 400 and 500 bytes round up to the same 512 byte class
+  float *q = a.allocate(125);
+  BOOST_CHECK_EQUAL( q, p );
+  a.deallocate(q,125);
+
+  pool_allocator<double> b(a);
+  BOOST_CHECK( a == b );
+  double *r = b.allocate(64);
+  BOOST_CHECK_EQUAL( static_cast<void *>(r), static_cast<void *>(p) );
+  b.deallocate(r,64);
+
+  // bypasses the pool
+  float *big = a.allocate(1024*1024);
+  big[1024*1024-1] = 1;
+  a.deallocate(big,1024*1024);
+}
+
+/** \test Check that counts whose size in bytes cannot be represented
+ *    throw rather than wrap into a small size class
+ */
+BOOST_AUTO_TEST_CASE( pool_allocator_overflow_test )
+{
+  const std::size_t max = std::numeric_limits<std::size_t>::max();
+
+  pool_allocator<double> a;
+  BOOST_CHECK_THROW( a.allocate(max), std::bad_alloc );
+  // wraps to 8 bytes without the check
+  BOOST_CHECK_THROW( a.allocate(max/8+2), std::bad_alloc );
+}
+
+/** \test Check channels using the pool
+ */
+BOOST_AUTO_TEST_CASE( pool_channel_test )
+{
+  float_pool_channel ch1(mags,mags+5,.5,-.2);
+  float_pool_channel ch2(ch1);
+  ch2.push_back(6);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch1.begin(),ch1.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( ch2.size(), std::size_t(6) );
+  BOOST_CHECK_EQUAL( ch2.frequency(), .5f );
+
+  float_pool_list_channel lc(mags,mags+5);
+  lc.pop_back();
+  BOOST_CHECK_EQUAL_COLLECTIONS( lc.begin(),lc.end(),mags,mags+4 );
+
+  for(int i=0; i<1000; ++i) {
+    float_pool_channel tmp(100,float(i));
+    BOOST_CHECK_EQUAL( tmp.back(), float(i) );
+  }
+}
+
+/** \test Check that channels may be released on another thread
+ */
+BOOST_AUTO_TEST_CASE( pool_channel_thread_test )
+{
+  float_pool_channel ch(mags,mags+5);
+
+  std::thread t([&ch]() {
+    float_pool_channel mine(fill,fill+5);
+    ch = mine;
+  });
+  t.join();
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin(),ch.end(),fill,fill+5 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,187 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/resample.h>
+
+#include <algorithm>
+#include <cmath>
+
+/** \file
+ *  \brief Unit tests for resampling channels
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<double,double,double> double_basic_channel;
+
+static const double pi = 3.14159265358979323846;
+
+/** \test Check resampling to the same frequency reproduces the channel
+ */
+BOOST_AUTO_TEST_CASE( resample_identity_test )
+{
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+
+  float_basic_channel res = resample(ch,2.0f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( res.begin(),res.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL( res.frequency(), 2.0 );
+  BOOST_CHECK_EQUAL( res.epoch(), 10.0 );
+
+  float_list_channel lch(mags,mags+5,2.0,10.0);
+  float_list_channel lres = resample(lch,2.0f);
+  BOOST_CHECK_EQUAL_COLLECTIONS( lres.begin(),lres.end(),mags,mags+5 );
+
+  float_basic_channel empty;
+  BOOST_CHECK( resample(empty,2.0f).empty() );
+}
+
+/** \test Check the size, frequency, and epoch of resampled channels and
+ *  subchannels
+ */
+BOOST_AUTO_TEST_CASE( resample_size_test )
+{
+  double_basic_channel ch(4800,1.0,48000.0,5.0);
+
+  double_basic_channel down = resample(ch,1000.0);
+  BOOST_CHECK_EQUAL( down.size(), std::size_t(100) );
+  BOOST_CHECK_EQUAL( down.frequency(), 1000.0 );
+  BOOST_CHECK_EQUAL( down.epoch(), 5.0 );
+
+  double_basic_channel cd = resample(ch,44100.0);
+  BOOST_CHECK_EQUAL( cd.size(), std::size_t(4410) );
+
+  double_basic_channel up = resample(down,4000.0);
+  BOOST_CHECK_EQUAL( up.size(), std::size_t(400) );
+
+  double_basic_channel::subchannel_type sub =
+    ch.subchannel(ch.begin()+480,ch.end());
+  double_basic_channel sres = resample(sub,1000.0);
+  BOOST_CHECK_EQUAL( sres.size(), std::size_t(90) );
+  BOOST_CHECK_CLOSE( sres.epoch(), 5.01, 1e-9 );
+}
+
+/** \test Check the values of downsampled and upsampled signals away from
+ *  the channel boundaries
+ */
+BOOST_AUTO_TEST_CASE( resample_value_test )
+{
+  double_basic_channel dc(4800,1.0,48000.0);
+  double_basic_channel down = resample(dc,1000.0);
+  for(std::size_t i=20; i<80; ++i)
+    BOOST_CHECK_SMALL( down[i]-1.0, 1e-4 );
+
+  double_basic_channel sine(0,0.0,250.0);
+  for(std::size_t i=0; i<1000; ++i)
+    sine.push_back(std::sin(2*pi*10*i/250.0));
+
+  double_basic_channel up = resample(sine,1000.0);
+  BOOST_REQUIRE_EQUAL( up.size(), std::size_t(4000) );
+  for(std::size_t i=200; i<3800; ++i)
+    BOOST_CHECK_SMALL( up[i]-std::sin(2*pi*10*i/1000.0), 1e-3 );
+
+  // content above the output Nyquist frequency is removed
+  double_basic_channel tone(0,0.0,1000.0);
+  for(std::size_t i=0; i<4000; ++i)
+    tone.push_back(std::sin(2*pi*400*i/1000.0));
+
+  double_basic_channel alias = resample(tone,250.0);
+  for(std::size_t i=50; i<950; ++i)
+    BOOST_CHECK_SMALL( alias[i], 1e-3 );
+}
+
+/** \test Check decimation by a ratio well below 1/4096
+ */
+BOOST_AUTO_TEST_CASE( resample_large_ratio_test )
+{
+  double_basic_channel dc(200000,1.0,1000000.0,2.0);
+
+  double_basic_channel down = resample(dc,100.0,4);
+  BOOST_REQUIRE_EQUAL( down.size(), std::size_t(20) );
+  BOOST_CHECK_EQUAL( down.frequency(), 100.0 );
+  BOOST_CHECK_EQUAL( down.epoch(), 2.0 );
+  for(std::size_t i=5; i<15; ++i)
+    BOOST_CHECK_SMALL( down[i]-1.0, 1e-4 );
+
+  double_basic_channel up = resample(down,1000000.0,1);
+  BOOST_CHECK_EQUAL( up.size(), std::size_t(200000) );
+}
+
+/** \test Check that integral samples clip rather than throw when the
+ *  filter overshoots a full scale step
+ */
+BOOST_AUTO_TEST_CASE( resample_full_scale_test )
+{
+  typedef basic_channel<short,double,double> short_basic_channel;
+
+  short_basic_channel step(4800,-32768,48000.0);
+  step.resize(9600,32767);
+
+  short_basic_channel res;
+  BOOST_REQUIRE_NO_THROW( res = resample(step,44100.0) );
+  BOOST_REQUIRE_EQUAL( res.size(), std::size_t(8820) );
+
+  // Gibbs ringing on either side of the step saturates
+  short lo = 0, hi = 0;
+  for(std::size_t i=0; i<res.size(); ++i) {
+    lo = std::min(lo,res[i]);
+    hi = std::max(hi,res[i]);
+  }
+  BOOST_CHECK_EQUAL( lo, -32768 );
+  BOOST_CHECK_EQUAL( hi, 32767 );
+  BOOST_CHECK_EQUAL( res[2000], -32768 );
+  BOOST_CHECK_EQUAL( res[7000], 32767 );
+}
+
+/** \test Check invalid arguments are rejected
+ */
+BOOST_AUTO_TEST_CASE( resample_error_test )
+{
+  float_basic_channel ch(mags,mags+5,2.0,10.0);
+
+  BOOST_CHECK_THROW( resample(ch,0.0f), std::invalid_argument );
+  BOOST_CHECK_THROW( resample(ch,-1.0f), std::invalid_argument );
+  BOOST_CHECK_THROW( resample(ch,1.0f,0), std::invalid_argument );
+
+  // ratios that cannot be represented exactly enough
+  BOOST_CHECK_THROW( resample(ch,2.0f/100000), std::invalid_argument );
+  double_basic_channel dch(10,1.0,48000.0);
+  BOOST_CHECK_THROW( resample(dch,47999.7), std::invalid_argument );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
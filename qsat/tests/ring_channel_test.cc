@@ -0,0 +1,183 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include <boost/static_assert.hpp>
+
+#include "test_types.h"
+
+#include <qsat/ring_channel.h>
+
+#include <thread>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+
+/** \file
+ *  \brief Unit tests for basic_ring_channel
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_ring_channel<float,float,float> float_ring_channel;
+
+/** \test Check the const sequence interface and subchannels
+ */
+BOOST_AUTO_TEST_CASE( ring_channel_access_test )
+{
+  float_ring_channel ring(5,2.0f,1.0f);
+  BOOST_CHECK_EQUAL( ring.capacity(), std::size_t(8) );
+  BOOST_CHECK( ring.empty() );
+  BOOST_CHECK( ring.begin() == ring.end() );
+  BOOST_CHECK_EQUAL( ring.frequency(), 2.0f );
+  BOOST_CHECK_EQUAL( ring.epoch(), 1.0f );
+
+  ring.append(mags,mags+5);
+  BOOST_CHECK_EQUAL( ring.size(), std::size_t(5) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ring.begin(),ring.end(),mags,mags+5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ring.rbegin(),ring.rend(),
+    std::reverse_iterator<const float*>(mags+5),
+    std::reverse_iterator<const float*>(mags) );
+  BOOST_CHECK_EQUAL( ring.front(), mags[0] );
+  BOOST_CHECK_EQUAL( ring.back(), mags[4] );
+  BOOST_CHECK_EQUAL( ring[2], mags[2] );
+  BOOST_CHECK_EQUAL( ring.at(4), mags[4] );
+  BOOST_CHECK_THROW( ring.at(5), std::out_of_range );
+  BOOST_CHECK_EQUAL( ring.end()-ring.begin(), 5 );
+
+  // samples are returned by value, yet the iterator stays random access
+  typedef std::iterator_traits<float_ring_channel::const_iterator> traits;
+  BOOST_STATIC_ASSERT(( std::is_same<traits::iterator_category,
+    std::random_access_iterator_tag>::value ));
+  BOOST_STATIC_ASSERT(( std::is_same<traits::reference,float>::value ));
+  BOOST_CHECK_EQUAL( std::distance(ring.begin(),ring.end()), 5 );
+  float_ring_channel::const_iterator cur = ring.begin();
+  std::advance(cur,3);
+  BOOST_CHECK_EQUAL( *cur, mags[3] );
+  BOOST_CHECK_EQUAL( cur[-2], mags[1] );
+
+  float_ring_channel::const_subchannel_type sub =
+    ring.subchannel(ring.begin()+1,ring.end());
+  BOOST_CHECK_EQUAL( sub.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),mags+1,mags+5 );
+  BOOST_CHECK_EQUAL( sub.epoch(), 1.5f );
+  BOOST_CHECK_EQUAL( sub.back(), mags[4] );
+
+  BOOST_CHECK_THROW( float_ring_channel(0), std::length_error );
+}
+
+/** \test Check that the oldest samples are overwritten and the epoch advances
+ */
+BOOST_AUTO_TEST_CASE( ring_channel_overwrite_test )
+{
+  float_ring_channel ring(4,2.0f,1.0f);
+
+  ring.append(mags,mags+5);
+  ring.append(mags,mags+2);
+  BOOST_CHECK_EQUAL( ring.size(), std::size_t(4) );
+  BOOST_CHECK_EQUAL( ring.epoch(), 2.5f );
+  BOOST_CHECK_EQUAL( ring.begin().index(), 3u );
+
+  const float expect[] = {4.0,5.0,1.0,2.0};
+  BOOST_CHECK_EQUAL_COLLECTIONS( ring.begin(),ring.end(),expect,expect+4 );
+
+  float_ring_channel::const_iterator first = ring.begin();
+  BOOST_CHECK( !ring.expired(first) );
+  ring.push_back(3.0f);
+  BOOST_CHECK( ring.expired(first) );
+  BOOST_CHECK( !ring.expired(first+1) );
+
+  float_ring_channel::const_subchannel_type sub =
+    ring.subchannel(ring.begin()+2,ring.end());
+  BOOST_CHECK_EQUAL( sub.epoch(), 4.0f );
+
+  ring.pop_front(2);
+  BOOST_CHECK_EQUAL( ring.size(), std::size_t(2) );
+  BOOST_CHECK_EQUAL( ring.front(), 2.0f );
+  BOOST_CHECK_EQUAL( ring.epoch(), 4.0f );
+  BOOST_CHECK_EQUAL( sub.epoch(), 4.0f );
+
+  float_ring_channel::snapshot_type snap = ring.snapshot();
+  BOOST_CHECK_EQUAL_COLLECTIONS( snap.begin(),snap.end(),mags+1,mags+3 );
+  BOOST_CHECK_EQUAL( snap.epoch(), 4.0f );
+  BOOST_CHECK_EQUAL( snap.frequency(), 2.0f );
+
+  ring.pop_front(10);
+  BOOST_CHECK( ring.empty() );
+  BOOST_CHECK_EQUAL( ring.epoch(), 5.0f );
+
+  ring.push_back(1.0f);
+  ring.clear();
+  BOOST_CHECK( ring.empty() );
+}
+
+/** \test Check that a consumer never observes out of order or overwritten
+ *  samples while the producer is pushing
+ */
+BOOST_AUTO_TEST_CASE( ring_channel_concurrent_test )
+{
+  typedef basic_ring_channel<double,double,double> double_ring_channel;
+
+  const std::size_t len = 1000000;
+
+  double_ring_channel ring(1024);
+  std::atomic<bool> done(false);
+  std::atomic<std::size_t> errors(0);
+
+  std::thread consumer([&]() {
+    while(!done.load()) {
+      double_ring_channel::snapshot_type snap = ring.snapshot();
+      for(std::size_t i=0; i<snap.size(); ++i) {
+        if(snap[i] != snap.epoch()+i)
+          ++errors;
+      }
+
+      if(ring.size() > 512)
+        ring.pop_front(256);
+    }
+  });
+
+  for(std::size_t i=0; i<len; ++i)
+    ring.push_back(double(i));
+
+  done.store(true);
+  consumer.join();
+
+  BOOST_CHECK_EQUAL( errors.load(), std::size_t(0) );
+  BOOST_CHECK_EQUAL( ring.end().index(), len );
+  BOOST_CHECK_EQUAL( ring.back(), double(len-1) );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -0,0 +1,413 @@
+/**
+ *  Copyright (c) 2012, Mike Tegtmeyer
+ *  All rights reserved.
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions are met:
+ *
+ *      * Redistributions of source code must retain the above copyright
+ *        notice, this list of conditions and the following disclaimer.
+ *      * Redistributions in binary form must reproduce the above copyright
+ *        notice, this list of conditions and the following disclaimer in the
+ *        documentation and/or other materials provided with the distribution.
+ *      * Neither the name of the author nor the names of its contributors may
+ *        be used to endorse or promote products derived from this software
+ *        without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND ANY
+ *  EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ *  WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ *  DISCLAIMED. IN NO EVENT SHALL THE REGENTS AND CONTRIBUTORS BE LIABLE FOR ANY
+ *  DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ *  (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ *  ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ *  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ *  THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <boost/test/unit_test.hpp>
+
+#include "test_types.h"
+
+#include <qsat/run_length_sequence.h>
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+/** \file
+ *  \brief Unit tests for run_length_sequence
+ */
+
+namespace lemma {
+namespace qsat {
+namespace test {
+
+BOOST_AUTO_TEST_SUITE( channel_suite )
+
+typedef basic_channel<float,double,double,run_length_sequence>
+  float_run_length_channel;
+
+/** \test Check that fill construction and runs of equal values are stored
+ *  once
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_fill_test )
+{
+  run_length_sequence<float> seq(1000000000,0.0f);
+  BOOST_CHECK_EQUAL( seq.size(), 1000000000 );
+  BOOST_CHECK_EQUAL( seq.run_count(), 1 );
+  BOOST_CHECK_EQUAL( seq[999999999], 0.0f );
+  BOOST_CHECK_EQUAL( seq.back(), 0.0f );
+
+  seq.resize(1500000000,0.0f);
+  BOOST_CHECK_EQUAL( seq.run_count(), 1 );
+  seq.resize(2000000000,1.0f);
+  BOOST_CHECK_EQUAL( seq.run_count(), 2 );
+  BOOST_CHECK_EQUAL( seq[1499999999], 0.0f );
+  BOOST_CHECK_EQUAL( seq[1500000000], 1.0f );
+  BOOST_CHECK_THROW( seq.at(2000000000), std::out_of_range );
+
+  const float data[] = {1,1,1,2,2,3,1,1};
+  run_length_sequence<float> rseq(data,data+8);
+  BOOST_CHECK_EQUAL( rseq.run_count(), 4 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( rseq.begin(),rseq.end(),data,data+8 );
+
+  std::vector<float> reversed(rseq.rbegin(),rseq.rend());
+  std::vector<float> expected(data,data+8);
+  BOOST_CHECK_EQUAL_COLLECTIONS( reversed.begin(),reversed.end(),
+    expected.rbegin(),expected.rend() );
+}
+
+/** \test Check writes split runs and merge them back again
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_set_test )
+{
+  run_length_sequence<float> seq(100,0.0f);
+
+  seq[50] = 1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  seq.set(51,1.0f);
+  seq[49] = 1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  seq[0] = 1.0f;
+  seq[99] = 1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 5 );
+
+  seq[50] = 0.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 7 );
+  seq[50] = 1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 5 );
+
+  for(std::size_t i=1; i<49; ++i)
+    seq[i] = 1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+
+  // compare against a vector under random writes
+  std::vector<float> data(1000,0.0f);
+  run_length_sequence<float> rseq(1000,0.0f);
+  std::srand(17);
+  for(std::size_t i=0; i<5000; ++i) {
+    std::size_t n = std::rand() % data.size();
+    float val = float(std::rand() % 3);
+    data[n] = val;
+    rseq[n] = val;
+  }
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( rseq.begin(),rseq.end(),
+    data.begin(),data.end() );
+
+  std::size_t runs = 1;
+  for(std::size_t i=1; i<data.size(); ++i)
+    runs += (data[i] != data[i-1]);
+  BOOST_CHECK_EQUAL( rseq.run_count(), runs );
+
+  // sequential overlay through an iterator
+  run_length_sequence<float> overlay(1000,0.0f);
+  run_length_sequence<float>::iterator cur = overlay.begin() + 100;
+  for(std::size_t i=0; i<5; ++i)
+    *cur++ = mags[i];
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( overlay.begin()+100,overlay.begin()+105,
+    mags,mags+5 );
+  BOOST_CHECK_EQUAL( overlay[105], 0.0f );
+  BOOST_CHECK_EQUAL( overlay.run_count(), 7 );
+}
+
+/** \test Check that runs are compared bitwise, keeping -0.0 apart from
+ *  0.0 and storing repeated NaNs as one run
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_bitwise_test )
+{
+  run_length_sequence<double> seq(10,0.0);
+
+  seq.set(5,-0.0);
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  BOOST_CHECK( std::signbit(double(seq[5])) );
+  BOOST_CHECK( !std::signbit(double(seq[4])) );
+
+  seq[4] = -0.0;
+  seq[6] = -0.0;
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  seq[5] = 0.0;
+  BOOST_CHECK_EQUAL( seq.run_count(), 5 );
+  BOOST_CHECK( !std::signbit(double(seq[5])) );
+  BOOST_CHECK( std::signbit(double(seq[6])) );
+
+  // erasing a run merges only neighbors of the same sign
+  seq.erase(seq.begin()+5);
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  seq.push_back(0.0);
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  seq.push_back(-0.0);
+  BOOST_CHECK_EQUAL( seq.run_count(), 4 );
+  BOOST_CHECK( std::signbit(double(seq.back())) );
+
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  run_length_sequence<double> nans;
+  for(std::size_t i=0; i<1000; ++i)
+    nans.push_back(nan);
+  BOOST_CHECK_EQUAL( nans.size(), 1000 );
+  BOOST_CHECK_EQUAL( nans.run_count(), 1 );
+  BOOST_CHECK( std::isnan(double(nans[999])) );
+
+  nans.resize(2000,nan);
+  nans.insert(nans.begin()+10,5,nan);
+  BOOST_CHECK_EQUAL( nans.run_count(), 1 );
+
+  nans[500] = 1.0;
+  BOOST_CHECK_EQUAL( nans.run_count(), 3 );
+  nans[500] = nan;
+  BOOST_CHECK_EQUAL( nans.run_count(), 1 );
+
+  run_length_sequence<double> copy(nans.begin(),nans.end());
+  BOOST_CHECK_EQUAL( copy.size(), 2005 );
+  BOOST_CHECK_EQUAL( copy.run_count(), 1 );
+
+  // long double is compared by value and sign, ignoring any padding bytes
+  long double vals[3];
+  std::memset(vals,0x55,sizeof(vals));
+  vals[0] = 1.0L;
+  std::memset(vals+1,0xaa,sizeof(vals[1]));
+  vals[1] = 1.0L;
+  vals[2] = -0.0L;
+  run_length_sequence<long double> wide(vals,vals+2);
+  BOOST_CHECK_EQUAL( wide.run_count(), 1 );
+  wide.push_back(0.0L);
+  wide.push_back(vals[2]);
+  BOOST_CHECK_EQUAL( wide.run_count(), 3 );
+  BOOST_CHECK( std::signbit(wide[3]) );
+  wide.push_back(std::numeric_limits<long double>::quiet_NaN());
+  wide.push_back(-std::numeric_limits<long double>::quiet_NaN());
+  BOOST_CHECK_EQUAL( wide.run_count(), 4 );
+}
+
+/** \test Check insertion and erasure against a vector
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_modify_test )
+{
+  std::vector<float> data(200,0.0f);
+  data.insert(data.end(),100,1.0f);
+  run_length_sequence<float> seq(data.begin(),data.end());
+
+  seq.insert(seq.begin()+50,mags,mags+5);
+  data.insert(data.begin()+50,mags,mags+5);
+  seq.insert(seq.begin()+5,2,-1.0f);
+  data.insert(data.begin()+5,2,-1.0f);
+  seq.insert(seq.begin()+10,3,0.0f);
+  data.insert(data.begin()+10,3,0.0f);
+  BOOST_CHECK_EQUAL( *seq.insert(seq.end(),9.0f), 9.0f );
+  data.push_back(9.0f);
+
+  // inserting a range of this sequence
+  std::vector<float> range(data.begin()+200,data.begin()+260);
+  seq.insert(seq.begin()+1,seq.begin()+200,seq.begin()+260);
+  data.insert(data.begin()+1,range.begin(),range.end());
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  BOOST_CHECK_EQUAL( *seq.erase(seq.begin()+3,seq.begin()+70), data[70] );
+  data.erase(data.begin()+3,data.begin()+70);
+  seq.erase(seq.begin());
+  data.erase(data.begin());
+
+  seq.pop_back();
+  data.pop_back();
+  seq.resize(300,2.5f);
+  data.resize(300,2.5f);
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  // erasing a short run merges its neighbors
+  run_length_sequence<float> merged(10,0.0f);
+  merged[5] = 1.0f;
+  merged.erase(merged.begin()+5);
+  BOOST_CHECK_EQUAL( merged.size(), 9 );
+  BOOST_CHECK_EQUAL( merged.run_count(), 1 );
+
+  seq.assign(data.begin(),data.end());
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+  seq.assign(seq.begin()+10,seq.begin()+20);
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin()+10,data.begin()+20 );
+
+  run_length_sequence<float> other;
+  other.swap(seq);
+  BOOST_CHECK( seq.empty() );
+  BOOST_CHECK_EQUAL( other.size(), 10 );
+  other.clear();
+  BOOST_CHECK( other.empty() );
+}
+
+/** \test Check consuming a sequence a run at a time
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_run_test )
+{
+  run_length_sequence<float> seq(1000000,0.0f);
+  seq.insert(seq.begin()+1000,mags,mags+5);
+
+  const run_length_sequence<float> &cseq = seq;
+  run_length_sequence<float>::const_iterator cur = cseq.begin() + 10;
+  run_length_sequence<float>::const_iterator last = cseq.end() - 10;
+
+  double sum = 0;
+  std::size_t steps = 0;
+  while(cur != last) {
+    std::size_t n = std::min<std::size_t>(cur.run_remaining(),last-cur);
+    sum += *cur * n;
+    cur += n;
+    ++steps;
+  }
+
+  BOOST_CHECK_EQUAL( sum, 15.0 );
+  BOOST_CHECK_EQUAL( steps, 7 );
+}
+
+/** \test Check that blocks written with set() are stored as literal
+ *  segments, against a vector
+ */
+BOOST_AUTO_TEST_CASE( run_length_sequence_literal_test )
+{
+  std::vector<float> block(4096);
+  for(std::size_t i=0; i<block.size(); ++i)
+    block[i] = i*0.5f;
+
+  std::vector<float> data(100000,0.0f);
+  run_length_sequence<float> seq(100000,0.0f);
+  seq.set(1000,block.begin(),block.end());
+  std::copy(block.begin(),block.end(),data.begin()+1000);
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  // writes within the segment overwrite it in place
+  seq.set(1500,mags,mags+5);
+  std::copy(mags,mags+5,data.begin()+1500);
+  seq[2000] = -1.0f;
+  data[2000] = -1.0f;
+  BOOST_CHECK_EQUAL( seq.run_count(), 3 );
+  BOOST_CHECK_EQUAL( seq[1502], mags[2] );
+
+  const run_length_sequence<float> &cseq = seq;
+  run_length_sequence<float>::const_iterator cur = cseq.begin() + 1000;
+  BOOST_REQUIRE( cur.literal() );
+  BOOST_CHECK_EQUAL( cur.segment_remaining(), 4096 );
+  BOOST_CHECK_EQUAL( cur.run_remaining(), 1 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( cur.literal()+500,cur.literal()+505,
+    mags,mags+5 );
+  BOOST_CHECK( !cseq.begin().literal() );
+  BOOST_CHECK_EQUAL( cseq.begin().run_remaining(), 1000 );
+
+  // a block across a run and a segment replaces both
+  seq.set(900,block.begin(),block.begin()+200);
+  std::copy(block.begin(),block.begin()+200,data.begin()+900);
+  BOOST_CHECK_EQUAL( seq.run_count(), 4 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  // a range of this sequence
+  seq.set(0,seq.begin()+1000,seq.begin()+1010);
+  std::copy(data.begin()+1000,data.begin()+1010,data.begin());
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  // copies keep the segments, joining the two that are adjacent
+  run_length_sequence<float> copy(seq.begin(),seq.end());
+  BOOST_CHECK_EQUAL( seq.run_count(), 5 );
+  BOOST_CHECK_EQUAL( copy.run_count(), 4 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( copy.begin(),copy.end(),
+    data.begin(),data.end() );
+
+  seq.insert(seq.begin()+3,copy.begin()+1990,copy.begin()+2010);
+  data.insert(data.begin()+3,data.begin()+1990,data.begin()+2010);
+  seq.erase(seq.begin()+950,seq.begin()+3000);
+  data.erase(data.begin()+950,data.begin()+3000);
+  seq.pop_back();
+  data.pop_back();
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+
+  // random blocks and erasure, reclaiming overwritten segments
+  std::srand(29);
+  for(std::size_t i=0; i<2000; ++i) {
+    std::size_t len = std::rand() % 300;
+    std::size_t pos = std::rand() % (data.size() - len);
+    std::size_t src = std::rand() % (block.size() - len);
+    seq.set(pos,block.begin()+src,block.begin()+src+len);
+    std::copy(block.begin()+src,block.begin()+src+len,data.begin()+pos);
+
+    if(i % 10 == 0) {
+      seq.erase(seq.begin()+pos,seq.begin()+pos+len/2);
+      data.erase(data.begin()+pos,data.begin()+pos+len/2);
+    }
+  }
+
+  BOOST_CHECK_EQUAL_COLLECTIONS( seq.begin(),seq.end(),
+    data.begin(),data.end() );
+}
+
+/** \test Check a basic_channel over a run_length_sequence, including writes
+ *  to a shared copy
+ */
+BOOST_AUTO_TEST_CASE( run_length_channel_test )
+{
+  float_run_length_channel ch(1000000,0.0f,100.0,5.0);
+  float_run_length_channel copy(ch);
+
+  ch[42] = 1.0f;
+  BOOST_CHECK_EQUAL( ch[42], 1.0f );
+  BOOST_CHECK_EQUAL( copy[42], 0.0f );
+
+  ch.insert(ch.begin()+100,mags,mags+5);
+  ch.erase(ch.begin()+10,ch.begin()+20);
+  BOOST_CHECK_EQUAL( ch.size(), 999995 );
+  BOOST_CHECK_EQUAL( ch[32], 1.0f );
+  BOOST_CHECK_EQUAL_COLLECTIONS( ch.begin()+90,ch.begin()+95,mags,mags+5 );
+
+  float_run_length_channel shared(ch);
+  shared.erase(shared.begin()+90,shared.begin()+95);
+  shared.insert(shared.begin()+32,2.0f);
+  BOOST_CHECK_EQUAL( shared.size(), 999991 );
+  BOOST_CHECK_EQUAL( shared[32], 2.0f );
+  BOOST_CHECK_EQUAL( shared[33], 1.0f );
+  BOOST_CHECK_EQUAL( shared[91], 0.0f );
+  BOOST_CHECK_EQUAL( ch.size(), 999995 );
+  BOOST_CHECK_EQUAL( ch[90], mags[0] );
+
+  const float_run_length_channel &cch = ch;
+  float_run_length_channel::const_subchannel_type sub =
+    cch.subchannel(5.9,5.95);
+  BOOST_REQUIRE_EQUAL( sub.size(), 5 );
+  BOOST_CHECK_EQUAL_COLLECTIONS( sub.begin(),sub.end(),mags,mags+5 );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
+}
+}
@@ -30,6 +30,8 @@
 
 #include <qsat/basic_channel.h>
 #include <qsat/channel_base.h>
+#include <qsat/chunked_sequence.h>
+#include <qsat/intrusive_sequence.h>
 
 #include <boost/mpl/vector.hpp>
 
@@ -57,6 +59,15 @@ typedef basic_channel<float,float,float> float_basic_channel;
 /** basic_channel with float precision using std::list as an underlying container*/
 typedef basic_channel<float,float,float,std::list> float_list_channel;
 
+/** basic_channel with float precision using chunked_sequence as an underlying container*/
+typedef basic_channel<float,float,float,chunked_sequence> float_chunked_channel;
+
+/** basic_channel with float precision using intrusive_sequence as an underlying container*/
+typedef basic_channel<float,float,float,intrusive_sequence> float_intrusive_channel;
+
+/** basic_channel with float precision using local_intrusive_sequence as an underlying container*/
+typedef basic_channel<float,float,float,local_intrusive_sequence> float_local_intrusive_channel;
+
 
 /** channel_base with float precision and float underlying type*/
 typedef channel_base<float,float,float,mpl::vector<float> > float_channel_base;